@@ -29,92 +29,238 @@
 #include "dbus_bindings-internal.h"
 #include "types-internal.h"
 
-/* Dict indexed by object IDs, whose values are nonzero variant levels
- * for immutable variable-sized D-Bus data types (_LongBase, _StrBase, Struct).
+/* Out-of-line attributes for immutable variable-sized D-Bus data types
+ * (_LongBase, _StrBase, _BytesBase, Struct): their nonzero variant levels
+ * and, for Struct, the signature.
  *
- * This is a strange way to store them, but adding a __dict__ to the offending
- * objects seems even more error-prone, given that their sizes are variable!
+ * Adding a slot or a __dict__ to the offending objects is too error-prone,
+ * given that their sizes are variable, so instead they live in an
+ * open-addressing hash table keyed by the object's address. The object
+ * itself is not referenced: every type that can have an entry removes it
+ * from its tp_dealloc via dbus_py_variant_level_clear(). Unlike the dict
+ * this replaces, looking up an entry never allocates, so the common case of
+ * an object with no entry costs a hash and a probe or two.
  */
-PyObject *_dbus_py_variant_levels = NULL;
+typedef struct {
+    PyObject *obj;          /* borrowed; NULL if the slot is free */
+    long variant_level;
+    PyObject *signature;    /* owned, or NULL */
+} ExtraAttrs;
 
-long
-dbus_py_variant_level_get(PyObject *obj)
+#define EXTRA_ATTRS_MIN_SIZE 64
+
+static ExtraAttrs *extra_attrs = NULL;
+static size_t extra_attrs_size = 0;     /* always 0 or a power of 2 */
+static size_t extra_attrs_used = 0;
+
+static size_t
+extra_attrs_hash(PyObject *obj)
 {
-    PyObject *vl_obj;
-    PyObject *key = PyLong_FromVoidPtr(obj);
-    long variant_level;
+    size_t h = ((size_t)obj) >> 3;
+
+    /* objects are aligned, so mix the high bits into the low ones */
+    h ^= h >> 16;
+    h *= 0x45d9f3bU;
+    h ^= h >> 16;
+    return h;
+}
+
+static ExtraAttrs *
+extra_attrs_lookup(PyObject *obj)
+{
+    size_t mask, i;
+
+    if (extra_attrs_used == 0)
+        return NULL;
+
+    mask = extra_attrs_size - 1;
+    for (i = extra_attrs_hash(obj) & mask;
+         extra_attrs[i].obj;
+         i = (i + 1) & mask) {
+        if (extra_attrs[i].obj == obj)
+            return &extra_attrs[i];
+    }
+    return NULL;
+}
 
-    if (!key) {
-        return -1;
+static dbus_bool_t
+extra_attrs_resize(size_t new_size)
+{
+    ExtraAttrs *old = extra_attrs;
+    size_t old_size = extra_attrs_size;
+    size_t mask = new_size - 1;
+    size_t i, j;
+
+    extra_attrs = PyMem_New(ExtraAttrs, new_size);
+    if (!extra_attrs) {
+        extra_attrs = old;
+        return FALSE;
     }
+    memset(extra_attrs, 0, new_size * sizeof(ExtraAttrs));
+    extra_attrs_size = new_size;
+
+    for (i = 0; i < old_size; i++) {
+        if (!old[i].obj)
+            continue;
+        for (j = extra_attrs_hash(old[i].obj) & mask;
+             extra_attrs[j].obj;
+             j = (j + 1) & mask);
+        extra_attrs[j] = old[i];
+    }
+    PyMem_Free(old);
+    return TRUE;
+}
 
-    vl_obj = PyDict_GetItem(_dbus_py_variant_levels, key);
-    Py_CLEAR(key);
+/* Return the entry for obj, creating an empty one if necessary. Return NULL
+ * with MemoryError set on failure. */
+static ExtraAttrs *
+extra_attrs_insert(PyObject *obj)
+{
+    ExtraAttrs *entry = extra_attrs_lookup(obj);
+    size_t mask, i;
 
-    if (!vl_obj) {
-        /* PyDict_GetItem() does not set an exception when the key is missing.
-         * In our case, it just means that there was no entry in the variant
-         * dictionary for this object.  Semantically, this is equivalent to a
-         * variant level of 0.
-         */
-        return 0;
+    if (entry)
+        return entry;
+
+    /* keep the load factor below 2/3 */
+    if ((extra_attrs_used + 1) * 3 > extra_attrs_size * 2) {
+        if (!extra_attrs_resize(extra_attrs_size ? extra_attrs_size * 2
+                                                 : EXTRA_ATTRS_MIN_SIZE)) {
+            PyErr_NoMemory();
+            return NULL;
+        }
     }
-    variant_level = NATIVEINT_ASLONG(vl_obj);
-    if (variant_level == -1 && PyErr_Occurred()) {
-        /* variant_level < 0 can never be inserted into the dictionary; see
-         * dbus_py_variant_level_set() below.  The semantics of setting
-         * variant_level < 0 is to delete it from the dictionary.
-         */
-        return -1;
-    }
-    assert(variant_level >= 0);
-    return variant_level;
+
+    mask = extra_attrs_size - 1;
+    for (i = extra_attrs_hash(obj) & mask;
+         extra_attrs[i].obj;
+         i = (i + 1) & mask);
+    entry = &extra_attrs[i];
+    entry->obj = obj;
+    entry->variant_level = 0;
+    entry->signature = NULL;
+    extra_attrs_used++;
+    return entry;
+}
+
+/* Remove entry from the table and return its signature, which the caller
+ * must release. */
+static PyObject *
+extra_attrs_remove(ExtraAttrs *entry)
+{
+    PyObject *signature = entry->signature;
+    size_t mask = extra_attrs_size - 1;
+    size_t i = entry - extra_attrs;
+    size_t j = i;
+
+    /* Backward-shift deletion: move later members of the same probe
+     * sequence into the hole, so that lookups never need tombstones. */
+    for (;;) {
+        size_t home;
+
+        j = (j + 1) & mask;
+        if (!extra_attrs[j].obj)
+            break;
+        home = extra_attrs_hash(extra_attrs[j].obj) & mask;
+        /* leave it alone if its home slot is cyclically in (i, j] */
+        if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+            continue;
+        extra_attrs[i] = extra_attrs[j];
+        i = j;
+    }
+    extra_attrs[i].obj = NULL;
+    extra_attrs[i].signature = NULL;
+    extra_attrs_used--;
+
+    /* shrink after a burst of wrapped objects has gone away; if that fails,
+     * the table just stays bigger than it needs to be */
+    if (extra_attrs_size > EXTRA_ATTRS_MIN_SIZE
+        && extra_attrs_used * 8 < extra_attrs_size) {
+        extra_attrs_resize(extra_attrs_size / 2);
+    }
+
+    return signature;
+}
+
+long
+dbus_py_variant_level_get(PyObject *obj)
+{
+    ExtraAttrs *entry = extra_attrs_lookup(obj);
+
+    /* no entry is semantically equivalent to a variant level of 0 */
+    if (!entry)
+        return 0;
+    assert(entry->variant_level >= 0);
+    return entry->variant_level;
 }
 
 dbus_bool_t
 dbus_py_variant_level_set(PyObject *obj, long variant_level)
 {
-    /* key is the object's ID (= pointer) to avoid referencing it */
-    PyObject *key = PyLong_FromVoidPtr(obj);
-
-    if (!key) {
-        return FALSE;
-    }
+    ExtraAttrs *entry;
 
     if (variant_level <= 0) {
-        if (PyDict_GetItem (_dbus_py_variant_levels, key)) {
-            if (PyDict_DelItem (_dbus_py_variant_levels, key) < 0) {
-                Py_CLEAR(key);
-                return FALSE;
-            }
+        entry = extra_attrs_lookup(obj);
+        if (entry) {
+            entry->variant_level = 0;
+            if (!entry->signature)
+                extra_attrs_remove(entry);
         }
+        return TRUE;
     }
-    else {
-        PyObject *vl_obj = NATIVEINT_FROMLONG(variant_level);
-        if (!vl_obj) {
-            Py_CLEAR(key);
-            return FALSE;
-        }
-        if (PyDict_SetItem(_dbus_py_variant_levels, key, vl_obj) < 0) {
-            Py_CLEAR(vl_obj);
-            Py_CLEAR(key);
-            return FALSE;
-        }
-        Py_CLEAR(vl_obj);
+
+    entry = extra_attrs_insert(obj);
+    if (!entry)
+        return FALSE;
+    entry->variant_level = variant_level;
+    return TRUE;
+}
+
+PyObject *
+dbus_py_struct_signature_get(PyObject *obj)
+{
+    ExtraAttrs *entry = extra_attrs_lookup(obj);
+
+    return entry ? entry->signature : NULL;
+}
+
+dbus_bool_t
+dbus_py_struct_signature_set(PyObject *obj, PyObject *signature)
+{
+    ExtraAttrs *entry;
+    PyObject *old;
+
+    if (!signature || signature == Py_None) {
+        entry = extra_attrs_lookup(obj);
+        if (!entry)
+            return TRUE;
+        old = entry->signature;
+        entry->signature = NULL;
+        if (entry->variant_level == 0)
+            extra_attrs_remove(entry);
+        Py_CLEAR(old);
+        return TRUE;
     }
-    Py_CLEAR(key);
+
+    entry = extra_attrs_insert(obj);
+    if (!entry)
+        return FALSE;
+    old = entry->signature;
+    Py_INCREF(signature);
+    entry->signature = signature;
+    Py_CLEAR(old);
     return TRUE;
 }
 
 PyObject *
 dbus_py_variant_level_getattro(PyObject *obj, PyObject *name)
 {
-    PyObject *key, *value;
-
 #ifdef PY3
     if (PyUnicode_CompareWithASCIIString(name, "variant_level"))
         return PyObject_GenericGetAttr(obj, name);
 #else
+    PyObject *value;
+
     if (PyBytes_Check(name)) {
         Py_INCREF(name);
     }
@@ -138,35 +284,27 @@ dbus_py_variant_level_getattro(PyObject *obj, PyObject *name)
     Py_CLEAR(name);
 #endif  /* PY3 */
 
-    key = PyLong_FromVoidPtr(obj);
-
-    if (!key) {
-        return NULL;
-    }
-
-    value = PyDict_GetItem(_dbus_py_variant_levels, key);
-    Py_CLEAR(key);
-
-    if (!value)
-        return NATIVEINT_FROMLONG(0);
-    Py_INCREF(value);
-    return value;
+    return NATIVEINT_FROMLONG(dbus_py_variant_level_get(obj));
 }
 
-/* To be invoked by destructors. Clear the variant level without touching the
- * exception state */
+/* To be invoked by destructors. Clear the variant level and signature
+ * without touching the exception state */
 void
 dbus_py_variant_level_clear(PyObject *self)
 {
-    PyObject *et, *ev, *etb;
-
-    /* avoid clobbering any pending exception */
-    PyErr_Fetch(&et, &ev, &etb);
-    if (!dbus_py_variant_level_set(self, 0)) {
-        /* should never happen */
-        PyErr_WriteUnraisable(self);
+    ExtraAttrs *entry = extra_attrs_lookup(self);
+    PyObject *signature, *et, *ev, *etb;
+
+    if (!entry)
+        return;
+
+    signature = extra_attrs_remove(entry);
+    if (signature) {
+        /* avoid clobbering any pending exception */
+        PyErr_Fetch(&et, &ev, &etb);
+        Py_CLEAR(signature);
+        PyErr_Restore(et, ev, etb);
     }
-    PyErr_Restore(et, ev, etb);
 }
 
 #ifndef PY3
@@ -277,6 +415,20 @@ PyTypeObject DBusPyIntBase_Type = {
     DBusPythonInt_tp_new,                   /* tp_new */
     PyObject_Del,                           /* tp_free */
 };
+
+/* Construct an instance of cls, a subclass of _IntBase, without going
+ * through its tp_new: no argument parsing and no range checking. */
+PyObject *
+DBusPyIntBase_FromLong(PyTypeObject *cls, long value, long variant_level)
+{
+    PyObject *self = cls->tp_alloc(cls, 0);
+
+    if (self) {
+        ((PyIntObject *)self)->ob_ival = value;
+        ((DBusPyIntBase *)self)->variant_level = variant_level;
+    }
+    return self;
+}
 #endif  /* !PY3 */
 
 /* Support code for float subclasses. ================================ */
@@ -389,6 +541,21 @@ PyTypeObject DBusPyFloatBase_Type = {
     DBusPythonFloat_tp_new,                 /* tp_new */
 };
 
+/* Construct an instance of cls, a subclass of _FloatBase, without going
+ * through its tp_new. */
+PyObject *
+DBusPyFloatBase_FromDouble(PyTypeObject *cls, double value,
+                           long variant_level)
+{
+    PyObject *self = cls->tp_alloc(cls, 0);
+
+    if (self) {
+        ((PyFloatObject *)self)->ob_fval = value;
+        ((DBusPyFloatBase *)self)->variant_level = variant_level;
+    }
+    return self;
+}
+
 #ifdef PY3
 /* Support code for bytes subclasses ================================== */
 
@@ -636,6 +803,48 @@ PyTypeObject DBusPyStrBase_Type = {
     DBusPythonString_tp_new,                /* tp_new */
 };
 
+/* Construct an instance of cls, a subclass of _StrBase, from a
+ * nul-terminated string without going through its tp_new: in particular,
+ * the caller is responsible for any validation cls would normally do. */
+PyObject *
+DBusPyStrBase_FromString(PyTypeObject *cls, const char *str,
+                         long variant_level)
+{
+    PyObject *self;
+#ifdef PY3
+    /* Instances of str subclasses keep their characters in a separate
+     * buffer, described by state flags that differ between Python 3
+     * versions and are private to str's own tp_new, so that has to make
+     * the object. Only the argument parsing of cls's tp_new is skipped. */
+    PyObject *args;
+    PyObject *value = NATIVESTR_FROMSTR(str);
+
+    if (!value)
+        return NULL;
+    args = PyTuple_Pack(1, value);
+    Py_CLEAR(value);
+    if (!args)
+        return NULL;
+    self = (NATIVESTR_TYPE.tp_new)(cls, args, NULL);
+    Py_CLEAR(args);
+#else
+    /* Python 2's str layout is the same in every version this supports */
+    Py_ssize_t len = strlen(str);
+
+    /* as string_subtype_new() does: tp_alloc leaves room for the nul */
+    self = cls->tp_alloc(cls, len);
+    if (self) {
+        memcpy(((PyStringObject *)self)->ob_sval, str, len + 1);
+        ((PyStringObject *)self)->ob_shash = -1;
+    }
+#endif
+    if (self && variant_level > 0
+        && !dbus_py_variant_level_set(self, variant_level)) {
+        Py_CLEAR(self);
+    }
+    return self;
+}
+
 /* Support code for long subclasses ================================= */
 
 PyDoc_STRVAR(DBusPythonLong_tp_doc,\
@@ -758,6 +967,55 @@ PyTypeObject DBusPyLongBase_Type = {
     DBusPythonLong_tp_new,                  /* tp_new */
 };
 
+/* Construct an instance of cls, a subclass of _LongBase, with the same value
+ * as value, which must be exactly a long (as returned by PyLong_FromLong()
+ * and friends), without going through cls's tp_new: no argument parsing and
+ * no range checking. Steals a reference to value, and returns NULL without
+ * setting an exception if it is NULL, so that the result of those functions
+ * can be passed straight in. */
+PyObject *
+DBusPyLongBase_FromPyLong(PyTypeObject *cls, PyObject *value,
+                          long variant_level)
+{
+    PyObject *self;
+#if PY_VERSION_HEX < 0x030C0000
+    Py_ssize_t i, n;
+
+    if (!value)
+        return NULL;
+    /* as long_subtype_new() does: copy the digits into an instance of cls,
+     * always allocating at least one digit, which zero leaves as 0 */
+    n = Py_SIZE(value) < 0 ? -Py_SIZE(value) : Py_SIZE(value);
+    self = cls->tp_alloc(cls, n ? n : 1);
+    if (self) {
+        ((PyVarObject *)self)->ob_size = Py_SIZE(value);
+        for (i = 0; i < n; i++) {
+            ((PyLongObject *)self)->ob_digit[i] =
+                ((PyLongObject *)value)->ob_digit[i];
+        }
+    }
+    Py_CLEAR(value);
+#else
+    /* Python 3.12 keeps the sign and digit count in lv_tag rather than
+     * ob_size, so leave the copying to long's tp_new. */
+    PyObject *args;
+
+    if (!value)
+        return NULL;
+    args = PyTuple_Pack(1, value);
+    Py_CLEAR(value);
+    if (!args)
+        return NULL;
+    self = (PyLong_Type.tp_new)(cls, args, NULL);
+    Py_CLEAR(args);
+#endif
+    if (self && variant_level > 0
+        && !dbus_py_variant_level_set(self, variant_level)) {
+        Py_CLEAR(self);
+    }
+    return self;
+}
+
 PyObject *dbus_py_variant_level_const = NULL;
 PyObject *dbus_py_signature_const = NULL;
 PyObject *dbus_py__dbus_object_path__const = NULL;
@@ -774,9 +1032,6 @@ PyObject *dbus_py__dbus_object_path__const = NULL;
 dbus_bool_t
 dbus_py_init_abstract(void)
 {
-    _dbus_py_variant_levels = PyDict_New();
-    if (!_dbus_py_variant_levels) return 0;
-
     dbus_py__dbus_object_path__const = INTERN("__dbus_object_path__");
     if (!dbus_py__dbus_object_path__const) return 0;
 
@@ -268,6 +268,18 @@ PyTypeObject DBusPyByteArray_Type = {
         0,                                      /* tp_new */
 };
 
+/* Internal constructor, skipping Byte_new's argument parsing */
+PyObject *
+DBusPyByte_FromDBus(unsigned char value, long variant_level)
+{
+#ifdef PY3
+    return DBusPyLongBase_FromPyLong(&DBusPyByte_Type, PyLong_FromLong(value),
+                                     variant_level);
+#else
+    return DBusPyIntBase_FromLong(&DBusPyByte_Type, value, variant_level);
+#endif
+}
+
 dbus_bool_t
 dbus_py_init_byte_types(void)
 {
@@ -44,6 +44,13 @@ typedef struct {
     PyObject *weaklist;
 
     dbus_bool_t has_mainloop;
+    /* set up with NULL_MAIN_LOOP, so a dispatch thread may be started */
+    dbus_bool_t has_null_mainloop;
+    dbus_bool_t has_dispatch_thread;
+    /* the main loop it was set up with, or NULL */
+    PyObject *mainloop;
+    /* default for the native option when unpacking incoming messages */
+    dbus_bool_t native_args;
 } Connection;
 
 typedef struct {
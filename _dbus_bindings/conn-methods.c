@@ -24,9 +24,13 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "config.h"
+
 #include "dbus_bindings-internal.h"
 #include "conn-internal.h"
 
+#include <pythread.h>
+
 static void
 _object_path_unregister(DBusConnection *conn, void *user_data)
 {
@@ -71,7 +75,7 @@ _object_path_message(DBusConnection *conn, DBusMessage *message,
                      void *user_data)
 {
     DBusHandlerResult ret;
-    PyGILState_STATE gil = PyGILState_Ensure();
+    PyGILState_STATE gil = dbus_py_gil_ensure();
     Connection *conn_obj = NULL;
     PyObject *tuple = NULL;
     PyObject *msg_obj;
@@ -139,7 +143,7 @@ static DBusHandlerResult
 _filter_message(DBusConnection *conn, DBusMessage *message, void *user_data)
 {
     DBusHandlerResult ret;
-    PyGILState_STATE gil = PyGILState_Ensure();
+    PyGILState_STATE gil = dbus_py_gil_ensure();
     Connection *conn_obj = NULL;
     PyObject *callable = NULL;
     PyObject *msg_obj;
@@ -158,6 +162,8 @@ _filter_message(DBusConnection *conn, DBusMessage *message, void *user_data)
     conn_obj = (Connection *)DBusPyConnection_ExistingFromDBusConnection(conn);
     if (!conn_obj) {
         DBG("%s", "failed to traverse DBusConnection -> Connection weakref");
+        /* the Connection has gone away, so there is nobody to tell */
+        PyErr_Clear();
         ret = DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
         goto out;
     }
@@ -245,6 +251,94 @@ Connection_close (Connection *self, PyObject *args UNUSED)
     Py_RETURN_NONE;
 }
 
+#ifndef WITH_EPOLL_MAINLOOP
+/* Without epoll, the dispatch thread just calls
+ * dbus_connection_read_write(), then dispatches what it read in batches.
+ * That cannot be woken up, so messages sent by other threads while it
+ * waits on the socket are only written when it returns, hence the short
+ * timeout. With epoll, the thread runs a loop of its own, which is woken
+ * up. */
+#define DISPATCH_THREAD_POLL_MS 20
+
+static void
+_dispatch_thread_main(void *data)
+{
+    DBusConnection *conn = data;
+
+    /* without the GIL: dispatching takes it for each batch. This returns
+     * FALSE once the Disconnected message has been dispatched. */
+    while (dbus_connection_read_write(conn, DISPATCH_THREAD_POLL_MS))
+        dbus_py_dispatch_connection(conn);
+    dbus_connection_unref(conn);
+}
+#endif
+
+PyDoc_STRVAR(Connection_start_dispatch_thread__doc__,
+"start_dispatch_thread()\n\n"
+"Start a native thread that reads, writes and dispatches messages for\n"
+"this connection until it is closed, only taking the GIL to call Python\n"
+"filters and object handlers. This lets a program with no main loop\n"
+"receive signals, export objects and make asynchronous calls.\n"
+"\n"
+"The connection must have been created with\n"
+"``mainloop=dbus.mainloop.NULL_MAIN_LOOP``, or with no main loop at all.\n"
+"Handlers are called in the dispatch thread, so they must be thread-safe.\n"
+"\n"
+":Raises RuntimeError: if a dispatch thread was already started, or the\n"
+"    connection is attached to a main loop\n"
+":Since: 1.2.1\n");
+static PyObject *
+Connection_start_dispatch_thread(Connection *self, PyObject *args UNUSED)
+{
+#ifndef WITH_EPOLL_MAINLOOP
+    DBusConnection *conn;
+#endif
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (self->has_dispatch_thread) {
+        PyErr_SetString(PyExc_RuntimeError, "This connection already has "
+                        "a dispatch thread");
+        return NULL;
+    }
+    if (self->has_mainloop && !self->has_null_mainloop) {
+        /* the thread would take over the loop's watches and timeouts */
+        PyErr_SetString(PyExc_RuntimeError, "This connection is already "
+                        "attached to a main loop");
+        return NULL;
+    }
+    /* libdbus before 1.7 only makes connections thread-safe if this has
+     * been called; later versions do it themselves */
+    if (!dbus_threads_init_default()) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+#ifdef WITH_EPOLL_MAINLOOP
+    if (!dbus_py_epoll_start_dispatch_thread(self->conn))
+        return NULL;
+#else
+    /* the thread's reference, released when it finishes */
+    conn = dbus_connection_ref(self->conn);
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+    if (PyThread_start_new_thread(_dispatch_thread_main, conn)
+        == PYTHREAD_INVALID_THREAD_ID) {
+        Py_BEGIN_ALLOW_THREADS
+        dbus_connection_unref(conn);
+        Py_END_ALLOW_THREADS
+        PyErr_SetString(PyExc_RuntimeError, "Unable to start the dispatch "
+                        "thread");
+        return NULL;
+    }
+#endif
+    self->has_dispatch_thread = TRUE;
+    /* asynchronous calls, signals and objects now work */
+    self->has_mainloop = TRUE;
+    Py_RETURN_NONE;
+}
+
 PyDoc_STRVAR(Connection_get_is_connected__doc__,
 "get_is_connected() -> bool\n\n"
 "Return true if this Connection is connected.\n");
@@ -337,6 +431,79 @@ Connection_send_message(Connection *self, PyObject *args)
     return PyLong_FromUnsignedLong(serial);
 }
 
+PyDoc_STRVAR(Connection_send_messages__doc__,
+"send_messages(msgs) -> list of long\n\n"
+"Queue all the given messages for sending, in order, and return their\n"
+"serial numbers. This is equivalent to calling `send_message` for each\n"
+"one, but releases the GIL only once.\n"
+"\n"
+":Parameters:\n"
+"   `msgs` : sequence of dbus.lowlevel.Message\n"
+"       The messages to be sent.\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection_send_messages(Connection *self, PyObject *args)
+{
+    PyObject *obj, *seq, *ret = NULL;
+    Py_ssize_t n, i, sent = 0;
+    DBusMessage **msgs = NULL;
+    dbus_uint32_t *serials = NULL;
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!PyArg_ParseTuple(args, "O:send_messages", &obj)) return NULL;
+
+    seq = PySequence_Fast(obj, "Expected a sequence of messages");
+    if (!seq) return NULL;
+    n = PySequence_Fast_GET_SIZE(seq);
+
+    /* +1 so that neither is a zero-length allocation */
+    msgs = PyMem_New(DBusMessage *, n + 1);
+    serials = PyMem_New(dbus_uint32_t, n + 1);
+    if (!msgs || !serials) {
+        PyErr_NoMemory();
+        goto out;
+    }
+    for (i = 0; i < n; i++) {
+        /* borrowed from the messages, which seq keeps alive */
+        msgs[i] = DBusPyMessage_BorrowDBusMessage(
+                        PySequence_Fast_GET_ITEM(seq, i));
+        if (!msgs[i]) goto out;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    while (sent < n && dbus_connection_send(self->conn, msgs[sent],
+                                            &serials[sent])) {
+        sent++;
+    }
+    Py_END_ALLOW_THREADS
+
+    /* the messages before the one that failed have been queued anyway */
+    if (sent < n) {
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    ret = PyList_New(n);
+    if (!ret) goto out;
+    for (i = 0; i < n; i++) {
+        PyObject *serial = PyLong_FromUnsignedLong(serials[i]);
+
+        if (!serial) {
+            Py_CLEAR(ret);
+            goto out;
+        }
+        PyList_SET_ITEM(ret, i, serial);
+    }
+
+out:
+    PyMem_Free(msgs);
+    PyMem_Free(serials);
+    Py_CLEAR(seq);
+    return ret;
+}
+
 PyDoc_STRVAR(Connection_set_allow_anonymous__doc__,
 "set_allow_anonymous(bool)\n\n"
 "Allows anonymous clients. Call this on the server side of a connection in a on_connection_added callback"
@@ -508,6 +675,141 @@ Connection_send_message_with_reply_and_block(Connection *self, PyObject *args)
     return DBusPyMessage_ConsumeDBusMessage(reply);
 }
 
+PyDoc_STRVAR(Connection_send_messages_with_reply_and_block__doc__,
+"send_messages_with_reply_and_block(msgs, timeout_s=-1)"
+" -> list of dbus.lowlevel.Message\n\n"
+"Send all the messages, then block until each has a reply, and return\n"
+"the replies in the same order. The GIL is released for the whole time.\n"
+"\n"
+"Errors are not raised: the reply to a call that fails or times out is a\n"
+"`dbus.lowlevel.ErrorMessage`, possibly created locally. Like\n"
+"`send_message_with_reply_and_block`, this does not re-enter the main\n"
+"loop.\n"
+"\n"
+":Parameters:\n"
+"   `msgs` : sequence of dbus.lowlevel.MethodCallMessage\n"
+"       The messages to be sent\n"
+"   `timeout_s` : float\n"
+"       If a reply takes more than this many seconds, a timeout error\n"
+"       is created locally instead. If this timeout is negative\n"
+"       (default), a sane default (supplied by libdbus) is used.\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection_send_messages_with_reply_and_block(Connection *self,
+                                              PyObject *args)
+{
+    double timeout_s = -1.0;
+    int timeout_ms;
+    PyObject *obj, *seq, *ret = NULL;
+    Py_ssize_t n, i;
+    DBusMessage **msgs = NULL, **replies = NULL;
+    DBusPendingCall **pending = NULL;
+    dbus_bool_t ok = TRUE;
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!PyArg_ParseTuple(args, "O|d:send_messages_with_reply_and_block",
+                          &obj, &timeout_s)) {
+        return NULL;
+    }
+
+    if (timeout_s < 0) {
+        timeout_ms = -1;
+    }
+    else {
+        if (timeout_s > ((double)INT_MAX) / 1000.0) {
+            PyErr_SetString(PyExc_ValueError, "Timeout too long");
+            return NULL;
+        }
+        timeout_ms = (int)(timeout_s * 1000.0);
+    }
+
+    seq = PySequence_Fast(obj, "Expected a sequence of messages");
+    if (!seq) return NULL;
+    n = PySequence_Fast_GET_SIZE(seq);
+
+    /* +1 so that none of them is a zero-length allocation */
+    msgs = PyMem_New(DBusMessage *, n + 1);
+    replies = PyMem_New(DBusMessage *, n + 1);
+    pending = PyMem_New(DBusPendingCall *, n + 1);
+    if (!msgs || !replies || !pending) {
+        PyErr_NoMemory();
+        goto out;
+    }
+    for (i = 0; i < n; i++) {
+        /* borrowed from the messages, which seq keeps alive */
+        msgs[i] = DBusPyMessage_BorrowDBusMessage(
+                        PySequence_Fast_GET_ITEM(seq, i));
+        if (!msgs[i]) goto out;
+        replies[i] = NULL;
+        pending[i] = NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    /* Queue all the calls first: libdbus writes as much as it can without
+     * blocking, and blocking on the first pending call writes the rest
+     * while reading replies. The pending call is NULL if the connection
+     * has been closed. */
+    for (i = 0; i < n; i++) {
+        if (!dbus_connection_send_with_reply(self->conn, msgs[i],
+                                             &pending[i], timeout_ms)) {
+            ok = FALSE;
+            break;
+        }
+    }
+    for (i = 0; i < n; i++) {
+        if (!pending[i])
+            continue;
+        if (ok) {
+            dbus_pending_call_block(pending[i]);
+            replies[i] = dbus_pending_call_steal_reply(pending[i]);
+        }
+        else {
+            dbus_pending_call_cancel(pending[i]);
+        }
+        dbus_pending_call_unref(pending[i]);
+    }
+    for (i = 0; ok && i < n; i++) {
+        if (!replies[i]) {
+            replies[i] = dbus_message_new_error(msgs[i],
+                                                DBUS_ERROR_DISCONNECTED,
+                                                "Connection is closed");
+            if (!replies[i])
+                ok = FALSE;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (ok)
+        ret = PyList_New(n);
+    for (i = 0; i < n; i++) {
+        if (ret && replies[i]) {
+            PyObject *reply = DBusPyMessage_ConsumeDBusMessage(replies[i]);
+
+            if (!reply) {
+                Py_CLEAR(ret);
+                continue;
+            }
+            PyList_SET_ITEM(ret, i, reply);
+        }
+        else if (replies[i]) {
+            Py_BEGIN_ALLOW_THREADS
+            dbus_message_unref(replies[i]);
+            Py_END_ALLOW_THREADS
+        }
+    }
+    if (!ok)
+        PyErr_NoMemory();
+
+out:
+    PyMem_Free(msgs);
+    PyMem_Free(replies);
+    PyMem_Free(pending);
+    Py_CLEAR(seq);
+    return ret;
+}
+
 PyDoc_STRVAR(Connection_flush__doc__,
 "flush()\n\n"
 "Block until the outgoing message queue is empty.\n");
@@ -934,6 +1236,86 @@ Connection__unregister_object_path(Connection *self, PyObject *args,
     }
 }
 
+PyDoc_STRVAR(Connection__list_object_path_handlers__doc__,
+"_list_object_path_handlers() -> list of (str, callable, callable)\n\n"
+"Return (path, on_unregister, on_message) for each object-path handler\n"
+"registered with `_register_object_path`, in no particular order.\n");
+static PyObject *
+Connection__list_object_path_handlers(Connection *self,
+                                      PyObject *args UNUSED)
+{
+    PyObject *ret, *key, *callbacks;
+    Py_ssize_t pos = 0;
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    ret = PyList_New(0);
+    if (!ret) return NULL;
+    while (PyDict_Next(self->object_paths, &pos, &key, &callbacks)) {
+        PyObject *item;
+
+        /* None while a registration or unregistration is in progress */
+        if (!PyTuple_Check(callbacks))
+            continue;
+        item = Py_BuildValue("(NOO)",
+                             NATIVESTR_FROMSTR(PyBytes_AS_STRING(key)),
+                             PyTuple_GET_ITEM(callbacks, 0),
+                             PyTuple_GET_ITEM(callbacks, 1));
+        if (!item || PyList_Append(ret, item) < 0) {
+            Py_CLEAR(item);
+            Py_CLEAR(ret);
+            return NULL;
+        }
+        Py_CLEAR(item);
+    }
+    return ret;
+}
+
+PyDoc_STRVAR(Connection__get_main_loop__doc__,
+"_get_main_loop() -> dbus.mainloop.NativeMainLoop or None\n\n"
+"Return the main loop the connection was set up with, which may be\n"
+"`dbus.mainloop.NULL_MAIN_LOOP`, or None if it has none.\n");
+static PyObject *
+Connection__get_main_loop(Connection *self, PyObject *args UNUSED)
+{
+    TRACE(self);
+    if (!self->mainloop)
+        Py_RETURN_NONE;
+    Py_INCREF(self->mainloop);
+    return self->mainloop;
+}
+
+/* Return a borrowed reference to the _ObjectSubtree registered as the
+ * fallback handler for path or its nearest ancestor, or NULL if there is
+ * none, in which case an exception may be set. */
+static PyObject *
+_find_object_subtree(Connection *self, const char *path)
+{
+    size_t len = strlen(path);
+
+    for (;;) {
+        PyObject *key, *callbacks;
+
+        key = PyBytes_FromStringAndSize(path, (Py_ssize_t)len);
+        if (!key)
+            return NULL;
+        callbacks = PyDict_GetItem(self->object_paths, key);
+        Py_CLEAR(key);
+        /* callbacks is (on_unregister, on_message) */
+        if (callbacks && PyTuple_Check(callbacks)
+            && DBusPyObjectSubtree_Check(PyTuple_GET_ITEM(callbacks, 1))) {
+            return PyTuple_GET_ITEM(callbacks, 1);
+        }
+        if (len <= 1)
+            return NULL;
+        while (len > 0 && path[len - 1] != '/')
+            len--;
+        /* drop the trailing '/' too, except for the root */
+        if (len > 1)
+            len--;
+    }
+}
+
 PyDoc_STRVAR(Connection_list_exported_child_objects__doc__,
 "list_exported_child_objects(path: str) -> list of str\n\n"
 "Return a list of the names of objects exported on this Connection as\n"
@@ -943,7 +1325,10 @@ PyDoc_STRVAR(Connection_list_exported_child_objects__doc__,
 "``dbus.ObjectPath('%s%s%s' % (path, (path != '/' and '/' or ''), name))``.\n"
 "For the purposes of this function, every parent or ancestor of an exported\n"
 "object is considered to be an exported object, even if it's only an object\n"
-"synthesized by the library to support introspection.\n");
+"synthesized by the library to support introspection.\n"
+"\n"
+"Children of objects in a subtree registered with an `_ObjectSubtree`\n"
+"handler are included, whether or not they have been created yet.\n");
 static PyObject *
 Connection_list_exported_child_objects (Connection *self, PyObject *args,
                                         PyObject *kwargs)
@@ -951,7 +1336,8 @@ Connection_list_exported_child_objects (Connection *self, PyObject *args,
     const char *path;
     char **kids, **kid_ptr;
     dbus_bool_t ok;
-    PyObject *ret;
+    PyObject *ret, *subtree, *virtual_kids;
+    Py_ssize_t i, n;
     static char *argnames[] = {"path", NULL};
 
     DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
@@ -992,6 +1378,32 @@ Connection_list_exported_child_objects (Connection *self, PyObject *args,
 
     dbus_free_string_array(kids);
 
+    subtree = _find_object_subtree(self, path);
+    if (!subtree) {
+        if (PyErr_Occurred())
+            Py_CLEAR(ret);
+        return ret;
+    }
+    virtual_kids = dbus_py_object_subtree_children(subtree, path);
+    if (!virtual_kids) {
+        Py_CLEAR(ret);
+        return NULL;
+    }
+    /* objects in the subtree aren't registered with libdbus individually,
+     * but the application might have registered some other object there */
+    n = PyList_GET_SIZE(virtual_kids);
+    for (i = 0; i < n; i++) {
+        PyObject *kid = PyList_GET_ITEM(virtual_kids, i);
+        int contains = PySequence_Contains(ret, kid);
+
+        if (contains < 0 || (!contains && PyList_Append(ret, kid) < 0)) {
+            Py_CLEAR(virtual_kids);
+            Py_CLEAR(ret);
+            return NULL;
+        }
+    }
+    Py_CLEAR(virtual_kids);
+
     return ret;
 }
 
@@ -1046,9 +1458,14 @@ struct PyMethodDef DBusPyConnection_tp_methods[] = {
     ENTRY(_register_object_path, METH_VARARGS|METH_KEYWORDS),
     ENTRY(remove_message_filter, METH_O),
     ENTRY(send_message, METH_VARARGS),
+    ENTRY(send_messages, METH_VARARGS),
     ENTRY(send_message_with_reply, METH_VARARGS|METH_KEYWORDS),
     ENTRY(send_message_with_reply_and_block, METH_VARARGS),
+    ENTRY(send_messages_with_reply_and_block, METH_VARARGS),
+    ENTRY(start_dispatch_thread, METH_NOARGS),
     ENTRY(_unregister_object_path, METH_VARARGS|METH_KEYWORDS),
+    ENTRY(_list_object_path_handlers, METH_NOARGS),
+    ENTRY(_get_main_loop, METH_NOARGS),
     ENTRY(list_exported_child_objects, METH_VARARGS|METH_KEYWORDS),
     {"_new_for_bus", (PyCFunction)DBusPyConnection_NewForBus,
         METH_CLASS|METH_VARARGS|METH_KEYWORDS,
@@ -230,6 +230,11 @@ DBusPyConnection_NewConsumingDBusConnection(PyTypeObject *cls,
     DBG_WHEREAMI;
 
     self->has_mainloop = (mainloop != Py_None);
+    self->has_null_mainloop = (self->has_mainloop
+                               && dbus_py_is_null_main_loop(mainloop));
+    self->has_dispatch_thread = FALSE;
+    self->mainloop = NULL;
+    self->native_args = FALSE;
     self->conn = NULL;
     self->filters = PyList_New(0);
     self->weaklist = NULL;
@@ -270,6 +275,11 @@ DBusPyConnection_NewConsumingDBusConnection(PyTypeObject *cls,
         goto err;
     }
 
+    if (self->has_mainloop) {
+        /* steal the reference */
+        self->mainloop = mainloop;
+        mainloop = NULL;
+    }
     Py_CLEAR(mainloop);
 
     DBG("%s() -> %p", __func__, self);
@@ -399,6 +409,7 @@ static void Connection_tp_dealloc(Connection *self)
     Py_CLEAR(filters);
     self->object_paths = NULL;
     Py_CLEAR(object_paths);
+    Py_CLEAR(self->mainloop);
 
     if (conn) {
         /* Might trigger callbacks if we're unlucky... */
@@ -426,6 +437,41 @@ static void Connection_tp_dealloc(Connection *self)
     (Py_TYPE(self)->tp_free)((PyObject *)self);
 }
 
+static PyObject *
+Connection_get_native_args(Connection *self, void *closure UNUSED)
+{
+    return PyBool_FromLong(self->native_args);
+}
+
+static int
+Connection_set_native_args(Connection *self, PyObject *value,
+                           void *closure UNUSED)
+{
+    int native;
+
+    if (!value) {
+        PyErr_SetString(PyExc_TypeError, "native_args cannot be deleted");
+        return -1;
+    }
+    native = PyObject_IsTrue(value);
+    if (native < 0) return -1;
+    self->native_args = native;
+    return 0;
+}
+
+static PyGetSetDef Connection_tp_getset[] = {
+    {"native_args", (getter)Connection_get_native_args,
+     (setter)Connection_set_native_args,
+     "If true, the arguments of incoming signals and method calls and of\n"
+     "method replies are unpacked as builtin Python types, as if by\n"
+     "Message.get_args_list(native=True), for handlers and calls that do\n"
+     "not say otherwise. The default is False.\n"
+     "\n"
+     ":Since: 1.2.1\n",
+     NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
 /* Connection type object =========================================== */
 
 PyTypeObject DBusPyConnection_Type = {
@@ -463,7 +509,7 @@ PyTypeObject DBusPyConnection_Type = {
     0,                      /*tp_iternext*/
     DBusPyConnection_tp_methods,  /*tp_methods*/
     0,                      /*tp_members*/
-    0,                      /*tp_getset*/
+    Connection_tp_getset,   /*tp_getset*/
     0,                      /*tp_base*/
     0,                      /*tp_dict*/
     0,                      /*tp_descr_get*/
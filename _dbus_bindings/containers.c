@@ -520,8 +520,6 @@ PyTypeObject DBusPyDict_Type = {
 
 /* Struct =========================================================== */
 
-static PyObject *struct_signatures;
-
 PyDoc_STRVAR(Struct_tp_doc,
 "An structure containing items of possibly distinct types.\n"
 "\n"
@@ -555,15 +553,11 @@ Struct_tp_repr(PyObject *self)
     PyObject *parent_repr = (PyTuple_Type.tp_repr)((PyObject *)self);
     PyObject *sig;
     PyObject *sig_repr = NULL;
-    PyObject *key;
     long variant_level;
     PyObject *my_repr = NULL;
 
     if (!parent_repr) goto finally;
-    key = PyLong_FromVoidPtr(self);
-    if (!key) goto finally;
-    sig = PyDict_GetItem(struct_signatures, key);
-    Py_CLEAR(key);
+    sig = dbus_py_struct_signature_get(self);
     if (!sig) sig = Py_None;
     sig_repr = PyObject_Repr(sig);
     if (!sig_repr) goto finally;
@@ -598,7 +592,7 @@ Struct_tp_new (PyTypeObject *cls, PyObject *args, PyObject *kwargs)
 {
     PyObject *signature = NULL;
     long variantness = 0;
-    PyObject *self, *key;
+    PyObject *self;
     static char *argnames[] = {"signature", "variant_level", NULL};
 
     if (PyTuple_Size(args) != 1) {
@@ -647,20 +641,12 @@ Struct_tp_new (PyTypeObject *cls, PyObject *args, PyObject *kwargs)
         }
     }
 
-    key = PyLong_FromVoidPtr(self);
-    if (!key) {
-        Py_CLEAR(self);
-        Py_CLEAR(signature);
-        return NULL;
-    }
-    if (PyDict_SetItem(struct_signatures, key, signature) < 0) {
-        Py_CLEAR(key);
+    if (!dbus_py_struct_signature_set(self, signature)) {
         Py_CLEAR(self);
         Py_CLEAR(signature);
         return NULL;
     }
 
-    Py_CLEAR(key);
     Py_CLEAR(signature);
     return self;
 }
@@ -668,35 +654,15 @@ Struct_tp_new (PyTypeObject *cls, PyObject *args, PyObject *kwargs)
 static void
 Struct_tp_dealloc(PyObject *self)
 {
-    PyObject *et, *ev, *etb, *key;
-
+    /* also releases the signature */
     dbus_py_variant_level_clear(self);
-    PyErr_Fetch(&et, &ev, &etb);
-
-    key = PyLong_FromVoidPtr(self);
-    if (key) {
-        if (PyDict_GetItem(struct_signatures, key)) {
-            if (PyDict_DelItem(struct_signatures, key) < 0) {
-                /* should never happen */
-                PyErr_WriteUnraisable(self);
-            }
-        }
-        Py_CLEAR(key);
-    }
-    else {
-        /* not enough memory to free all the memory... leak the signature,
-         * there's not much else we could do here */
-        PyErr_WriteUnraisable(self);
-    }
-
-    PyErr_Restore(et, ev, etb);
     (PyTuple_Type.tp_dealloc)(self);
 }
 
 static PyObject *
 Struct_tp_getattro(PyObject *obj, PyObject *name)
 {
-    PyObject *key, *value;
+    PyObject *value;
 
 #ifdef PY3
     if (PyUnicode_CompareWithASCIIString(name, "signature"))
@@ -724,14 +690,7 @@ Struct_tp_getattro(PyObject *obj, PyObject *name)
     Py_CLEAR(name);
 #endif  /* PY3 */
 
-    key = PyLong_FromVoidPtr(obj);
-
-    if (!key) {
-        return NULL;
-    }
-
-    value = PyDict_GetItem(struct_signatures, key);
-    Py_CLEAR(key);
+    value = dbus_py_struct_signature_get(obj);
 
     if (!value)
         value = Py_None;
@@ -783,9 +742,6 @@ PyTypeObject DBusPyStruct_Type = {
 dbus_bool_t
 dbus_py_init_container_types(void)
 {
-    struct_signatures = PyDict_New();
-    if (!struct_signatures) return 0;
-
     DBusPyArray_Type.tp_base = &PyList_Type;
     if (PyType_Ready(&DBusPyArray_Type) < 0) return 0;
     DBusPyArray_Type.tp_print = NULL;
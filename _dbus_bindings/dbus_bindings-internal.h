@@ -29,6 +29,13 @@
 #define PY_SSIZE_T_CLEAN 1
 
 #include <Python.h>
+#include <pythread.h>
+
+/* returned by PyThread_start_new_thread() on failure; before Python 3.7
+ * that function returns a long and only documents it as -1 */
+#ifndef PYTHREAD_INVALID_THREAD_ID
+#   define PYTHREAD_INVALID_THREAD_ID (-1L)
+#endif
 
 #define INSIDE_DBUS_PYTHON_BINDINGS
 #include "dbus-python.h"
@@ -113,6 +120,19 @@ PyObject *DBusPyLibDBusConnection_New(DBusConnection *conn);
 extern dbus_bool_t dbus_py_init_libdbus_conn_types(void);
 extern dbus_bool_t dbus_py_insert_libdbus_conn_types(PyObject *this_module);
 
+/* method-dispatch.c */
+extern PyTypeObject DBusPyMethodDispatcher_Type;
+extern dbus_bool_t dbus_py_init_method_dispatch_types(void);
+extern dbus_bool_t dbus_py_insert_method_dispatch_types(PyObject *this_module);
+
+/* object-subtree.c */
+extern PyTypeObject DBusPyObjectSubtree_Type;
+DEFINE_CHECK(DBusPyObjectSubtree)
+PyObject *dbus_py_object_subtree_children(PyObject *subtree,
+                                          const char *path);
+extern dbus_bool_t dbus_py_init_object_subtree_types(void);
+extern dbus_bool_t dbus_py_insert_object_subtree_types(PyObject *this_module);
+
 /* bus.c */
 extern dbus_bool_t dbus_py_init_bus_types(void);
 extern dbus_bool_t dbus_py_insert_bus_types(PyObject *this_module);
@@ -155,6 +175,28 @@ DEFINE_CHECK(DBusPyUnixFd)
 extern PyTypeObject DBusPyInt64_Type, DBusPyUInt64_Type;
 DEFINE_CHECK(DBusPyInt64)
 DEFINE_CHECK(DBusPyUInt64)
+/* Construct types from values already validated by libdbus, without
+ * argument parsing */
+extern PyObject *DBusPyBoolean_FromDBus(dbus_bool_t, long variant_level);
+extern PyObject *DBusPyByte_FromDBus(unsigned char, long variant_level);
+extern PyObject *DBusPyInt16_FromDBus(dbus_int16_t, long variant_level);
+extern PyObject *DBusPyUInt16_FromDBus(dbus_uint16_t, long variant_level);
+extern PyObject *DBusPyInt32_FromDBus(dbus_int32_t, long variant_level);
+extern PyObject *DBusPyUInt32_FromDBus(dbus_uint32_t, long variant_level);
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+extern PyObject *DBusPyInt64_FromDBus(dbus_int64_t, long variant_level);
+extern PyObject *DBusPyUInt64_FromDBus(dbus_uint64_t, long variant_level);
+#endif
+extern PyObject *DBusPyDouble_FromDBus(double, long variant_level);
+#ifdef WITH_DBUS_FLOAT32
+extern PyObject *DBusPyFloat_FromDBus(float, long variant_level);
+#endif
+extern PyObject *DBusPyString_FromDBus(const char *, long variant_level);
+#ifndef PY3
+extern PyObject *DBusPyUTF8String_FromDBus(const char *, long variant_level);
+#endif
+extern PyObject *DBusPyObjectPath_FromDBus(const char *, long variant_level);
+extern PyObject *DBusPySignature_FromDBus(const char *, long variant_level);
 extern dbus_bool_t dbus_py_init_abstract(void);
 extern dbus_bool_t dbus_py_init_signature(void);
 extern dbus_bool_t dbus_py_init_int_types(void);
@@ -175,11 +217,44 @@ extern dbus_bool_t dbus_py_insert_byte_types(PyObject *this_module);
 int dbus_py_unix_fd_get_fd(PyObject *self);
 
 /* generic */
+typedef struct {
+    unsigned long gil_acquisitions;
+    unsigned long batches;
+    unsigned long messages;
+} DBusPyDispatchStats;
+
+extern unsigned int dbus_py_dispatch_batch_size;
+extern DBusPyDispatchStats dbus_py_dispatch_stats;
+extern PyGILState_STATE dbus_py_gil_ensure(void);
+extern void dbus_py_dispatch_connection(DBusConnection *);
 extern void dbus_py_take_gil_and_xdecref(PyObject *);
 extern int dbus_py_immutable_setattro(PyObject *, PyObject *, PyObject *);
 extern PyObject *dbus_py_empty_tuple;
 extern dbus_bool_t dbus_py_init_generic(void);
 
+/* intern.c */
+typedef enum {
+    DBUS_PY_INTERN_NATIVESTR,
+    /* the same thing as a native str on Python 3 */
+#ifdef PY3
+    DBUS_PY_INTERN_UNICODE = DBUS_PY_INTERN_NATIVESTR,
+#else
+    DBUS_PY_INTERN_UNICODE,
+#endif
+    DBUS_PY_INTERN_STRING,          /* dbus.String, variant_level 0 */
+    DBUS_PY_INTERN_OBJECT_PATH,     /* dbus.ObjectPath, variant_level 0 */
+    DBUS_PY_INTERN_SIGNATURE        /* dbus.Signature, variant_level 0 */
+} DBusPyInternKind;
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+} DBusPyInternStats;
+
+extern DBusPyInternStats dbus_py_intern_stats;
+extern PyObject *dbus_py_intern(DBusPyInternKind kind, const char *str);
+extern unsigned long dbus_py_intern_count(void);
+
 /* message.c */
 extern DBusMessage *DBusPyMessage_BorrowDBusMessage(PyObject *msg);
 extern PyObject *DBusPyMessage_ConsumeDBusMessage(DBusMessage *);
@@ -193,15 +268,45 @@ extern dbus_bool_t dbus_py_init_pending_call(void);
 extern dbus_bool_t dbus_py_insert_pending_call(PyObject *this_module);
 
 /* mainloop.c */
+typedef struct {
+    PyObject_HEAD
+    /* Called with the GIL held, should set a Python exception on error */
+    dbus_bool_t (*set_up_connection_cb)(DBusConnection *, void *);
+    dbus_bool_t (*set_up_server_cb)(DBusServer *, void *);
+    /* Called in a destructor. Must not touch the exception state (use
+     * PyErr_Fetch and PyErr_Restore if necessary). */
+    void (*free_cb)(void *);
+    void *data;
+} NativeMainLoop;
+extern PyTypeObject DBusPyNativeMainLoop_Type;
+DEFINE_CHECK(DBusPyNativeMainLoop)
+extern void dbus_py_native_main_loop_init(NativeMainLoop *,
+        dbus_bool_t (*)(DBusConnection *, void *),
+        dbus_bool_t (*)(DBusServer *, void *),
+        void (*)(void *),
+        void *);
 extern dbus_bool_t dbus_py_set_up_connection(PyObject *conn,
                                              PyObject *mainloop);
 extern dbus_bool_t dbus_py_set_up_server(PyObject *server,
                                          PyObject *mainloop);
 extern PyObject *dbus_py_get_default_main_loop(void);
+extern dbus_bool_t dbus_py_set_default_main_loop(PyObject *);
 extern dbus_bool_t dbus_py_check_mainloop_sanity(PyObject *);
+extern dbus_bool_t dbus_py_is_null_main_loop(PyObject *);
 extern dbus_bool_t dbus_py_init_mainloop(void);
 extern dbus_bool_t dbus_py_insert_mainloop_types(PyObject *);
 
+/* mainloop-epoll.c */
+#ifdef WITH_EPOLL_MAINLOOP
+extern dbus_bool_t dbus_py_init_epoll_mainloop(void);
+extern dbus_bool_t dbus_py_insert_epoll_mainloop(PyObject *);
+extern dbus_bool_t dbus_py_epoll_start_dispatch_thread(DBusConnection *);
+#endif
+
+/* mainloop-python.c */
+extern dbus_bool_t dbus_py_init_python_mainloop(void);
+extern dbus_bool_t dbus_py_insert_python_mainloop(PyObject *);
+
 /* server.c */
 extern PyTypeObject DBusPyServer_Type;
 DEFINE_CHECK(DBusPyServer)
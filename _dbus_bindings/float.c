@@ -122,6 +122,24 @@ PyTypeObject DBusPyFloat_Type = {
 };
 #endif /* defined(WITH_DBUS_FLOAT32) */
 
+/* Internal constructors, skipping tp_new's argument parsing */
+
+PyObject *
+DBusPyDouble_FromDBus(double value, long variant_level)
+{
+    return DBusPyFloatBase_FromDouble(&DBusPyDouble_Type, value,
+                                      variant_level);
+}
+
+#ifdef WITH_DBUS_FLOAT32
+PyObject *
+DBusPyFloat_FromDBus(float value, long variant_level)
+{
+    return DBusPyFloatBase_FromDouble(&DBusPyFloat_Type, value,
+                                      variant_level);
+}
+#endif
+
 dbus_bool_t
 dbus_py_init_float_types(void)
 {
@@ -50,6 +50,63 @@ dbus_py_take_gil_and_xdecref(PyObject *obj)
     PyGILState_Release(gil);
 }
 
+/* How many messages the native main loops dispatch per GIL acquisition;
+ * 0 to let each handler take the GIL itself */
+unsigned int dbus_py_dispatch_batch_size = 64;
+
+/* Only updated with the GIL held */
+DBusPyDispatchStats dbus_py_dispatch_stats = { 0, 0, 0 };
+
+/* PyGILState_Ensure() for the callbacks that run handlers, counting how
+ * often it actually has to take the GIL, rather than finding that the
+ * dispatching thread already holds it. */
+PyGILState_STATE
+dbus_py_gil_ensure(void)
+{
+#if PY_VERSION_HEX >= 0x03040000
+    dbus_bool_t held = PyGILState_Check();
+    PyGILState_STATE gil = PyGILState_Ensure();
+
+    if (!held)
+        dbus_py_dispatch_stats.gil_acquisitions++;
+#else
+    PyGILState_STATE gil = PyGILState_Ensure();
+
+    dbus_py_dispatch_stats.gil_acquisitions++;
+#endif
+    return gil;
+}
+
+/* Dispatch conn's messages, without the GIL. Rather than having every
+ * handler take the GIL for each message, take it once for each batch of
+ * dbus_py_dispatch_batch_size messages, releasing it in between so that
+ * other threads get a turn. This is only safe for connections whose
+ * watch and timeout functions, which libdbus calls with the connection
+ * locked, never need the GIL: those of the epoll loop, or none. */
+void
+dbus_py_dispatch_connection(DBusConnection *conn)
+{
+    unsigned int batch_size = dbus_py_dispatch_batch_size;
+    DBusDispatchStatus status;
+
+    if (!batch_size) {
+        while (dbus_connection_dispatch(conn) == DBUS_DISPATCH_DATA_REMAINS);
+        return;
+    }
+    do {
+        PyGILState_STATE gil = dbus_py_gil_ensure();
+        unsigned int n = 0;
+
+        do {
+            status = dbus_connection_dispatch(conn);
+            n++;
+        } while (status == DBUS_DISPATCH_DATA_REMAINS && n < batch_size);
+        dbus_py_dispatch_stats.batches++;
+        dbus_py_dispatch_stats.messages += n;
+        PyGILState_Release(gil);
+    } while (status == DBUS_DISPATCH_DATA_REMAINS);
+}
+
 dbus_bool_t
 dbus_py_init_generic(void)
 {
@@ -732,6 +732,70 @@ PyTypeObject DBusPyUInt64_Type = {
     UInt64_tp_new,                          /* tp_new */
 };
 
+/* Internal constructors ============================================ */
+
+/* These skip the argument parsing and range checking done by tp_new, since
+ * the value is known to be in range. */
+
+#ifdef PY3
+#define INTBASE_FROMLONG(cls, value, variant_level) \
+    DBusPyLongBase_FromPyLong(cls, PyLong_FromLong(value), variant_level)
+#else
+#define INTBASE_FROMLONG(cls, value, variant_level) \
+    DBusPyIntBase_FromLong(cls, value, variant_level)
+#endif
+
+PyObject *
+DBusPyBoolean_FromDBus(dbus_bool_t value, long variant_level)
+{
+    return INTBASE_FROMLONG(&DBusPyBoolean_Type, value ? 1 : 0,
+                            variant_level);
+}
+
+PyObject *
+DBusPyInt16_FromDBus(dbus_int16_t value, long variant_level)
+{
+    return INTBASE_FROMLONG(&DBusPyInt16_Type, value, variant_level);
+}
+
+PyObject *
+DBusPyUInt16_FromDBus(dbus_uint16_t value, long variant_level)
+{
+    return INTBASE_FROMLONG(&DBusPyUInt16_Type, value, variant_level);
+}
+
+PyObject *
+DBusPyInt32_FromDBus(dbus_int32_t value, long variant_level)
+{
+    return INTBASE_FROMLONG(&DBusPyInt32_Type, value, variant_level);
+}
+
+PyObject *
+DBusPyUInt32_FromDBus(dbus_uint32_t value, long variant_level)
+{
+    return DBusPyLongBase_FromPyLong(&DBusPyUInt32_Type,
+                                     PyLong_FromUnsignedLong(value),
+                                     variant_level);
+}
+
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+PyObject *
+DBusPyInt64_FromDBus(dbus_int64_t value, long variant_level)
+{
+    return DBusPyLongBase_FromPyLong(&DBusPyInt64_Type,
+                                     PyLong_FromLongLong(value),
+                                     variant_level);
+}
+
+PyObject *
+DBusPyUInt64_FromDBus(dbus_uint64_t value, long variant_level)
+{
+    return DBusPyLongBase_FromPyLong(&DBusPyUInt64_Type,
+                                     PyLong_FromUnsignedLongLong(value),
+                                     variant_level);
+}
+#endif
+
 dbus_bool_t
 dbus_py_init_int_types(void)
 {
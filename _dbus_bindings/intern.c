@@ -0,0 +1,147 @@
+/* A bounded table of shared Python strings for names that recur on the bus.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "dbus_bindings-internal.h"
+
+/* Interface and member names, object paths, unique names, signatures and
+ * the keys of a{sv} dicts are drawn from a vocabulary of a few hundred
+ * strings on any given bus, so rather than decoding them afresh for every
+ * message, the objects are kept in a direct-mapped table keyed by their
+ * UTF-8 and kind. A colliding string simply replaces the previous occupant
+ * of its slot, which bounds the memory used however many distinct names go
+ * past.
+ *
+ * The strings are deliberately not passed to PyUnicode_InternInPlace(): they
+ * come from other processes, and some versions of Python never free
+ * interned strings.
+ *
+ * Only used with the GIL held.
+ */
+
+#define INTERN_TABLE_SIZE 1024      /* must be a power of 2 */
+#define INTERN_MAX_LEN 255          /* longer strings are not cached */
+
+typedef struct {
+    PyObject *obj;          /* owned, or NULL if the slot is free */
+    char *str;              /* PyMem_Malloc'd copy of the UTF-8 */
+    size_t len;
+    size_t hash;
+    DBusPyInternKind kind;
+} InternEntry;
+
+static InternEntry intern_table[INTERN_TABLE_SIZE];
+
+DBusPyInternStats dbus_py_intern_stats = { 0, 0 };
+
+static PyObject *
+intern_new(DBusPyInternKind kind, const char *str, size_t len)
+{
+    switch (kind) {
+        case DBUS_PY_INTERN_STRING:
+            return DBusPyString_FromDBus(str, 0);
+        case DBUS_PY_INTERN_OBJECT_PATH:
+            return DBusPyObjectPath_FromDBus(str, 0);
+        case DBUS_PY_INTERN_SIGNATURE:
+            return DBusPySignature_FromDBus(str, 0);
+#ifndef PY3
+        case DBUS_PY_INTERN_UNICODE:
+            return PyUnicode_DecodeUTF8(str, len, NULL);
+#endif
+        default:
+            (void)len;
+            return NATIVESTR_FROMSTR(str);
+    }
+}
+
+/* Return a new reference to an object of the given kind whose value is
+ * the (already validated) UTF-8 string str, shared with previous callers
+ * asking for the same string if possible. */
+PyObject *
+dbus_py_intern(DBusPyInternKind kind, const char *str)
+{
+    const unsigned char *p;
+    size_t hash = 2166136261U ^ (size_t)kind;
+    size_t len;
+    InternEntry *entry;
+    PyObject *obj, *old;
+    char *copy;
+
+    /* FNV-1a */
+    for (p = (const unsigned char *)str; *p; p++) {
+        if (p - (const unsigned char *)str >= INTERN_MAX_LEN) {
+            dbus_py_intern_stats.misses++;
+            return intern_new(kind, str, strlen(str));
+        }
+        hash = (hash ^ *p) * 16777619U;
+    }
+    len = p - (const unsigned char *)str;
+
+    entry = &intern_table[hash & (INTERN_TABLE_SIZE - 1)];
+    if (entry->obj && entry->hash == hash && entry->kind == kind
+        && entry->len == len && memcmp(entry->str, str, len) == 0) {
+        dbus_py_intern_stats.hits++;
+        Py_INCREF(entry->obj);
+        return entry->obj;
+    }
+
+    dbus_py_intern_stats.misses++;
+    obj = intern_new(kind, str, len);
+    if (!obj)
+        return NULL;
+
+    /* if this fails, the old entry is still intact: just don't cache */
+    copy = PyMem_Realloc(entry->str, len + 1);
+    if (!copy)
+        return obj;
+    memcpy(copy, str, len + 1);
+
+    old = entry->obj;
+    Py_INCREF(obj);
+    entry->obj = obj;
+    entry->str = copy;
+    entry->len = len;
+    entry->hash = hash;
+    entry->kind = kind;
+    Py_XDECREF(old);
+    return obj;
+}
+
+/* Return the number of strings currently held in the table. */
+unsigned long
+dbus_py_intern_count(void)
+{
+    unsigned long n = 0;
+    size_t i;
+
+    for (i = 0; i < INTERN_TABLE_SIZE; i++) {
+        if (intern_table[i].obj)
+            n++;
+    }
+    return n;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -0,0 +1,1205 @@
+/* A main loop for dbus-python using Linux epoll, without GLib.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#ifdef WITH_EPOLL_MAINLOOP
+
+#include "dbus_bindings-internal.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pythread.h>
+
+/* The state of a DBusEpollMainLoop lives outside the Python object, with
+ * its own reference count, because libdbus keeps a reference (as the data
+ * of the watch, timeout and dispatch functions) for each connection and
+ * server set up with it, and drops them from whichever thread finalizes
+ * those, without the GIL.
+ *
+ * DBusWatches are registered with epoll per file descriptor, since libdbus
+ * usually has separate read and write watches on one socket. DBusTimeouts
+ * with an interval are kept in a binary heap ordered by deadline, and
+ * connections with incoming messages in a queue. run() releases the GIL
+ * for the whole loop: the Python handlers called by dbus_connection_dispatch
+ * take it back themselves, as do the callables queued by call_later(),
+ * which run after the dispatching in each iteration.
+ *
+ * loop->lock protects the structures below, and is never held while
+ * calling into libdbus, which calls the watch and timeout functions with
+ * its own connection lock held. Watches, timeouts and file descriptor
+ * records that the loop thread is about to handle are marked, and freed by
+ * the loop thread if libdbus removes them meanwhile.
+ */
+
+typedef struct _EpollFd EpollFd;
+typedef struct _EpollWatch EpollWatch;
+
+struct _EpollWatch {
+    DBusWatch *watch;       /* NULL once libdbus has removed it */
+    EpollFd *fd;
+    EpollWatch *next;       /* in fd->watches */
+    unsigned int flags;     /* DBUS_WATCH_READABLE etc., or 0 if disabled */
+    dbus_bool_t pending;    /* about to be handled by the loop thread */
+};
+
+struct _EpollFd {
+    int fd;
+    uint32_t events;        /* registered with epoll, or 0 if not */
+    EpollWatch *watches;
+    EpollFd *next;          /* in loop->fds or loop->dead_fds */
+};
+
+typedef struct {
+    DBusTimeout *timeout;   /* NULL once libdbus has removed it */
+    long long deadline;     /* in milliseconds on CLOCK_MONOTONIC */
+    size_t index;           /* in loop->heap, or NOT_IN_HEAP if disabled */
+    dbus_bool_t pending;    /* about to be handled by the loop thread */
+} EpollTimeout;
+
+#define NOT_IN_HEAP ((size_t)-1)
+
+typedef struct _EpollCall EpollCall;
+
+struct _EpollCall {
+    long long deadline;     /* in milliseconds on CLOCK_MONOTONIC */
+    PyObject *callable;     /* owned */
+    EpollCall *next;        /* in loop->calls */
+};
+
+/* per iteration; epoll is level-triggered, so anything beyond these is
+ * picked up by the next one */
+#define MAX_EVENTS 32
+#define MAX_READY 64
+
+typedef struct {
+    PyThread_type_lock lock;
+    int refcount;
+    int epfd;
+    int wakeup_fd;          /* an eventfd, registered with a NULL pointer */
+    dbus_bool_t running;
+    dbus_bool_t quit;
+    unsigned long owner;    /* the thread in run(); PyThread_get_thread_ident()
+                             * returns a long before Python 3.7 */
+    /* set by the loop thread while it might have pointers to EpollFds
+     * from epoll_wait(), which are then moved to dead_fds, not freed */
+    dbus_bool_t iterating;
+    EpollFd *fds;
+    EpollFd *dead_fds;
+    EpollTimeout **heap;
+    size_t n_heap, heap_size;
+    /* connections whose dispatch status is DATA_REMAINS, each with a ref */
+    DBusConnection **dispatch;
+    size_t n_dispatch, dispatch_size;
+    /* from call_later(), in order of deadline */
+    EpollCall *calls;
+} EpollLoop;
+
+#define LOCK(loop) PyThread_acquire_lock((loop)->lock, WAIT_LOCK)
+#define UNLOCK(loop) PyThread_release_lock((loop)->lock)
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Loop lifetime ==================================================== */
+
+static void
+epoll_loop_unref(void *data)
+{
+    EpollLoop *loop = data;
+    EpollFd *fd;
+    int refcount;
+
+    LOCK(loop);
+    refcount = --loop->refcount;
+    UNLOCK(loop);
+    if (refcount > 0)
+        return;
+
+    /* every connection and server has let go of it, so there are no
+     * watches, timeouts or queued connections left */
+    while (loop->dead_fds) {
+        fd = loop->dead_fds;
+        loop->dead_fds = fd->next;
+        free(fd);
+    }
+    if (loop->calls) {
+        /* the last reference may be dropped without the GIL */
+        PyGILState_STATE gil = PyGILState_Ensure();
+
+        while (loop->calls) {
+            EpollCall *call = loop->calls;
+
+            loop->calls = call->next;
+            Py_CLEAR(call->callable);
+            free(call);
+        }
+        PyGILState_Release(gil);
+    }
+    free(loop->heap);
+    free(loop->dispatch);
+    close(loop->wakeup_fd);
+    close(loop->epfd);
+    PyThread_free_lock(loop->lock);
+    free(loop);
+}
+
+static EpollLoop *
+epoll_loop_ref(EpollLoop *loop)
+{
+    LOCK(loop);
+    loop->refcount++;
+    UNLOCK(loop);
+    return loop;
+}
+
+/* Returns a new loop, or NULL with an exception set. */
+static EpollLoop *
+epoll_loop_new(void)
+{
+    struct epoll_event ev;
+    EpollLoop *loop = calloc(1, sizeof(EpollLoop));
+
+    if (!loop) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    loop->refcount = 1;
+    loop->epfd = loop->wakeup_fd = -1;
+
+    loop->lock = PyThread_allocate_lock();
+    if (!loop->lock) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epfd < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        goto error;
+    }
+    loop->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (loop->wakeup_fd < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        goto error;
+    }
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wakeup_fd, &ev) < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        goto error;
+    }
+    return loop;
+
+error:
+    if (loop->wakeup_fd >= 0)
+        close(loop->wakeup_fd);
+    if (loop->epfd >= 0)
+        close(loop->epfd);
+    if (loop->lock)
+        PyThread_free_lock(loop->lock);
+    free(loop);
+    return NULL;
+}
+
+/* Wake up epoll_wait() if the loop is running in another thread, so that
+ * it notices a change. Called with the lock held. */
+static void
+epoll_loop_wake(EpollLoop *loop)
+{
+    uint64_t one = 1;
+
+    if (loop->running
+        && loop->owner != (unsigned long)PyThread_get_thread_ident()) {
+        /* if this fails, the counter is already non-zero */
+        if (write(loop->wakeup_fd, &one, sizeof(one)) < 0) {}
+    }
+}
+
+/* Watches ========================================================== */
+
+/* Make the epoll registration for fd match its enabled watches. Called
+ * with the lock held. */
+static int
+epoll_fd_update(EpollLoop *loop, EpollFd *fd)
+{
+    struct epoll_event ev;
+    EpollWatch *w;
+    unsigned int flags = 0;
+    int op;
+
+    for (w = fd->watches; w; w = w->next)
+        flags |= w->flags;
+
+    ev.events = 0;
+    if (flags & DBUS_WATCH_READABLE)
+        ev.events |= EPOLLIN;
+    if (flags & DBUS_WATCH_WRITABLE)
+        ev.events |= EPOLLOUT;
+    ev.data.ptr = fd;
+
+    if (ev.events == fd->events)
+        return 0;
+    if (!ev.events) {
+        /* EPOLLHUP and EPOLLERR can't be masked, so a descriptor with no
+         * enabled watches has to be removed altogether; it may already
+         * have been closed, which removed it anyway */
+        epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd->fd, &ev);
+        fd->events = 0;
+        return 0;
+    }
+    op = fd->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(loop->epfd, op, fd->fd, &ev) < 0)
+        return -1;
+    fd->events = ev.events;
+    return 0;
+}
+
+/* Forget fd, which has no watches left. Called with the lock held. */
+static void
+epoll_fd_drop(EpollLoop *loop, EpollFd *fd)
+{
+    EpollFd **link;
+
+    epoll_fd_update(loop, fd);
+    for (link = &loop->fds; *link != fd; link = &(*link)->next);
+    *link = fd->next;
+    if (loop->iterating) {
+        fd->next = loop->dead_fds;
+        loop->dead_fds = fd;
+    }
+    else {
+        free(fd);
+    }
+}
+
+static void
+epoll_watch_unlink(EpollWatch *w)
+{
+    EpollWatch **link;
+
+    for (link = &w->fd->watches; *link != w; link = &(*link)->next);
+    *link = w->next;
+}
+
+static dbus_bool_t
+epoll_add_watch(DBusWatch *watch, void *data)
+{
+    EpollLoop *loop = data;
+    int unix_fd = dbus_watch_get_unix_fd(watch);
+    EpollWatch *w = malloc(sizeof(EpollWatch));
+    EpollFd *fd;
+
+    if (!w)
+        return FALSE;
+    w->watch = watch;
+    w->flags = (dbus_watch_get_enabled(watch)
+                ? dbus_watch_get_flags(watch) : 0);
+    w->pending = FALSE;
+
+    LOCK(loop);
+    for (fd = loop->fds; fd && fd->fd != unix_fd; fd = fd->next);
+    if (!fd) {
+        fd = malloc(sizeof(EpollFd));
+        if (!fd) {
+            UNLOCK(loop);
+            free(w);
+            return FALSE;
+        }
+        fd->fd = unix_fd;
+        fd->events = 0;
+        fd->watches = NULL;
+        fd->next = loop->fds;
+        loop->fds = fd;
+    }
+    w->fd = fd;
+    w->next = fd->watches;
+    fd->watches = w;
+    if (epoll_fd_update(loop, fd) < 0) {
+        epoll_watch_unlink(w);
+        if (!fd->watches)
+            epoll_fd_drop(loop, fd);
+        UNLOCK(loop);
+        free(w);
+        return FALSE;
+    }
+    dbus_watch_set_data(watch, w, NULL);
+    UNLOCK(loop);
+    return TRUE;
+}
+
+static void
+epoll_remove_watch(DBusWatch *watch, void *data)
+{
+    EpollLoop *loop = data;
+    EpollWatch *w = dbus_watch_get_data(watch);
+    EpollFd *fd;
+
+    if (!w)
+        return;
+
+    LOCK(loop);
+    dbus_watch_set_data(watch, NULL, NULL);
+    fd = w->fd;
+    epoll_watch_unlink(w);
+    if (fd->watches)
+        epoll_fd_update(loop, fd);
+    else
+        epoll_fd_drop(loop, fd);
+    w->watch = NULL;
+    if (w->pending)
+        w = NULL;       /* the loop thread will free it */
+    UNLOCK(loop);
+    free(w);
+}
+
+static void
+epoll_toggle_watch(DBusWatch *watch, void *data)
+{
+    EpollLoop *loop = data;
+    EpollWatch *w = dbus_watch_get_data(watch);
+
+    if (!w)
+        return;
+
+    LOCK(loop);
+    w->flags = (dbus_watch_get_enabled(watch)
+                ? dbus_watch_get_flags(watch) : 0);
+    epoll_fd_update(loop, w->fd);
+    UNLOCK(loop);
+}
+
+/* Timeouts ========================================================= */
+
+static void
+heap_swap(EpollLoop *loop, size_t i, size_t j)
+{
+    EpollTimeout *t = loop->heap[i];
+
+    loop->heap[i] = loop->heap[j];
+    loop->heap[j] = t;
+    loop->heap[i]->index = i;
+    loop->heap[j]->index = j;
+}
+
+static void
+heap_sift_up(EpollLoop *loop, size_t i)
+{
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+
+        if (loop->heap[parent]->deadline <= loop->heap[i]->deadline)
+            break;
+        heap_swap(loop, i, parent);
+        i = parent;
+    }
+}
+
+static void
+heap_sift_down(EpollLoop *loop, size_t i)
+{
+    for (;;) {
+        size_t child = 2 * i + 1;
+
+        if (child >= loop->n_heap)
+            break;
+        if (child + 1 < loop->n_heap
+            && loop->heap[child + 1]->deadline < loop->heap[child]->deadline)
+            child++;
+        if (loop->heap[i]->deadline <= loop->heap[child]->deadline)
+            break;
+        heap_swap(loop, i, child);
+        i = child;
+    }
+}
+
+/* Called with the lock held. */
+static dbus_bool_t
+heap_insert(EpollLoop *loop, EpollTimeout *t, long long now)
+{
+    if (loop->n_heap == loop->heap_size) {
+        size_t size = loop->heap_size ? 2 * loop->heap_size : 16;
+        EpollTimeout **heap = realloc(loop->heap,
+                                      size * sizeof(EpollTimeout *));
+
+        if (!heap)
+            return FALSE;
+        loop->heap = heap;
+        loop->heap_size = size;
+    }
+    t->deadline = now + dbus_timeout_get_interval(t->timeout);
+    t->index = loop->n_heap++;
+    loop->heap[t->index] = t;
+    heap_sift_up(loop, t->index);
+    if (t->index == 0)
+        epoll_loop_wake(loop);
+    return TRUE;
+}
+
+/* Called with the lock held. */
+static void
+heap_remove(EpollLoop *loop, EpollTimeout *t)
+{
+    size_t i = t->index;
+
+    t->index = NOT_IN_HEAP;
+    loop->n_heap--;
+    if (i < loop->n_heap) {
+        EpollTimeout *moved = loop->heap[loop->n_heap];
+
+        loop->heap[i] = moved;
+        moved->index = i;
+        heap_sift_down(loop, i);
+        heap_sift_up(loop, moved->index);
+    }
+}
+
+static dbus_bool_t
+epoll_add_timeout(DBusTimeout *timeout, void *data)
+{
+    EpollLoop *loop = data;
+    EpollTimeout *t = malloc(sizeof(EpollTimeout));
+    long long now = now_ms();
+
+    if (!t)
+        return FALSE;
+    t->timeout = timeout;
+    t->index = NOT_IN_HEAP;
+    t->pending = FALSE;
+
+    LOCK(loop);
+    if (dbus_timeout_get_enabled(timeout) && !heap_insert(loop, t, now)) {
+        UNLOCK(loop);
+        free(t);
+        return FALSE;
+    }
+    dbus_timeout_set_data(timeout, t, NULL);
+    UNLOCK(loop);
+    return TRUE;
+}
+
+static void
+epoll_remove_timeout(DBusTimeout *timeout, void *data)
+{
+    EpollLoop *loop = data;
+    EpollTimeout *t = dbus_timeout_get_data(timeout);
+
+    if (!t)
+        return;
+
+    LOCK(loop);
+    dbus_timeout_set_data(timeout, NULL, NULL);
+    if (t->index != NOT_IN_HEAP)
+        heap_remove(loop, t);
+    t->timeout = NULL;
+    if (t->pending)
+        t = NULL;       /* the loop thread will free it */
+    UNLOCK(loop);
+    free(t);
+}
+
+static void
+epoll_toggle_timeout(DBusTimeout *timeout, void *data)
+{
+    EpollLoop *loop = data;
+    EpollTimeout *t = dbus_timeout_get_data(timeout);
+    long long now = now_ms();
+
+    if (!t)
+        return;
+
+    LOCK(loop);
+    /* re-enabling, or changing the interval, restarts the timer */
+    if (t->index != NOT_IN_HEAP)
+        heap_remove(loop, t);
+    if (dbus_timeout_get_enabled(timeout)) {
+        /* if this runs out of memory the timeout never fires, which is
+         * all that can be done from a function returning void */
+        heap_insert(loop, t, now);
+    }
+    UNLOCK(loop);
+}
+
+/* Dispatching ====================================================== */
+
+static void
+epoll_queue_dispatch(EpollLoop *loop, DBusConnection *conn)
+{
+    size_t i;
+
+    LOCK(loop);
+    for (i = 0; i < loop->n_dispatch; i++) {
+        if (loop->dispatch[i] == conn) {
+            UNLOCK(loop);
+            return;
+        }
+    }
+    if (loop->n_dispatch == loop->dispatch_size) {
+        size_t size = loop->dispatch_size ? 2 * loop->dispatch_size : 8;
+        DBusConnection **dispatch = realloc(loop->dispatch,
+                                            size * sizeof(DBusConnection *));
+
+        if (!dispatch) {
+            /* it will be dispatched when the next message arrives */
+            UNLOCK(loop);
+            return;
+        }
+        loop->dispatch = dispatch;
+        loop->dispatch_size = size;
+    }
+    loop->dispatch[loop->n_dispatch++] = dbus_connection_ref(conn);
+    epoll_loop_wake(loop);
+    UNLOCK(loop);
+}
+
+static void
+epoll_dispatch_status(DBusConnection *conn, DBusDispatchStatus status,
+                      void *data)
+{
+    if (status == DBUS_DISPATCH_DATA_REMAINS)
+        epoll_queue_dispatch(data, conn);
+}
+
+static void
+epoll_wakeup_main(void *data)
+{
+    EpollLoop *loop = data;
+
+    LOCK(loop);
+    epoll_loop_wake(loop);
+    UNLOCK(loop);
+}
+
+/* Run one iteration, without the GIL. Return 0 on success, 1 if
+ * epoll_wait() was interrupted by a signal, or -1 with errno set. */
+static int
+epoll_loop_iterate(EpollLoop *loop)
+{
+    struct epoll_event events[MAX_EVENTS];
+    EpollWatch *watches[MAX_READY];
+    unsigned int conditions[MAX_READY];
+    EpollTimeout *timeouts[MAX_READY];
+    DBusConnection **dispatch;
+    EpollCall *calls, *call;
+    size_t n_watches = 0, n_timeouts = 0, n_dispatch, i;
+    long long now, deadline = -1, wait = -1;
+    int n_events, j;
+
+    LOCK(loop);
+    if (loop->n_heap)
+        deadline = loop->heap[0]->deadline;
+    if (loop->calls && (deadline < 0 || loop->calls->deadline < deadline))
+        deadline = loop->calls->deadline;
+    if (loop->n_dispatch) {
+        wait = 0;
+    }
+    else if (deadline >= 0) {
+        wait = deadline - now_ms();
+        if (wait < 0)
+            wait = 0;
+        else if (wait > INT_MAX)
+            wait = INT_MAX;
+    }
+    loop->iterating = TRUE;
+    UNLOCK(loop);
+
+    n_events = epoll_wait(loop->epfd, events, MAX_EVENTS, (int)wait);
+    if (n_events < 0) {
+        int saved_errno = errno;
+
+        LOCK(loop);
+        loop->iterating = FALSE;
+        UNLOCK(loop);
+        if (saved_errno == EINTR)
+            return 1;
+        errno = saved_errno;
+        return -1;
+    }
+
+    /* Collect what's ready, then handle it without the lock */
+    LOCK(loop);
+    for (j = 0; j < n_events; j++) {
+        EpollFd *fd = events[j].data.ptr;
+        EpollWatch *w;
+
+        if (!fd) {
+            uint64_t counter;
+
+            if (read(loop->wakeup_fd, &counter, sizeof(counter)) < 0) {}
+            continue;
+        }
+        for (w = fd->watches; w && n_watches < MAX_READY; w = w->next) {
+            unsigned int condition = 0;
+
+            if ((events[j].events & EPOLLIN)
+                && (w->flags & DBUS_WATCH_READABLE))
+                condition |= DBUS_WATCH_READABLE;
+            if ((events[j].events & EPOLLOUT)
+                && (w->flags & DBUS_WATCH_WRITABLE))
+                condition |= DBUS_WATCH_WRITABLE;
+            if (w->flags && (events[j].events & EPOLLHUP))
+                condition |= DBUS_WATCH_HANGUP;
+            if (w->flags && (events[j].events & EPOLLERR))
+                condition |= DBUS_WATCH_ERROR;
+            if (condition) {
+                w->pending = TRUE;
+                watches[n_watches] = w;
+                conditions[n_watches++] = condition;
+            }
+        }
+    }
+    now = now_ms();
+    while (loop->n_heap && loop->heap[0]->deadline <= now
+           && n_timeouts < MAX_READY) {
+        EpollTimeout *t = loop->heap[0];
+        int interval = dbus_timeout_get_interval(t->timeout);
+
+        /* libdbus timeouts repeat until they are removed or disabled */
+        t->pending = TRUE;
+        timeouts[n_timeouts++] = t;
+        t->deadline = now + (interval > 0 ? interval : 1);
+        heap_sift_down(loop, 0);
+    }
+    UNLOCK(loop);
+
+    for (i = 0; i < n_watches; i++) {
+        DBusWatch *watch;
+
+        LOCK(loop);
+        watch = watches[i]->watch;
+        UNLOCK(loop);
+        if (watch)
+            dbus_watch_handle(watch, conditions[i]);
+    }
+    for (i = 0; i < n_timeouts; i++) {
+        DBusTimeout *timeout;
+
+        LOCK(loop);
+        timeout = timeouts[i]->timeout;
+        UNLOCK(loop);
+        if (timeout)
+            dbus_timeout_handle(timeout);
+    }
+
+    LOCK(loop);
+    for (i = 0; i < n_watches; i++) {
+        watches[i]->pending = FALSE;
+        if (!watches[i]->watch)
+            free(watches[i]);
+    }
+    for (i = 0; i < n_timeouts; i++) {
+        timeouts[i]->pending = FALSE;
+        if (!timeouts[i]->timeout)
+            free(timeouts[i]);
+    }
+    dispatch = loop->dispatch;
+    n_dispatch = loop->n_dispatch;
+    loop->dispatch = NULL;
+    loop->n_dispatch = loop->dispatch_size = 0;
+    UNLOCK(loop);
+
+    /* This is where Python code runs */
+    for (i = 0; i < n_dispatch; i++) {
+        dbus_py_dispatch_connection(dispatch[i]);
+        dbus_connection_unref(dispatch[i]);
+    }
+    free(dispatch);
+
+    /* Then the calls that are due, including those queued with no delay
+     * by the handlers above */
+    LOCK(loop);
+    now = now_ms();
+    calls = NULL;
+    if (loop->calls && loop->calls->deadline <= now) {
+        calls = call = loop->calls;
+        while (call->next && call->next->deadline <= now)
+            call = call->next;
+        loop->calls = call->next;
+        call->next = NULL;
+    }
+    UNLOCK(loop);
+
+    if (calls) {
+        PyGILState_STATE gil = PyGILState_Ensure();
+
+        while (calls) {
+            PyObject *ret;
+
+            call = calls;
+            calls = call->next;
+            ret = PyObject_CallObject(call->callable, NULL);
+            if (!ret)
+                PyErr_Print();
+            Py_CLEAR(ret);
+            Py_CLEAR(call->callable);
+            free(call);
+        }
+        PyGILState_Release(gil);
+    }
+
+    LOCK(loop);
+    while (loop->dead_fds) {
+        EpollFd *fd = loop->dead_fds;
+
+        loop->dead_fds = fd->next;
+        free(fd);
+    }
+    loop->iterating = FALSE;
+    UNLOCK(loop);
+    return 0;
+}
+
+/* NativeMainLoop callbacks ========================================= */
+
+static dbus_bool_t
+epoll_set_up_conn(DBusConnection *conn, void *data)
+{
+    EpollLoop *loop = data;
+    dbus_bool_t ok = FALSE;
+
+    Py_BEGIN_ALLOW_THREADS
+    epoll_loop_ref(loop);
+    if (!dbus_connection_set_watch_functions(conn, epoll_add_watch,
+                                             epoll_remove_watch,
+                                             epoll_toggle_watch,
+                                             loop, epoll_loop_unref)) {
+        epoll_loop_unref(loop);
+    }
+    else {
+        epoll_loop_ref(loop);
+        if (!dbus_connection_set_timeout_functions(conn, epoll_add_timeout,
+                                                   epoll_remove_timeout,
+                                                   epoll_toggle_timeout,
+                                                   loop, epoll_loop_unref)) {
+            epoll_loop_unref(loop);
+        }
+        else {
+            ok = TRUE;
+        }
+    }
+    if (ok) {
+        epoll_loop_ref(loop);
+        dbus_connection_set_dispatch_status_function(conn,
+                                                     epoll_dispatch_status,
+                                                     loop, epoll_loop_unref);
+        epoll_loop_ref(loop);
+        dbus_connection_set_wakeup_main_function(conn, epoll_wakeup_main,
+                                                 loop, epoll_loop_unref);
+        if (dbus_connection_get_dispatch_status(conn)
+            == DBUS_DISPATCH_DATA_REMAINS)
+            epoll_queue_dispatch(loop, conn);
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!ok)
+        PyErr_NoMemory();
+    return ok;
+}
+
+static dbus_bool_t
+epoll_set_up_srv(DBusServer *srv, void *data)
+{
+    EpollLoop *loop = data;
+    dbus_bool_t ok = FALSE;
+
+    Py_BEGIN_ALLOW_THREADS
+    epoll_loop_ref(loop);
+    if (!dbus_server_set_watch_functions(srv, epoll_add_watch,
+                                         epoll_remove_watch,
+                                         epoll_toggle_watch,
+                                         loop, epoll_loop_unref)) {
+        epoll_loop_unref(loop);
+    }
+    else {
+        epoll_loop_ref(loop);
+        if (!dbus_server_set_timeout_functions(srv, epoll_add_timeout,
+                                               epoll_remove_timeout,
+                                               epoll_toggle_timeout,
+                                               loop, epoll_loop_unref)) {
+            epoll_loop_unref(loop);
+        }
+        else {
+            ok = TRUE;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!ok)
+        PyErr_NoMemory();
+    return ok;
+}
+
+/* Dispatch threads ================================================= */
+
+/* Connection.start_dispatch_thread() gives the connection a loop of its
+ * own, run by a native thread until the connection is disconnected and
+ * its Disconnected signal has been dispatched. */
+
+typedef struct {
+    EpollLoop *loop;
+    DBusConnection *conn;
+} EpollThread;
+
+static void
+epoll_dispatch_thread_main(void *data)
+{
+    EpollThread *thread = data;
+    EpollLoop *loop = thread->loop;
+    DBusConnection *conn = thread->conn;
+
+    free(thread);
+
+    LOCK(loop);
+    loop->running = TRUE;
+    loop->owner = (unsigned long)PyThread_get_thread_ident();
+    UNLOCK(loop);
+
+    while (dbus_connection_get_is_connected(conn)
+           || (dbus_connection_get_dispatch_status(conn)
+               == DBUS_DISPATCH_DATA_REMAINS)) {
+        if (epoll_loop_iterate(loop) < 0)
+            break;
+    }
+
+    LOCK(loop);
+    loop->running = FALSE;
+    loop->owner = 0;
+    UNLOCK(loop);
+
+    /* Detach the loop, so that it is freed now rather than when the
+     * connection is */
+    dbus_connection_set_watch_functions(conn, NULL, NULL, NULL, NULL, NULL);
+    dbus_connection_set_timeout_functions(conn, NULL, NULL, NULL, NULL,
+                                          NULL);
+    dbus_connection_set_dispatch_status_function(conn, NULL, NULL, NULL);
+    dbus_connection_set_wakeup_main_function(conn, NULL, NULL, NULL);
+    epoll_loop_unref(loop);
+    dbus_connection_unref(conn);
+}
+
+/* Start a dispatch thread for conn, which must not be attached to any
+ * other main loop. Return TRUE, or FALSE with an exception set. */
+dbus_bool_t
+dbus_py_epoll_start_dispatch_thread(DBusConnection *conn)
+{
+    EpollThread *thread;
+    EpollLoop *loop = epoll_loop_new();
+
+    if (!loop)
+        return FALSE;
+    if (!epoll_set_up_conn(conn, loop)) {
+        epoll_loop_unref(loop);
+        return FALSE;
+    }
+    thread = malloc(sizeof(EpollThread));
+    if (!thread) {
+        epoll_loop_unref(loop);
+        PyErr_NoMemory();
+        return FALSE;
+    }
+    /* the loop's own reference and one to the connection go with it */
+    thread->loop = loop;
+    thread->conn = dbus_connection_ref(conn);
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+    if (PyThread_start_new_thread(epoll_dispatch_thread_main, thread)
+        == PYTHREAD_INVALID_THREAD_ID) {
+        free(thread);
+        Py_BEGIN_ALLOW_THREADS
+        dbus_connection_unref(conn);
+        epoll_loop_unref(loop);
+        Py_END_ALLOW_THREADS
+        PyErr_SetString(PyExc_RuntimeError, "Unable to start the dispatch "
+                        "thread");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Python API ======================================================= */
+
+PyDoc_STRVAR(EpollMainLoop_tp_doc,
+"DBusEpollMainLoop([set_as_default=False])\n"
+"\n"
+"A main loop for D-Bus connections and servers, using Linux epoll\n"
+"directly rather than GLib. It is a `dbus.mainloop.NativeMainLoop`, so\n"
+"it can be passed as the ``mainloop`` argument of a connection or server\n"
+"constructor; call `run` to handle their events.\n"
+"\n"
+"If the keyword argument set_as_default is given and is true, set the new\n"
+"main loop as the default for all new Connection or Bus instances.\n"
+"\n"
+"Connections attached to the loop may be used from other threads, but\n"
+"the loop itself should only run in one thread at a time.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+static PyTypeObject EpollMainLoop_Type;
+
+static PyObject *
+EpollMainLoop_tp_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    NativeMainLoop *self;
+    EpollLoop *loop;
+    int set_as_default = 0;
+    static char *argnames[] = {"set_as_default", NULL};
+
+    if (PyTuple_Size(args) != 0) {
+        PyErr_SetString(PyExc_TypeError, "DBusEpollMainLoop() takes no "
+                                         "positional arguments");
+        return NULL;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i:DBusEpollMainLoop",
+                                     argnames, &set_as_default)) {
+        return NULL;
+    }
+
+    loop = epoll_loop_new();
+    if (!loop) return NULL;
+    self = (NativeMainLoop *)(cls->tp_alloc(cls, 0));
+    if (!self) {
+        epoll_loop_unref(loop);
+        return NULL;
+    }
+    /* the loop's own reference is released by NativeMainLoop's dealloc */
+    dbus_py_native_main_loop_init(self, epoll_set_up_conn, epoll_set_up_srv,
+                                  epoll_loop_unref, loop);
+
+    if (set_as_default && !dbus_py_set_default_main_loop((PyObject *)self)) {
+        Py_CLEAR(self);
+    }
+    return (PyObject *)self;
+}
+
+PyDoc_STRVAR(EpollMainLoop_run__doc__,
+"run()\n\n"
+"Handle events for the connections and servers using this main loop,\n"
+"calling their Python handlers, until `quit` is called. Signals such as\n"
+"SIGINT interrupt it by raising an exception as usual.\n");
+static PyObject *
+EpollMainLoop_run(NativeMainLoop *self, PyObject *unused UNUSED)
+{
+    EpollLoop *loop = self->data;
+    int ret = 0, failed_errno = 0;
+    dbus_bool_t quit = FALSE;
+
+    LOCK(loop);
+    if (loop->running) {
+        UNLOCK(loop);
+        PyErr_SetString(PyExc_RuntimeError, "This main loop is already "
+                        "running");
+        return NULL;
+    }
+    loop->running = TRUE;
+    loop->quit = FALSE;
+    loop->owner = (unsigned long)PyThread_get_thread_ident();
+    UNLOCK(loop);
+
+    Py_BEGIN_ALLOW_THREADS
+    while (!quit) {
+        ret = epoll_loop_iterate(loop);
+        if (ret < 0) {
+            failed_errno = errno;
+            break;
+        }
+        if (ret > 0) {
+            Py_BLOCK_THREADS
+            ret = PyErr_CheckSignals();
+            Py_UNBLOCK_THREADS
+            if (ret < 0)
+                break;
+        }
+        LOCK(loop);
+        quit = loop->quit;
+        UNLOCK(loop);
+    }
+    Py_END_ALLOW_THREADS
+
+    LOCK(loop);
+    loop->running = FALSE;
+    loop->owner = 0;
+    UNLOCK(loop);
+
+    if (failed_errno) {
+        errno = failed_errno;
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    if (ret < 0)
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(EpollMainLoop_quit__doc__,
+"quit()\n\n"
+"Make `run` return once it has finished handling the current events.\n"
+"This may be called from a handler, or from another thread.\n");
+static PyObject *
+EpollMainLoop_quit(NativeMainLoop *self, PyObject *unused UNUSED)
+{
+    EpollLoop *loop = self->data;
+
+    LOCK(loop);
+    loop->quit = TRUE;
+    epoll_loop_wake(loop);
+    UNLOCK(loop);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(EpollMainLoop_call_later__doc__,
+"call_later(delay, callable)\n\n"
+"Call ``callable()`` from the thread running `run`, once at least\n"
+"``delay`` seconds have passed. Calls made with a delay of 0 are run at\n"
+"the end of the loop's current or next iteration, after the handlers for\n"
+"the messages it dispatches. This may be called from any thread.\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+EpollMainLoop_call_later(NativeMainLoop *self, PyObject *args)
+{
+    EpollLoop *loop = self->data;
+    EpollCall *call, **link;
+    PyObject *callable;
+    double delay;
+
+    if (!PyArg_ParseTuple(args, "dO:call_later", &delay, &callable))
+        return NULL;
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "call_later: the second argument "
+                        "must be callable");
+        return NULL;
+    }
+    if (!(delay >= 0)) {
+        PyErr_SetString(PyExc_ValueError, "call_later: the delay must not "
+                        "be negative");
+        return NULL;
+    }
+    if (delay > INT_MAX / 1000)
+        delay = INT_MAX / 1000;
+    call = malloc(sizeof(EpollCall));
+    if (!call)
+        return PyErr_NoMemory();
+    Py_INCREF(callable);
+    call->callable = callable;
+    /* rounded up, so that it is never early */
+    call->deadline = now_ms() + (long long)(delay * 1000);
+    if ((double)(long long)(delay * 1000) < delay * 1000)
+        call->deadline++;
+
+    LOCK(loop);
+    /* after any with the same deadline, so that they run in order */
+    for (link = &loop->calls; *link && (*link)->deadline <= call->deadline;
+         link = &(*link)->next) {}
+    call->next = *link;
+    *link = call;
+    epoll_loop_wake(loop);
+    UNLOCK(loop);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef EpollMainLoop_tp_methods[] = {
+    {"run", (PyCFunction)EpollMainLoop_run, METH_NOARGS,
+     EpollMainLoop_run__doc__},
+    {"quit", (PyCFunction)EpollMainLoop_quit, METH_NOARGS,
+     EpollMainLoop_quit__doc__},
+    {"call_later", (PyCFunction)EpollMainLoop_call_later, METH_VARARGS,
+     EpollMainLoop_call_later__doc__},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject EpollMainLoop_Type = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.mainloop.epoll.DBusEpollMainLoop",
+    sizeof(NativeMainLoop),
+    0,
+    0,                                      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    EpollMainLoop_tp_doc,                   /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    EpollMainLoop_tp_methods,               /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    DEFERRED_ADDRESS(&DBusPyNativeMainLoop_Type), /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    EpollMainLoop_tp_new,                   /* tp_new */
+};
+
+dbus_bool_t
+dbus_py_init_epoll_mainloop(void)
+{
+    EpollMainLoop_Type.tp_base = &DBusPyNativeMainLoop_Type;
+    if (PyType_Ready(&EpollMainLoop_Type) < 0) return 0;
+    return 1;
+}
+
+dbus_bool_t
+dbus_py_insert_epoll_mainloop(PyObject *this_module)
+{
+    /* PyModule_AddObject steals a ref */
+    Py_INCREF(&EpollMainLoop_Type);
+    if (PyModule_AddObject(this_module, "DBusEpollMainLoop",
+                           (PyObject *)&EpollMainLoop_Type) < 0) return 0;
+    return 1;
+}
+
+#endif /* WITH_EPOLL_MAINLOOP */
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
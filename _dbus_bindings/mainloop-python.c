@@ -0,0 +1,710 @@
+/* Main loop integration implemented in Python.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "dbus_bindings-internal.h"
+
+/* A PythonMainLoop passes each DBusWatch and DBusTimeout to methods of
+ * its Python subclass, wrapped in a Watch or Timeout object, and each
+ * connection that has messages to dispatch as a Dispatcher.
+ *
+ * The Watch and Timeout objects are attached to the libdbus objects as
+ * their data, so the same Python object is passed to every method call
+ * about one DBusWatch. They do not keep the DBusWatch alive: libdbus
+ * removes it before freeing it, and freeing it detaches the Python
+ * object, after which its methods do nothing. A Dispatcher, on the other
+ * hand, holds a reference to its connection until it is dropped.
+ *
+ * libdbus calls the watch and timeout functions from any thread, with its
+ * connection lock held, so they take the GIL themselves; the rest of the
+ * bindings never call into libdbus with the GIL held, so that cannot
+ * deadlock. The methods must not call back into the connection.
+ */
+
+typedef struct {
+    PyObject_HEAD
+    DBusWatch *watch;       /* NULL once libdbus has freed it */
+} Watch;
+
+typedef struct {
+    PyObject_HEAD
+    DBusTimeout *timeout;   /* NULL once libdbus has freed it */
+} Timeout;
+
+typedef struct {
+    PyObject_HEAD
+    DBusConnection *conn;   /* a reference */
+} Dispatcher;
+
+static PyTypeObject WatchType, TimeoutType, DispatcherType;
+
+/* Call a method of the main loop with one argument, with the GIL held.
+ * Exceptions cannot be propagated through libdbus, so they are printed. */
+static dbus_bool_t
+call_hook(PyObject *mainloop, const char *name, PyObject *arg)
+{
+    PyObject *ret = PyObject_CallMethod(mainloop, (char *)name, "(O)", arg);
+
+    if (!ret) {
+        PyErr_Print();
+        return FALSE;
+    }
+    Py_DECREF(ret);
+    return TRUE;
+}
+
+/* Watches ========================================================== */
+
+PyDoc_STRVAR(Watch_tp_doc,
+"A file descriptor that libdbus wants to be told about, passed to the\n"
+"watch methods of a `PythonMainLoop`. Cannot be instantiated directly.\n"
+);
+
+static void
+Watch_detach(Watch *self)
+{
+    PyGILState_STATE gil = PyGILState_Ensure();
+
+    self->watch = NULL;
+    Py_DECREF(self);
+    PyGILState_Release(gil);
+}
+
+/* Return the Watch for watch, creating it if necessary, or NULL with an
+ * exception set. The GIL must be held. */
+static PyObject *
+Watch_for_dbus_watch(DBusWatch *watch)
+{
+    Watch *self = dbus_watch_get_data(watch);
+
+    if (self) {
+        Py_INCREF(self);
+        return (PyObject *)self;
+    }
+    self = PyObject_New(Watch, &WatchType);
+    if (!self)
+        return NULL;
+    self->watch = watch;
+    /* one reference for libdbus, released by Watch_detach */
+    Py_INCREF(self);
+    dbus_watch_set_data(watch, self, (DBusFreeFunction)Watch_detach);
+    return (PyObject *)self;
+}
+
+PyDoc_STRVAR(Watch_fileno__doc__,
+"fileno() -> int\n\n"
+"Return the file descriptor to watch, or -1 if libdbus no longer\n"
+"needs this watch.\n");
+static PyObject *
+Watch_fileno(Watch *self, PyObject *unused UNUSED)
+{
+    if (!self->watch)
+        return NATIVEINT_FROMLONG(-1);
+    return NATIVEINT_FROMLONG(dbus_watch_get_unix_fd(self->watch));
+}
+
+PyDoc_STRVAR(Watch_handle__doc__,
+"handle(flags)\n\n"
+"Tell libdbus that the file descriptor is ready. flags is a bitwise-or\n"
+"of `dbus.mainloop.WATCH_READABLE` etc.\n");
+static PyObject *
+Watch_handle(Watch *self, PyObject *args)
+{
+    unsigned int flags;
+
+    if (!PyArg_ParseTuple(args, "I:handle", &flags))
+        return NULL;
+    if (self->watch) {
+        DBusWatch *watch = self->watch;
+
+        Py_BEGIN_ALLOW_THREADS
+        dbus_watch_handle(watch, flags);
+        Py_END_ALLOW_THREADS
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+Watch_get_flags(Watch *self, void *closure UNUSED)
+{
+    if (!self->watch)
+        return NATIVEINT_FROMLONG(0);
+    return NATIVEINT_FROMLONG(dbus_watch_get_flags(self->watch));
+}
+
+static PyObject *
+Watch_get_enabled(Watch *self, void *closure UNUSED)
+{
+    return PyBool_FromLong(self->watch && dbus_watch_get_enabled(self->watch));
+}
+
+static PyMethodDef Watch_tp_methods[] = {
+    {"fileno", (PyCFunction)Watch_fileno, METH_NOARGS, Watch_fileno__doc__},
+    {"handle", (PyCFunction)Watch_handle, METH_VARARGS, Watch_handle__doc__},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef Watch_tp_getset[] = {
+    {"flags", (getter)Watch_get_flags, NULL,
+     "The conditions to watch for: WATCH_READABLE and/or WATCH_WRITABLE.",
+     NULL},
+    {"enabled", (getter)Watch_get_enabled, NULL,
+     "True if the file descriptor should currently be watched.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyTypeObject WatchType = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.mainloop.Watch",
+    sizeof(Watch),
+    0,
+    0,                                      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    Watch_tp_doc,                           /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    Watch_tp_methods,                       /* tp_methods */
+    0,                                      /* tp_members */
+    Watch_tp_getset,                        /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    /* deliberately not callable! */
+    0,                                      /* tp_new */
+};
+
+static dbus_bool_t
+python_watch_hook(DBusWatch *watch, PyObject *mainloop, const char *name)
+{
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject *obj = Watch_for_dbus_watch(watch);
+    dbus_bool_t ok = FALSE;
+
+    if (obj) {
+        ok = call_hook(mainloop, name, obj);
+        Py_DECREF(obj);
+    }
+    else {
+        PyErr_Print();
+    }
+    PyGILState_Release(gil);
+    return ok;
+}
+
+static dbus_bool_t
+python_add_watch(DBusWatch *watch, void *data)
+{
+    return python_watch_hook(watch, data, "add_watch");
+}
+
+static void
+python_remove_watch(DBusWatch *watch, void *data)
+{
+    python_watch_hook(watch, data, "remove_watch");
+}
+
+static void
+python_toggle_watch(DBusWatch *watch, void *data)
+{
+    python_watch_hook(watch, data, "toggle_watch");
+}
+
+/* Timeouts ========================================================= */
+
+PyDoc_STRVAR(Timeout_tp_doc,
+"A timeout that libdbus wants to be called back for, passed to the\n"
+"timeout methods of a `PythonMainLoop`. Cannot be instantiated directly.\n"
+);
+
+static void
+Timeout_detach(Timeout *self)
+{
+    PyGILState_STATE gil = PyGILState_Ensure();
+
+    self->timeout = NULL;
+    Py_DECREF(self);
+    PyGILState_Release(gil);
+}
+
+static PyObject *
+Timeout_for_dbus_timeout(DBusTimeout *timeout)
+{
+    Timeout *self = dbus_timeout_get_data(timeout);
+
+    if (self) {
+        Py_INCREF(self);
+        return (PyObject *)self;
+    }
+    self = PyObject_New(Timeout, &TimeoutType);
+    if (!self)
+        return NULL;
+    self->timeout = timeout;
+    /* one reference for libdbus, released by Timeout_detach */
+    Py_INCREF(self);
+    dbus_timeout_set_data(timeout, self, (DBusFreeFunction)Timeout_detach);
+    return (PyObject *)self;
+}
+
+PyDoc_STRVAR(Timeout_handle__doc__,
+"handle()\n\n"
+"Tell libdbus that the interval has elapsed. If the timeout is still\n"
+"enabled afterwards, it should be called again after another interval.\n");
+static PyObject *
+Timeout_handle(Timeout *self, PyObject *unused UNUSED)
+{
+    if (self->timeout) {
+        DBusTimeout *timeout = self->timeout;
+
+        Py_BEGIN_ALLOW_THREADS
+        dbus_timeout_handle(timeout);
+        Py_END_ALLOW_THREADS
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+Timeout_get_interval(Timeout *self, void *closure UNUSED)
+{
+    if (!self->timeout)
+        return NATIVEINT_FROMLONG(0);
+    return NATIVEINT_FROMLONG(dbus_timeout_get_interval(self->timeout));
+}
+
+static PyObject *
+Timeout_get_enabled(Timeout *self, void *closure UNUSED)
+{
+    return PyBool_FromLong(self->timeout
+                           && dbus_timeout_get_enabled(self->timeout));
+}
+
+static PyMethodDef Timeout_tp_methods[] = {
+    {"handle", (PyCFunction)Timeout_handle, METH_NOARGS,
+     Timeout_handle__doc__},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef Timeout_tp_getset[] = {
+    {"interval", (getter)Timeout_get_interval, NULL,
+     "The interval in milliseconds.", NULL},
+    {"enabled", (getter)Timeout_get_enabled, NULL,
+     "True if the timeout should currently be running.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyTypeObject TimeoutType = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.mainloop.Timeout",
+    sizeof(Timeout),
+    0,
+    0,                                      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    Timeout_tp_doc,                         /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    Timeout_tp_methods,                     /* tp_methods */
+    0,                                      /* tp_members */
+    Timeout_tp_getset,                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    /* deliberately not callable! */
+    0,                                      /* tp_new */
+};
+
+static dbus_bool_t
+python_timeout_hook(DBusTimeout *timeout, PyObject *mainloop,
+                    const char *name)
+{
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject *obj = Timeout_for_dbus_timeout(timeout);
+    dbus_bool_t ok = FALSE;
+
+    if (obj) {
+        ok = call_hook(mainloop, name, obj);
+        Py_DECREF(obj);
+    }
+    else {
+        PyErr_Print();
+    }
+    PyGILState_Release(gil);
+    return ok;
+}
+
+static dbus_bool_t
+python_add_timeout(DBusTimeout *timeout, void *data)
+{
+    return python_timeout_hook(timeout, data, "add_timeout");
+}
+
+static void
+python_remove_timeout(DBusTimeout *timeout, void *data)
+{
+    python_timeout_hook(timeout, data, "remove_timeout");
+}
+
+static void
+python_toggle_timeout(DBusTimeout *timeout, void *data)
+{
+    python_timeout_hook(timeout, data, "toggle_timeout");
+}
+
+/* Dispatching ====================================================== */
+
+PyDoc_STRVAR(Dispatcher_tp_doc,
+"A callable that dispatches the incoming messages of one connection,\n"
+"passed to the queue_dispatch method of a `PythonMainLoop`. Cannot be\n"
+"instantiated directly.\n"
+);
+
+static void
+Dispatcher_tp_dealloc(Dispatcher *self)
+{
+    DBusConnection *conn = self->conn;
+
+    Py_BEGIN_ALLOW_THREADS
+    dbus_connection_unref(conn);
+    Py_END_ALLOW_THREADS
+    PyObject_Del(self);
+}
+
+static PyObject *
+Dispatcher_tp_call(Dispatcher *self, PyObject *args, PyObject *kwargs)
+{
+    DBusConnection *conn = self->conn;
+
+    if (PyTuple_Size(args) != 0 || (kwargs && PyDict_Size(kwargs) != 0)) {
+        PyErr_SetString(PyExc_TypeError, "Dispatcher takes no arguments");
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    while (dbus_connection_dispatch(conn) == DBUS_DISPATCH_DATA_REMAINS);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyTypeObject DispatcherType = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.mainloop.Dispatcher",
+    sizeof(Dispatcher),
+    0,
+    (destructor)Dispatcher_tp_dealloc,      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    (ternaryfunc)Dispatcher_tp_call,        /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    Dispatcher_tp_doc,                      /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    0,                                      /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    /* deliberately not callable! */
+    0,                                      /* tp_new */
+};
+
+/* Call the main loop's queue_dispatch() with a new Dispatcher for conn.
+ * The GIL must be held. */
+static void
+python_queue_dispatch(PyObject *mainloop, DBusConnection *conn)
+{
+    Dispatcher *dispatcher = PyObject_New(Dispatcher, &DispatcherType);
+
+    if (!dispatcher) {
+        PyErr_Print();
+        return;
+    }
+    dispatcher->conn = dbus_connection_ref(conn);
+    call_hook(mainloop, "queue_dispatch", (PyObject *)dispatcher);
+    Py_DECREF(dispatcher);
+}
+
+static void
+python_dispatch_status(DBusConnection *conn, DBusDispatchStatus status,
+                       void *data)
+{
+    PyGILState_STATE gil;
+
+    if (status != DBUS_DISPATCH_DATA_REMAINS)
+        return;
+    gil = PyGILState_Ensure();
+    python_queue_dispatch(data, conn);
+    PyGILState_Release(gil);
+}
+
+/* NativeMainLoop callbacks ========================================= */
+
+/* Each set of functions on a connection or server keeps a reference to
+ * the main loop, released by dbus_py_take_gil_and_xdecref. They are
+ * taken before releasing the GIL, and any that were not needed are
+ * dropped afterwards. */
+
+static dbus_bool_t
+python_set_up_conn(DBusConnection *conn, void *data)
+{
+    PyObject *mainloop = data;
+    int unused_refs = 3;
+    DBusDispatchStatus status = DBUS_DISPATCH_COMPLETE;
+
+    Py_INCREF(mainloop);
+    Py_INCREF(mainloop);
+    Py_INCREF(mainloop);
+    Py_BEGIN_ALLOW_THREADS
+    if (dbus_connection_set_watch_functions(conn, python_add_watch,
+            python_remove_watch, python_toggle_watch, mainloop,
+            (DBusFreeFunction)dbus_py_take_gil_and_xdecref)) {
+        unused_refs--;
+        if (dbus_connection_set_timeout_functions(conn, python_add_timeout,
+                python_remove_timeout, python_toggle_timeout, mainloop,
+                (DBusFreeFunction)dbus_py_take_gil_and_xdecref)) {
+            unused_refs--;
+            dbus_connection_set_dispatch_status_function(conn,
+                    python_dispatch_status, mainloop,
+                    (DBusFreeFunction)dbus_py_take_gil_and_xdecref);
+            unused_refs--;
+            status = dbus_connection_get_dispatch_status(conn);
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (unused_refs) {
+        while (unused_refs--)
+            Py_DECREF(mainloop);
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
+        return FALSE;
+    }
+    if (status == DBUS_DISPATCH_DATA_REMAINS)
+        python_queue_dispatch(mainloop, conn);
+    return TRUE;
+}
+
+static dbus_bool_t
+python_set_up_srv(DBusServer *srv, void *data)
+{
+    PyObject *mainloop = data;
+    int unused_refs = 2;
+
+    Py_INCREF(mainloop);
+    Py_INCREF(mainloop);
+    Py_BEGIN_ALLOW_THREADS
+    if (dbus_server_set_watch_functions(srv, python_add_watch,
+            python_remove_watch, python_toggle_watch, mainloop,
+            (DBusFreeFunction)dbus_py_take_gil_and_xdecref)) {
+        unused_refs--;
+        if (dbus_server_set_timeout_functions(srv, python_add_timeout,
+                python_remove_timeout, python_toggle_timeout, mainloop,
+                (DBusFreeFunction)dbus_py_take_gil_and_xdecref)) {
+            unused_refs--;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (unused_refs) {
+        while (unused_refs--)
+            Py_DECREF(mainloop);
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Python API ======================================================= */
+
+PyDoc_STRVAR(PythonMainLoop_tp_doc,
+"PythonMainLoop()\n"
+"\n"
+"Base class for main loop integration written in Python. Instances are\n"
+"`dbus.mainloop.NativeMainLoop` objects, so they can be passed as the\n"
+"``mainloop`` argument of a connection or server constructor; subclasses\n"
+"implement these methods, which libdbus calls from any thread:\n"
+"\n"
+"``add_watch(watch)``, ``remove_watch(watch)``, ``toggle_watch(watch)``\n"
+"    Start, stop or update watching ``watch.fileno()`` for the conditions\n"
+"    in ``watch.flags``, while ``watch.enabled`` is true, and call\n"
+"    ``watch.handle(flags)`` when it is ready.\n"
+"``add_timeout(timeout)``, ``remove_timeout(timeout)``,\n"
+"``toggle_timeout(timeout)``\n"
+"    Start, stop or restart calling ``timeout.handle()`` every\n"
+"    ``timeout.interval`` milliseconds, while ``timeout.enabled`` is true.\n"
+"``queue_dispatch(dispatcher)``\n"
+"    Call ``dispatcher()`` soon, from the main loop, to handle a\n"
+"    connection's incoming messages.\n"
+"``call_later(delay, callable)``, optionally\n"
+"    Call ``callable()`` from the main loop, once ``delay`` seconds have\n"
+"    passed. `dbus.service.PropertiesInterface` uses it to merge property\n"
+"    changes into fewer signals.\n"
+"\n"
+"None of them may use the connection or server directly.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+static PyObject *
+PythonMainLoop_tp_new(PyTypeObject *cls, PyObject *args UNUSED,
+                      PyObject *kwargs UNUSED)
+{
+    NativeMainLoop *self = (NativeMainLoop *)(cls->tp_alloc(cls, 0));
+
+    /* The data is the object itself, borrowed: the functions set on each
+     * connection or server keep their own references. Arguments are left
+     * for the subclass's __init__. */
+    if (self) {
+        dbus_py_native_main_loop_init(self, python_set_up_conn,
+                                      python_set_up_srv, NULL, self);
+    }
+    return (PyObject *)self;
+}
+
+static PyTypeObject PythonMainLoop_Type = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.mainloop.PythonMainLoop",
+    sizeof(NativeMainLoop),
+    0,
+    0,                                      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* tp_flags */
+    PythonMainLoop_tp_doc,                  /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    0,                                      /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    DEFERRED_ADDRESS(&DBusPyNativeMainLoop_Type), /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    PythonMainLoop_tp_new,                  /* tp_new */
+};
+
+dbus_bool_t
+dbus_py_init_python_mainloop(void)
+{
+    PythonMainLoop_Type.tp_base = &DBusPyNativeMainLoop_Type;
+    if (PyType_Ready(&PythonMainLoop_Type) < 0) return 0;
+    if (PyType_Ready(&WatchType) < 0) return 0;
+    if (PyType_Ready(&TimeoutType) < 0) return 0;
+    if (PyType_Ready(&DispatcherType) < 0) return 0;
+    return 1;
+}
+
+dbus_bool_t
+dbus_py_insert_python_mainloop(PyObject *this_module)
+{
+    /* PyModule_AddObject steals a ref */
+    Py_INCREF(&PythonMainLoop_Type);
+    if (PyModule_AddObject(this_module, "PythonMainLoop",
+                           (PyObject *)&PythonMainLoop_Type) < 0) return 0;
+    return 1;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
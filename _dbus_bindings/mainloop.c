@@ -35,30 +35,15 @@ PyDoc_STRVAR(NativeMainLoop_tp_doc,
 "Cannot be instantiated directly.\n"
 );
 
-static PyTypeObject NativeMainLoop_Type;
-
-DEFINE_CHECK(NativeMainLoop)
-
-typedef struct {
-    PyObject_HEAD
-    /* Called with the GIL held, should set a Python exception on error */
-    dbus_bool_t (*set_up_connection_cb)(DBusConnection *, void *);
-    dbus_bool_t (*set_up_server_cb)(DBusServer *, void *);
-    /* Called in a destructor. Must not touch the exception state (use
-     * PyErr_Fetch and PyErr_Restore if necessary). */
-    void (*free_cb)(void *);
-    void *data;
-} NativeMainLoop;
-
 static void NativeMainLoop_tp_dealloc(NativeMainLoop *self)
 {
     if (self->data && self->free_cb) {
         (self->free_cb)(self->data);
     }
-    PyObject_Del((PyObject *)self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
-static PyTypeObject NativeMainLoop_Type = {
+PyTypeObject DBusPyNativeMainLoop_Type = {
     PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
     "dbus.mainloop.NativeMainLoop",
     sizeof(NativeMainLoop),
@@ -78,7 +63,7 @@ static PyTypeObject NativeMainLoop_Type = {
     0,                                      /* tp_getattro */
     0,                                      /* tp_setattro */
     0,                                      /* tp_as_buffer */
-    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* tp_flags */
     NativeMainLoop_tp_doc,                  /* tp_doc */
     0,                                      /* tp_traverse */
     0,                                      /* tp_clear */
@@ -96,16 +81,29 @@ static PyTypeObject NativeMainLoop_Type = {
     0,                                      /* tp_dictoffset */
     0,                                      /* tp_init */
     0,                                      /* tp_alloc */
-    /* deliberately not callable! */
+    /* deliberately not callable! Subclasses in this module may be */
     0,                                      /* tp_new */
 };
 
+void
+dbus_py_native_main_loop_init(NativeMainLoop *self,
+                              dbus_bool_t (*conn_cb)(DBusConnection *, void *),
+                              dbus_bool_t (*server_cb)(DBusServer *, void *),
+                              void (*free_cb)(void *),
+                              void *data)
+{
+    self->data = data;
+    self->free_cb = free_cb;
+    self->set_up_connection_cb = conn_cb;
+    self->set_up_server_cb = server_cb;
+}
+
 /* Internal C API for Connection, Bus, Server ======================= */
 
 dbus_bool_t
 dbus_py_check_mainloop_sanity(PyObject *mainloop)
 {
-    if (NativeMainLoop_Check(mainloop)) {
+    if (DBusPyNativeMainLoop_Check(mainloop)) {
         return TRUE;
     }
     PyErr_SetString(PyExc_TypeError,
@@ -116,7 +114,7 @@ dbus_py_check_mainloop_sanity(PyObject *mainloop)
 dbus_bool_t
 dbus_py_set_up_connection(PyObject *conn, PyObject *mainloop)
 {
-    if (NativeMainLoop_Check(mainloop)) {
+    if (DBusPyNativeMainLoop_Check(mainloop)) {
         /* Native mainloops are allowed to do arbitrary strange things */
         NativeMainLoop *nml = (NativeMainLoop *)mainloop;
         DBusConnection *dbc = DBusPyConnection_BorrowDBusConnection(conn);
@@ -134,7 +132,7 @@ dbus_py_set_up_connection(PyObject *conn, PyObject *mainloop)
 dbus_bool_t
 dbus_py_set_up_server(PyObject *server, PyObject *mainloop)
 {
-    if (NativeMainLoop_Check(mainloop)) {
+    if (DBusPyNativeMainLoop_Check(mainloop)) {
         /* Native mainloops are allowed to do arbitrary strange things */
         NativeMainLoop *nml = (NativeMainLoop *)mainloop;
         DBusServer *dbs = DBusPyServer_BorrowDBusServer(server);
@@ -157,12 +155,11 @@ DBusPyNativeMainLoop_New4(dbus_bool_t (*conn_cb)(DBusConnection *, void *),
                           void (*free_cb)(void *),
                           void *data)
 {
-    NativeMainLoop *self = PyObject_New(NativeMainLoop, &NativeMainLoop_Type);
+    NativeMainLoop *self = PyObject_New(NativeMainLoop,
+                                        &DBusPyNativeMainLoop_Type);
     if (self) {
-        self->data = data;
-        self->free_cb = free_cb;
-        self->set_up_connection_cb = conn_cb;
-        self->set_up_server_cb = server_cb;
+        dbus_py_native_main_loop_init(self, conn_cb, server_cb, free_cb,
+                                      data);
     }
     return (PyObject *)self;
 }
@@ -178,12 +175,22 @@ noop_main_loop_cb(void *conn_or_server UNUSED, void *data UNUSED)
 #define noop_conn_cb ((dbus_bool_t (*)(DBusConnection *, void *))(noop_main_loop_cb))
 #define noop_server_cb ((dbus_bool_t (*)(DBusServer *, void *))(noop_main_loop_cb))
 
+/* Return TRUE if mainloop is dbus.mainloop.NULL_MAIN_LOOP, or another
+ * NativeMainLoop that does nothing. */
+dbus_bool_t
+dbus_py_is_null_main_loop(PyObject *mainloop)
+{
+    return (DBusPyNativeMainLoop_Check(mainloop)
+            && ((NativeMainLoop *)mainloop)->set_up_connection_cb
+                == noop_conn_cb);
+}
+
 /* Initialization =================================================== */
 
 dbus_bool_t
 dbus_py_init_mainloop(void)
 {
-    if (PyType_Ready (&NativeMainLoop_Type) < 0) return 0;
+    if (PyType_Ready (&DBusPyNativeMainLoop_Type) < 0) return 0;
 
     return 1;
 }
@@ -198,9 +205,10 @@ dbus_py_insert_mainloop_types(PyObject *this_module)
     if (!null_main_loop) return 0;
 
     /* PyModule_AddObject steals a ref */
-    Py_INCREF (&NativeMainLoop_Type);
+    Py_INCREF (&DBusPyNativeMainLoop_Type);
     if (PyModule_AddObject (this_module, "NativeMainLoop",
-                            (PyObject *)&NativeMainLoop_Type) < 0) return 0;
+                            (PyObject *)&DBusPyNativeMainLoop_Type) < 0)
+        return 0;
     if (PyModule_AddObject (this_module, "NULL_MAIN_LOOP",
                             null_main_loop) < 0) return 0;
     return 1;
@@ -0,0 +1,264 @@
+/* Compiled signatures for Message.append(), and a cache of them.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+
+#include "message-internal.h"
+
+/* Compiling a signature flattens its type tree into an array of nodes in
+ * pre-order (see message-internal.h), so that the appender can walk it
+ * without re-parsing, and precomputes the element signature that opening
+ * each array needs.
+ *
+ * Plans are kept in a small LRU cache keyed by signature. They are
+ * reference-counted, because appending can call back into Python code
+ * which could append to another message and evict the plan that is in
+ * use from the cache.
+ */
+
+/* Power of 2; enough for the few dozen signatures a typical service uses,
+ * plus whatever its clients put in variants */
+#define SIG_PLAN_CACHE_SIZE 256
+
+static DBusPySigPlan *cache_buckets[SIG_PLAN_CACHE_SIZE];
+/* most recently used first */
+static DBusPySigPlan *cache_lru_head = NULL;
+static DBusPySigPlan *cache_lru_tail = NULL;
+static unsigned int cache_n_plans = 0;
+
+static unsigned long
+sig_hash(const char *signature)
+{
+    /* FNV-1a */
+    unsigned long h = 2166136261UL;
+
+    for (; *signature; signature++) {
+        h ^= (unsigned char)*signature;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+/* Parse the complete type starting at sig[pos] into nodes[*n_nodes...],
+ * and return the position just after it. The signature has already been
+ * validated by libdbus, so this can trust it. For arrays, the element
+ * signature is left pointing into sig, and its length is stored in
+ * elem_lens at the array's index. */
+static size_t
+compile_complete_type(const char *sig, size_t pos, DBusPySigNode *nodes,
+                      size_t *elem_lens, unsigned int *n_nodes)
+{
+    unsigned int me = (*n_nodes)++;
+    size_t end;
+
+    nodes[me].type = sig[pos];
+    nodes[me].n_children = 0;
+    nodes[me].signature = NULL;
+
+    switch (sig[pos]) {
+        case DBUS_TYPE_ARRAY:
+            end = compile_complete_type(sig, pos + 1, nodes, elem_lens,
+                                        n_nodes);
+            nodes[me].n_children = 1;
+            nodes[me].signature = sig + pos + 1;
+            elem_lens[me] = end - (pos + 1);
+            pos = end;
+            break;
+
+        case DBUS_STRUCT_BEGIN_CHAR:
+        case DBUS_DICT_ENTRY_BEGIN_CHAR:
+            nodes[me].type = (sig[pos] == DBUS_STRUCT_BEGIN_CHAR
+                              ? DBUS_TYPE_STRUCT : DBUS_TYPE_DICT_ENTRY);
+            pos++;
+            while (sig[pos] != DBUS_STRUCT_END_CHAR
+                   && sig[pos] != DBUS_DICT_ENTRY_END_CHAR) {
+                pos = compile_complete_type(sig, pos, nodes, elem_lens,
+                                            n_nodes);
+                nodes[me].n_children++;
+            }
+            pos++;
+            break;
+
+        default:
+            pos++;
+    }
+
+    nodes[me].n_nodes = *n_nodes - me;
+    return pos;
+}
+
+static DBusPySigPlan *
+sig_plan_compile(const char *signature)
+{
+    /* a node consumes at least one character of the signature */
+    DBusPySigNode nodes[DBUS_MAXIMUM_SIGNATURE_LENGTH];
+    size_t elem_lens[DBUS_MAXIMUM_SIGNATURE_LENGTH];
+    unsigned int n_nodes = 0, n_args = 0, i;
+    size_t sig_len = strlen(signature);
+    size_t pos = 0, pool_size = sig_len + 1;
+    DBusPySigPlan *plan;
+    char *pool;
+
+    if (sig_len > DBUS_MAXIMUM_SIGNATURE_LENGTH
+        || !dbus_signature_validate(signature, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
+        return NULL;
+    }
+
+    while (pos < sig_len) {
+        pos = compile_complete_type(signature, pos, nodes, elem_lens,
+                                    &n_nodes);
+        n_args++;
+    }
+    for (i = 0; i < n_nodes; i++) {
+        if (nodes[i].type == DBUS_TYPE_ARRAY)
+            pool_size += elem_lens[i] + 1;
+    }
+
+    plan = PyMem_Malloc(sizeof(DBusPySigPlan)
+                        + n_nodes * sizeof(DBusPySigNode) + pool_size);
+    if (!plan) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    plan->n_args = n_args;
+    plan->nodes = (DBusPySigNode *)(plan + 1);
+    plan->refcount = 1;
+    plan->hash = 0;
+    plan->cached = FALSE;
+    plan->bucket_next = plan->lru_prev = plan->lru_next = NULL;
+    memcpy(plan->nodes, nodes, n_nodes * sizeof(DBusPySigNode));
+
+    /* the string pool holds the signature itself, then a nul-terminated
+     * copy of each array's element signature */
+    pool = (char *)(plan->nodes + n_nodes);
+    memcpy(pool, signature, sig_len + 1);
+    plan->signature = pool;
+    pool += sig_len + 1;
+    for (i = 0; i < n_nodes; i++) {
+        if (nodes[i].type == DBUS_TYPE_ARRAY) {
+            memcpy(pool, nodes[i].signature, elem_lens[i]);
+            pool[elem_lens[i]] = '\0';
+            plan->nodes[i].signature = pool;
+            pool += elem_lens[i] + 1;
+        }
+    }
+    return plan;
+}
+
+static void
+cache_unlink_lru(DBusPySigPlan *plan)
+{
+    if (plan->lru_prev)
+        plan->lru_prev->lru_next = plan->lru_next;
+    else
+        cache_lru_head = plan->lru_next;
+    if (plan->lru_next)
+        plan->lru_next->lru_prev = plan->lru_prev;
+    else
+        cache_lru_tail = plan->lru_prev;
+    plan->lru_prev = plan->lru_next = NULL;
+}
+
+static void
+cache_push_lru(DBusPySigPlan *plan)
+{
+    plan->lru_prev = NULL;
+    plan->lru_next = cache_lru_head;
+    if (cache_lru_head)
+        cache_lru_head->lru_prev = plan;
+    else
+        cache_lru_tail = plan;
+    cache_lru_head = plan;
+}
+
+static void
+cache_evict(DBusPySigPlan *plan)
+{
+    DBusPySigPlan **link = &cache_buckets[plan->hash
+                                          & (SIG_PLAN_CACHE_SIZE - 1)];
+
+    while (*link != plan)
+        link = &(*link)->bucket_next;
+    *link = plan->bucket_next;
+    plan->bucket_next = NULL;
+    cache_unlink_lru(plan);
+    plan->cached = FALSE;
+    cache_n_plans--;
+    dbus_py_sig_plan_release(plan);
+}
+
+/* Return a compiled plan for signature, which the caller must release
+ * with dbus_py_sig_plan_release(), or NULL with ValueError set if the
+ * signature is invalid (or MemoryError). */
+DBusPySigPlan *
+dbus_py_sig_plan_get(const char *signature)
+{
+    unsigned long hash = sig_hash(signature);
+    DBusPySigPlan **bucket = &cache_buckets[hash & (SIG_PLAN_CACHE_SIZE - 1)];
+    DBusPySigPlan *plan;
+
+    for (plan = *bucket; plan; plan = plan->bucket_next) {
+        if (plan->hash == hash && !strcmp(plan->signature, signature)) {
+            if (plan != cache_lru_head) {
+                cache_unlink_lru(plan);
+                cache_push_lru(plan);
+            }
+            plan->refcount++;
+            return plan;
+        }
+    }
+
+    plan = sig_plan_compile(signature);
+    if (!plan)
+        return NULL;
+
+    if (cache_n_plans >= SIG_PLAN_CACHE_SIZE)
+        cache_evict(cache_lru_tail);
+
+    /* one reference for the cache, one for the caller */
+    plan->refcount++;
+    plan->hash = hash;
+    plan->cached = TRUE;
+    plan->bucket_next = *bucket;
+    *bucket = plan;
+    cache_push_lru(plan);
+    cache_n_plans++;
+    return plan;
+}
+
+void
+dbus_py_sig_plan_release(DBusPySigPlan *plan)
+{
+    assert(plan->refcount > 0);
+    if (--plan->refcount == 0) {
+        assert(!plan->cached);
+        PyMem_Free(plan);
+    }
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
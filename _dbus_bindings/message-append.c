@@ -169,293 +169,350 @@ get_object_path(PyObject *obj)
     }
 }
 
-/* Return a new reference. If the object is a variant and variant_level_ptr
- * is not NULL, put the variant level in the variable pointed to, and
- * return the contained type instead of "v". */
-static PyObject *
-_signature_string_from_pyobject(PyObject *obj, long *variant_level_ptr)
+/* Signatures are guessed into a fixed-size buffer: nothing longer than
+ * DBUS_MAXIMUM_SIGNATURE_LENGTH could be sent anyway. */
+typedef struct {
+    char str[DBUS_MAXIMUM_SIGNATURE_LENGTH + 1];
+    size_t len;
+} GuessBuffer;
+
+static int
+guess_buffer_append(GuessBuffer *buf, const char *s, size_t n)
 {
-    PyObject *magic_attr;
-    long variant_level = get_variant_level(obj);
+    if (buf->len + n > DBUS_MAXIMUM_SIGNATURE_LENGTH) {
+        PyErr_Format(PyExc_ValueError, "Guessed signature would be longer "
+                     "than %d characters", DBUS_MAXIMUM_SIGNATURE_LENGTH);
+        return -1;
+    }
+    memcpy(buf->str + buf->len, s, n);
+    buf->len += n;
+    buf->str[buf->len] = '\0';
+    return 0;
+}
 
-    if (variant_level < 0)
-        return NULL;
+/* Append the explicit signature of an Array, Dict or Struct. The string
+ * object keeps its own UTF-8 form, so this does not allocate after the
+ * first time a given instance is guessed. */
+static int
+guess_buffer_append_signature(GuessBuffer *buf, PyObject *signature)
+{
+#ifdef PY3
+    Py_ssize_t n;
+    const char *s = PyUnicode_AsUTF8AndSize(signature, &n);
 
-    if (variant_level_ptr) {
-        *variant_level_ptr = variant_level;
-    }
-    else if (variant_level > 0) {
-        return NATIVESTR_FROMSTR(DBUS_TYPE_VARIANT_AS_STRING);
-    }
+    if (!s)
+        return -1;
+    return guess_buffer_append(buf, s, n);
+#else
+    return guess_buffer_append(buf, PyBytes_AS_STRING(signature),
+                               PyBytes_GET_SIZE(signature));
+#endif
+}
 
-    if (obj == Py_True || obj == Py_False) {
-      return NATIVESTR_FROMSTR(DBUS_TYPE_BOOLEAN_AS_STRING);
-    }
+/* Cache of the type guessed for objects which are not containers, keyed
+ * by their exact type. The variant level is per-instance and is checked
+ * before the cache, so an entry is only ever used at variant level 0;
+ * at higher levels the answer is "v" (or, for a variant's contents, the
+ * entry again).
+ *
+ * Each entry holds a reference to its type, so that the type cannot be
+ * freed and its address reused by an unrelated type while the entry
+ * exists. An entry also records the type's version tag, and is only used
+ * while the tag is still valid and unchanged: modifying the type or one
+ * of its bases invalidates the tag. Tags themselves are not unique for
+ * the life of the interpreter (they can be reassigned after the counter
+ * overflows), which is why the type pointer is part of the key. */
+#define GUESS_CACHE_SIZE 64
+
+static struct {
+    PyTypeObject *type;
+    unsigned int version_tag;
+    const char *signature;
+} guess_cache[GUESS_CACHE_SIZE];
+
+static size_t
+guess_cache_index(PyTypeObject *type)
+{
+    return ((size_t)type >> 4) & (GUESS_CACHE_SIZE - 1);
+}
 
-    magic_attr = get_object_path(obj);
-    if (!magic_attr)
-        return NULL;
-    if (magic_attr != Py_None) {
-        Py_CLEAR(magic_attr);
-        return NATIVESTR_FROMSTR(DBUS_TYPE_OBJECT_PATH_AS_STRING);
-    }
-    Py_CLEAR(magic_attr);
+/* Whether the guess for an instance of type depends only on the type:
+ * __dbus_object_path__ must be impossible to find on the instance. */
+static dbus_bool_t
+guess_cache_type_is_eligible(PyTypeObject *type)
+{
+    if (type->tp_dictoffset != 0)
+        return FALSE;
+    if (type->tp_getattro != PyObject_GenericGetAttr &&
+        type->tp_getattro != dbus_py_variant_level_getattro)
+        return FALSE;
+    if (_PyType_Lookup(type, dbus_py__dbus_object_path__const))
+        return FALSE;
+    /* _PyType_Lookup assigns a version tag if it can */
+    return PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG);
+}
 
+/* Return the signature of obj if it's a basic type (or a py2 ByteArray),
+ * without considering __dbus_object_path__ or variant levels, or NULL. */
+static const char *
+_guess_basic_signature(PyObject *obj)
+{
     /* Ordering is important: some of these are subclasses of each other. */
 #ifdef PY3
     if (PyLong_Check(obj)) {
         if (DBusPyUInt64_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_UINT64_AS_STRING);
+            return DBUS_TYPE_UINT64_AS_STRING;
         else if (DBusPyInt64_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT64_AS_STRING);
+            return DBUS_TYPE_INT64_AS_STRING;
         else if (DBusPyUInt32_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_UINT32_AS_STRING);
+            return DBUS_TYPE_UINT32_AS_STRING;
         else if (DBusPyInt32_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT32_AS_STRING);
+            return DBUS_TYPE_INT32_AS_STRING;
         else if (DBusPyUInt16_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_UINT16_AS_STRING);
+            return DBUS_TYPE_UINT16_AS_STRING;
         else if (DBusPyInt16_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT16_AS_STRING);
+            return DBUS_TYPE_INT16_AS_STRING;
         else if (DBusPyByte_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_BYTE_AS_STRING);
+            return DBUS_TYPE_BYTE_AS_STRING;
         else if (DBusPyBoolean_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_BOOLEAN_AS_STRING);
+            return DBUS_TYPE_BOOLEAN_AS_STRING;
         else
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT32_AS_STRING);
+            return DBUS_TYPE_INT32_AS_STRING;
     }
 #else  /* !PY3 */
     if (PyInt_Check(obj)) {
         if (DBusPyInt16_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT16_AS_STRING);
+            return DBUS_TYPE_INT16_AS_STRING;
         else if (DBusPyInt32_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT32_AS_STRING);
+            return DBUS_TYPE_INT32_AS_STRING;
         else if (DBusPyByte_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_BYTE_AS_STRING);
+            return DBUS_TYPE_BYTE_AS_STRING;
         else if (DBusPyUInt16_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_UINT16_AS_STRING);
+            return DBUS_TYPE_UINT16_AS_STRING;
         else if (DBusPyBoolean_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_BOOLEAN_AS_STRING);
+            return DBUS_TYPE_BOOLEAN_AS_STRING;
         else
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT32_AS_STRING);
+            return DBUS_TYPE_INT32_AS_STRING;
     }
     else if (PyLong_Check(obj)) {
         if (DBusPyInt64_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT64_AS_STRING);
+            return DBUS_TYPE_INT64_AS_STRING;
         else if (DBusPyUInt32_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_UINT32_AS_STRING);
+            return DBUS_TYPE_UINT32_AS_STRING;
         else if (DBusPyUInt64_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_UINT64_AS_STRING);
+            return DBUS_TYPE_UINT64_AS_STRING;
         else
-            return NATIVESTR_FROMSTR(DBUS_TYPE_INT64_AS_STRING);
+            return DBUS_TYPE_INT64_AS_STRING;
     }
 #endif  /* PY3 */
     else if (PyUnicode_Check(obj)) {
         /* Object paths and signatures are unicode subtypes in Python 3
          * (the first two cases will never be true in Python 2) */
         if (DBusPyObjectPath_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_OBJECT_PATH_AS_STRING);
+            return DBUS_TYPE_OBJECT_PATH_AS_STRING;
         else if (DBusPySignature_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_SIGNATURE_AS_STRING);
+            return DBUS_TYPE_SIGNATURE_AS_STRING;
         else
-            return NATIVESTR_FROMSTR(DBUS_TYPE_STRING_AS_STRING);
+            return DBUS_TYPE_STRING_AS_STRING;
     }
 #if defined(DBUS_TYPE_UNIX_FD)
     else if (DBusPyUnixFd_Check(obj))
-        return NATIVESTR_FROMSTR(DBUS_TYPE_UNIX_FD_AS_STRING);
+        return DBUS_TYPE_UNIX_FD_AS_STRING;
 #endif
     else if (PyFloat_Check(obj)) {
 #ifdef WITH_DBUS_FLOAT32
         if (DBusPyDouble_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_DOUBLE_AS_STRING);
+            return DBUS_TYPE_DOUBLE_AS_STRING;
         else if (DBusPyFloat_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_FLOAT_AS_STRING);
+            return DBUS_TYPE_FLOAT_AS_STRING;
         else
 #endif
-            return NATIVESTR_FROMSTR(DBUS_TYPE_DOUBLE_AS_STRING);
+            return DBUS_TYPE_DOUBLE_AS_STRING;
     }
     else if (PyBytes_Check(obj)) {
         /* Object paths and signatures are bytes subtypes in Python 2
          * (the first two cases will never be true in Python 3) */
         if (DBusPyObjectPath_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_OBJECT_PATH_AS_STRING);
+            return DBUS_TYPE_OBJECT_PATH_AS_STRING;
         else if (DBusPySignature_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_SIGNATURE_AS_STRING);
+            return DBUS_TYPE_SIGNATURE_AS_STRING;
         else if (DBusPyByteArray_Check(obj))
-            return NATIVESTR_FROMSTR(DBUS_TYPE_ARRAY_AS_STRING
-                                     DBUS_TYPE_BYTE_AS_STRING);
+            return (DBUS_TYPE_ARRAY_AS_STRING DBUS_TYPE_BYTE_AS_STRING);
         else
-            return NATIVESTR_FROMSTR(DBUS_TYPE_STRING_AS_STRING);
+            return DBUS_TYPE_STRING_AS_STRING;
+    }
+    return NULL;
+}
+
+/* Append the signature of obj to buf. If the object is a variant and
+ * variant_level_ptr is not NULL, put the variant level in the variable
+ * pointed to, and append the contained type instead of "v".
+ * Return 0 on success or -1 with an exception set. */
+static int
+_guess_signature_from_pyobject(PyObject *obj, GuessBuffer *buf,
+                               long *variant_level_ptr)
+{
+    PyTypeObject *type = Py_TYPE(obj);
+    size_t cache_index;
+    const char *basic;
+    PyObject *magic_attr;
+    long variant_level;
+
+    if (DBusPyLazyVariant_Check(obj)) {
+        /* it's copied into the message as a whole */
+        if (variant_level_ptr)
+            *variant_level_ptr = 0;
+        return guess_buffer_append(buf, DBUS_TYPE_VARIANT_AS_STRING, 1);
+    }
+
+    variant_level = get_variant_level(obj);
+    if (variant_level < 0)
+        return -1;
+
+    if (variant_level_ptr) {
+        *variant_level_ptr = variant_level;
+    }
+    else if (variant_level > 0) {
+        return guess_buffer_append(buf, DBUS_TYPE_VARIANT_AS_STRING, 1);
+    }
+
+    if (obj == Py_True || obj == Py_False) {
+        return guess_buffer_append(buf, DBUS_TYPE_BOOLEAN_AS_STRING, 1);
+    }
+
+    cache_index = guess_cache_index(type);
+    if (guess_cache[cache_index].type == type &&
+        PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG) &&
+        guess_cache[cache_index].version_tag == type->tp_version_tag) {
+        basic = guess_cache[cache_index].signature;
+        return guess_buffer_append(buf, basic, strlen(basic));
+    }
+
+    magic_attr = get_object_path(obj);
+    if (!magic_attr)
+        return -1;
+    if (magic_attr != Py_None) {
+        Py_CLEAR(magic_attr);
+        return guess_buffer_append(buf, DBUS_TYPE_OBJECT_PATH_AS_STRING, 1);
+    }
+    Py_CLEAR(magic_attr);
+
+    basic = _guess_basic_signature(obj);
+    if (basic) {
+        if (guess_cache_type_is_eligible(type)) {
+            PyTypeObject *old_type = guess_cache[cache_index].type;
+
+            Py_INCREF((PyObject *)type);
+            guess_cache[cache_index].type = type;
+            guess_cache[cache_index].version_tag = type->tp_version_tag;
+            guess_cache[cache_index].signature = basic;
+            Py_XDECREF((PyObject *)old_type);
+        }
+        return guess_buffer_append(buf, basic, strlen(basic));
     }
     else if (PyTuple_Check(obj)) {
         Py_ssize_t len = PyTuple_GET_SIZE(obj);
-        PyObject *list = PyList_New(len + 2);   /* new ref */
-        PyObject *item;                         /* temporary new ref */
-        PyObject *empty_str;                    /* temporary new ref */
-        PyObject *ret;
+        PyObject *signature = NULL;
         Py_ssize_t i;
 
-        if (!list) return NULL;
-        if (len == 0) {
+        if (DBusPyStruct_Check(obj))
+            signature = dbus_py_struct_signature_get(obj);
+
+        if (len == 0 && !signature) {
             PyErr_SetString(PyExc_ValueError, "D-Bus structs cannot be empty");
-            Py_CLEAR(list);
-            return NULL;
-        }
-        /* Set the first and last elements of list to be the parentheses */
-        item = NATIVESTR_FROMSTR(DBUS_STRUCT_BEGIN_CHAR_AS_STRING);
-        if (PyList_SetItem(list, 0, item) < 0) {
-            Py_CLEAR(list);
-            return NULL;
-        }
-        item = NATIVESTR_FROMSTR(DBUS_STRUCT_END_CHAR_AS_STRING);
-        if (PyList_SetItem(list, len + 1, item) < 0) {
-            Py_CLEAR(list);
-            return NULL;
+            return -1;
         }
-        if (!item || !PyList_GET_ITEM(list, 0)) {
-            Py_CLEAR(list);
-            return NULL;
+        if (guess_buffer_append(buf, DBUS_STRUCT_BEGIN_CHAR_AS_STRING, 1) < 0)
+            return -1;
+        if (signature) {
+            if (guess_buffer_append_signature(buf, signature) < 0)
+                return -1;
         }
-        item = NULL;
-
-        for (i = 0; i < len; i++) {
-            item = PyTuple_GetItem(obj, i);
-            if (!item) {
-                Py_CLEAR(list);
-                return NULL;
-            }
-            item = _signature_string_from_pyobject(item, NULL);
-            if (!item) {
-                Py_CLEAR(list);
-                return NULL;
-            }
-            if (PyList_SetItem(list, i + 1, item) < 0) {
-                Py_CLEAR(list);
-                return NULL;
+        else {
+            for (i = 0; i < len; i++) {
+                if (_guess_signature_from_pyobject(PyTuple_GET_ITEM(obj, i),
+                                                   buf, NULL) < 0)
+                    return -1;
             }
-            item = NULL;
-        }
-        empty_str = NATIVESTR_FROMSTR("");
-        if (!empty_str) {
-            /* really shouldn't happen */
-            Py_CLEAR(list);
-            return NULL;
         }
-        ret = PyObject_CallMethod(empty_str, "join", "(O)", list); /* new ref */
-        /* whether ret is NULL or not, */
-        Py_CLEAR(empty_str);
-        Py_CLEAR(list);
-        return ret;
+        return guess_buffer_append(buf, DBUS_STRUCT_END_CHAR_AS_STRING, 1);
     }
     else if (PyList_Check(obj)) {
-        PyObject *tmp;
-        PyObject *ret = NATIVESTR_FROMSTR(DBUS_TYPE_ARRAY_AS_STRING);
-        if (!ret) return NULL;
-#ifdef PY3
-        if (DBusPyArray_Check(obj) &&
-            PyUnicode_Check(((DBusPyArray *)obj)->signature))
-        {
-            PyObject *concat = PyUnicode_Concat(
-                ret, ((DBusPyArray *)obj)->signature);
-            Py_CLEAR(ret);
-            return concat;
-        }
-#else
+        if (guess_buffer_append(buf, DBUS_TYPE_ARRAY_AS_STRING, 1) < 0)
+            return -1;
         if (DBusPyArray_Check(obj) &&
-            PyBytes_Check(((DBusPyArray *)obj)->signature))
+            NATIVESTR_CHECK(((DBusPyArray *)obj)->signature))
         {
-            PyBytes_Concat(&ret, ((DBusPyArray *)obj)->signature);
-            return ret;
+            return guess_buffer_append_signature(
+                buf, ((DBusPyArray *)obj)->signature);
         }
-#endif
         if (PyList_GET_SIZE(obj) == 0) {
             /* No items, so fail. Or should we guess "av"? */
             PyErr_SetString(PyExc_ValueError, "Unable to guess signature "
                             "from an empty list");
-            return NULL;
-        }
-        tmp = PyList_GetItem(obj, 0);
-        tmp = _signature_string_from_pyobject(tmp, NULL);
-        if (!tmp) return NULL;
-#ifdef PY3
-        {
-            PyObject *concat = PyUnicode_Concat(ret, tmp);
-            Py_CLEAR(ret);
-            Py_CLEAR(tmp);
-            return concat;
+            return -1;
         }
-#else
-        PyBytes_ConcatAndDel(&ret, tmp);
-        return ret;
-#endif
+        return _guess_signature_from_pyobject(PyList_GET_ITEM(obj, 0),
+                                              buf, NULL);
     }
     else if (PyDict_Check(obj)) {
-        PyObject *key, *value, *keysig, *valuesig;
+        PyObject *key, *value;
         Py_ssize_t pos = 0;
-        PyObject *ret = NULL;
 
-#ifdef PY3
-        if (DBusPyDict_Check(obj) &&
-            PyUnicode_Check(((DBusPyDict *)obj)->signature))
-        {
-            return PyUnicode_FromFormat((DBUS_TYPE_ARRAY_AS_STRING
-                                         DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
-                                         "%U"
-                                         DBUS_DICT_ENTRY_END_CHAR_AS_STRING),
-                                        ((DBusPyDict *)obj)->signature);
-        }
-#else
+        if (guess_buffer_append(buf, (DBUS_TYPE_ARRAY_AS_STRING
+                                      DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING),
+                                2) < 0)
+            return -1;
         if (DBusPyDict_Check(obj) &&
-            PyBytes_Check(((DBusPyDict *)obj)->signature))
+            NATIVESTR_CHECK(((DBusPyDict *)obj)->signature))
         {
-            const char *sig = PyBytes_AS_STRING(((DBusPyDict *)obj)->signature);
-
-            return PyBytes_FromFormat((DBUS_TYPE_ARRAY_AS_STRING
-                                       DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
-                                       "%s"
-                                       DBUS_DICT_ENTRY_END_CHAR_AS_STRING),
-                                      sig);
-        }
-#endif
-        if (!PyDict_Next(obj, &pos, &key, &value)) {
-            /* No items, so fail. Or should we guess "a{vv}"? */
-            PyErr_SetString(PyExc_ValueError, "Unable to guess signature "
-                             "from an empty dict");
-            return NULL;
+            if (guess_buffer_append_signature(
+                    buf, ((DBusPyDict *)obj)->signature) < 0)
+                return -1;
         }
-        keysig = _signature_string_from_pyobject(key, NULL);
-        valuesig = _signature_string_from_pyobject(value, NULL);
-        if (keysig && valuesig) {
-#ifdef PY3
-            ret = PyUnicode_FromFormat((DBUS_TYPE_ARRAY_AS_STRING
-                                        DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
-                                        "%U%U"
-                                        DBUS_DICT_ENTRY_END_CHAR_AS_STRING),
-                                       keysig, valuesig);
-#else
-            ret = PyBytes_FromFormat((DBUS_TYPE_ARRAY_AS_STRING
-                                      DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
-                                      "%s%s"
-                                      DBUS_DICT_ENTRY_END_CHAR_AS_STRING),
-                                     PyBytes_AS_STRING(keysig),
-                                     PyBytes_AS_STRING(valuesig));
-#endif
+        else {
+            if (!PyDict_Next(obj, &pos, &key, &value)) {
+                /* No items, so fail. Or should we guess "a{vv}"? */
+                PyErr_SetString(PyExc_ValueError, "Unable to guess signature "
+                                 "from an empty dict");
+                return -1;
+            }
+            if (_guess_signature_from_pyobject(key, buf, NULL) < 0 ||
+                _guess_signature_from_pyobject(value, buf, NULL) < 0)
+                return -1;
         }
-        Py_CLEAR(keysig);
-        Py_CLEAR(valuesig);
-        return ret;
+        return guess_buffer_append(buf, DBUS_DICT_ENTRY_END_CHAR_AS_STRING, 1);
     }
     else {
         PyErr_Format(PyExc_TypeError, "Don't know which D-Bus type "
                      "to use to encode type \"%s\"",
                      Py_TYPE(obj)->tp_name);
-        return NULL;
+        return -1;
+    }
+}
+
+/* Guess the signature of the tuple args into buf, which is a
+ * nul-terminated string on success. Return 0, or -1 with an exception
+ * set. */
+static int
+_guess_signature_from_args(PyObject *args, GuessBuffer *buf)
+{
+    Py_ssize_t i;
+
+    buf->len = 0;
+    buf->str[0] = '\0';
+    for (i = 0; i < PyTuple_GET_SIZE(args); i++) {
+        if (_guess_signature_from_pyobject(PyTuple_GET_ITEM(args, i),
+                                           buf, NULL) < 0)
+            return -1;
     }
+    return 0;
 }
 
 PyObject *
 dbus_py_Message_guess_signature(PyObject *unused UNUSED, PyObject *args)
 {
-    PyObject *tmp, *ret = NULL;
+    GuessBuffer buf;
 
     if (!args) {
         if (!PyErr_Occurred()) {
@@ -476,52 +533,21 @@ dbus_py_Message_guess_signature(PyObject *unused UNUSED, PyObject *args)
         return NULL;
     }
 
-    /* if there were no args, easy */
-    if (PyTuple_GET_SIZE(args) == 0) {
-        DBG("%s", "Message_guess_signature: no args, so return Signature('')");
-        return PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s)", "");
-    }
-
-    /* if there were args, the signature we want is, by construction,
-     * exactly the signature we get for the tuple args, except that we don't
-     * want the parentheses. */
-    tmp = _signature_string_from_pyobject(args, NULL);
-    if (!tmp) {
+    if (_guess_signature_from_args(args, &buf) < 0) {
         DBG("%s", "Message_guess_signature: failed");
         return NULL;
     }
-    if (PyUnicode_Check(tmp)) {
-        PyObject *as_bytes = PyUnicode_AsUTF8String(tmp);
-        Py_CLEAR(tmp);
-        if (!as_bytes)
-            return NULL;
-        if (PyBytes_GET_SIZE(as_bytes) < 2) {
-            PyErr_SetString(PyExc_RuntimeError, "Internal error: "
-                            "_signature_string_from_pyobject returned "
-                            "a bad result");
-            Py_CLEAR(as_bytes);
-            return NULL;
-        }
-        tmp = as_bytes;
-    }
-    if (!PyBytes_Check(tmp) || PyBytes_GET_SIZE(tmp) < 2) {
-        PyErr_SetString(PyExc_RuntimeError, "Internal error: "
-                        "_signature_string_from_pyobject returned "
-                        "a bad result");
-        Py_CLEAR(tmp);
+    /* Guessing can only go wrong this way by nesting too deeply */
+    if (!dbus_signature_validate(buf.str, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
         return NULL;
     }
-    ret = PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s#)",
-                                PyBytes_AS_STRING(tmp) + 1,
-                                PyBytes_GET_SIZE(tmp) - 2);
-    Py_CLEAR(tmp);
-    return ret;
+    return DBusPySignature_FromDBus(buf.str, 0);
 }
 
 static int _message_iter_append_pyobject(DBusMessageIter *appender,
-                                         DBusSignatureIter *sig_iter,
-                                         PyObject *obj,
-                                         dbus_bool_t *more);
+                                         const DBusPySigNode *node,
+                                         PyObject *obj);
 static int _message_iter_append_variant(DBusMessageIter *appender,
                                         PyObject *obj);
 
@@ -587,11 +613,11 @@ _message_iter_append_string(DBusMessageIter *appender,
     return 0;
 }
 
+/* Convert obj to a byte value in *y. Return 0 on success/-1 with
+ * exception on failure. */
 static int
-_message_iter_append_byte(DBusMessageIter *appender, PyObject *obj)
+_byte_from_pyobject(PyObject *obj, unsigned char *y)
 {
-    unsigned char y;
-
     if (PyBytes_Check(obj)) {
         if (PyBytes_GET_SIZE(obj) != 1) {
             PyErr_Format(PyExc_ValueError,
@@ -599,7 +625,7 @@ _message_iter_append_byte(DBusMessageIter *appender, PyObject *obj)
                          (int)PyBytes_GET_SIZE(obj));
             return -1;
         }
-        y = *(unsigned char *)PyBytes_AS_STRING(obj);
+        *y = *(unsigned char *)PyBytes_AS_STRING(obj);
     }
     else {
         /* on Python 2 this accepts either int or long */
@@ -612,8 +638,18 @@ _message_iter_append_byte(DBusMessageIter *appender, PyObject *obj)
                          (int)i);
             return -1;
         }
-        y = i;
+        *y = i;
     }
+    return 0;
+}
+
+static int
+_message_iter_append_byte(DBusMessageIter *appender, PyObject *obj)
+{
+    unsigned char y;
+
+    if (_byte_from_pyobject(obj, &y) < 0)
+        return -1;
     DBG("Performing actual append: byte \\x%02x", (unsigned)y);
     if (!dbus_message_iter_append_basic(appender, DBUS_TYPE_BYTE, &y)) {
         PyErr_NoMemory();
@@ -672,14 +708,14 @@ _message_iter_append_unixfd(DBusMessageIter *appender, PyObject *obj)
 
 static int
 _message_iter_append_dictentry(DBusMessageIter *appender,
-                               DBusSignatureIter *sig_iter,
+                               const DBusPySigNode *entry_node,
                                PyObject *dict, PyObject *key)
 {
-    DBusSignatureIter sub_sig_iter;
+    const DBusPySigNode *key_node = entry_node + 1;
+    const DBusPySigNode *value_node = key_node + key_node->n_nodes;
     DBusMessageIter sub;
     int ret = -1;
     PyObject *value = PyObject_GetItem(dict, key);
-    dbus_bool_t more;
 
     if (!value) return -1;
 
@@ -691,29 +727,15 @@ _message_iter_append_dictentry(DBusMessageIter *appender,
     fprintf(stderr, "\n");
 #endif
 
-    DBG("Recursing signature iterator %p -> %p", sig_iter, &sub_sig_iter);
-    dbus_signature_iter_recurse(sig_iter, &sub_sig_iter);
-#ifdef USING_DBG
-    {
-        char *s;
-        s = dbus_signature_iter_get_signature(sig_iter);
-        DBG("Signature of parent iterator %p is %s", sig_iter, s);
-        dbus_free(s);
-        s = dbus_signature_iter_get_signature(&sub_sig_iter);
-        DBG("Signature of sub-iterator %p is %s", &sub_sig_iter, s);
-        dbus_free(s);
-    }
-#endif
-
     DBG("%s", "Opening DICT_ENTRY container");
     if (!dbus_message_iter_open_container(appender, DBUS_TYPE_DICT_ENTRY,
                                           NULL, &sub)) {
         PyErr_NoMemory();
         goto out;
     }
-    ret = _message_iter_append_pyobject(&sub, &sub_sig_iter, key, &more);
+    ret = _message_iter_append_pyobject(&sub, key_node, key);
     if (ret == 0) {
-        ret = _message_iter_append_pyobject(&sub, &sub_sig_iter, value, &more);
+        ret = _message_iter_append_pyobject(&sub, value_node, value);
     }
     DBG("%s", "Closing DICT_ENTRY container");
     if (!dbuspy_message_iter_close_container(appender, &sub, (ret == 0))) {
@@ -727,19 +749,17 @@ out:
 
 static int
 _message_iter_append_multi(DBusMessageIter *appender,
-                           const DBusSignatureIter *sig_iter,
+                           const DBusPySigNode *node,
                            int mode, PyObject *obj)
 {
     DBusMessageIter sub_appender;
-    DBusSignatureIter sub_sig_iter;
+    const DBusPySigNode *sub_node = node + 1;
     PyObject *contents;
     int ret;
     PyObject *iterator = PyObject_GetIter(obj);
-    char *sig = NULL;
     int container = mode;
     dbus_bool_t is_byte_array = DBusPyByteArray_Check(obj);
-    int inner_type;
-    dbus_bool_t more;
+    unsigned int n_items = 0;
 
     assert(mode == DBUS_TYPE_DICT_ENTRY || mode == DBUS_TYPE_ARRAY ||
             mode == DBUS_TYPE_STRUCT);
@@ -753,72 +773,37 @@ _message_iter_append_multi(DBusMessageIter *appender,
     if (!iterator) return -1;
     if (mode == DBUS_TYPE_DICT_ENTRY) container = DBUS_TYPE_ARRAY;
 
-    DBG("Recursing signature iterator %p -> %p", sig_iter, &sub_sig_iter);
-    dbus_signature_iter_recurse(sig_iter, &sub_sig_iter);
-#ifdef USING_DBG
-    {
-        char *s;
-        s = dbus_signature_iter_get_signature(sig_iter);
-        DBG("Signature of parent iterator %p is %s", sig_iter, s);
-        dbus_free(s);
-        s = dbus_signature_iter_get_signature(&sub_sig_iter);
-        DBG("Signature of sub-iterator %p is %s", &sub_sig_iter, s);
-        dbus_free(s);
-    }
-#endif
-    inner_type = dbus_signature_iter_get_current_type(&sub_sig_iter);
-
-    if (mode == DBUS_TYPE_ARRAY || mode == DBUS_TYPE_DICT_ENTRY) {
-        sig = dbus_signature_iter_get_signature(&sub_sig_iter);
-        if (!sig) {
-            PyErr_NoMemory();
-            ret = -1;
-            goto out;
-        }
-    }
-    /* else leave sig set to NULL. */
-
+    /* for arrays, node->signature is the element signature that
+     * open_container wants; for structs it is NULL, as it should be */
     DBG("Opening '%c' container", container);
     if (!dbus_message_iter_open_container(appender, container,
-                                          sig, &sub_appender)) {
+                                          node->signature, &sub_appender)) {
         PyErr_NoMemory();
         ret = -1;
         goto out;
     }
     ret = 0;
-    more = TRUE;
     while ((contents = PyIter_Next(iterator))) {
 
-        if (mode == DBUS_TYPE_ARRAY || mode == DBUS_TYPE_DICT_ENTRY) {
-            DBG("Recursing signature iterator %p -> %p", sig_iter, &sub_sig_iter);
-            dbus_signature_iter_recurse(sig_iter, &sub_sig_iter);
-#ifdef USING_DBG
-            {
-                char *s;
-                s = dbus_signature_iter_get_signature(sig_iter);
-                DBG("Signature of parent iterator %p is %s", sig_iter, s);
-                dbus_free(s);
-                s = dbus_signature_iter_get_signature(&sub_sig_iter);
-                DBG("Signature of sub-iterator %p is %s", &sub_sig_iter, s);
-                dbus_free(s);
-            }
-#endif
-        }
-        else /* struct */ {
-            if (!more) {
+        if (mode == DBUS_TYPE_STRUCT) {
+            if (n_items >= node->n_children) {
                 PyErr_Format(PyExc_TypeError, "Fewer items found in struct's "
                              "D-Bus signature than in Python arguments ");
+                Py_CLEAR(contents);
                 ret = -1;
                 break;
             }
+            if (n_items > 0)
+                sub_node += sub_node->n_nodes;
         }
+        n_items++;
 
         if (mode == DBUS_TYPE_DICT_ENTRY) {
-            ret = _message_iter_append_dictentry(&sub_appender, &sub_sig_iter,
+            ret = _message_iter_append_dictentry(&sub_appender, sub_node,
                                                  obj, contents);
         }
         else if (mode == DBUS_TYPE_ARRAY && is_byte_array
-                 && inner_type == DBUS_TYPE_VARIANT) {
+                 && sub_node->type == DBUS_TYPE_VARIANT) {
             /* Subscripting a ByteArray gives a str of length 1, but if the
              * container is a ByteArray and the parameter is an array of
              * variants, we want to produce an array of variants containing
@@ -837,10 +822,8 @@ _message_iter_append_multi(DBusMessageIter *appender,
             Py_CLEAR(byte);
         }
         else {
-            /* advances sub_sig_iter and sets more on success - for array
-             * this doesn't matter, for struct it's essential */
-            ret = _message_iter_append_pyobject(&sub_appender, &sub_sig_iter,
-                                                contents, &more);
+            ret = _message_iter_append_pyobject(&sub_appender, sub_node,
+                                                contents);
         }
 
         Py_CLEAR(contents);
@@ -852,7 +835,7 @@ _message_iter_append_multi(DBusMessageIter *appender,
     if (PyErr_Occurred()) {
         ret = -1;
     }
-    else if (mode == DBUS_TYPE_STRUCT && more) {
+    else if (mode == DBUS_TYPE_STRUCT && n_items < node->n_children) {
         PyErr_Format(PyExc_TypeError, "More items found in struct's D-Bus "
                      "signature than in Python arguments ");
         ret = -1;
@@ -867,7 +850,6 @@ _message_iter_append_multi(DBusMessageIter *appender,
 
 out:
     Py_CLEAR(iterator);
-    dbus_free(sig);
     return ret;
 }
 
@@ -904,41 +886,289 @@ _message_iter_append_string_as_byte_array(DBusMessageIter *appender,
     return ret;
 }
 
+/* Return the size of one element of an array of the given type, as laid
+ * out in memory for dbus_message_iter_append_fixed_array(), or 0 if arrays
+ * of that type must be appended one item at a time. Unix fds are fixed-size
+ * on the wire, but each one has to be duplicated, so they are excluded. */
+static size_t
+_fixed_array_item_size(int element_type)
+{
+    switch (element_type) {
+        case DBUS_TYPE_BYTE:
+            return sizeof(unsigned char);
+        case DBUS_TYPE_BOOLEAN:
+            return sizeof(dbus_bool_t);
+        case DBUS_TYPE_INT16:
+            return sizeof(dbus_int16_t);
+        case DBUS_TYPE_UINT16:
+            return sizeof(dbus_uint16_t);
+        case DBUS_TYPE_INT32:
+            return sizeof(dbus_int32_t);
+        case DBUS_TYPE_UINT32:
+            return sizeof(dbus_uint32_t);
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+            return sizeof(dbus_int64_t);
+        case DBUS_TYPE_UINT64:
+            return sizeof(dbus_uint64_t);
+#endif
+        case DBUS_TYPE_DOUBLE:
+            return sizeof(double);
+        default:
+            return 0;
+    }
+}
+
+/* Return TRUE if the buffer's items can be handed to libdbus as-is, for an
+ * array of the given fixed-size type. Only native-sized struct module
+ * format codes with the right size and signedness are accepted. */
+static dbus_bool_t
+_buffer_matches_fixed_type(const Py_buffer *view, int element_type)
+{
+    const char *format = view->format ? view->format : "B";
+
+    if (format[0] == '@')
+        format++;
+    if (format[0] == '\0' || format[1] != '\0')
+        return FALSE;
+    if ((size_t)view->itemsize != _fixed_array_item_size(element_type))
+        return FALSE;
+
+    switch (element_type) {
+        case DBUS_TYPE_BYTE:
+        case DBUS_TYPE_UINT16:
+        case DBUS_TYPE_UINT32:
+        case DBUS_TYPE_UINT64:
+            return (strchr("BHILQ", format[0]) != NULL);
+        case DBUS_TYPE_INT16:
+        case DBUS_TYPE_INT32:
+        case DBUS_TYPE_INT64:
+            return (strchr("hilq", format[0]) != NULL);
+        case DBUS_TYPE_DOUBLE:
+            return (format[0] == 'd');
+        default:
+            /* booleans are 4 bytes long and must be exactly 0 or 1, so
+             * there's no buffer format we can trust to match */
+            return FALSE;
+    }
+}
+
+/* Convert every item of seq (a list or tuple) into the packed C array
+ * values, which has room for n items of the given fixed-size type.
+ * Return 0 on success/-1 with exception on failure. */
+static int
+_fixed_array_from_sequence(PyObject *seq, int element_type,
+                           void *values, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++) {
+        PyObject *item;
+        int ret = 0;
+
+        /* converting an item can run arbitrary Python code, which might
+         * resize the list under our feet */
+        if (i >= PySequence_Fast_GET_SIZE(seq)) {
+            break;
+        }
+        item = PySequence_Fast_GET_ITEM(seq, i);
+        Py_INCREF(item);
+
+        switch (element_type) {
+            case DBUS_TYPE_BYTE:
+                ret = _byte_from_pyobject(item,
+                                          &((unsigned char *)values)[i]);
+                break;
+
+            case DBUS_TYPE_BOOLEAN:
+                ret = PyObject_IsTrue(item);
+                if (ret >= 0) {
+                    ((dbus_bool_t *)values)[i] = (ret ? TRUE : FALSE);
+                    ret = 0;
+                }
+                break;
+
+            case DBUS_TYPE_DOUBLE:
+                ((double *)values)[i] = PyFloat_AsDouble(item);
+                if (PyErr_Occurred())
+                    ret = -1;
+                break;
+
+#define PROCESS_INTEGER(size) \
+                ((dbus_##size##_t *)values)[i] = \
+                    dbus_py_##size##_range_check(item); \
+                if (((dbus_##size##_t *)values)[i] == (dbus_##size##_t)(-1) \
+                    && PyErr_Occurred()) \
+                    ret = -1;
+
+            case DBUS_TYPE_INT16:
+                PROCESS_INTEGER(int16)
+                break;
+            case DBUS_TYPE_UINT16:
+                PROCESS_INTEGER(uint16)
+                break;
+            case DBUS_TYPE_INT32:
+                PROCESS_INTEGER(int32)
+                break;
+            case DBUS_TYPE_UINT32:
+                PROCESS_INTEGER(uint32)
+                break;
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+            case DBUS_TYPE_INT64:
+                PROCESS_INTEGER(int64)
+                break;
+            case DBUS_TYPE_UINT64:
+                PROCESS_INTEGER(uint64)
+                break;
+#endif
+#undef PROCESS_INTEGER
+
+            default:
+                PyErr_Format(PyExc_TypeError, "Unknown type '\\x%x' in "
+                             "fixed-size array", element_type);
+                ret = -1;
+        }
+
+        Py_CLEAR(item);
+        if (ret < 0)
+            return -1;
+    }
+
+    if (PySequence_Fast_GET_SIZE(seq) != n) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "sequence changed size during iteration");
+        return -1;
+    }
+    return 0;
+}
+
+/* Append an array of a fixed-size type in a single libdbus call, rather
+ * than one item at a time. Lists and tuples are converted into a packed
+ * C array first; objects exporting a C-contiguous buffer of a matching
+ * format are passed to libdbus directly. Anything else takes the
+ * general path through _message_iter_append_multi(). */
+static int
+_message_iter_append_fixed_array(DBusMessageIter *appender,
+                                 const DBusPySigNode *node,
+                                 int element_type, PyObject *obj)
+{
+    size_t item_size = _fixed_array_item_size(element_type);
+    Py_buffer view;
+    dbus_bool_t have_view = FALSE;
+    void *values = NULL;
+    Py_ssize_t n;
+    DBusMessageIter sub;
+    int ret = -1;
+
+    assert(item_size > 0);
+
+    if (PyList_Check(obj) || PyTuple_Check(obj)) {
+        n = PySequence_Fast_GET_SIZE(obj);
+        if ((size_t)n > DBUS_MAXIMUM_ARRAY_LENGTH / item_size) {
+            PyErr_SetString(PyExc_ValueError, "Array too long to be sent "
+                            "over D-Bus");
+            return -1;
+        }
+        if (n > 0) {
+            values = PyMem_Malloc(n * item_size);
+            if (!values) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            if (_fixed_array_from_sequence(obj, element_type,
+                                           values, n) < 0) {
+                goto out;
+            }
+        }
+    }
+    else if (PyObject_CheckBuffer(obj)) {
+        if (PyObject_GetBuffer(obj, &view,
+                               PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0) {
+            /* not usable as a flat buffer: treat it as any other iterable */
+            PyErr_Clear();
+            return _message_iter_append_multi(appender, node,
+                                              DBUS_TYPE_ARRAY, obj);
+        }
+        if (!_buffer_matches_fixed_type(&view, element_type)) {
+            PyBuffer_Release(&view);
+            return _message_iter_append_multi(appender, node,
+                                              DBUS_TYPE_ARRAY, obj);
+        }
+        have_view = TRUE;
+        values = view.buf;
+        n = view.len / view.itemsize;
+        if ((size_t)n > DBUS_MAXIMUM_ARRAY_LENGTH / item_size) {
+            PyErr_SetString(PyExc_ValueError, "Array too long to be sent "
+                            "over D-Bus");
+            goto out;
+        }
+    }
+    else {
+        return _message_iter_append_multi(appender, node,
+                                          DBUS_TYPE_ARRAY, obj);
+    }
+
+    DBG("Opening ARRAY container of '%c'", element_type);
+    if (!dbus_message_iter_open_container(appender, DBUS_TYPE_ARRAY,
+                                          node->signature, &sub)) {
+        PyErr_NoMemory();
+        goto out;
+    }
+    DBG("Appending fixed array of %ld items", (long)n);
+    if (n == 0 || dbus_message_iter_append_fixed_array(&sub, element_type,
+                                                       &values, (int)n)) {
+        ret = 0;
+    }
+    else {
+        PyErr_NoMemory();
+    }
+    DBG("%s", "Closing ARRAY container");
+    if (!dbuspy_message_iter_close_container(appender, &sub, (ret == 0))) {
+        PyErr_NoMemory();
+        ret = -1;
+    }
+
+out:
+    if (have_view)
+        PyBuffer_Release(&view);
+    else
+        PyMem_Free(values);
+    return ret;
+}
+
 /* Encode some Python object into a D-Bus variant slot. */
 static int
 _message_iter_append_variant(DBusMessageIter *appender, PyObject *obj)
 {
-    DBusSignatureIter obj_sig_iter;
-    const char *obj_sig_str;
-    PyObject *obj_sig;
+    DBusPySigPlan *obj_plan = NULL;
+    GuessBuffer obj_sig;
+    const char *obj_sig_str = obj_sig.str;
     int ret;
     long variant_level;
-    dbus_bool_t dummy;
     DBusMessageIter *variant_iters = NULL;
 
     /* Separate the object into the contained object, and the number of
      * variants it's wrapped in. */
-    obj_sig = _signature_string_from_pyobject(obj, &variant_level);
-    if (!obj_sig) return -1;
-
-    if (PyUnicode_Check(obj_sig)) {
-        PyObject *obj_sig_as_bytes = PyUnicode_AsUTF8String(obj_sig);
-        Py_CLEAR(obj_sig);
-        if (!obj_sig_as_bytes)
-            return -1;
-        obj_sig = obj_sig_as_bytes;
-    }
-    obj_sig_str = PyBytes_AsString(obj_sig);
-    if (!obj_sig_str) {
-        Py_CLEAR(obj_sig);
+    obj_sig.len = 0;
+    obj_sig.str[0] = '\0';
+    if (_guess_signature_from_pyobject(obj, &obj_sig, &variant_level) < 0)
         return -1;
-    }
 
     if (variant_level < 1) {
         variant_level = 1;
     }
 
-    dbus_signature_iter_init(&obj_sig_iter, obj_sig_str);
+    obj_plan = dbus_py_sig_plan_get(obj_sig_str);
+    if (!obj_plan) {
+        ret = -1;
+        goto out;
+    }
+    if (obj_plan->n_args != 1) {
+        PyErr_Format(PyExc_ValueError, "Variant would contain more than "
+                     "one complete type: '%s'", obj_sig_str);
+        ret = -1;
+        goto out;
+    }
 
     {
         long i;
@@ -979,7 +1209,7 @@ _message_iter_append_variant(DBusMessageIter *appender, PyObject *obj)
 
         /* Put the object itself into the innermost variant */
         ret = _message_iter_append_pyobject(&variant_iters[variant_level-1],
-                                            &obj_sig_iter, obj, &dummy);
+                                            obj_plan->nodes, obj);
 
         /* here we rely on i (and variant_level) being a signed long */
         for (i = variant_level - 1; i >= 0; i--) {
@@ -1004,18 +1234,18 @@ out:
     if (variant_iters != NULL)
         free (variant_iters);
 
-    Py_CLEAR(obj_sig);
+    if (obj_plan)
+        dbus_py_sig_plan_release(obj_plan);
     return ret;
 }
 
-/* On success, *more is set to whether there's more in the signature. */
+/* Append obj as the complete type described by node. */
 static int
 _message_iter_append_pyobject(DBusMessageIter *appender,
-                              DBusSignatureIter *sig_iter,
-                              PyObject *obj,
-                              dbus_bool_t *more)
+                              const DBusPySigNode *node,
+                              PyObject *obj)
 {
-    int sig_type = dbus_signature_iter_get_current_type(sig_iter);
+    int sig_type = node->type;
     DBusBasicValue u;
     int ret = -1;
 
@@ -1026,6 +1256,21 @@ _message_iter_append_pyobject(DBusMessageIter *appender,
             appender, sig_type);
 #endif
 
+    if (DBusPyLazyVariant_Check(obj)) {
+        PyObject *value;
+
+        if (sig_type == DBUS_TYPE_VARIANT)
+            return dbus_py_LazyVariant_append(obj, appender);
+        /* something other than a variant is wanted, so it has to be
+         * unpacked after all */
+        value = dbus_py_LazyVariant_get_value(obj);
+        if (!value)
+            return -1;
+        ret = _message_iter_append_pyobject(appender, node, value);
+        Py_CLEAR(value);
+        return ret;
+    }
+
     switch (sig_type) {
       /* The numeric types are relatively simple to deal with, so are
        * inlined here. */
@@ -1141,36 +1386,34 @@ _message_iter_append_pyobject(DBusMessageIter *appender,
           break;
 
       case DBUS_TYPE_ARRAY:
-          /* 3 cases - it might actually be a dict, or it might be a byte array
+          /* 4 cases - it might actually be a dict, or it might be a byte array
            * being copied from a string (for which we have a faster path),
-           * or it might be a generic array. */
+           * or an array of some other fixed-size type (which can also be
+           * appended in bulk), or it might be a generic array. */
 
-          sig_type = dbus_signature_iter_get_element_type(sig_iter);
+          sig_type = node[1].type;
           if (sig_type == DBUS_TYPE_DICT_ENTRY)
-            ret = _message_iter_append_multi(appender, sig_iter,
+            ret = _message_iter_append_multi(appender, node,
                                              DBUS_TYPE_DICT_ENTRY, obj);
           else if (sig_type == DBUS_TYPE_BYTE && PyBytes_Check(obj))
             ret = _message_iter_append_string_as_byte_array(appender, obj);
+          else if (_fixed_array_item_size(sig_type) > 0)
+            ret = _message_iter_append_fixed_array(appender, node,
+                                                   sig_type, obj);
           else
-            ret = _message_iter_append_multi(appender, sig_iter,
+            ret = _message_iter_append_multi(appender, node,
                                              DBUS_TYPE_ARRAY, obj);
           DBG("_message_iter_append_multi(): %d", ret);
           break;
 
       case DBUS_TYPE_STRUCT:
-          ret = _message_iter_append_multi(appender, sig_iter, sig_type, obj);
+          ret = _message_iter_append_multi(appender, node, sig_type, obj);
           break;
 
       case DBUS_TYPE_VARIANT:
           ret = _message_iter_append_variant(appender, obj);
           break;
 
-      case DBUS_TYPE_INVALID:
-          PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
-                          "signature than in Python arguments");
-          ret = -1;
-          break;
-
 #if defined(DBUS_TYPE_UNIX_FD)
       case DBUS_TYPE_UNIX_FD:
           ret = _message_iter_append_unixfd(appender, obj);
@@ -1184,99 +1427,174 @@ _message_iter_append_pyobject(DBusMessageIter *appender,
           break;
     }
     if (ret < 0) return -1;
-
-    DBG("Advancing signature iter at %p", sig_iter);
-    *more = dbus_signature_iter_next(sig_iter);
-#ifdef USING_DBG
-    DBG("- result: %ld, type %02x '%c'", (long)(*more),
-        (int)dbus_signature_iter_get_current_type(sig_iter),
-        (int)dbus_signature_iter_get_current_type(sig_iter));
-#endif
     return 0;
 }
 
 
-PyObject *
-dbus_py_Message_append(Message *self, PyObject *args, PyObject *kwargs)
+/* Append a copy of the complete type at src, which is reading some other
+ * message, without converting it to Python objects. Return 0 on success
+ * or -1 with an exception set. */
+int
+dbus_py_message_iter_copy(DBusMessageIter *src, DBusMessageIter *dst)
 {
-    const char *signature = NULL;
-    PyObject *signature_obj = NULL;
-    DBusSignatureIter sig_iter;
-    DBusMessageIter appender;
-    static char *argnames[] = {"signature", NULL};
-    dbus_bool_t more;
+    int type = dbus_message_iter_get_arg_type(src);
+    int element_type;
+    DBusMessageIter src_sub, dst_sub;
+    char *sig = NULL;
+    const char *contained = NULL;
+    int ret = 0;
 
-    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (dbus_type_is_basic(type)) {
+        DBusBasicValue u;
+        dbus_bool_t ok;
 
-#ifdef USING_DBG
-    fprintf(stderr, "DBG/%ld: called Message_append(*", (long)getpid());
-    PyObject_Print(args, stderr, 0);
-    if (kwargs) {
-        fprintf(stderr, ", **");
-        PyObject_Print(kwargs, stderr, 0);
-    }
-    fprintf(stderr, ")\n");
+        dbus_message_iter_get_basic(src, &u);
+        ok = dbus_message_iter_append_basic(dst, type, &u);
+#if defined(DBUS_TYPE_UNIX_FD)
+        /* we were given a duplicate, and appending makes another one */
+        if (type == DBUS_TYPE_UNIX_FD && u.fd >= 0)
+            close(u.fd);
 #endif
+        if (!ok) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        return 0;
+    }
 
-    /* only use kwargs for this step: deliberately ignore args for now */
-    if (!PyArg_ParseTupleAndKeywords(dbus_py_empty_tuple, kwargs, "|z:append",
-                                     argnames, &signature)) return NULL;
+    switch (type) {
+        case DBUS_TYPE_ARRAY:
+            /* the signature of an empty array's items is only available
+             * from the array itself */
+            sig = dbus_message_iter_get_signature(src);
+            if (!sig) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            contained = sig + 1;
+            break;
+        case DBUS_TYPE_VARIANT:
+            dbus_message_iter_recurse(src, &src_sub);
+            sig = dbus_message_iter_get_signature(&src_sub);
+            if (!sig) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            contained = sig;
+            break;
+        case DBUS_TYPE_STRUCT:
+        case DBUS_TYPE_DICT_ENTRY:
+            break;
+        default:
+            PyErr_Format(PyExc_TypeError, "Unknown type '\\x%x' in D-Bus "
+                         "message", type);
+            return -1;
+    }
 
-    if (!signature) {
-        DBG("%s", "No signature for message, guessing...");
-        signature_obj = dbus_py_Message_guess_signature(NULL, args);
-        if (!signature_obj) return NULL;
-        if (PyUnicode_Check(signature_obj)) {
-            PyObject *signature_as_bytes;
-            signature_as_bytes = PyUnicode_AsUTF8String(signature_obj);
-            Py_CLEAR(signature_obj);
-            if (!signature_as_bytes)
-                return NULL;
-            signature_obj = signature_as_bytes;
+    dbus_message_iter_recurse(src, &src_sub);
+    if (!dbus_message_iter_open_container(dst, type, contained, &dst_sub)) {
+        dbus_free(sig);
+        PyErr_NoMemory();
+        return -1;
+    }
+    dbus_free(sig);
+
+    element_type = (type == DBUS_TYPE_ARRAY
+                    ? dbus_message_iter_get_element_type(src)
+                    : DBUS_TYPE_INVALID);
+    if (_fixed_array_item_size(element_type) > 0) {
+        const void *data = NULL;
+        int n = 0;
+
+        dbus_message_iter_get_fixed_array(&src_sub, &data, &n);
+        if (n > 0 && !dbus_message_iter_append_fixed_array(&dst_sub,
+                                                           element_type,
+                                                           &data, n)) {
+            PyErr_NoMemory();
+            ret = -1;
         }
-        else {
-            assert(PyBytes_Check(signature_obj));
+    }
+    else {
+        while (dbus_message_iter_get_arg_type(&src_sub)
+               != DBUS_TYPE_INVALID) {
+            if (dbus_py_message_iter_copy(&src_sub, &dst_sub) < 0) {
+                ret = -1;
+                break;
+            }
+            dbus_message_iter_next(&src_sub);
         }
-        signature = PyBytes_AS_STRING(signature_obj);
     }
-    /* from here onwards, you have to do a goto rather than returning NULL
-    to make sure signature_obj gets freed */
 
-    /* iterate over args and the signature, together */
-    if (!dbus_signature_validate(signature, NULL)) {
-        PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
-        goto err;
+    if (!dbuspy_message_iter_close_container(dst, &dst_sub, ret == 0)) {
+        PyErr_NoMemory();
+        return -1;
     }
-    dbus_message_iter_init_append(self->msg, &appender);
+    return ret;
+}
 
-    if (signature[0] != '\0') {
-        int i = 0;
+/* Append the items of the tuple args to the message, according to
+ * signature, or a guessed signature if that's NULL. Return 0, or -1 with
+ * an exception set; if appending failed part-way through, the message
+ * is thrown away. */
+int
+dbus_py_Message_append_args(Message *self, PyObject *args,
+                            const char *signature)
+{
+    GuessBuffer guessed;
+    DBusPySigPlan *plan = NULL;
+    const DBusPySigNode *node;
+    DBusMessageIter appender;
+    unsigned int i;
 
-        more = TRUE;
-        dbus_signature_iter_init(&sig_iter, signature);
-        while (more) {
-            if (i >= PyTuple_GET_SIZE(args)) {
-                PyErr_SetString(PyExc_TypeError, "More items found in D-Bus "
-                                "signature than in Python arguments");
-                goto hosed;
-            }
-            if (_message_iter_append_pyobject(&appender, &sig_iter,
-                                              PyTuple_GET_ITEM(args, i),
-                                              &more) < 0) {
-                goto hosed;
-            }
-            i++;
+    if (!self->msg) {
+        DBusPy_RaiseUnusableMessage();
+        return -1;
+    }
+    if (self->exports > 0) {
+        PyErr_SetString(PyExc_BufferError, "Existing exports of data: "
+                        "arguments cannot be appended to this message");
+        return -1;
+    }
+    dbus_py_Message_clear_args_cache(self);
+    /* the header includes the signature */
+    Py_CLEAR(self->header);
+
+    if (!signature) {
+        DBG("%s", "No signature for message, guessing...");
+        if (_guess_signature_from_args(args, &guessed) < 0) return -1;
+        signature = guessed.str;
+    }
+    /* from here onwards, you have to do a goto rather than returning -1
+    to make sure plan gets freed */
+
+    /* validates the signature, or finds it already compiled */
+    plan = dbus_py_sig_plan_get(signature);
+    if (!plan) goto err;
+    dbus_message_iter_init_append(self->msg, &appender);
+
+    /* iterate over args and the signature, together */
+    node = plan->nodes;
+    for (i = 0; i < plan->n_args; i++) {
+        if (i >= (unsigned int)PyTuple_GET_SIZE(args)) {
+            PyErr_SetString(PyExc_TypeError, "More items found in D-Bus "
+                            "signature than in Python arguments");
+            goto hosed;
         }
-        if (i < PyTuple_GET_SIZE(args)) {
-            PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
-                    "signature than in Python arguments");
+        if (_message_iter_append_pyobject(&appender, node,
+                                          PyTuple_GET_ITEM(args, i)) < 0) {
             goto hosed;
         }
+        node += node->n_nodes;
+    }
+    if (plan->n_args > 0 && i < (unsigned int)PyTuple_GET_SIZE(args)) {
+        PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
+                "signature than in Python arguments");
+        goto hosed;
     }
 
     /* success! */
-    Py_CLEAR(signature_obj);
-    Py_RETURN_NONE;
+    dbus_py_sig_plan_release(plan);
+    return 0;
 
 hosed:
     /* "If appending any of the arguments fails due to lack of memory,
@@ -1286,8 +1604,34 @@ hosed:
     dbus_message_unref(self->msg);
     self->msg = NULL;
 err:
-    Py_CLEAR(signature_obj);
-    return NULL;
+    if (plan)
+        dbus_py_sig_plan_release(plan);
+    return -1;
+}
+
+PyObject *
+dbus_py_Message_append(Message *self, PyObject *args, PyObject *kwargs)
+{
+    const char *signature = NULL;
+    static char *argnames[] = {"signature", NULL};
+
+#ifdef USING_DBG
+    fprintf(stderr, "DBG/%ld: called Message_append(*", (long)getpid());
+    PyObject_Print(args, stderr, 0);
+    if (kwargs) {
+        fprintf(stderr, ", **");
+        PyObject_Print(kwargs, stderr, 0);
+    }
+    fprintf(stderr, ")\n");
+#endif
+
+    /* only use kwargs for this step: deliberately ignore args for now */
+    if (!PyArg_ParseTupleAndKeywords(dbus_py_empty_tuple, kwargs, "|z:append",
+                                     argnames, &signature)) return NULL;
+
+    if (dbus_py_Message_append_args(self, args, signature) < 0)
+        return NULL;
+    Py_RETURN_NONE;
 }
 
 /* vim:set ft=c cino< sw=4 sts=4 et: */
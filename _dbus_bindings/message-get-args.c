@@ -43,6 +43,51 @@ char dbus_py_Message_get_args_list__doc__[] = (
 "       it's off by default for consistency.\n"
 "\n"
 "       If false (default), convert them into a dbus.Array of Bytes.\n"
+"   `fixed_arrays` : str or None\n"
+"       If 'buffer', convert arrays of fixed-size numeric types (signatures\n"
+"       'ay', 'an', 'aq', 'ai', 'au', 'ax', 'at' and 'ad') into read-only\n"
+"       memoryview objects sharing the message's memory, with a struct\n"
+"       module format matching the item type. No per-item Python objects\n"
+"       are created; the message cannot be appended to while any such\n"
+"       view is alive. byte_arrays takes precedence for 'ay', and the\n"
+"       variant_level of an array inside a variant is not preserved.\n"
+"\n"
+"       If None (default), convert them into a dbus.Array.\n"
+"   `cache` : bool\n"
+"       If true, keep the list in the message and return the same list from\n"
+"       later calls with cache=True and the same options, until more\n"
+"       arguments are appended. This lets everything that a message is\n"
+"       dispatched to share one unpacking of it; the list and its items\n"
+"       must not be modified. It cannot be combined with fixed_arrays.\n"
+"\n"
+"       If false (default), unpack the arguments into a new list.\n"
+"\n"
+"       :Since: 1.2.1\n"
+"   `native` : bool\n"
+"       If true, return builtin Python types instead of the dbus.types\n"
+"       wrappers: int for all integer types and bytes, bool, float, str for\n"
+"       strings, object paths and signatures, list for arrays, dict for\n"
+"       dictionaries and tuple for structs. On Python 2, strings are\n"
+"       unicode like dbus.String (or str if utf8_strings is also set) and\n"
+"       64-bit integers are long. Variants are replaced by their contents,\n"
+"       so variant_level is lost, and the D-Bus type of each value is no\n"
+"       longer recorded. Byte arrays are bytes if byte_arrays is also set,\n"
+"       and Unix file descriptors are still dbus.types.UnixFd.\n"
+"       This is several times faster and uses much less memory.\n"
+"\n"
+"       If false (default), use the mappings below.\n"
+"\n"
+"       :Since: 1.2.1\n"
+"   `lazy_variants` : bool\n"
+"       If true, return each variant as a dbus.LazyVariant, which only\n"
+"       unpacks its contents when its `value` is read, and can be appended\n"
+"       to another message as a variant without being unpacked. This\n"
+"       avoids unpacking the values of large a{sv} dictionaries that are\n"
+"       mostly ignored. It cannot be combined with cache.\n"
+"\n"
+"       If false (default), unpack variants' contents immediately.\n"
+"\n"
+"       :Since: 1.2.1\n"
 #ifndef PY3
 "   `utf8_strings` : bool\n"
 "       If true, return D-Bus strings as Python 8-bit strings (of UTF-8).\n"
@@ -76,12 +121,394 @@ typedef struct {
 #ifndef PY3
     int utf8_strings;
 #endif
+    int fixed_arrays_as_buffer;
+    int native;
+    int lazy_variants;
+    /* the message being unpacked, for objects which refer back to it */
+    Message *message;
 } Message_get_args_options;
 
+/* Fixed-size arrays exported as buffers ============================ */
+
+/* A read-only buffer exporter for the contents of an array of a
+ * fixed-size type, pointing directly into a message's body. It is only
+ * ever seen from Python wrapped in a memoryview. The message is kept
+ * alive, and prevented from being appended to (which might reallocate
+ * its body), for as long as the exporter exists.
+ */
+typedef struct {
+    PyObject_HEAD
+    Message *message;
+    DBusMessage *msg;
+    const void *data;
+    char format[2];
+    Py_ssize_t shape[1];
+    Py_ssize_t strides[1];
+} FixedArrayBuffer;
+
+/* libdbus gives us NULL for an empty array, but buffers must point
+ * somewhere */
+static double empty_fixed_array[1];
+
+static void
+FixedArrayBuffer_tp_dealloc(FixedArrayBuffer *self)
+{
+    if (self->message) {
+        self->message->exports--;
+        Py_CLEAR(self->message);
+    }
+    if (self->msg) {
+        dbus_message_unref(self->msg);
+    }
+    PyObject_Del(self);
+}
+
+static int
+FixedArrayBuffer_getbuffer(FixedArrayBuffer *self, Py_buffer *view,
+                           int flags)
+{
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "D-Bus message arguments "
+                        "are read-only");
+        return -1;
+    }
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+    view->buf = (void *)self->data;
+    view->len = self->shape[0] * self->strides[0];
+    view->readonly = 1;
+    view->itemsize = self->strides[0];
+    view->format = ((flags & PyBUF_FORMAT) == PyBUF_FORMAT
+                    ? self->format : NULL);
+    view->ndim = 1;
+    view->shape = ((flags & PyBUF_ND) == PyBUF_ND ? self->shape : NULL);
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES
+                     ? self->strides : NULL);
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs FixedArrayBuffer_tp_as_buffer = {
+#ifndef PY3
+    0,                                      /* bf_getreadbuffer */
+    0,                                      /* bf_getwritebuffer */
+    0,                                      /* bf_getsegcount */
+    0,                                      /* bf_getcharbuffer */
+#endif
+    (getbufferproc)FixedArrayBuffer_getbuffer, /* bf_getbuffer */
+    0,                                      /* bf_releasebuffer */
+};
+
+static PyTypeObject FixedArrayBuffer_Type = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "_dbus_bindings._FixedArrayBuffer",
+    sizeof(FixedArrayBuffer),
+    0,
+    (destructor)FixedArrayBuffer_tp_dealloc, /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    &FixedArrayBuffer_tp_as_buffer,         /* tp_as_buffer */
+#ifdef PY3
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+#else
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+#endif
+    0,                                      /* tp_doc */
+};
+
+/* Return the struct module format character for items of a fixed-size
+ * array that can be exported as a buffer, and put the size of an item in
+ * *itemsize; or return '\0' if that type must be unpacked into Python
+ * objects. Booleans are 4 bytes on the wire, so there is no matching
+ * format for them. */
+static char
+_fixed_array_buffer_format(int element_type, Py_ssize_t *itemsize)
+{
+    switch (element_type) {
+        case DBUS_TYPE_BYTE:
+            *itemsize = sizeof(unsigned char);
+            return 'B';
+        case DBUS_TYPE_INT16:
+            *itemsize = sizeof(dbus_int16_t);
+            return 'h';
+        case DBUS_TYPE_UINT16:
+            *itemsize = sizeof(dbus_uint16_t);
+            return 'H';
+        case DBUS_TYPE_INT32:
+            *itemsize = sizeof(dbus_int32_t);
+            return 'i';
+        case DBUS_TYPE_UINT32:
+            *itemsize = sizeof(dbus_uint32_t);
+            return 'I';
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+            *itemsize = sizeof(dbus_int64_t);
+            return 'q';
+        case DBUS_TYPE_UINT64:
+            *itemsize = sizeof(dbus_uint64_t);
+            return 'Q';
+#endif
+        case DBUS_TYPE_DOUBLE:
+            *itemsize = sizeof(double);
+            return 'd';
+        default:
+            return '\0';
+    }
+}
+
+/* Return a memoryview of the array at iter, whose items have the given
+ * struct module format and size. Returns a new reference. */
+static PyObject *
+_message_iter_get_fixed_array_buffer(DBusMessageIter *iter,
+                                     Message_get_args_options *opts,
+                                     char format, Py_ssize_t itemsize)
+{
+    FixedArrayBuffer *exporter;
+    DBusMessageIter sub;
+    const void *data = NULL;
+    int n = 0;
+    PyObject *ret;
+
+    dbus_message_iter_recurse(iter, &sub);
+    dbus_message_iter_get_fixed_array(&sub, &data, &n);
+
+    exporter = PyObject_New(FixedArrayBuffer, &FixedArrayBuffer_Type);
+    if (!exporter) return NULL;
+    exporter->message = opts->message;
+    Py_INCREF(exporter->message);
+    exporter->message->exports++;
+    exporter->msg = dbus_message_ref(opts->message->msg);
+    exporter->data = (data ? data : (const void *)empty_fixed_array);
+    exporter->format[0] = format;
+    exporter->format[1] = '\0';
+    exporter->shape[0] = n;
+    exporter->strides[0] = itemsize;
+
+    ret = PyMemoryView_FromObject((PyObject *)exporter);
+    /* the memoryview holds the only reference we need */
+    Py_CLEAR(exporter);
+    return ret;
+}
+
 static PyObject *_message_iter_get_pyobject(DBusMessageIter *iter,
                                             Message_get_args_options *opts,
                                             long extra_variants);
 
+/* Lazily unpacked variants ========================================= */
+
+PyDoc_STRVAR(LazyVariant_tp_doc,
+"A variant among a message's arguments that has not been unpacked yet,\n"
+"as returned by ``get_args_list(lazy_variants=True)``. It cannot be\n"
+"instantiated from Python.\n"
+"\n"
+"Its contents are unpacked, with the options that were given to\n"
+"get_args_list, when the `value` attribute is first read. Appending a\n"
+"LazyVariant to another message as a variant ('v') copies it across\n"
+"without unpacking it at all.\n"
+"\n"
+"A LazyVariant keeps its message alive, and prevents arguments being\n"
+"appended to that message, for as long as it exists.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+typedef struct {
+    PyObject_HEAD
+    Message *message;
+    DBusMessage *msg;
+    /* positioned at the variant itself */
+    DBusMessageIter iter;
+    Message_get_args_options opts;
+    /* the unpacked contents, or NULL if they haven't been needed yet */
+    PyObject *value;
+} LazyVariant;
+
+static PyObject *
+_message_iter_get_lazy_variant(DBusMessageIter *iter,
+                               Message_get_args_options *opts)
+{
+    LazyVariant *self;
+
+    self = PyObject_New(LazyVariant, &DBusPyLazyVariant_Type);
+    if (!self) return NULL;
+    self->message = opts->message;
+    Py_INCREF(self->message);
+    self->message->exports++;
+    self->msg = dbus_message_ref(opts->message->msg);
+    self->iter = *iter;
+    self->opts = *opts;
+    self->value = NULL;
+    return (PyObject *)self;
+}
+
+static void
+LazyVariant_tp_dealloc(LazyVariant *self)
+{
+    Py_CLEAR(self->value);
+    if (self->message) {
+        self->message->exports--;
+        Py_CLEAR(self->message);
+    }
+    if (self->msg) {
+        dbus_message_unref(self->msg);
+    }
+    PyObject_Del(self);
+}
+
+/* Returns a borrowed reference to the unpacked contents. */
+static PyObject *
+LazyVariant_borrow_value(LazyVariant *self)
+{
+    DBusMessageIter iter = self->iter;
+    DBusMessageIter sub;
+    long variant_level = 0;
+
+    if (self->value) return self->value;
+
+    /* Directly nested variants just add to the variant_level; unpacking
+     * them with lazy_variants set would only give another LazyVariant */
+    while (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_VARIANT) {
+        dbus_message_iter_recurse(&iter, &sub);
+        iter = sub;
+        variant_level++;
+    }
+    self->value = _message_iter_get_pyobject(&iter, &self->opts,
+                                             (self->opts.native
+                                              ? 0 : variant_level));
+    return self->value;
+}
+
+PyObject *
+dbus_py_LazyVariant_get_value(PyObject *self)
+{
+    PyObject *value = LazyVariant_borrow_value((LazyVariant *)self);
+
+    Py_XINCREF(value);
+    return value;
+}
+
+int
+dbus_py_LazyVariant_append(PyObject *self, DBusMessageIter *appender)
+{
+    DBusMessageIter iter = ((LazyVariant *)self)->iter;
+
+    return dbus_py_message_iter_copy(&iter, appender);
+}
+
+static PyObject *
+LazyVariant_get_value(LazyVariant *self, void *closure UNUSED)
+{
+    return dbus_py_LazyVariant_get_value((PyObject *)self);
+}
+
+static PyObject *
+LazyVariant_get_signature(LazyVariant *self, void *closure UNUSED)
+{
+    DBusMessageIter sub;
+    char *sig;
+    PyObject *ret;
+
+    dbus_message_iter_recurse(&self->iter, &sub);
+    sig = dbus_message_iter_get_signature(&sub);
+    if (!sig) return PyErr_NoMemory();
+    ret = DBusPySignature_FromDBus(sig, 0);
+    dbus_free(sig);
+    return ret;
+}
+
+static PyObject *
+LazyVariant_get_variant_level(LazyVariant *self, void *closure UNUSED)
+{
+    DBusMessageIter iter = self->iter;
+    DBusMessageIter sub;
+    long variant_level = 0;
+
+    while (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_VARIANT) {
+        dbus_message_iter_recurse(&iter, &sub);
+        iter = sub;
+        variant_level++;
+    }
+    return NATIVEINT_FROMLONG(variant_level);
+}
+
+static PyObject *
+LazyVariant_tp_repr(LazyVariant *self)
+{
+    PyObject *sig = LazyVariant_get_signature(self, NULL);
+    PyObject *ret;
+
+    if (!sig) return NULL;
+#ifdef PY3
+    ret = PyUnicode_FromFormat("<%s with signature '%U'>",
+                               Py_TYPE(self)->tp_name, sig);
+#else
+    ret = PyString_FromFormat("<%s with signature '%s'>",
+                              Py_TYPE(self)->tp_name,
+                              PyString_AS_STRING(sig));
+#endif
+    Py_CLEAR(sig);
+    return ret;
+}
+
+static PyGetSetDef LazyVariant_tp_getset[] = {
+    {"value", (getter)LazyVariant_get_value, NULL,
+     "The variant's contents, unpacked when first needed, as get_args_list\n"
+     "without lazy_variants would have returned them.", NULL},
+    {"signature", (getter)LazyVariant_get_signature, NULL,
+     "The signature of the variant's contents, found without unpacking\n"
+     "them.", NULL},
+    {"variant_level", (getter)LazyVariant_get_variant_level, NULL,
+     "The number of nested variants wrapping the contents: usually 1.",
+     NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+PyTypeObject DBusPyLazyVariant_Type = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.LazyVariant",
+    sizeof(LazyVariant),
+    0,
+    (destructor)LazyVariant_tp_dealloc,     /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    (reprfunc)LazyVariant_tp_repr,          /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    LazyVariant_tp_doc,                     /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    0,                                      /* tp_methods */
+    0,                                      /* tp_members */
+    LazyVariant_tp_getset,                  /* tp_getset */
+};
+
 /* Append all the items iterated over to the given Python list object.
    * Return 0 on success/-1 with exception on failure. */
 static int
@@ -114,12 +541,84 @@ _message_iter_append_all_to_list(DBusMessageIter *iter, PyObject *list,
     return 0;
 }
 
+/* Returns a new reference to the dict key at iter. Keys are mostly drawn
+ * from a small vocabulary (property names and the like), so string keys
+ * come from the intern table rather than being decoded afresh. */
+static PyObject *
+_message_iter_get_dict_key(DBusMessageIter *iter,
+                           Message_get_args_options *opts)
+{
+    const char *str;
+
+    switch (dbus_message_iter_get_arg_type(iter)) {
+        case DBUS_TYPE_STRING:
+#ifndef PY3
+            if (opts->utf8_strings)
+                break;
+#endif
+            dbus_message_iter_get_basic(iter, &str);
+            return dbus_py_intern(opts->native ? DBUS_PY_INTERN_UNICODE
+                                               : DBUS_PY_INTERN_STRING,
+                                  str);
+
+        case DBUS_TYPE_OBJECT_PATH:
+            dbus_message_iter_get_basic(iter, &str);
+            return dbus_py_intern(opts->native ? DBUS_PY_INTERN_NATIVESTR
+                                               : DBUS_PY_INTERN_OBJECT_PATH,
+                                  str);
+    }
+    return _message_iter_get_pyobject(iter, opts, 0);
+}
+
+/* Add the entries of the dict (array of DICT_ENTRY) at iter to the given
+ * Python dict object. Return 0 on success/-1 with exception on failure. */
+static int
+_message_iter_fill_dict(DBusMessageIter *iter,
+                        Message_get_args_options *opts,
+                        PyObject *dict)
+{
+    DBusMessageIter entries;
+    int status;
+
+    dbus_message_iter_recurse(iter, &entries);
+    while (dbus_message_iter_get_arg_type(&entries) == DBUS_TYPE_DICT_ENTRY) {
+        PyObject *key = NULL;
+        PyObject *value = NULL;
+        DBusMessageIter kv;
+
+        DBG("%s", "dict entry...");
+
+        dbus_message_iter_recurse(&entries, &kv);
+
+        key = _message_iter_get_dict_key(&kv, opts);
+        if (!key) {
+            return -1;
+        }
+        dbus_message_iter_next(&kv);
+
+        value = _message_iter_get_pyobject(&kv, opts, 0);
+        if (!value) {
+            Py_CLEAR(key);
+            return -1;
+        }
+
+        status = PyDict_SetItem(dict, key, value);
+        Py_CLEAR(key);
+        Py_CLEAR(value);
+
+        if (status < 0) {
+            return -1;
+        }
+        dbus_message_iter_next(&entries);
+    }
+    return 0;
+}
+
 static inline PyObject *
 _message_iter_get_dict(DBusMessageIter *iter,
                        Message_get_args_options *opts,
                        PyObject *kwargs)
 {
-    DBusMessageIter entries;
     char *sig_str = dbus_message_iter_get_signature(iter);
     PyObject *sig;
     PyObject *ret;
@@ -146,43 +645,194 @@ _message_iter_get_dict(DBusMessageIter *iter,
     if (!ret) {
         return NULL;
     }
+    if (_message_iter_fill_dict(iter, opts, ret) < 0) {
+        Py_CLEAR(ret);
+    }
+    return ret;
+}
 
-    dbus_message_iter_recurse(iter, &entries);
-    while (dbus_message_iter_get_arg_type(&entries) == DBUS_TYPE_DICT_ENTRY) {
-        PyObject *key = NULL;
-        PyObject *value = NULL;
-        DBusMessageIter kv;
-
-        DBG("%s", "dict entry...");
-
-        dbus_message_iter_recurse(&entries, &kv);
+/* Native types ===================================================== */
 
-        key = _message_iter_get_pyobject(&kv, opts, 0);
-        if (!key) {
-            Py_CLEAR(ret);
+/* Return a builtin Python object for the value of fixed-size type at p,
+ * which is either a DBusBasicValue or an item of a fixed-size array.
+ * Returns a new reference. */
+static PyObject *
+_native_from_fixed(int type, const void *p)
+{
+    switch (type) {
+        case DBUS_TYPE_BYTE:
+            return NATIVEINT_FROMLONG(*(const unsigned char *)p);
+        case DBUS_TYPE_BOOLEAN:
+            return PyBool_FromLong(*(const dbus_bool_t *)p);
+        case DBUS_TYPE_INT16:
+            return NATIVEINT_FROMLONG(*(const dbus_int16_t *)p);
+        case DBUS_TYPE_UINT16:
+            return NATIVEINT_FROMLONG(*(const dbus_uint16_t *)p);
+        case DBUS_TYPE_INT32:
+            return NATIVEINT_FROMLONG(*(const dbus_int32_t *)p);
+        case DBUS_TYPE_UINT32:
+#if LONG_MAX < 0xFFFFFFFFL
+            if (*(const dbus_uint32_t *)p > (unsigned long)LONG_MAX) {
+                return PyLong_FromUnsignedLong(*(const dbus_uint32_t *)p);
+            }
+#endif
+            return NATIVEINT_FROMLONG((long)*(const dbus_uint32_t *)p);
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+            return PyLong_FromLongLong(*(const dbus_int64_t *)p);
+        case DBUS_TYPE_UINT64:
+            return PyLong_FromUnsignedLongLong(*(const dbus_uint64_t *)p);
+#else
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+            PyErr_SetString(PyExc_NotImplementedError,
+                            "64-bit integer types are not supported on "
+                            "this platform");
             return NULL;
-        }
-        dbus_message_iter_next(&kv);
-
-        value = _message_iter_get_pyobject(&kv, opts, 0);
-        if (!value) {
-            Py_CLEAR(key);
-            Py_CLEAR(ret);
+#endif
+        case DBUS_TYPE_DOUBLE:
+            return PyFloat_FromDouble(*(const double *)p);
+#ifdef WITH_DBUS_FLOAT32
+        case DBUS_TYPE_FLOAT:
+            return PyFloat_FromDouble(*(const float *)p);
+#endif
+        default:
+            PyErr_Format(PyExc_TypeError, "Unknown type '\\%x' in D-Bus "
+                         "message", type);
             return NULL;
-        }
+    }
+}
 
-        status = PyDict_SetItem(ret, key, value);
-        Py_CLEAR(key);
-        Py_CLEAR(value);
+/* Return a list of builtin Python objects for the array at iter, whose
+ * items are of a fixed-size type, or NULL with no exception set if that
+ * type has to be iterated over item by item. */
+static PyObject *
+_native_list_from_fixed_array(DBusMessageIter *iter, int type)
+{
+    DBusMessageIter sub;
+    const char *data = NULL;
+    Py_ssize_t itemsize;
+    PyObject *list;
+    int n = 0, i;
 
-        if (status < 0) {
-            Py_CLEAR(ret);
+    if (type == DBUS_TYPE_BOOLEAN) {
+        itemsize = sizeof(dbus_bool_t);
+    }
+    else if (!_fixed_array_buffer_format(type, &itemsize)) {
+        return NULL;
+    }
+
+    dbus_message_iter_recurse(iter, &sub);
+    dbus_message_iter_get_fixed_array(&sub, &data, &n);
+    list = PyList_New(n);
+    if (!list) return NULL;
+    for (i = 0; i < n; i++) {
+        PyObject *item = _native_from_fixed(type, data + i * itemsize);
+
+        if (!item) {
+            Py_CLEAR(list);
             return NULL;
         }
-        dbus_message_iter_next(&entries);
+        PyList_SET_ITEM(list, i, item);
     }
+    return list;
+}
 
-    return ret;
+/* Returns a new reference to the value at iter as builtin Python types.
+ * Unix fds, which have no builtin equivalent, are not handled here. */
+static PyObject *
+_message_iter_get_native(DBusMessageIter *iter,
+                         Message_get_args_options *opts)
+{
+    DBusBasicValue u;
+    DBusMessageIter sub;
+    int type = dbus_message_iter_get_arg_type(iter);
+    char format;
+    Py_ssize_t itemsize;
+    PyObject *ret;
+
+    switch (type) {
+        case DBUS_TYPE_STRING:
+            dbus_message_iter_get_basic(iter, &u.str);
+#ifndef PY3
+            if (opts->utf8_strings) {
+                return PyString_FromString(u.str);
+            }
+#endif
+            return PyUnicode_DecodeUTF8(u.str, strlen(u.str), NULL);
+
+        case DBUS_TYPE_SIGNATURE:
+        case DBUS_TYPE_OBJECT_PATH:
+            dbus_message_iter_get_basic(iter, &u.str);
+            return NATIVESTR_FROMSTR(u.str);
+
+        case DBUS_TYPE_ARRAY:
+            type = dbus_message_iter_get_element_type(iter);
+            if (type == DBUS_TYPE_DICT_ENTRY) {
+                ret = PyDict_New();
+                if (ret && _message_iter_fill_dict(iter, opts, ret) < 0) {
+                    Py_CLEAR(ret);
+                }
+                return ret;
+            }
+            if (opts->byte_arrays && type == DBUS_TYPE_BYTE) {
+                const char *data = NULL;
+                int n = 0;
+
+                dbus_message_iter_recurse(iter, &sub);
+                dbus_message_iter_get_fixed_array(&sub, &data, &n);
+                /* libdbus gives us NULL for an empty array */
+                return PyBytes_FromStringAndSize(data ? data : "", n);
+            }
+            if (opts->fixed_arrays_as_buffer &&
+                (format = _fixed_array_buffer_format(type, &itemsize))) {
+                return _message_iter_get_fixed_array_buffer(iter, opts,
+                                                            format,
+                                                            itemsize);
+            }
+            ret = _native_list_from_fixed_array(iter, type);
+            if (ret || PyErr_Occurred()) {
+                return ret;
+            }
+            ret = PyList_New(0);
+            if (!ret) return NULL;
+            dbus_message_iter_recurse(iter, &sub);
+            if (_message_iter_append_all_to_list(&sub, ret, opts) < 0) {
+                Py_CLEAR(ret);
+            }
+            return ret;
+
+        case DBUS_TYPE_STRUCT:
+            {
+                PyObject *list = PyList_New(0);
+
+                if (!list) return NULL;
+                dbus_message_iter_recurse(iter, &sub);
+                if (_message_iter_append_all_to_list(&sub, list, opts) < 0) {
+                    Py_CLEAR(list);
+                    return NULL;
+                }
+                ret = PyList_AsTuple(list);
+                Py_CLEAR(list);
+                return ret;
+            }
+
+        case DBUS_TYPE_VARIANT:
+            if (opts->lazy_variants) {
+                return _message_iter_get_lazy_variant(iter, opts);
+            }
+            dbus_message_iter_recurse(iter, &sub);
+            return _message_iter_get_pyobject(&sub, opts, 0);
+
+        default:
+            if (!dbus_type_is_basic(type)) {
+                PyErr_Format(PyExc_TypeError, "Unknown type '\\%x' in D-Bus "
+                             "message", type);
+                return NULL;
+            }
+            dbus_message_iter_get_basic(iter, &u);
+            return _native_from_fixed(type, &u);
+    }
 }
 
 /* Returns a new reference. */
@@ -193,14 +843,26 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
 {
     DBusBasicValue u;
     int type = dbus_message_iter_get_arg_type(iter);
+    char format;
+    Py_ssize_t itemsize;
     PyObject *args = NULL;
     PyObject *kwargs = NULL;
     PyObject *ret = NULL;
 
-    /* If the variant-level is >0, prepare a dict for the kwargs.
-     * For variant wrappers optimize slightly by skipping this.
+#ifdef DBUS_TYPE_UNIX_FD
+    if (opts->native && type != DBUS_TYPE_UNIX_FD) {
+#else
+    if (opts->native) {
+#endif
+        return _message_iter_get_native(iter, opts);
+    }
+
+    /* If the variant-level is >0, prepare a dict for the kwargs of the
+     * types which are still constructed by calling them. Other basic types
+     * are constructed directly, and variant wrappers just pass it on.
      */
-    if (variant_level > 0 && type != DBUS_TYPE_VARIANT) {
+    if (variant_level > 0 && type != DBUS_TYPE_VARIANT
+        && !dbus_type_is_basic(type)) {
         PyObject *variant_level_int;
 
         variant_level_int = NATIVEINT_FROMLONG(variant_level);
@@ -225,57 +887,34 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
      */
 
     switch (type) {
-        PyObject *unicode;
-
         case DBUS_TYPE_STRING:
             DBG("%s", "found a string");
             dbus_message_iter_get_basic(iter, &u.str);
 #ifndef PY3
             if (opts->utf8_strings) {
-                args = Py_BuildValue("(s)", u.str);
-                if (!args) break;
-                ret = PyObject_Call((PyObject *)&DBusPyUTF8String_Type,
-                                    args, kwargs);
-            }
-            else {
-#endif
-                unicode = PyUnicode_DecodeUTF8(u.str, strlen(u.str), NULL);
-                if (!unicode) {
-                    break;
-                }
-                args = Py_BuildValue("(N)", unicode);
-                if (!args) {
-                    break;
-                }
-                ret = PyObject_Call((PyObject *)&DBusPyString_Type,
-                                    args, kwargs);
-#ifndef PY3
+                ret = DBusPyUTF8String_FromDBus(u.str, variant_level);
+                break;
             }
 #endif
+            ret = DBusPyString_FromDBus(u.str, variant_level);
             break;
 
         case DBUS_TYPE_SIGNATURE:
             DBG("%s", "found a signature");
             dbus_message_iter_get_basic(iter, &u.str);
-            args = Py_BuildValue("(s)", u.str);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPySignature_Type, args, kwargs);
+            ret = DBusPySignature_FromDBus(u.str, variant_level);
             break;
 
         case DBUS_TYPE_OBJECT_PATH:
             DBG("%s", "found an object path");
             dbus_message_iter_get_basic(iter, &u.str);
-            args = Py_BuildValue("(s)", u.str);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyObjectPath_Type, args, kwargs);
+            ret = DBusPyObjectPath_FromDBus(u.str, variant_level);
             break;
 
         case DBUS_TYPE_DOUBLE:
             DBG("%s", "found a double");
             dbus_message_iter_get_basic(iter, &u.dbl);
-            args = Py_BuildValue("(f)", u.dbl);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyDouble_Type, args, kwargs);
+            ret = DBusPyDouble_FromDBus(u.dbl, variant_level);
             break;
 
 #ifdef WITH_DBUS_FLOAT32
@@ -284,49 +923,45 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
             /* FIXME: DBusBasicValue will need to grow a float member if
              * float32 becomes supported */
             dbus_message_iter_get_basic(iter, &u.f);
-            args = Py_BuildValue("(f)", (double)u.f);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyFloat_Type, args, kwargs);
+            ret = DBusPyFloat_FromDBus(u.f, variant_level);
             break;
 #endif
 
         case DBUS_TYPE_INT16:
             DBG("%s", "found an int16");
             dbus_message_iter_get_basic(iter, &u.i16);
-            args = Py_BuildValue("(i)", (int)u.i16);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyInt16_Type, args, kwargs);
+            ret = DBusPyInt16_FromDBus(u.i16, variant_level);
             break;
 
         case DBUS_TYPE_UINT16:
             DBG("%s", "found a uint16");
             dbus_message_iter_get_basic(iter, &u.u16);
-            args = Py_BuildValue("(i)", (int)u.u16);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyUInt16_Type, args, kwargs);
+            ret = DBusPyUInt16_FromDBus(u.u16, variant_level);
             break;
 
         case DBUS_TYPE_INT32:
             DBG("%s", "found an int32");
             dbus_message_iter_get_basic(iter, &u.i32);
-            args = Py_BuildValue("(l)", (long)u.i32);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyInt32_Type, args, kwargs);
+            ret = DBusPyInt32_FromDBus(u.i32, variant_level);
             break;
 
         case DBUS_TYPE_UINT32:
             DBG("%s", "found a uint32");
             dbus_message_iter_get_basic(iter, &u.u32);
-            args = Py_BuildValue("(k)", (unsigned long)u.u32);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyUInt32_Type, args, kwargs);
+            ret = DBusPyUInt32_FromDBus(u.u32, variant_level);
             break;
 
 #ifdef DBUS_TYPE_UNIX_FD
         case DBUS_TYPE_UNIX_FD:
             DBG("%s", "found an unix fd");
             dbus_message_iter_get_basic(iter, &u.fd);
-            args = Py_BuildValue("(i)", u.fd);
+            if (variant_level > 0) {
+                kwargs = Py_BuildValue("{Ol}", dbus_py_variant_level_const,
+                                       variant_level);
+            }
+            if (variant_level <= 0 || kwargs) {
+                args = Py_BuildValue("(i)", u.fd);
+            }
             if (args) {
                 ret = PyObject_Call((PyObject *)&DBusPyUnixFd_Type, args,
                                     kwargs);
@@ -341,17 +976,13 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
         case DBUS_TYPE_INT64:
             DBG("%s", "found an int64");
             dbus_message_iter_get_basic(iter, &u.i64);
-            args = Py_BuildValue("(L)", (PY_LONG_LONG)u.i64);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyInt64_Type, args, kwargs);
+            ret = DBusPyInt64_FromDBus(u.i64, variant_level);
             break;
 
         case DBUS_TYPE_UINT64:
             DBG("%s", "found a uint64");
             dbus_message_iter_get_basic(iter, &u.u64);
-            args = Py_BuildValue("(K)", (unsigned PY_LONG_LONG)u.u64);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyUInt64_Type, args, kwargs);
+            ret = DBusPyUInt64_FromDBus(u.u64, variant_level);
             break;
 #else
         case DBUS_TYPE_INT64:
@@ -365,19 +996,13 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
         case DBUS_TYPE_BYTE:
             DBG("%s", "found a byte");
             dbus_message_iter_get_basic(iter, &u.byt);
-            args = Py_BuildValue("(l)", (long)u.byt);
-            if (!args)
-                break;
-            ret = PyObject_Call((PyObject *)&DBusPyByte_Type, args, kwargs);
+            ret = DBusPyByte_FromDBus(u.byt, variant_level);
             break;
 
         case DBUS_TYPE_BOOLEAN:
             DBG("%s", "found a bool");
             dbus_message_iter_get_basic(iter, &u.bool_val);
-            args = Py_BuildValue("(l)", (long)u.bool_val);
-            if (!args)
-                break;
-            ret = PyObject_Call((PyObject *)&DBusPyBoolean_Type, args, kwargs);
+            ret = DBusPyBoolean_FromDBus(u.bool_val, variant_level);
             break;
 
         case DBUS_TYPE_ARRAY:
@@ -417,6 +1042,13 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
                 ret = PyObject_Call((PyObject *)&DBusPyByteArray_Type,
                                     args, kwargs);
             }
+            else if (opts->fixed_arrays_as_buffer &&
+                     (format = _fixed_array_buffer_format(type,
+                                                          &itemsize))) {
+                DBG("%s", "an array to be exported as a buffer...");
+                ret = _message_iter_get_fixed_array_buffer(iter, opts,
+                                                           format, itemsize);
+            }
             else {
                 DBusMessageIter sub;
                 char *sig;
@@ -431,8 +1063,7 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
                 dbus_message_iter_recurse(iter, &sub);
                 sig = dbus_message_iter_get_signature(&sub);
                 if (!sig) break;
-                sig_obj = PyObject_CallFunction((PyObject *)&DBusPySignature_Type,
-                                                "(s)", sig);
+                sig_obj = DBusPySignature_FromDBus(sig, 0);
                 dbus_free(sig);
                 if (!sig_obj) break;
                 status = PyDict_SetItem(kwargs, dbus_py_signature_const, sig_obj);
@@ -478,6 +1109,10 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
                 DBusMessageIter sub;
 
                 DBG("%s", "found a variant...");
+                if (opts->lazy_variants) {
+                    ret = _message_iter_get_lazy_variant(iter, opts);
+                    break;
+                }
                 dbus_message_iter_recurse(iter, &sub);
                 ret = _message_iter_get_pyobject(&sub, opts, variant_level+1);
             }
@@ -493,16 +1128,73 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
     return ret;
 }
 
-PyObject *
-dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
+/* Parse the keyword arguments accepted by all the methods that unpack
+ * arguments into opts, and the cache keyword into *cache if that is not
+ * NULL (in which case it is rejected). fname is the method's name, for
+ * error messages. Return 0, or -1 with an exception set. */
+static int
+_message_parse_options(Message *self, PyObject *kwargs, const char *fname,
+                       Message_get_args_options *opts, int *cache)
 {
 #ifdef PY3
-    Message_get_args_options opts = { 0 };
-    static char *argnames[] = { "byte_arrays", NULL };
+    static char *argnames[] = { "byte_arrays", "fixed_arrays", "cache",
+                                "native", "lazy_variants", NULL };
+#else
+    static char *argnames[] = { "byte_arrays", "utf8_strings",
+                                "fixed_arrays", "cache", "native",
+                                "lazy_variants", NULL };
+#endif
+    char format[64];
+    const char *fixed_arrays = NULL;
+    int dummy_cache = 0;
+
+    memset(opts, 0, sizeof(*opts));
+#ifdef PY3
+    PyOS_snprintf(format, sizeof(format), "|iziii:%s", fname);
+    if (!PyArg_ParseTupleAndKeywords(dbus_py_empty_tuple, kwargs, format,
+                                     argnames,
+                                     &(opts->byte_arrays),
+                                     &fixed_arrays,
+                                     (cache ? cache : &dummy_cache),
+                                     &(opts->native),
+                                     &(opts->lazy_variants))) return -1;
 #else
-    Message_get_args_options opts = { 0, 0 };
-    static char *argnames[] = { "byte_arrays", "utf8_strings", NULL };
+    PyOS_snprintf(format, sizeof(format), "|iiziii:%s", fname);
+    if (!PyArg_ParseTupleAndKeywords(dbus_py_empty_tuple, kwargs, format,
+                                     argnames,
+                                     &(opts->byte_arrays),
+                                     &(opts->utf8_strings),
+                                     &fixed_arrays,
+                                     (cache ? cache : &dummy_cache),
+                                     &(opts->native),
+                                     &(opts->lazy_variants))) return -1;
 #endif
+    if (dummy_cache) {
+        PyErr_Format(PyExc_TypeError, "%s does not support cache", fname);
+        return -1;
+    }
+    if (fixed_arrays) {
+        if (strcmp(fixed_arrays, "buffer")) {
+            PyErr_SetString(PyExc_ValueError, "fixed_arrays must be None "
+                            "or 'buffer'");
+            return -1;
+        }
+        opts->fixed_arrays_as_buffer = 1;
+    }
+    if (!self->msg) {
+        DBusPy_RaiseUnusableMessage();
+        return -1;
+    }
+    opts->message = self;
+    return 0;
+}
+
+PyObject *
+dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
+{
+    Message_get_args_options opts;
+    int cache = 0;
+    PyObject **slot = NULL;
     PyObject *list;
     DBusMessageIter iter;
 
@@ -522,17 +1214,36 @@ dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
                         "arguments");
         return NULL;
     }
+    if (_message_parse_options(self, kwargs, "get_args_list", &opts,
+                               &cache) < 0) return NULL;
+
+    if (cache) {
+        /* Buffers and lazy variants would keep the message alive from
+         * its own cache, and stop it being appended to for as long as it
+         * exists */
+        if (opts.fixed_arrays_as_buffer) {
+            PyErr_SetString(PyExc_ValueError, "cache cannot be used with "
+                            "fixed_arrays");
+            return NULL;
+        }
+        if (opts.lazy_variants) {
+            PyErr_SetString(PyExc_ValueError, "cache cannot be used with "
+                            "lazy_variants");
+            return NULL;
+        }
 #ifdef PY3
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i:get_args_list",
-                                     argnames,
-                                     &(opts.byte_arrays))) return NULL;
+        slot = &self->args_cache[(opts.byte_arrays ? 1 : 0)
+                                 | (opts.native ? 4 : 0)];
 #else
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ii:get_args_list",
-                                     argnames,
-                                     &(opts.byte_arrays),
-                                     &(opts.utf8_strings))) return NULL;
+        slot = &self->args_cache[(opts.byte_arrays ? 1 : 0)
+                                 | (opts.utf8_strings ? 2 : 0)
+                                 | (opts.native ? 4 : 0)];
 #endif
-    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+        if (*slot) {
+            Py_INCREF(*slot);
+            return *slot;
+        }
+    }
 
     list = PyList_New(0);
     if (!list) return NULL;
@@ -552,7 +1263,332 @@ dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
     fprintf(stderr, "\n");
 #endif
 
+    if (slot) {
+        Py_INCREF(list);
+        *slot = list;
+    }
     return list;
 }
 
+/* Drop the lists kept by get_args_list(cache=True), which must be done
+ * whenever the message's body changes. */
+void
+dbus_py_Message_clear_args_cache(Message *self)
+{
+    int i;
+
+    for (i = 0; i < MESSAGE_ARGS_CACHE_SIZE; i++) {
+        Py_CLEAR(self->args_cache[i]);
+    }
+}
+
+char dbus_py_Message_get_arg_strings__doc__[] = (
+"get_arg_strings(n: int[, object_paths: bool]) -> tuple\n\n"
+"Return a tuple with an item for each of the first n arguments (or fewer,\n"
+"if the message has fewer arguments): the argument's value as a str if\n"
+"it is a string (signature 's'), possibly inside one or more variants,\n"
+"or None if it is any other type. If object_paths is true, object paths\n"
+"(signature 'o') are returned as a str too. Other arguments are not\n"
+"unpacked, which makes this much cheaper than get_args_list() for\n"
+"matching signals against ``arg``\\ *n* keywords.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_get_arg_strings(Message *self, PyObject *args,
+                                PyObject *kwargs)
+{
+    Py_ssize_t n, i = 0;
+    int object_paths = 0;
+    PyObject *tuple;
+    DBusMessageIter iter;
+    static char *argnames[] = {"n", "object_paths", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "n|i:get_arg_strings",
+                                     argnames, &n, &object_paths)) {
+        return NULL;
+    }
+    if (n < 0) {
+        PyErr_SetString(PyExc_ValueError, "n must be non-negative");
+        return NULL;
+    }
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+
+    tuple = PyTuple_New(n);
+    if (!tuple) return NULL;
+
+    if (n > 0 && dbus_message_iter_init(self->msg, &iter)) {
+        do {
+            DBusMessageIter sub, *arg = &iter;
+            PyObject *item;
+            const char *str;
+            int type;
+
+            while (dbus_message_iter_get_arg_type(arg) == DBUS_TYPE_VARIANT) {
+                dbus_message_iter_recurse(arg, &sub);
+                arg = &sub;
+            }
+            type = dbus_message_iter_get_arg_type(arg);
+            if (type == DBUS_TYPE_STRING
+                || (object_paths && type == DBUS_TYPE_OBJECT_PATH)) {
+                dbus_message_iter_get_basic(arg, &str);
+                item = dbus_py_intern(DBUS_PY_INTERN_NATIVESTR, str);
+                if (!item) {
+                    Py_CLEAR(tuple);
+                    return NULL;
+                }
+            }
+            else {
+                item = Py_None;
+                Py_INCREF(item);
+            }
+            PyTuple_SET_ITEM(tuple, i, item);
+            i++;
+        } while (i < n && dbus_message_iter_next(&iter));
+    }
+
+    if (i < n && _PyTuple_Resize(&tuple, i) < 0) return NULL;
+    return tuple;
+}
+
+/* Position iter at argument n of the message, without unpacking the
+ * arguments before it. Return 0, or -1 with IndexError set. */
+static int
+_message_iter_init_at(Message *self, Py_ssize_t n, DBusMessageIter *iter)
+{
+    Py_ssize_t i;
+
+    if (n < 0 || !dbus_message_iter_init(self->msg, iter)) goto out_of_range;
+    for (i = 0; i < n; i++) {
+        if (!dbus_message_iter_next(iter)) goto out_of_range;
+    }
+    return 0;
+
+out_of_range:
+    PyErr_SetString(PyExc_IndexError, "message argument index out of "
+                    "range");
+    return -1;
+}
+
+char dbus_py_Message_get_arg__doc__[] = (
+"get_arg(n: int, **kwargs) -> object\n\n"
+"Return argument n of the message (counting from 0), unpacked as\n"
+"get_args_list would with the same keyword arguments (except cache).\n"
+"The arguments before it are skipped without being unpacked.\n"
+"\n"
+":Raises IndexError: if the message has n arguments or fewer\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_get_arg(Message *self, PyObject *args, PyObject *kwargs)
+{
+    Message_get_args_options opts;
+    DBusMessageIter iter;
+    Py_ssize_t n;
+
+    if (!PyArg_ParseTuple(args, "n:get_arg", &n)) return NULL;
+    if (_message_parse_options(self, kwargs, "get_arg", &opts, NULL) < 0)
+        return NULL;
+    if (_message_iter_init_at(self, n, &iter) < 0) return NULL;
+    return _message_iter_get_pyobject(&iter, &opts, 0);
+}
+
+/* Iterating over arguments or array items =========================== */
+
+/* Unpacks one argument, or one item of an array, at a time. Like the
+ * buffers, it stops the message being appended to until it's exhausted
+ * or freed. */
+typedef struct {
+    PyObject_HEAD
+    /* NULL once exhausted */
+    Message *message;
+    /* the message iter points into, with a reference of its own */
+    DBusMessage *msg;
+    DBusMessageIter iter;
+    Message_get_args_options opts;
+    /* true if the items are dict entries, which are yielded as
+     * (key, value) tuples */
+    int dict_entries;
+} ArgsIterator;
+
+static void
+ArgsIterator_release(ArgsIterator *self)
+{
+    if (self->message) {
+        self->message->exports--;
+        Py_CLEAR(self->message);
+        dbus_message_unref(self->msg);
+        self->msg = NULL;
+    }
+}
+
+static void
+ArgsIterator_tp_dealloc(ArgsIterator *self)
+{
+    ArgsIterator_release(self);
+    PyObject_Del(self);
+}
+
+static PyObject *
+ArgsIterator_tp_iternext(ArgsIterator *self)
+{
+    PyObject *ret;
+
+    if (!self->message) return NULL;
+    if (dbus_message_iter_get_arg_type(&self->iter) == DBUS_TYPE_INVALID) {
+        ArgsIterator_release(self);
+        return NULL;
+    }
+
+    if (self->dict_entries) {
+        DBusMessageIter kv;
+        PyObject *key, *value;
+
+        dbus_message_iter_recurse(&self->iter, &kv);
+        key = _message_iter_get_pyobject(&kv, &self->opts, 0);
+        if (!key) return NULL;
+        dbus_message_iter_next(&kv);
+        value = _message_iter_get_pyobject(&kv, &self->opts, 0);
+        if (!value) {
+            Py_CLEAR(key);
+            return NULL;
+        }
+        ret = PyTuple_Pack(2, key, value);
+        Py_CLEAR(key);
+        Py_CLEAR(value);
+    }
+    else {
+        ret = _message_iter_get_pyobject(&self->iter, &self->opts, 0);
+    }
+
+    if (ret && !dbus_message_iter_next(&self->iter)) {
+        ArgsIterator_release(self);
+    }
+    return ret;
+}
+
+static PyTypeObject ArgsIterator_Type = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "_dbus_bindings._ArgsIterator",
+    sizeof(ArgsIterator),
+    0,
+    (destructor)ArgsIterator_tp_dealloc,    /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    0,                                      /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc)ArgsIterator_tp_iternext, /* tp_iternext */
+};
+
+/* Return a new iterator over the items at iter, which must be inside the
+ * message being unpacked with opts. */
+static PyObject *
+_args_iterator_new(DBusMessageIter *iter, Message_get_args_options *opts,
+                   int dict_entries)
+{
+    ArgsIterator *self;
+
+    self = PyObject_New(ArgsIterator, &ArgsIterator_Type);
+    if (!self) return NULL;
+    self->message = opts->message;
+    Py_INCREF(self->message);
+    self->message->exports++;
+    self->msg = dbus_message_ref(opts->message->msg);
+    self->iter = *iter;
+    self->opts = *opts;
+    self->dict_entries = dict_entries;
+    return (PyObject *)self;
+}
+
+char dbus_py_Message_iter_args__doc__[] = (
+"iter_args(**kwargs) -> iterator\n\n"
+"Return an iterator over the message's arguments, which unpacks each one\n"
+"as get_args_list would with the same keyword arguments (except cache)\n"
+"only when it is reached, so that they need not all be in memory at\n"
+"once. Arguments cannot be appended to the message, nor can it be\n"
+"re-initialized, until the iterator is exhausted or freed.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_iter_args(Message *self, PyObject *args, PyObject *kwargs)
+{
+    Message_get_args_options opts;
+    DBusMessageIter iter;
+
+    if (!PyArg_ParseTuple(args, ":iter_args")) return NULL;
+    if (_message_parse_options(self, kwargs, "iter_args", &opts, NULL) < 0)
+        return NULL;
+    /* if there are no arguments, the iterator is still valid, and the
+     * first item's type is DBUS_TYPE_INVALID */
+    dbus_message_iter_init(self->msg, &iter);
+    return _args_iterator_new(&iter, &opts, FALSE);
+}
+
+char dbus_py_Message_iter_array__doc__[] = (
+"iter_array(n: int, **kwargs) -> iterator\n\n"
+"Return an iterator over the items of argument n (counting from 0),\n"
+"which must be an array, unpacking each one as get_args_list would with\n"
+"the same keyword arguments (except cache) only when it is reached. The\n"
+"items of a dict are (key, value) tuples. This allows very large arrays\n"
+"to be processed without a Python object for every item existing at\n"
+"once. Arguments cannot be appended to the message, nor can it be\n"
+"re-initialized, until the iterator is exhausted or freed.\n"
+"\n"
+":Raises IndexError: if the message has n arguments or fewer\n"
+":Raises TypeError: if argument n is not an array\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_iter_array(Message *self, PyObject *args, PyObject *kwargs)
+{
+    Message_get_args_options opts;
+    DBusMessageIter iter, sub;
+    Py_ssize_t n;
+
+    if (!PyArg_ParseTuple(args, "n:iter_array", &n)) return NULL;
+    if (_message_parse_options(self, kwargs, "iter_array", &opts, NULL) < 0)
+        return NULL;
+    if (_message_iter_init_at(self, n, &iter) < 0) return NULL;
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) {
+        PyErr_Format(PyExc_TypeError, "message argument %ld is not an "
+                     "array", (long)n);
+        return NULL;
+    }
+    dbus_message_iter_recurse(&iter, &sub);
+    return _args_iterator_new(&sub, &opts,
+                              (dbus_message_iter_get_element_type(&iter)
+                               == DBUS_TYPE_DICT_ENTRY));
+}
+
+dbus_bool_t
+dbus_py_init_message_arg_types(void)
+{
+    if (PyType_Ready(&FixedArrayBuffer_Type) < 0) return 0;
+    if (PyType_Ready(&DBusPyLazyVariant_Type) < 0) return 0;
+    if (PyType_Ready(&ArgsIterator_Type) < 0) return 0;
+    return 1;
+}
+
 /* vim:set ft=c cino< sw=4 sts=4 et: */
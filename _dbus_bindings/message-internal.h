@@ -30,19 +30,79 @@
 #ifndef DBUS_BINDINGS_MESSAGE_INTERNAL_H
 #define DBUS_BINDINGS_MESSAGE_INTERNAL_H
 
+/* one slot for each combination of byte_arrays, utf8_strings and native */
+#define MESSAGE_ARGS_CACHE_SIZE 8
+
 typedef struct {
     PyObject_HEAD
     DBusMessage *msg;
+    /* number of live buffers exporting memory from msg's body */
+    Py_ssize_t exports;
+    /* lists returned by get_args_list(cache=True), or NULL */
+    PyObject *args_cache[MESSAGE_ARGS_CACHE_SIZE];
+    /* MessageHeader returned by get_header(), or NULL, and the serial the
+     * message had when it was built */
+    PyObject *header;
+    dbus_uint32_t header_serial;
 } Message;
 
 extern char dbus_py_Message_append__doc__[];
 extern PyObject *dbus_py_Message_append(Message *, PyObject *, PyObject *);
+extern int dbus_py_Message_append_args(Message *, PyObject *, const char *);
+extern int dbus_py_message_iter_copy(DBusMessageIter *, DBusMessageIter *);
 extern char dbus_py_Message_guess_signature__doc__[];
 extern PyObject *dbus_py_Message_guess_signature(PyObject *, PyObject *);
 extern char dbus_py_Message_get_args_list__doc__[];
 extern PyObject *dbus_py_Message_get_args_list(Message *,
                                                PyObject *,
                                                PyObject *);
+extern void dbus_py_Message_clear_args_cache(Message *);
+extern char dbus_py_Message_get_arg_strings__doc__[];
+extern PyObject *dbus_py_Message_get_arg_strings(Message *, PyObject *,
+                                                 PyObject *);
+extern char dbus_py_Message_get_arg__doc__[];
+extern PyObject *dbus_py_Message_get_arg(Message *, PyObject *, PyObject *);
+extern char dbus_py_Message_iter_args__doc__[];
+extern PyObject *dbus_py_Message_iter_args(Message *, PyObject *,
+                                           PyObject *);
+extern char dbus_py_Message_iter_array__doc__[];
+extern PyObject *dbus_py_Message_iter_array(Message *, PyObject *,
+                                            PyObject *);
+
+extern dbus_bool_t dbus_py_init_message_arg_types(void);
+
+extern PyTypeObject DBusPyLazyVariant_Type;
+DEFINE_CHECK(DBusPyLazyVariant)
+extern PyObject *dbus_py_LazyVariant_get_value(PyObject *);
+extern int dbus_py_LazyVariant_append(PyObject *, DBusMessageIter *);
+
+/* message-append-plan.c */
+
+/* One complete type in a compiled signature. Nodes are stored in pre-order:
+ * a container's first child immediately follows it, and each node is
+ * followed by its next sibling after n_nodes nodes. */
+typedef struct {
+    int type;                   /* DBUS_TYPE_STRUCT etc. for containers */
+    unsigned int n_nodes;       /* size of this subtree, including itself */
+    unsigned int n_children;    /* 1 for arrays, 2 for dict entries */
+    const char *signature;      /* arrays only: the element's signature */
+} DBusPySigNode;
+
+typedef struct _DBusPySigPlan DBusPySigPlan;
+struct _DBusPySigPlan {
+    unsigned int n_args;        /* number of top-level complete types */
+    DBusPySigNode *nodes;
+    /* private to message-append-plan.c */
+    unsigned int refcount;
+    unsigned long hash;
+    dbus_bool_t cached;
+    const char *signature;
+    DBusPySigPlan *bucket_next;
+    DBusPySigPlan *lru_prev, *lru_next;
+};
+
+extern DBusPySigPlan *dbus_py_sig_plan_get(const char *signature);
+extern void dbus_py_sig_plan_release(DBusPySigPlan *plan);
 
 extern PyObject *DBusPy_RaiseUnusableMessage(void);
 
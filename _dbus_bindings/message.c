@@ -50,6 +50,8 @@ PyDoc_STRVAR(Message_tp_doc,
 
 static void Message_tp_dealloc(Message *self)
 {
+    dbus_py_Message_clear_args_cache(self);
+    Py_CLEAR(self->header);
     if (self->msg) {
         dbus_message_unref(self->msg);
     }
@@ -66,9 +68,33 @@ Message_tp_new(PyTypeObject *type,
     self = (Message *)type->tp_alloc(type, 0);
     if (!self) return NULL;
     self->msg = NULL;
+    self->exports = 0;
+    memset(self->args_cache, 0, sizeof(self->args_cache));
+    self->header = NULL;
+    self->header_serial = 0;
     return (PyObject *)self;
 }
 
+/* Drop the message and everything derived from it, so that __init__ can
+ * replace it. Return 0, or -1 with BufferError set if buffers or
+ * iterators still refer into it. */
+static int
+_message_reset(Message *self)
+{
+    if (self->exports > 0) {
+        PyErr_SetString(PyExc_BufferError, "Existing exports of data: "
+                        "this message cannot be re-initialized");
+        return -1;
+    }
+    dbus_py_Message_clear_args_cache(self);
+    Py_CLEAR(self->header);
+    if (self->msg) {
+        dbus_message_unref(self->msg);
+        self->msg = NULL;
+    }
+    return 0;
+}
+
 static PyObject *
 MethodCallMessage_tp_repr(PyObject *self)
 {
@@ -126,10 +152,7 @@ MethodCallMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
     if (!dbus_py_validate_object_path(path)) return -1;
     if (interface && !dbus_py_validate_interface_name(interface)) return -1;
     if (!dbus_py_validate_member_name(method)) return -1;
-    if (self->msg) {
-        dbus_message_unref(self->msg);
-        self->msg = NULL;
-    }
+    if (_message_reset(self) < 0) return -1;
     self->msg = dbus_message_new_method_call(destination, path, interface,
                                              method);
     if (!self->msg) {
@@ -153,10 +176,7 @@ MethodReturnMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
                                      &MessageType, &other)) {
         return -1;
     }
-    if (self->msg) {
-        dbus_message_unref(self->msg);
-        self->msg = NULL;
-    }
+    if (_message_reset(self) < 0) return -1;
     self->msg = dbus_message_new_method_return(other->msg);
     if (!self->msg) {
         PyErr_NoMemory();
@@ -181,10 +201,7 @@ SignalMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
     if (!dbus_py_validate_object_path(path)) return -1;
     if (!dbus_py_validate_interface_name(interface)) return -1;
     if (!dbus_py_validate_member_name(name)) return -1;
-    if (self->msg) {
-        dbus_message_unref(self->msg);
-        self->msg = NULL;
-    }
+    if (_message_reset(self) < 0) return -1;
     self->msg = dbus_message_new_signal(path, interface, name);
     if (!self->msg) {
         PyErr_NoMemory();
@@ -233,10 +250,7 @@ ErrorMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
         return -1;
     }
     if (!dbus_py_validate_error_name(error_name)) return -1;
-    if (self->msg) {
-        dbus_message_unref(self->msg);
-        self->msg = NULL;
-    }
+    if (_message_reset(self) < 0) return -1;
     self->msg = dbus_message_new_error(reply_to->msg, error_name, error_message);
     if (!self->msg) {
         PyErr_NoMemory();
@@ -305,6 +319,49 @@ Message_copy(Message *self, PyObject *args UNUSED)
     return DBusPyMessage_ConsumeDBusMessage(msg);
 }
 
+PyDoc_STRVAR(Message_copy_with_header__doc__,
+"message.copy_with_header(path: str, destination: str or None)\n"
+"    -> Message (or subclass)\n\n"
+"Copy the message as for `copy`, replacing the object path and/or the\n"
+"destination bus name with those given. A destination of None removes\n"
+"it; header fields not passed are unchanged.\n"
+"\n"
+"The body is copied without being marshalled again, so this is the cheap\n"
+"way to send the same arguments to several objects or peers.\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+Message_copy_with_header(Message *self, PyObject *args, PyObject *kwargs)
+{
+    /* PyArg_ParseTupleAndKeywords leaves this alone if no destination is
+     * passed, and sets it to NULL if it is None */
+    static const char unchanged[] = "";
+    const char *path = NULL, *destination = unchanged;
+    static char *kwlist[] = {"path", "destination", NULL};
+    DBusMessage *msg;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|sz:copy_with_header",
+                                     kwlist, &path, &destination)) {
+        return NULL;
+    }
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (path && !dbus_py_validate_object_path(path)) return NULL;
+    if (destination && destination != unchanged
+        && !dbus_py_validate_bus_name(destination, 1, 1)) {
+        return NULL;
+    }
+
+    msg = dbus_message_copy(self->msg);
+    if (!msg) return PyErr_NoMemory();
+    if ((path && !dbus_message_set_path(msg, path))
+        || (destination != unchanged
+            && !dbus_message_set_destination(msg, destination))) {
+        dbus_message_unref(msg);
+        return PyErr_NoMemory();
+    }
+    return DBusPyMessage_ConsumeDBusMessage(msg);
+}
+
 PyDoc_STRVAR(Message_get_auto_start__doc__,
 "message.get_auto_start() -> bool\n"
 "Return true if this message will cause an owner for the destination name\n"
@@ -326,6 +383,7 @@ Message_set_auto_start(Message *self, PyObject *args)
     int value;
     if (!PyArg_ParseTuple(args, "i", &value)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    Py_CLEAR(self->header);
     dbus_message_set_auto_start(self->msg, value ? TRUE : FALSE);
     Py_INCREF(Py_None);
     return Py_None;
@@ -350,6 +408,7 @@ Message_set_no_reply(Message *self, PyObject *args)
     int value;
     if (!PyArg_ParseTuple(args, "i", &value)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    Py_CLEAR(self->header);
     dbus_message_set_no_reply(self->msg, value ? TRUE : FALSE);
     Py_RETURN_NONE;
 }
@@ -374,6 +433,7 @@ Message_set_reply_serial(Message *self, PyObject *args)
 
     if (!PyArg_ParseTuple(args, "k", &value)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    Py_CLEAR(self->header);
     if (!dbus_message_set_reply_serial(self->msg, value)) {
         return PyErr_NoMemory();
     }
@@ -406,6 +466,31 @@ Message_get_serial(Message *self, PyObject *unused UNUSED)
     return PyLong_FromUnsignedLong(dbus_message_get_serial(self->msg));
 }
 
+PyDoc_STRVAR(Message__set_serial__doc__,
+"_set_serial(serial: long)\n\n"
+"Internal, for tests and benchmarks that construct incoming messages.\n");
+static PyObject *
+Message__set_serial(Message *self, PyObject *args)
+{
+    unsigned long value;
+
+    if (!PyArg_ParseTuple(args, "k", &value)) return NULL;
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (value == 0 || value > 0xFFFFFFFFUL) {
+        PyErr_SetString(PyExc_ValueError, "Serial must be non-zero and fit "
+                        "in 32 bits");
+        return NULL;
+    }
+    if (dbus_message_get_serial(self->msg) != 0) {
+        PyErr_SetString(PyExc_ValueError, "Message already has a serial");
+        return NULL;
+    }
+    Py_CLEAR(self->header);
+    dbus_message_set_serial(self->msg, value);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 PyDoc_STRVAR(Message_is_method_call__doc__,
 "is_method_call(interface: str, member: str) -> bool");
 static PyObject *
@@ -462,7 +547,7 @@ Message_get_member(Message *self, PyObject *unused UNUSED)
     if (!c_str) {
         Py_RETURN_NONE;
     }
-    return NATIVESTR_FROMSTR(c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_NATIVESTR, c_str);
 }
 
 PyDoc_STRVAR(Message_has_member__doc__,
@@ -491,6 +576,7 @@ Message_set_member(Message *self, PyObject *args)
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_py_validate_member_name(name)) return NULL;
+    Py_CLEAR(self->header);
     if (!dbus_message_set_member(self->msg, name)) return PyErr_NoMemory();
     Py_RETURN_NONE;
 }
@@ -510,7 +596,7 @@ Message_get_path(Message *self, PyObject *unused UNUSED)
     if (!c_str) {
         Py_RETURN_NONE;
     }
-    return PyObject_CallFunction((PyObject *)&DBusPyObjectPath_Type, "(s)", c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_OBJECT_PATH, c_str);
 }
 
 PyDoc_STRVAR(Message_get_path_decomposed__doc__,
@@ -590,10 +676,7 @@ Message_get_signature(Message *self, PyObject *unused UNUSED)
 
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     c_str = dbus_message_get_signature(self->msg);
-    if (!c_str) {
-        return PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s)", "");
-    }
-    return PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s)", c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_SIGNATURE, c_str ? c_str : "");
 }
 
 PyDoc_STRVAR(Message_has_signature__doc__,
@@ -623,7 +706,7 @@ Message_get_sender(Message *self, PyObject *unused UNUSED)
     if (!c_str) {
         Py_RETURN_NONE;
     }
-    return NATIVESTR_FROMSTR(c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_NATIVESTR, c_str);
 }
 
 PyDoc_STRVAR(Message_has_sender__doc__,
@@ -652,6 +735,7 @@ Message_set_sender(Message *self, PyObject *args)
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_py_validate_bus_name(name, 1, 1)) return NULL;
+    Py_CLEAR(self->header);
     if (!dbus_message_set_sender(self->msg, name)) return PyErr_NoMemory();
     Py_RETURN_NONE;
 }
@@ -669,7 +753,7 @@ Message_get_destination(Message *self, PyObject *unused UNUSED)
     if (!c_str) {
         Py_RETURN_NONE;
     }
-    return NATIVESTR_FROMSTR(c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_NATIVESTR, c_str);
 }
 
 PyDoc_STRVAR(Message_has_destination__doc__,
@@ -698,6 +782,7 @@ Message_set_destination(Message *self, PyObject *args)
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_py_validate_bus_name(name, 1, 1)) return NULL;
+    Py_CLEAR(self->header);
     if (!dbus_message_set_destination(self->msg, name)) return PyErr_NoMemory();
     Py_RETURN_NONE;
 }
@@ -714,7 +799,7 @@ Message_get_interface(Message *self, PyObject *unused UNUSED)
     if (!c_str) {
         Py_RETURN_NONE;
     }
-    return NATIVESTR_FROMSTR(c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_NATIVESTR, c_str);
 }
 
 PyDoc_STRVAR(Message_has_interface__doc__,
@@ -743,6 +828,7 @@ Message_set_interface(Message *self, PyObject *args)
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_py_validate_interface_name(name)) return NULL;
+    Py_CLEAR(self->header);
     if (!dbus_message_set_interface(self->msg, name)) return PyErr_NoMemory();
     Py_RETURN_NONE;
 }
@@ -759,7 +845,7 @@ Message_get_error_name(Message *self, PyObject *unused UNUSED)
     if (!c_str) {
         Py_RETURN_NONE;
     }
-    return NATIVESTR_FROMSTR(c_str);
+    return dbus_py_intern(DBUS_PY_INTERN_NATIVESTR, c_str);
 }
 
 PyDoc_STRVAR(Message_set_error_name__doc__,
@@ -774,13 +860,198 @@ Message_set_error_name(Message *self, PyObject *args)
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_py_validate_error_name(name)) return NULL;
+    Py_CLEAR(self->header);
     if (!dbus_message_set_error_name(self->msg, name)) return PyErr_NoMemory();
     Py_RETURN_NONE;
 }
 
+/* MessageHeader is a tuple subclass with a read-only property per field,
+ * rather than a PyStructSequence, which costs about twice as much to
+ * create and destroy. */
+
+#define MESSAGE_HEADER_N_FIELDS 12
+
+static PyObject *
+MessageHeader_get_field(PyObject *self, void *closure)
+{
+    PyObject *item = PyTuple_GET_ITEM(self, (Py_ssize_t)closure);
+
+    Py_INCREF(item);
+    return item;
+}
+
+#define FIELD(name, i, doc) \
+    {name, MessageHeader_get_field, NULL, doc, (void *)(i)}
+static PyGetSetDef MessageHeader_tp_getset[] = {
+    FIELD("type", 0, "One of the MESSAGE_TYPE_* constants"),
+    FIELD("serial", 1, "The serial number, or 0 if none has been "
+          "assigned yet"),
+    FIELD("reply_serial", 2, "The serial of the message replied to, or 0"),
+    FIELD("path", 3, "The object path as an ObjectPath, or None"),
+    FIELD("interface", 4, "The interface name, or None"),
+    FIELD("member", 5, "The method or signal name, or None"),
+    FIELD("error_name", 6, "The error name, or None"),
+    FIELD("destination", 7, "The destination bus name, or None"),
+    FIELD("sender", 8, "The sender's unique name, or None"),
+    FIELD("signature", 9, "The signature of the body, as a Signature"),
+    FIELD("no_reply", 10, "True if the sender does not want a reply"),
+    FIELD("auto_start", 11, "True if the destination may be "
+          "auto-started"),
+    {NULL},
+};
+#undef FIELD
+
+static PyObject *
+MessageHeader_tp_repr(PyObject *self)
+{
+    PyObject *parent_repr = (PyTuple_Type.tp_repr)(self);
+    PyObject *my_repr;
+
+    if (!parent_repr) return NULL;
+    my_repr = PyUnicode_FromFormat("%s(%V)", Py_TYPE(self)->tp_name,
+                                   REPRV(parent_repr));
+    Py_CLEAR(parent_repr);
+    return my_repr;
+}
+
+PyDoc_STRVAR(MessageHeader_tp_doc,
+"The fields of a message's header, as returned by Message.get_header():\n"
+"a read-only tuple (type, serial, reply_serial, path, interface, member,\n"
+"error_name, destination, sender, signature, no_reply, auto_start)\n"
+"whose items are also available as attributes of those names.\n"
+"\n"
+":Since: 1.2.1\n");
+
+static PyTypeObject MessageHeaderType = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.lowlevel.MessageHeader",
+    0,
+    0,
+    0,                                      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    MessageHeader_tp_repr,                  /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    MessageHeader_tp_doc,                   /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    0,                                      /* tp_methods */
+    0,                                      /* tp_members */
+    MessageHeader_tp_getset,                /* tp_getset */
+    DEFERRED_ADDRESS(&PyTuple_Type),        /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    0,                                      /* tp_new */
+};
+
+static PyObject *
+_header_string(DBusPyInternKind kind, const char *c_str)
+{
+    if (!c_str) {
+        Py_RETURN_NONE;
+    }
+    return dbus_py_intern(kind, c_str);
+}
+
+PyDoc_STRVAR(Message_get_header__doc__,
+"get_header() -> MessageHeader\n\n"
+"Return all the fields of the message's header in one read-only record,\n"
+"which is cheaper than calling get_member(), get_path() and so on one by\n"
+"one. The record is kept until the header changes, so calling this again\n"
+"returns the same object.\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+Message_get_header(Message *self, PyObject *unused UNUSED)
+{
+    DBusMessage *msg = self->msg;
+    dbus_uint32_t serial;
+    const char *sig;
+    PyObject *header;
+    Py_ssize_t i;
+
+    if (!msg) return DBusPy_RaiseUnusableMessage();
+
+    /* sending the message assigns it a serial without our knowledge */
+    serial = dbus_message_get_serial(msg);
+    if (self->header && self->header_serial == serial) {
+        Py_INCREF(self->header);
+        return self->header;
+    }
+    Py_CLEAR(self->header);
+
+    header = MessageHeaderType.tp_alloc(&MessageHeaderType,
+                                        MESSAGE_HEADER_N_FIELDS);
+    if (!header) return NULL;
+
+    sig = dbus_message_get_signature(msg);
+    PyTuple_SET_ITEM(header, 0,
+        NATIVEINT_FROMLONG(dbus_message_get_type(msg)));
+    PyTuple_SET_ITEM(header, 1, PyLong_FromUnsignedLong(serial));
+    PyTuple_SET_ITEM(header, 2,
+        PyLong_FromUnsignedLong(dbus_message_get_reply_serial(msg)));
+    PyTuple_SET_ITEM(header, 3,
+        _header_string(DBUS_PY_INTERN_OBJECT_PATH,
+                       dbus_message_get_path(msg)));
+    PyTuple_SET_ITEM(header, 4,
+        _header_string(DBUS_PY_INTERN_NATIVESTR,
+                       dbus_message_get_interface(msg)));
+    PyTuple_SET_ITEM(header, 5,
+        _header_string(DBUS_PY_INTERN_NATIVESTR,
+                       dbus_message_get_member(msg)));
+    PyTuple_SET_ITEM(header, 6,
+        _header_string(DBUS_PY_INTERN_NATIVESTR,
+                       dbus_message_get_error_name(msg)));
+    PyTuple_SET_ITEM(header, 7,
+        _header_string(DBUS_PY_INTERN_NATIVESTR,
+                       dbus_message_get_destination(msg)));
+    PyTuple_SET_ITEM(header, 8,
+        _header_string(DBUS_PY_INTERN_NATIVESTR,
+                       dbus_message_get_sender(msg)));
+    PyTuple_SET_ITEM(header, 9,
+        dbus_py_intern(DBUS_PY_INTERN_SIGNATURE, sig ? sig : ""));
+    PyTuple_SET_ITEM(header, 10,
+        PyBool_FromLong(dbus_message_get_no_reply(msg)));
+    PyTuple_SET_ITEM(header, 11,
+        PyBool_FromLong(dbus_message_get_auto_start(msg)));
+
+    for (i = 0; i < MESSAGE_HEADER_N_FIELDS; i++) {
+        if (!PyTuple_GET_ITEM(header, i)) {
+            Py_CLEAR(header);
+            return NULL;
+        }
+    }
+
+    Py_INCREF(header);
+    self->header = header;
+    self->header_serial = serial;
+    return header;
+}
+
 static PyMethodDef Message_tp_methods[] = {
     {"copy", (PyCFunction)Message_copy,
       METH_NOARGS, Message_copy__doc__},
+    {"copy_with_header", (PyCFunction)Message_copy_with_header,
+      METH_VARARGS|METH_KEYWORDS, Message_copy_with_header__doc__},
     {"is_method_call", (PyCFunction)Message_is_method_call,
       METH_VARARGS, Message_is_method_call__doc__},
     {"is_signal", (PyCFunction)Message_is_signal,
@@ -790,6 +1061,14 @@ static PyMethodDef Message_tp_methods[] = {
 
     {"get_args_list", (PyCFunction)dbus_py_Message_get_args_list,
       METH_VARARGS|METH_KEYWORDS, dbus_py_Message_get_args_list__doc__},
+    {"get_arg_strings", (PyCFunction)dbus_py_Message_get_arg_strings,
+      METH_VARARGS|METH_KEYWORDS, dbus_py_Message_get_arg_strings__doc__},
+    {"get_arg", (PyCFunction)dbus_py_Message_get_arg,
+      METH_VARARGS|METH_KEYWORDS, dbus_py_Message_get_arg__doc__},
+    {"iter_args", (PyCFunction)dbus_py_Message_iter_args,
+      METH_VARARGS|METH_KEYWORDS, dbus_py_Message_iter_args__doc__},
+    {"iter_array", (PyCFunction)dbus_py_Message_iter_array,
+      METH_VARARGS|METH_KEYWORDS, dbus_py_Message_iter_array__doc__},
     {"guess_signature", (PyCFunction)dbus_py_Message_guess_signature,
       METH_VARARGS|METH_STATIC, dbus_py_Message_guess_signature__doc__},
     {"append", (PyCFunction)dbus_py_Message_append,
@@ -845,8 +1124,12 @@ static PyMethodDef Message_tp_methods[] = {
       METH_VARARGS, Message_has_sender__doc__},
     {"get_serial", (PyCFunction)Message_get_serial,
       METH_NOARGS, Message_get_serial__doc__},
+    {"_set_serial", (PyCFunction)Message__set_serial,
+      METH_VARARGS, Message__set_serial__doc__},
     {"get_signature", (PyCFunction)Message_get_signature,
       METH_NOARGS, Message_get_signature__doc__},
+    {"get_header", (PyCFunction)Message_get_header,
+      METH_NOARGS, Message_get_header__doc__},
     {"has_signature", (PyCFunction)Message_has_signature,
       METH_VARARGS, Message_has_signature__doc__},
     {"get_type", (PyCFunction)Message_get_type,
@@ -1076,6 +1359,13 @@ dbus_py_init_message_types(void)
     ErrorMessageType.tp_base = &MessageType;
     if (PyType_Ready(&ErrorMessageType) < 0) return 0;
 
+    MessageHeaderType.tp_base = &PyTuple_Type;
+    if (PyType_Ready(&MessageHeaderType) < 0) return 0;
+    /* only get_header() can make them, with the right number of items */
+    MessageHeaderType.tp_new = NULL;
+
+    if (!dbus_py_init_message_arg_types()) return 0;
+
     return 1;
 }
 
@@ -1088,6 +1378,8 @@ dbus_py_insert_message_types(PyObject *this_module)
     Py_INCREF (&MethodReturnMessageType);
     Py_INCREF (&ErrorMessageType);
     Py_INCREF (&SignalMessageType);
+    Py_INCREF (&DBusPyLazyVariant_Type);
+    Py_INCREF (&MessageHeaderType);
 
     if (PyModule_AddObject(this_module, "Message",
                          (PyObject *)&MessageType) < 0) return 0;
@@ -1104,6 +1396,12 @@ dbus_py_insert_message_types(PyObject *this_module)
     if (PyModule_AddObject(this_module, "SignalMessage",
                          (PyObject *)&SignalMessageType) < 0) return 0;
 
+    if (PyModule_AddObject(this_module, "LazyVariant",
+                         (PyObject *)&DBusPyLazyVariant_Type) < 0) return 0;
+
+    if (PyModule_AddObject(this_module, "MessageHeader",
+                         (PyObject *)&MessageHeaderType) < 0) return 0;
+
     return 1;
 }
 
@@ -0,0 +1,681 @@
+/* Calling methods of exported objects without going through Python code.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "dbus_bindings-internal.h"
+#include "conn-internal.h"
+#include "message-internal.h"
+
+/* A _MethodDispatcher is registered as the message callback of an exported
+ * dbus.service.Object whose class sets FAST_DISPATCH. It handles the same
+ * method calls as Object._message_cb, using a table which dbus.service
+ * fills in per class:
+ *
+ *     {member: {interface or None: entry}}
+ *
+ * where each entry is a tuple indexed by the ENTRY_ constants below.
+ * Calls that aren't in the table (including those with async callbacks or
+ * rel_path_keyword, which dbus.service never puts there) are passed to the
+ * fallback, which is the object's _message_cb. */
+
+enum {
+    ENTRY_METHOD = 0,           /* function to call with the object */
+    ENTRY_GET_ARGS_OPTIONS,     /* dict of options for get_args_list */
+    ENTRY_OUT_SIGNATURE,        /* Signature, or None to guess */
+    ENTRY_N_OUT,                /* number of complete types in it */
+    ENTRY_SENDER_KEYWORD,       /* each of these is a str or None */
+    ENTRY_PATH_KEYWORD,
+    ENTRY_DESTINATION_KEYWORD,
+    ENTRY_MESSAGE_KEYWORD,
+    ENTRY_CONNECTION_KEYWORD,
+    N_ENTRY_ITEMS
+};
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *object;
+    PyObject *table;
+    PyObject *fallback;
+    PyObject *on_error;
+    PyObject *enter;            /* or NULL */
+    PyObject *exit;             /* or NULL */
+} MethodDispatcher;
+
+PyDoc_STRVAR(MethodDispatcher_tp_doc,
+"_MethodDispatcher(object, table, fallback, on_error, enter=None, exit=None)\n\n"
+"A message callback for `Connection._register_object_path` which calls\n"
+"methods of ``object`` directly, as described by ``table``. Messages\n"
+"it has no entry for are passed to ``fallback(connection, message)``.\n"
+"If unpacking the arguments, calling the method or sending the reply\n"
+"raises an exception, ``on_error(connection, message, exception)`` is\n"
+"called with it as the exception being handled.\n"
+"\n"
+"If given, ``enter()`` and ``exit()`` are called before and after each\n"
+"method that is called directly (whether or not it raises), and before\n"
+"the reply is sent.\n"
+"\n"
+"This is an implementation detail of `dbus.service`.\n"
+);
+
+static PyObject *
+MethodDispatcher_tp_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    MethodDispatcher *self;
+    PyObject *object, *table, *fallback, *on_error;
+    PyObject *enter = Py_None, *exit = Py_None;
+    static char *argnames[] = {"object", "table", "fallback", "on_error",
+                               "enter", "exit", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+                                     "OO!OO|OO:_MethodDispatcher",
+                                     argnames, &object, &PyDict_Type, &table,
+                                     &fallback, &on_error, &enter, &exit))
+        return NULL;
+
+    self = (MethodDispatcher *)(cls->tp_alloc(cls, 0));
+    if (!self)
+        return NULL;
+    Py_INCREF(object);
+    self->object = object;
+    Py_INCREF(table);
+    self->table = table;
+    Py_INCREF(fallback);
+    self->fallback = fallback;
+    Py_INCREF(on_error);
+    self->on_error = on_error;
+    if (enter != Py_None) {
+        Py_INCREF(enter);
+        self->enter = enter;
+    }
+    if (exit != Py_None) {
+        Py_INCREF(exit);
+        self->exit = exit;
+    }
+    return (PyObject *)self;
+}
+
+static int
+MethodDispatcher_tp_traverse(MethodDispatcher *self, visitproc visit,
+                             void *arg)
+{
+    Py_VISIT(self->object);
+    Py_VISIT(self->table);
+    Py_VISIT(self->fallback);
+    Py_VISIT(self->on_error);
+    Py_VISIT(self->enter);
+    Py_VISIT(self->exit);
+    return 0;
+}
+
+static int
+MethodDispatcher_tp_clear(MethodDispatcher *self)
+{
+    Py_CLEAR(self->object);
+    Py_CLEAR(self->table);
+    Py_CLEAR(self->fallback);
+    Py_CLEAR(self->on_error);
+    Py_CLEAR(self->enter);
+    Py_CLEAR(self->exit);
+    return 0;
+}
+
+static void
+MethodDispatcher_tp_dealloc(MethodDispatcher *self)
+{
+    PyObject_GC_UnTrack(self);
+    MethodDispatcher_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+/* Return a borrowed reference to the table entry for the message, or NULL
+ * without an exception set if there isn't one. */
+static PyObject *
+find_entry(MethodDispatcher *self, DBusMessage *msg)
+{
+    const char *member = dbus_message_get_member(msg);
+    const char *interface = dbus_message_get_interface(msg);
+    PyObject *key, *by_interface, *entry;
+
+    if (!member)
+        return NULL;
+
+    key = NATIVESTR_FROMSTR(member);
+    if (!key)
+        return NULL;
+    by_interface = PyDict_GetItem(self->table, key);
+    Py_CLEAR(key);
+    if (!by_interface || !PyDict_Check(by_interface))
+        return NULL;
+
+    if (interface) {
+        key = NATIVESTR_FROMSTR(interface);
+        if (!key)
+            return NULL;
+    }
+    else {
+        key = Py_None;
+        Py_INCREF(key);
+    }
+    entry = PyDict_GetItem(by_interface, key);
+    Py_CLEAR(key);
+
+    if (!entry || !PyTuple_Check(entry) ||
+        PyTuple_GET_SIZE(entry) != N_ENTRY_ITEMS)
+        return NULL;
+    return entry;
+}
+
+/* Set kwargs[keyword] = value, creating kwargs if necessary and stealing
+ * a reference to value (which may be NULL if creating it failed) */
+static int
+set_keyword(PyObject **kwargs, PyObject *keyword, PyObject *value)
+{
+    int ret;
+
+    if (!value)
+        return -1;
+    if (!*kwargs) {
+        *kwargs = PyDict_New();
+        if (!*kwargs) {
+            Py_CLEAR(value);
+            return -1;
+        }
+    }
+    ret = PyDict_SetItem(*kwargs, keyword, value);
+    Py_CLEAR(value);
+    return ret;
+}
+
+static PyObject *
+string_or_none(const char *s)
+{
+    if (!s)
+        Py_RETURN_NONE;
+    return NATIVESTR_FROMSTR(s);
+}
+
+/* Return a new reference to the keyword arguments for the call, or NULL
+ * with no exception set if there are none */
+static PyObject *
+build_keywords(PyObject *entry, PyObject *connection, PyObject *message,
+               DBusMessage *msg)
+{
+    PyObject *kwargs = NULL;
+    PyObject *keyword;
+
+    keyword = PyTuple_GET_ITEM(entry, ENTRY_SENDER_KEYWORD);
+    if (keyword != Py_None &&
+        set_keyword(&kwargs, keyword,
+                    string_or_none(dbus_message_get_sender(msg))) < 0)
+        goto error;
+
+    keyword = PyTuple_GET_ITEM(entry, ENTRY_PATH_KEYWORD);
+    if (keyword != Py_None) {
+        const char *path = dbus_message_get_path(msg);
+        PyObject *value;
+
+        if (path) {
+            value = DBusPyObjectPath_FromDBus(path, 0);
+        }
+        else {
+            value = Py_None;
+            Py_INCREF(value);
+        }
+        if (set_keyword(&kwargs, keyword, value) < 0)
+            goto error;
+    }
+
+    keyword = PyTuple_GET_ITEM(entry, ENTRY_DESTINATION_KEYWORD);
+    if (keyword != Py_None &&
+        set_keyword(&kwargs, keyword,
+                    string_or_none(dbus_message_get_destination(msg))) < 0)
+        goto error;
+
+    keyword = PyTuple_GET_ITEM(entry, ENTRY_MESSAGE_KEYWORD);
+    if (keyword != Py_None) {
+        Py_INCREF(message);
+        if (set_keyword(&kwargs, keyword, message) < 0)
+            goto error;
+    }
+
+    keyword = PyTuple_GET_ITEM(entry, ENTRY_CONNECTION_KEYWORD);
+    if (keyword != Py_None) {
+        Py_INCREF(connection);
+        if (set_keyword(&kwargs, keyword, connection) < 0)
+            goto error;
+    }
+
+    return kwargs;
+
+error:
+    Py_CLEAR(kwargs);
+    return NULL;
+}
+
+/* Turn the method's return value into a tuple of the values to reply
+ * with, as Object._message_cb does. Steals a reference to retval. */
+static PyObject *
+reply_values(PyObject *entry, PyObject *retval, DBusMessage *msg)
+{
+    PyObject *out_signature = PyTuple_GET_ITEM(entry, ENTRY_OUT_SIGNATURE);
+    PyObject *ret;
+
+    if (out_signature != Py_None) {
+        long n_out = NATIVEINT_ASLONG(PyTuple_GET_ITEM(entry, ENTRY_N_OUT));
+
+        if (n_out == -1 && PyErr_Occurred()) {
+            ret = NULL;
+        }
+        else if (n_out == 0) {
+            if (retval == Py_None) {
+                ret = PyTuple_New(0);
+            }
+            else {
+                PyErr_Format(PyExc_TypeError, "%s has an empty output "
+                             "signature but did not return None",
+                             dbus_message_get_member(msg));
+                ret = NULL;
+            }
+        }
+        else if (n_out == 1) {
+            ret = PyTuple_Pack(1, retval);
+        }
+        else if (PySequence_Check(retval)) {
+            ret = PySequence_Tuple(retval);
+        }
+        else {
+            PyObject *sig_repr = PyObject_Str(out_signature);
+
+            if (sig_repr) {
+#ifdef PY3
+                PyErr_Format(PyExc_TypeError, "%s has multiple output "
+                             "values in signature %U but did not return "
+                             "a sequence", dbus_message_get_member(msg),
+                             sig_repr);
+#else
+                PyErr_Format(PyExc_TypeError, "%s has multiple output "
+                             "values in signature %s but did not return "
+                             "a sequence", dbus_message_get_member(msg),
+                             PyBytes_AS_STRING(sig_repr));
+#endif
+                Py_CLEAR(sig_repr);
+            }
+            ret = NULL;
+        }
+    }
+    else if (retval == Py_None) {
+        ret = PyTuple_New(0);
+    }
+    else if (PyTuple_Check(retval) && !DBusPyStruct_Check(retval)) {
+        /* the usual Python idiom for multiple return values
+         * (fd.o #10174) */
+        ret = PySequence_Tuple(retval);
+    }
+    else {
+        ret = PyTuple_Pack(1, retval);
+    }
+
+    Py_CLEAR(retval);
+    return ret;
+}
+
+static int
+send_reply(PyObject *connection, PyObject *reply)
+{
+    if (DBusPyConnection_Check(connection)) {
+        Connection *conn = (Connection *)connection;
+        DBusMessage *msg = DBusPyMessage_BorrowDBusMessage(reply);
+        dbus_bool_t ok;
+
+        if (!msg)
+            return -1;
+        DBUS_PY_RAISE_VIA_GOTO_IF_FAIL(conn->conn, fail);
+        Py_BEGIN_ALLOW_THREADS
+        ok = dbus_connection_send(conn->conn, msg, NULL);
+        Py_END_ALLOW_THREADS
+        if (!ok) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        return 0;
+    }
+    else {
+        /* something duck-typed, presumably for testing */
+        PyObject *ret = PyObject_CallMethod(connection, "send_message",
+                                            "(O)", reply);
+
+        if (!ret)
+            return -1;
+        Py_CLEAR(ret);
+        return 0;
+    }
+fail:
+    return -1;
+}
+
+/* Call self->on_error for the current exception, with it set as the
+ * exception being handled, so that sys.exc_info() works as it would in
+ * the except clause of Object._message_cb. */
+static PyObject *
+report_error(MethodDispatcher *self, PyObject *connection,
+             PyObject *message)
+{
+    PyObject *et, *ev, *etb, *ret;
+    PyObject *old_et, *old_ev, *old_etb;
+
+    if (PyErr_ExceptionMatches(PyExc_KeyboardInterrupt) ||
+        PyErr_ExceptionMatches(PyExc_SystemExit)) {
+        /* not Exceptions, so _message_cb wouldn't catch them either */
+        return NULL;
+    }
+
+    PyErr_Fetch(&et, &ev, &etb);
+    PyErr_NormalizeException(&et, &ev, &etb);
+    if (!ev) {
+        Py_CLEAR(et);
+        Py_CLEAR(etb);
+        return NULL;
+    }
+#ifdef PY3
+    if (etb)
+        PyException_SetTraceback(ev, etb);
+    PyErr_GetExcInfo(&old_et, &old_ev, &old_etb);
+    Py_INCREF(ev);
+    PyErr_SetExcInfo(et, ev, etb);
+    ret = PyObject_CallFunctionObjArgs(self->on_error, connection, message,
+                                       ev, NULL);
+    PyErr_SetExcInfo(old_et, old_ev, old_etb);
+#else
+    {
+        PyThreadState *tstate = PyThreadState_GET();
+
+        old_et = tstate->exc_type;
+        old_ev = tstate->exc_value;
+        old_etb = tstate->exc_traceback;
+        Py_INCREF(ev);
+        tstate->exc_type = et;
+        tstate->exc_value = ev;
+        tstate->exc_traceback = etb;
+        ret = PyObject_CallFunctionObjArgs(self->on_error, connection,
+                                           message, ev, NULL);
+        et = tstate->exc_type;
+        etb = tstate->exc_traceback;
+        Py_XDECREF(tstate->exc_value);
+        tstate->exc_type = old_et;
+        tstate->exc_value = old_ev;
+        tstate->exc_traceback = old_etb;
+        Py_CLEAR(et);
+        Py_CLEAR(etb);
+    }
+#endif
+    Py_CLEAR(ev);
+    if (!ret)
+        return NULL;
+    Py_CLEAR(ret);
+    Py_RETURN_NONE;
+}
+
+/* Return the native_args default of the connection, which is normally a
+ * Connection but (as for Object._message_cb) could be anything with that
+ * attribute, or none. */
+static int
+connection_native_args(PyObject *connection)
+{
+    PyObject *value;
+    int ret;
+
+    if (DBusPyConnection_Check(connection))
+        return ((Connection *)connection)->native_args;
+    value = PyObject_GetAttrString(connection, "native_args");
+    if (!value) {
+        PyErr_Clear();
+        return 0;
+    }
+    ret = PyObject_IsTrue(value);
+    Py_CLEAR(value);
+    if (ret < 0) {
+        PyErr_Clear();
+        return 0;
+    }
+    return ret;
+}
+
+static PyObject *
+MethodDispatcher_tp_call(MethodDispatcher *self, PyObject *args,
+                         PyObject *kwargs)
+{
+    PyObject *connection, *message;
+    PyObject *entry, *options, *out_signature;
+    PyObject *native_options = NULL;
+    PyObject *in_args = NULL, *call_args = NULL, *call_kwargs = NULL;
+    PyObject *retval = NULL, *reply = NULL;
+    DBusMessage *msg, *reply_msg;
+    const char *signature = NULL;
+    Py_ssize_t i, n;
+
+    if (!PyArg_ParseTuple(args, "OO:_MethodDispatcher", &connection,
+                          &message))
+        return NULL;
+    msg = DBusPyMessage_BorrowDBusMessage(message);
+    if (!msg)
+        return NULL;
+    if (!self->object) {
+        PyErr_SetString(PyExc_ValueError, "_MethodDispatcher has been "
+                        "cleared");
+        return NULL;
+    }
+
+    if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_METHOD_CALL) {
+        /* _message_cb ignores these */
+        Py_RETURN_NONE;
+    }
+
+    entry = find_entry(self, msg);
+    if (!entry) {
+        if (PyErr_Occurred())
+            return NULL;
+        return PyObject_CallFunctionObjArgs(self->fallback, connection,
+                                            message, NULL);
+    }
+    /* the table could be cleared by the method call */
+    Py_INCREF(entry);
+
+    options = PyTuple_GET_ITEM(entry, ENTRY_GET_ARGS_OPTIONS);
+    if (!PyDict_Check(options) || PyDict_Size(options) == 0)
+        options = NULL;
+    /* methods that don't say whether they want native types get the
+     * connection's default */
+    if (connection_native_args(connection)
+        && !(options && PyDict_GetItemString(options, "native"))) {
+        native_options = options ? PyDict_Copy(options) : PyDict_New();
+        if (!native_options
+            || PyDict_SetItemString(native_options, "native", Py_True) < 0)
+            goto error;
+        options = native_options;
+    }
+    in_args = dbus_py_Message_get_args_list(
+        (Message *)message, dbus_py_empty_tuple, options);
+    Py_CLEAR(native_options);
+    if (!in_args)
+        goto error;
+
+    n = PyList_GET_SIZE(in_args);
+    call_args = PyTuple_New(n + 1);
+    if (!call_args)
+        goto error;
+    Py_INCREF(self->object);
+    PyTuple_SET_ITEM(call_args, 0, self->object);
+    for (i = 0; i < n; i++) {
+        PyObject *item = PyList_GET_ITEM(in_args, i);
+
+        Py_INCREF(item);
+        PyTuple_SET_ITEM(call_args, i + 1, item);
+    }
+    Py_CLEAR(in_args);
+
+    call_kwargs = build_keywords(entry, connection, message, msg);
+    if (!call_kwargs && PyErr_Occurred())
+        goto error;
+
+    if (self->enter) {
+        PyObject *ret = PyObject_CallFunctionObjArgs(self->enter, NULL);
+
+        if (!ret)
+            goto error;
+        Py_CLEAR(ret);
+    }
+    retval = PyObject_Call(PyTuple_GET_ITEM(entry, ENTRY_METHOD), call_args,
+                           call_kwargs);
+    Py_CLEAR(call_args);
+    Py_CLEAR(call_kwargs);
+    if (self->exit) {
+        PyObject *et, *ev, *etb, *ret;
+
+        /* exit() runs whether or not the method raised */
+        PyErr_Fetch(&et, &ev, &etb);
+        ret = PyObject_CallFunctionObjArgs(self->exit, NULL);
+        if (ret) {
+            Py_CLEAR(ret);
+            PyErr_Restore(et, ev, etb);
+        }
+        else {
+            Py_CLEAR(et);
+            Py_CLEAR(ev);
+            Py_CLEAR(etb);
+            Py_CLEAR(retval);
+        }
+    }
+    if (!retval)
+        goto error;
+
+    /* steals retval */
+    retval = reply_values(entry, retval, msg);
+    if (!retval)
+        goto error;
+
+    out_signature = PyTuple_GET_ITEM(entry, ENTRY_OUT_SIGNATURE);
+    if (out_signature != Py_None) {
+#ifdef PY3
+        signature = PyUnicode_AsUTF8(out_signature);
+#else
+        signature = PyBytes_AsString(out_signature);
+#endif
+        if (!signature)
+            goto error;
+    }
+
+    reply_msg = dbus_message_new_method_return(msg);
+    if (!reply_msg) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    reply = DBusPyMessage_ConsumeDBusMessage(reply_msg);
+    if (!reply)
+        goto error;
+    if (dbus_py_Message_append_args((Message *)reply, retval,
+                                    signature) < 0)
+        goto error;
+    Py_CLEAR(retval);
+
+    if (send_reply(connection, reply) < 0)
+        goto error;
+
+    Py_CLEAR(reply);
+    Py_CLEAR(entry);
+    Py_RETURN_NONE;
+
+error:
+    Py_CLEAR(native_options);
+    Py_CLEAR(in_args);
+    Py_CLEAR(call_args);
+    Py_CLEAR(call_kwargs);
+    Py_CLEAR(retval);
+    Py_CLEAR(reply);
+    Py_CLEAR(entry);
+    return report_error(self, connection, message);
+}
+
+PyTypeObject DBusPyMethodDispatcher_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_dbus_bindings._MethodDispatcher",
+    sizeof(MethodDispatcher),
+    0,
+    (destructor)MethodDispatcher_tp_dealloc, /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    (ternaryfunc)MethodDispatcher_tp_call,  /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, /* tp_flags */
+    MethodDispatcher_tp_doc,                /* tp_doc */
+    (traverseproc)MethodDispatcher_tp_traverse, /* tp_traverse */
+    (inquiry)MethodDispatcher_tp_clear,     /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    0,                                      /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    MethodDispatcher_tp_new,                /* tp_new */
+};
+
+dbus_bool_t
+dbus_py_init_method_dispatch_types(void)
+{
+    if (PyType_Ready(&DBusPyMethodDispatcher_Type) < 0)
+        return FALSE;
+
+    return TRUE;
+}
+
+dbus_bool_t
+dbus_py_insert_method_dispatch_types(PyObject *this_module)
+{
+    /* PyModule_AddObject steals a ref */
+    Py_INCREF(&DBusPyMethodDispatcher_Type);
+    if (PyModule_AddObject(this_module, "_MethodDispatcher",
+                           (PyObject *)&DBusPyMethodDispatcher_Type) < 0)
+        return FALSE;
+
+    return TRUE;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
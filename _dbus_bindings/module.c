@@ -165,6 +165,21 @@ dbus_py_get_default_main_loop(void)
     return default_main_loop;
 }
 
+dbus_bool_t
+dbus_py_set_default_main_loop(PyObject *new_loop)
+{
+    PyObject *old_loop;
+
+    if (!dbus_py_check_mainloop_sanity(new_loop)) {
+        return FALSE;
+    }
+    old_loop = default_main_loop;
+    Py_INCREF(new_loop);
+    default_main_loop = new_loop;
+    Py_CLEAR(old_loop);
+    return TRUE;
+}
+
 PyDoc_STRVAR(get_default_main_loop__doc__,
 "get_default_main_loop() -> object\n\n"
 "Return the global default dbus-python main loop wrapper, which is used\n"
@@ -203,21 +218,102 @@ static PyObject *
 set_default_main_loop(PyObject *always_null UNUSED,
                       PyObject *args)
 {
-    PyObject *new_loop, *old_loop;
+    PyObject *new_loop;
 
     if (!PyArg_ParseTuple(args, "O", &new_loop)) {
         return NULL;
     }
-    if (!dbus_py_check_mainloop_sanity(new_loop)) {
+    if (!dbus_py_set_default_main_loop(new_loop)) {
         return NULL;
     }
-    old_loop = default_main_loop;
-    Py_INCREF(new_loop);
-    default_main_loop = new_loop;
-    Py_CLEAR(old_loop);
     Py_RETURN_NONE;
 }
 
+PyDoc_STRVAR(get_dispatch_batch_size__doc__,
+"get_dispatch_batch_size() -> int\n\n"
+"Return the number of messages that main loops implemented in C dispatch\n"
+"each time they take the global interpreter lock. See\n"
+"`set_dispatch_batch_size`.\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+get_dispatch_batch_size(PyObject *always_null UNUSED,
+                        PyObject *no_args UNUSED)
+{
+    return PyLong_FromUnsignedLong(dbus_py_dispatch_batch_size);
+}
+
+PyDoc_STRVAR(set_dispatch_batch_size__doc__,
+"set_dispatch_batch_size(n)\n\n"
+"Set the number of messages that main loops implemented in C, such as\n"
+"`dbus.mainloop.epoll.DBusEpollMainLoop` and the thread started by\n"
+"`Connection.start_dispatch_thread`, dispatch each time they take the\n"
+"global interpreter lock, before letting other threads run. Larger\n"
+"batches mean fewer GIL hand-offs when many messages arrive at once,\n"
+"at the cost of latency for other threads. If n is 0, the lock is\n"
+"instead taken by each handler, for each message. The default is 64.\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+set_dispatch_batch_size(PyObject *always_null UNUSED, PyObject *args)
+{
+    unsigned int batch_size;
+
+    if (!PyArg_ParseTuple(args, "I:set_dispatch_batch_size", &batch_size)) {
+        return NULL;
+    }
+    dbus_py_dispatch_batch_size = batch_size;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(get_dispatch_stats__doc__,
+"get_dispatch_stats() -> dict\n\n"
+"Return counters describing how incoming messages have been dispatched\n"
+"since the module was loaded:\n"
+"\n"
+"``gil_acquisitions``\n"
+"    How often the GIL had to be taken to dispatch messages or call\n"
+"    handlers, as opposed to already being held\n"
+"``batches``\n"
+"    How many batches of messages were dispatched with the GIL held\n"
+"``messages``\n"
+"    How many messages were dispatched in those batches\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+get_dispatch_stats(PyObject *always_null UNUSED, PyObject *no_args UNUSED)
+{
+    return Py_BuildValue("{sksksk}",
+                         "gil_acquisitions",
+                         dbus_py_dispatch_stats.gil_acquisitions,
+                         "batches", dbus_py_dispatch_stats.batches,
+                         "messages", dbus_py_dispatch_stats.messages);
+}
+
+PyDoc_STRVAR(get_intern_stats__doc__,
+"get_intern_stats() -> dict\n\n"
+"Return counters for the table of shared strings that interface and\n"
+"member names, object paths, bus names and the string keys of dicts\n"
+"received in messages are looked up in, so that repeated names are\n"
+"returned as the same object:\n"
+"\n"
+"``hits``\n"
+"    How many strings were found in the table\n"
+"``misses``\n"
+"    How many strings had to be created\n"
+"``size``\n"
+"    How many strings the table currently holds\n"
+"\n"
+":Since: 1.2.1\n");
+static PyObject *
+get_intern_stats(PyObject *always_null UNUSED, PyObject *no_args UNUSED)
+{
+    return Py_BuildValue("{sksksk}",
+                         "hits", dbus_py_intern_stats.hits,
+                         "misses", dbus_py_intern_stats.misses,
+                         "size", dbus_py_intern_count());
+}
+
 static PyMethodDef module_functions[] = {
 #define ENTRY(name,flags) {#name, (PyCFunction)name, flags, name##__doc__}
     ENTRY(validate_interface_name, METH_VARARGS),
@@ -226,6 +322,10 @@ static PyMethodDef module_functions[] = {
     ENTRY(validate_object_path, METH_VARARGS),
     ENTRY(set_default_main_loop, METH_VARARGS),
     ENTRY(get_default_main_loop, METH_NOARGS),
+    ENTRY(set_dispatch_batch_size, METH_VARARGS),
+    ENTRY(get_dispatch_batch_size, METH_NOARGS),
+    ENTRY(get_dispatch_stats, METH_NOARGS),
+    ENTRY(get_intern_stats, METH_NOARGS),
     /* validate_error_name is just implemented as validate_interface_name */
     {"validate_error_name", validate_interface_name,
      METH_VARARGS, validate_error_name__doc__},
@@ -276,9 +376,15 @@ init_dbus_bindings(void)
     if (!dbus_py_init_message_types()) goto init_error;
     if (!dbus_py_init_pending_call()) goto init_error;
     if (!dbus_py_init_mainloop()) goto init_error;
+    if (!dbus_py_init_python_mainloop()) goto init_error;
+#ifdef WITH_EPOLL_MAINLOOP
+    if (!dbus_py_init_epoll_mainloop()) goto init_error;
+#endif
     if (!dbus_py_init_libdbus_conn_types()) goto init_error;
     if (!dbus_py_init_conn_types()) goto init_error;
     if (!dbus_py_init_server_types()) goto init_error;
+    if (!dbus_py_init_method_dispatch_types()) goto init_error;
+    if (!dbus_py_init_object_subtree_types()) goto init_error;
 
 #ifdef PY3
     this_module = PyModule_Create(&moduledef);
@@ -299,9 +405,15 @@ init_dbus_bindings(void)
     if (!dbus_py_insert_message_types(this_module)) goto init_error;
     if (!dbus_py_insert_pending_call(this_module)) goto init_error;
     if (!dbus_py_insert_mainloop_types(this_module)) goto init_error;
+    if (!dbus_py_insert_python_mainloop(this_module)) goto init_error;
+#ifdef WITH_EPOLL_MAINLOOP
+    if (!dbus_py_insert_epoll_mainloop(this_module)) goto init_error;
+#endif
     if (!dbus_py_insert_libdbus_conn_types(this_module)) goto init_error;
     if (!dbus_py_insert_conn_types(this_module)) goto init_error;
     if (!dbus_py_insert_server_types(this_module)) goto init_error;
+    if (!dbus_py_insert_method_dispatch_types(this_module)) goto init_error;
+    if (!dbus_py_insert_object_subtree_types(this_module)) goto init_error;
 
     if (PyModule_AddStringConstant(this_module, "BUS_DAEMON_NAME",
                                    DBUS_SERVICE_DBUS) < 0) goto init_error;
@@ -321,6 +433,10 @@ init_dbus_bindings(void)
     if (PyModule_AddStringConstant(this_module, "PROPERTIES_IFACE",
                                    DBUS_INTERFACE_PROPERTIES) < 0)
         goto init_error;
+    /* not defined by libdbus until 1.9 */
+    if (PyModule_AddStringConstant(this_module, "OBJECT_MANAGER_IFACE",
+                                   "org.freedesktop.DBus.ObjectManager") < 0)
+        goto init_error;
     if (PyModule_AddStringConstant(this_module,
                 "DBUS_INTROSPECT_1_0_XML_PUBLIC_IDENTIFIER",
                 DBUS_INTROSPECT_1_0_XML_PUBLIC_IDENTIFIER) < 0)
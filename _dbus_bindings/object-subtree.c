@@ -0,0 +1,834 @@
+/* A subtree of the object-path namespace whose objects are created on
+ * demand, for dbus.service.ObjectSubtree.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "dbus_bindings-internal.h"
+
+/* An _ObjectSubtree is registered with libdbus as a single fallback
+ * handler for its root path, rather than registering each object path
+ * separately. The objects that have been created so far are kept in a
+ * trie with a node per path component, each node's children sorted by
+ * name; when a message arrives for a path that has no object yet, the
+ * resolver is asked for one.
+ *
+ * Paths are handled relative to the root: "" is the root itself and
+ * "/a/b" is the object at root + "/a/b".
+ */
+
+typedef struct _SubtreeNode SubtreeNode;
+struct _SubtreeNode {
+    PyObject *object;           /* owned, or NULL if there is none here */
+    PyObject *handler;          /* owned; NULL if and only if object is */
+    SubtreeNode **children;     /* sorted by name */
+    unsigned int n_children;
+    unsigned int n_allocated;
+    char name[1];               /* allocated with the node */
+};
+
+typedef struct {
+    PyObject_HEAD
+    char *root;
+    size_t root_len;
+    PyObject *resolver;
+    PyObject *enumerator;       /* or None */
+    PyObject *on_missing;       /* or None */
+    SubtreeNode *tree;
+    Py_ssize_t n_objects;
+} ObjectSubtree;
+
+static SubtreeNode *
+node_new(const char *name, size_t len)
+{
+    SubtreeNode *node = PyMem_Malloc(offsetof(SubtreeNode, name) + len + 1);
+
+    if (!node) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    node->object = NULL;
+    node->handler = NULL;
+    node->children = NULL;
+    node->n_children = 0;
+    node->n_allocated = 0;
+    memcpy(node->name, name, len);
+    node->name[len] = '\0';
+    return node;
+}
+
+/* Free node and its descendants, which must already have been detached
+ * from the subtree, since releasing the objects can run arbitrary code. */
+static void
+node_free(SubtreeNode *node)
+{
+    unsigned int i;
+
+    for (i = 0; i < node->n_children; i++) {
+        node_free(node->children[i]);
+    }
+    PyMem_Free(node->children);
+    Py_CLEAR(node->object);
+    Py_CLEAR(node->handler);
+    PyMem_Free(node);
+}
+
+/* Return the child of node called name[:len], or NULL with *index set to
+ * where it would be inserted. */
+static SubtreeNode *
+node_find_child(SubtreeNode *node, const char *name, size_t len,
+                unsigned int *index)
+{
+    unsigned int lo = 0, hi = node->n_children;
+
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        SubtreeNode *child = node->children[mid];
+        int cmp = strncmp(child->name, name, len);
+
+        if (cmp == 0 && child->name[len] != '\0')
+            cmp = 1;
+        if (cmp == 0) {
+            *index = mid;
+            return child;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *index = lo;
+    return NULL;
+}
+
+static SubtreeNode *
+node_insert_child(SubtreeNode *node, unsigned int index, const char *name,
+                  size_t len)
+{
+    SubtreeNode *child;
+
+    if (node->n_children == node->n_allocated) {
+        unsigned int n = node->n_allocated ? node->n_allocated * 2 : 4;
+        SubtreeNode **children = PyMem_Realloc(node->children,
+                                               n * sizeof(SubtreeNode *));
+
+        if (!children) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        node->children = children;
+        node->n_allocated = n;
+    }
+    child = node_new(name, len);
+    if (!child)
+        return NULL;
+    memmove(node->children + index + 1, node->children + index,
+            (node->n_children - index) * sizeof(SubtreeNode *));
+    node->children[index] = child;
+    node->n_children++;
+    return child;
+}
+
+/* Return the node for the relative path rel below node, or NULL (with an
+ * exception set only if create is true and allocation failed). */
+static SubtreeNode *
+node_lookup(SubtreeNode *node, const char *rel, dbus_bool_t create)
+{
+    while (*rel) {
+        const char *name = rel + 1;
+        const char *end = strchr(name, '/');
+        size_t len = end ? (size_t)(end - name) : strlen(name);
+        unsigned int index;
+        SubtreeNode *child = node_find_child(node, name, len, &index);
+
+        if (!child) {
+            if (!create)
+                return NULL;
+            child = node_insert_child(node, index, name, len);
+            if (!child)
+                return NULL;
+        }
+        node = child;
+        rel = name + len;
+    }
+    return node;
+}
+
+/* Remove nodes along the relative path rel below node that have neither
+ * an object nor children. Return true if node itself is now such a node. */
+static dbus_bool_t
+node_prune(SubtreeNode *node, const char *rel)
+{
+    if (*rel) {
+        const char *name = rel + 1;
+        const char *end = strchr(name, '/');
+        size_t len = end ? (size_t)(end - name) : strlen(name);
+        unsigned int index;
+        SubtreeNode *child = node_find_child(node, name, len, &index);
+
+        if (child && node_prune(child, name + len)) {
+            node->n_children--;
+            memmove(node->children + index, node->children + index + 1,
+                    (node->n_children - index) * sizeof(SubtreeNode *));
+            node_free(child);
+        }
+    }
+    return !node->object && node->n_children == 0;
+}
+
+/* Append (path, object) for node and its descendants to list, where path
+ * is the node's absolute path, held in *buf up to len. */
+static int
+node_collect(SubtreeNode *node, char **buf, size_t *size, size_t len,
+             PyObject *list)
+{
+    unsigned int i;
+
+    if (node->object) {
+        PyObject *item = Py_BuildValue("(NO)",
+            DBusPyObjectPath_FromDBus(len ? *buf : "/", 0), node->object);
+
+        if (!item)
+            return -1;
+        if (PyList_Append(list, item) < 0) {
+            Py_CLEAR(item);
+            return -1;
+        }
+        Py_CLEAR(item);
+    }
+    for (i = 0; i < node->n_children; i++) {
+        SubtreeNode *child = node->children[i];
+        size_t child_len = len + 1 + strlen(child->name);
+
+        if (child_len + 1 > *size) {
+            char *bigger = PyMem_Realloc(*buf, child_len * 2);
+
+            if (!bigger) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            *buf = bigger;
+            *size = child_len * 2;
+        }
+        (*buf)[len] = '/';
+        strcpy(*buf + len + 1, child->name);
+        if (node_collect(child, buf, size, child_len, list) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int
+node_traverse(SubtreeNode *node, visitproc visit, void *arg)
+{
+    unsigned int i;
+
+    Py_VISIT(node->object);
+    Py_VISIT(node->handler);
+    for (i = 0; i < node->n_children; i++) {
+        int ret = node_traverse(node->children[i], visit, arg);
+
+        if (ret)
+            return ret;
+    }
+    return 0;
+}
+
+/* Return path relative to the subtree's root, or NULL with ValueError
+ * set if it is outside the subtree. */
+static const char *
+subtree_relative(ObjectSubtree *self, const char *path)
+{
+    const char *rel;
+
+    if (self->root_len == 1) {
+        /* the root is "/" */
+        return strcmp(path, "/") == 0 ? "" : path;
+    }
+    if (strncmp(path, self->root, self->root_len) == 0) {
+        rel = path + self->root_len;
+        if (*rel == '\0' || *rel == '/')
+            return rel;
+    }
+    PyErr_Format(PyExc_ValueError, "%s is not in the subtree at %s",
+                 path, self->root);
+    return NULL;
+}
+
+PyDoc_STRVAR(ObjectSubtree_tp_doc,
+"_ObjectSubtree(path, resolver, enumerator=None, on_missing=None)\n\n"
+"A message callback for `Connection._register_object_path`, registered\n"
+"with ``fallback=True`` at ``path``, which dispatches messages to\n"
+"objects in the subtree below it that are only created when they are\n"
+"first addressed. When a message arrives for an object path that has no\n"
+"object yet, ``resolver(object_path)`` is called, and returns either a\n"
+"tuple ``(object, handler)``, which is kept, and ``handler(connection,\n"
+"message)`` called for this and later messages to that path; or None,\n"
+"in which case ``on_missing(connection, message)`` is called if given.\n"
+"\n"
+"If given, ``enumerator(object_path)`` returns the names of the\n"
+"children of an object path in the subtree, including those that have\n"
+"no object yet, for introspection.\n"
+"\n"
+"This is an implementation detail of `dbus.service`.\n"
+);
+
+static PyObject *
+ObjectSubtree_tp_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    ObjectSubtree *self;
+    const char *path;
+    PyObject *resolver, *enumerator = Py_None, *on_missing = Py_None;
+    static char *argnames[] = {"path", "resolver", "enumerator",
+                               "on_missing", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|OO:_ObjectSubtree",
+                                     argnames, &path, &resolver,
+                                     &enumerator, &on_missing))
+        return NULL;
+    if (!dbus_py_validate_object_path(path))
+        return NULL;
+
+    self = (ObjectSubtree *)(cls->tp_alloc(cls, 0));
+    if (!self)
+        return NULL;
+    self->root_len = strlen(path);
+    self->root = PyMem_Malloc(self->root_len + 1);
+    self->tree = node_new("", 0);
+    if (!self->root || !self->tree) {
+        Py_CLEAR(self);
+        return PyErr_NoMemory();
+    }
+    memcpy(self->root, path, self->root_len + 1);
+    Py_INCREF(resolver);
+    self->resolver = resolver;
+    Py_INCREF(enumerator);
+    self->enumerator = enumerator;
+    Py_INCREF(on_missing);
+    self->on_missing = on_missing;
+    return (PyObject *)self;
+}
+
+static int
+ObjectSubtree_tp_traverse(ObjectSubtree *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->resolver);
+    Py_VISIT(self->enumerator);
+    Py_VISIT(self->on_missing);
+    if (self->tree)
+        return node_traverse(self->tree, visit, arg);
+    return 0;
+}
+
+static int
+ObjectSubtree_tp_clear(ObjectSubtree *self)
+{
+    SubtreeNode *tree = self->tree;
+
+    self->tree = NULL;
+    self->n_objects = 0;
+    if (tree)
+        node_free(tree);
+    Py_CLEAR(self->resolver);
+    Py_CLEAR(self->enumerator);
+    Py_CLEAR(self->on_missing);
+    return 0;
+}
+
+static void
+ObjectSubtree_tp_dealloc(ObjectSubtree *self)
+{
+    PyObject_GC_UnTrack(self);
+    ObjectSubtree_tp_clear(self);
+    PyMem_Free(self->root);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+ObjectSubtree_tp_call(ObjectSubtree *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *connection, *message, *handler, *found, *ret;
+    DBusMessage *msg;
+    SubtreeNode *node;
+    const char *path, *rel;
+
+    if (!PyArg_ParseTuple(args, "OO:_ObjectSubtree", &connection, &message))
+        return NULL;
+    msg = DBusPyMessage_BorrowDBusMessage(message);
+    if (!msg)
+        return NULL;
+    if (!self->tree) {
+        PyErr_SetString(PyExc_ValueError, "_ObjectSubtree has been cleared");
+        return NULL;
+    }
+    path = dbus_message_get_path(msg);
+    if (!path || !(rel = subtree_relative(self, path))) {
+        PyErr_Clear();
+        Py_INCREF(Py_NotImplemented);
+        return Py_NotImplemented;
+    }
+
+    node = node_lookup(self->tree, rel, FALSE);
+    if (!node || !node->handler) {
+        PyObject *object_path;
+
+        /* only method calls bring objects into existence: an Object
+         * would ignore anything else anyway */
+        if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_METHOD_CALL) {
+            Py_INCREF(Py_NotImplemented);
+            return Py_NotImplemented;
+        }
+        object_path = DBusPyObjectPath_FromDBus(path, 0);
+        if (!object_path)
+            return NULL;
+        found = PyObject_CallFunctionObjArgs(self->resolver, object_path,
+                                             NULL);
+        Py_CLEAR(object_path);
+        if (!found)
+            return NULL;
+        if (found == Py_None) {
+            Py_CLEAR(found);
+            if (self->on_missing == Py_None) {
+                Py_INCREF(Py_NotImplemented);
+                return Py_NotImplemented;
+            }
+            return PyObject_CallFunctionObjArgs(self->on_missing, connection,
+                                                message, NULL);
+        }
+        if (!PyTuple_Check(found) || PyTuple_GET_SIZE(found) != 2) {
+            PyErr_SetString(PyExc_TypeError, "_ObjectSubtree resolver "
+                            "must return None or (object, handler)");
+            Py_CLEAR(found);
+            return NULL;
+        }
+        /* the resolver could have added the object itself, or cleared us */
+        if (!self->tree || !(node = node_lookup(self->tree, rel, TRUE))) {
+            Py_CLEAR(found);
+            if (!PyErr_Occurred())
+                PyErr_SetString(PyExc_ValueError,
+                                "_ObjectSubtree has been cleared");
+            return NULL;
+        }
+        if (!node->handler) {
+            node->object = PyTuple_GET_ITEM(found, 0);
+            Py_INCREF(node->object);
+            node->handler = PyTuple_GET_ITEM(found, 1);
+            Py_INCREF(node->handler);
+            self->n_objects++;
+        }
+        Py_CLEAR(found);
+    }
+
+    /* the handler could remove itself from the subtree */
+    handler = node->handler;
+    Py_INCREF(handler);
+    ret = PyObject_CallFunctionObjArgs(handler, connection, message, NULL);
+    Py_CLEAR(handler);
+    return ret;
+}
+
+/* Return the node for path, or NULL, with an exception set if path is
+ * outside the subtree or (if create is true) allocation failed. */
+static SubtreeNode *
+ObjectSubtree_lookup(ObjectSubtree *self, const char *path,
+                     dbus_bool_t create)
+{
+    const char *rel;
+
+    if (!self->tree) {
+        PyErr_SetString(PyExc_ValueError, "_ObjectSubtree has been cleared");
+        return NULL;
+    }
+    rel = subtree_relative(self, path);
+    if (!rel)
+        return NULL;
+    return node_lookup(self->tree, rel, create);
+}
+
+PyDoc_STRVAR(ObjectSubtree_add__doc__,
+"add(path, object, handler)\n\n"
+"Put an object in the subtree without waiting for it to be addressed.\n"
+"\n"
+":Raises KeyError: if there is already an object at that path\n");
+static PyObject *
+ObjectSubtree_add(ObjectSubtree *self, PyObject *args)
+{
+    const char *path;
+    PyObject *object, *handler;
+    SubtreeNode *node;
+
+    if (!PyArg_ParseTuple(args, "sOO:add", &path, &object, &handler))
+        return NULL;
+    if (!dbus_py_validate_object_path(path))
+        return NULL;
+    node = ObjectSubtree_lookup(self, path, TRUE);
+    if (!node) {
+        /* don't leave behind any nodes created before running out of
+         * memory */
+        if (self->tree && PyErr_ExceptionMatches(PyExc_MemoryError))
+            node_prune(self->tree, subtree_relative(self, path));
+        return NULL;
+    }
+    if (node->handler) {
+        PyErr_Format(PyExc_KeyError, "There is already an object at %s",
+                     path);
+        return NULL;
+    }
+    Py_INCREF(object);
+    node->object = object;
+    Py_INCREF(handler);
+    node->handler = handler;
+    self->n_objects++;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(ObjectSubtree_remove__doc__,
+"remove(path) -> object\n\n"
+"Remove the object at the given path from the subtree and return it.\n"
+"The resolver will be asked for a new one if the path is addressed again.\n"
+"\n"
+":Raises KeyError: if there is no object at that path\n");
+static PyObject *
+ObjectSubtree_remove(ObjectSubtree *self, PyObject *args)
+{
+    const char *path;
+    PyObject *object, *handler;
+    SubtreeNode *node;
+
+    if (!PyArg_ParseTuple(args, "s:remove", &path))
+        return NULL;
+    node = ObjectSubtree_lookup(self, path, FALSE);
+    if (!node || !node->object) {
+        if (!PyErr_Occurred())
+            PyErr_Format(PyExc_KeyError, "There is no object at %s", path);
+        return NULL;
+    }
+    object = node->object;
+    handler = node->handler;
+    node->object = NULL;
+    node->handler = NULL;
+    self->n_objects--;
+    node_prune(self->tree, subtree_relative(self, path));
+    Py_CLEAR(handler);
+    return object;
+}
+
+PyDoc_STRVAR(ObjectSubtree_get__doc__,
+"get(path) -> object or None\n\n"
+"Return the object at the given path if it has been created, without\n"
+"calling the resolver.\n");
+static PyObject *
+ObjectSubtree_get(ObjectSubtree *self, PyObject *args)
+{
+    const char *path;
+    SubtreeNode *node;
+
+    if (!PyArg_ParseTuple(args, "s:get", &path))
+        return NULL;
+    node = ObjectSubtree_lookup(self, path, FALSE);
+    if (!node) {
+        if (PyErr_Occurred())
+            return NULL;
+        Py_RETURN_NONE;
+    }
+    if (!node->object) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(node->object);
+    return node->object;
+}
+
+/* Return a new list of the names of the children of path, which must be
+ * in the subtree, or NULL with an exception set. */
+PyObject *
+dbus_py_object_subtree_children(PyObject *subtree, const char *path)
+{
+    ObjectSubtree *self = (ObjectSubtree *)subtree;
+    PyObject *ret = NULL, *seen = NULL, *names = NULL, *iter = NULL;
+    PyObject *name;
+    SubtreeNode *node;
+    unsigned int i;
+
+    if (!ObjectSubtree_lookup(self, path, FALSE) && PyErr_Occurred())
+        return NULL;
+    ret = PyList_New(0);
+    seen = PySet_New(NULL);
+    if (!ret || !seen)
+        goto error;
+
+    if (self->enumerator != Py_None) {
+        PyObject *object_path = DBusPyObjectPath_FromDBus(path, 0);
+
+        if (!object_path)
+            goto error;
+        names = PyObject_CallFunctionObjArgs(self->enumerator, object_path,
+                                             NULL);
+        Py_CLEAR(object_path);
+        if (!names)
+            goto error;
+        iter = PyObject_GetIter(names);
+        if (!iter)
+            goto error;
+        while ((name = PyIter_Next(iter))) {
+#ifndef PY3
+            if (PyUnicode_Check(name)) {
+                PyObject *utf8 = PyUnicode_AsUTF8String(name);
+
+                Py_CLEAR(name);
+                if (!utf8)
+                    goto error;
+                name = utf8;
+            }
+#endif
+            if (!NATIVESTR_CHECK(name)) {
+                PyErr_SetString(PyExc_TypeError, "_ObjectSubtree "
+                                "enumerator must return an iterable of str");
+                Py_CLEAR(name);
+                goto error;
+            }
+            if (PyList_Append(ret, name) < 0 || PySet_Add(seen, name) < 0) {
+                Py_CLEAR(name);
+                goto error;
+            }
+            Py_CLEAR(name);
+        }
+        if (PyErr_Occurred())
+            goto error;
+    }
+
+    /* look again: the enumerator could have changed the subtree */
+    node = ObjectSubtree_lookup(self, path, FALSE);
+    if (!node && PyErr_Occurred())
+        goto error;
+    for (i = 0; node && i < node->n_children; i++) {
+        int contains;
+
+        name = NATIVESTR_FROMSTR(node->children[i]->name);
+        if (!name)
+            goto error;
+        contains = PySet_Contains(seen, name);
+        if (contains < 0 || (!contains && PyList_Append(ret, name) < 0)) {
+            Py_CLEAR(name);
+            goto error;
+        }
+        Py_CLEAR(name);
+    }
+
+    Py_CLEAR(iter);
+    Py_CLEAR(names);
+    Py_CLEAR(seen);
+    return ret;
+
+error:
+    Py_CLEAR(iter);
+    Py_CLEAR(names);
+    Py_CLEAR(seen);
+    Py_CLEAR(ret);
+    return NULL;
+}
+
+PyDoc_STRVAR(ObjectSubtree_children__doc__,
+"children(path) -> list of str\n\n"
+"Return the names of the children of the given path: those returned by\n"
+"the enumerator, followed by any others at which objects have been\n"
+"created.\n");
+static PyObject *
+ObjectSubtree_children(ObjectSubtree *self, PyObject *args)
+{
+    const char *path;
+
+    if (!PyArg_ParseTuple(args, "s:children", &path))
+        return NULL;
+    return dbus_py_object_subtree_children((PyObject *)self, path);
+}
+
+/* Return a new list of (ObjectPath, object) for every object in the
+ * subtree, or NULL with an exception set. */
+static PyObject *
+subtree_collect(ObjectSubtree *self)
+{
+    PyObject *list;
+    size_t size = self->root_len + 64;
+    char *buf;
+
+    if (!self->tree) {
+        PyErr_SetString(PyExc_ValueError, "_ObjectSubtree has been cleared");
+        return NULL;
+    }
+    list = PyList_New(0);
+    buf = PyMem_Malloc(size);
+    if (!list || !buf) {
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
+        goto error;
+    }
+    /* the root "/" is written as the empty prefix of its children */
+    memcpy(buf, self->root, self->root_len + 1);
+    if (node_collect(self->tree, &buf, &size,
+                     self->root_len == 1 ? 0 : self->root_len, list) < 0)
+        goto error;
+    PyMem_Free(buf);
+    return list;
+
+error:
+    PyMem_Free(buf);
+    Py_CLEAR(list);
+    return NULL;
+}
+
+PyDoc_STRVAR(ObjectSubtree_items__doc__,
+"items() -> list of (ObjectPath, object)\n\n"
+"Return every object in the subtree with its path.\n");
+static PyObject *
+ObjectSubtree_items(ObjectSubtree *self, PyObject *unused UNUSED)
+{
+    return subtree_collect(self);
+}
+
+PyDoc_STRVAR(ObjectSubtree_clear__doc__,
+"clear() -> list of (ObjectPath, object)\n\n"
+"Remove every object from the subtree and return them with their paths.\n");
+static PyObject *
+ObjectSubtree_clear(ObjectSubtree *self, PyObject *unused UNUSED)
+{
+    SubtreeNode *tree, *empty;
+    PyObject *list = subtree_collect(self);
+
+    if (!list)
+        return NULL;
+    empty = node_new("", 0);
+    if (!empty) {
+        Py_CLEAR(list);
+        return NULL;
+    }
+
+    /* releasing the objects could run code that uses the subtree */
+    tree = self->tree;
+    self->tree = empty;
+    self->n_objects = 0;
+    node_free(tree);
+    return list;
+}
+
+static Py_ssize_t
+ObjectSubtree_sq_length(ObjectSubtree *self)
+{
+    return self->n_objects;
+}
+
+static PyObject *
+ObjectSubtree_get_path(ObjectSubtree *self, void *closure UNUSED)
+{
+    return DBusPyObjectPath_FromDBus(self->root, 0);
+}
+
+static PyGetSetDef ObjectSubtree_tp_getset[] = {
+    {"path", (getter)ObjectSubtree_get_path, NULL,
+     "The object path at the root of the subtree", NULL},
+    {NULL},
+};
+
+static PyMethodDef ObjectSubtree_tp_methods[] = {
+#define ENTRY(name, flags) \
+    {#name, (PyCFunction)ObjectSubtree_##name, flags, \
+     ObjectSubtree_##name##__doc__}
+    ENTRY(add, METH_VARARGS),
+    ENTRY(remove, METH_VARARGS),
+    ENTRY(get, METH_VARARGS),
+    ENTRY(children, METH_VARARGS),
+    ENTRY(items, METH_NOARGS),
+    ENTRY(clear, METH_NOARGS),
+#undef ENTRY
+    {NULL},
+};
+
+static PySequenceMethods ObjectSubtree_tp_as_sequence = {
+    (lenfunc)ObjectSubtree_sq_length,       /* sq_length */
+};
+
+PyTypeObject DBusPyObjectSubtree_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_dbus_bindings._ObjectSubtree",
+    sizeof(ObjectSubtree),
+    0,
+    (destructor)ObjectSubtree_tp_dealloc,   /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    &ObjectSubtree_tp_as_sequence,          /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    (ternaryfunc)ObjectSubtree_tp_call,     /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, /* tp_flags */
+    ObjectSubtree_tp_doc,                   /* tp_doc */
+    (traverseproc)ObjectSubtree_tp_traverse, /* tp_traverse */
+    (inquiry)ObjectSubtree_tp_clear,        /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    ObjectSubtree_tp_methods,               /* tp_methods */
+    0,                                      /* tp_members */
+    ObjectSubtree_tp_getset,                /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    ObjectSubtree_tp_new,                   /* tp_new */
+};
+
+dbus_bool_t
+dbus_py_init_object_subtree_types(void)
+{
+    if (PyType_Ready(&DBusPyObjectSubtree_Type) < 0)
+        return FALSE;
+
+    return TRUE;
+}
+
+dbus_bool_t
+dbus_py_insert_object_subtree_types(PyObject *this_module)
+{
+    /* PyModule_AddObject steals a ref */
+    Py_INCREF(&DBusPyObjectSubtree_Type);
+    if (PyModule_AddObject(this_module, "_ObjectSubtree",
+                           (PyObject *)&DBusPyObjectSubtree_Type) < 0)
+        return FALSE;
+
+    return TRUE;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -28,6 +28,10 @@
 PyDoc_STRVAR(PendingCall_tp_doc,
 "Object representing a pending D-Bus call, returned by\n"
 "Connection.send_message_with_reply(). Cannot be instantiated directly.\n"
+"\n"
+"Under Python 3.5 or later, it can be awaited if its reply handler can\n"
+"be (the handler's ``__await__`` method is used), as is the case for\n"
+"those returned by `dbus.connection.Connection.call_async`.\n"
 );
 
 static PyTypeObject PendingCallType;
@@ -41,6 +45,7 @@ static inline int PendingCall_Check (PyObject *o)
 typedef struct {
     PyObject_HEAD
     DBusPendingCall *pc;
+    PyObject *handler;
 } PendingCall;
 
 PyDoc_STRVAR(PendingCall_cancel__doc__,
@@ -76,7 +81,7 @@ static void
 _pending_call_notify_function(DBusPendingCall *pc,
                               PyObject *list)
 {
-    PyGILState_STATE gil = PyGILState_Ensure();
+    PyGILState_STATE gil = dbus_py_gil_ensure();
     /* BEGIN CRITICAL SECTION
      * While holding the GIL, make sure the callback only gets called once
      * by deleting it from the 1-item list that's held by libdbus.
@@ -150,6 +155,10 @@ DBusPyPendingCall_ConsumeDBusPendingCall(DBusPendingCall *pc,
     PyObject *list = PyList_New(1);
     PendingCall *self = PyObject_New(PendingCall, &PendingCallType);
 
+    if (self) {
+        self->pc = NULL;
+        self->handler = NULL;
+    }
     if (!list || !self) {
         Py_CLEAR(list);
         Py_CLEAR(self);
@@ -208,6 +217,8 @@ DBusPyPendingCall_ConsumeDBusPendingCall(DBusPendingCall *pc,
 
     Py_CLEAR(list);
     self->pc = pc;
+    Py_INCREF(callable);
+    self->handler = callable;
     return (PyObject *)self;
 }
 
@@ -219,9 +230,36 @@ PendingCall_tp_dealloc (PendingCall *self)
         dbus_pending_call_unref(self->pc);
         Py_END_ALLOW_THREADS
     }
+    Py_CLEAR(self->handler);
     PyObject_Del (self);
 }
 
+#if defined(PY3) && PY_VERSION_HEX >= 0x03050000
+static PyObject *
+PendingCall_am_await(PendingCall *self)
+{
+    PyObject *await = PyObject_GetAttrString(self->handler, "__await__");
+    PyObject *ret;
+
+    if (!await) {
+        if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            PyErr_SetString(PyExc_TypeError, "This PendingCall cannot be "
+                            "awaited: its reply handler is not awaitable");
+        }
+        return NULL;
+    }
+    ret = PyObject_CallObject(await, NULL);
+    Py_DECREF(await);
+    return ret;
+}
+
+static PyAsyncMethods PendingCall_tp_as_async = {
+    (unaryfunc)PendingCall_am_await,        /* am_await */
+    0,                                      /* am_aiter */
+    0,                                      /* am_anext */
+};
+#endif
+
 static PyMethodDef PendingCall_tp_methods[] = {
     {"block", (PyCFunction)PendingCall_block, METH_NOARGS,
      PendingCall_block__doc__},
@@ -241,7 +279,11 @@ static PyTypeObject PendingCallType = {
     0,                                      /* tp_print */
     0,                                      /* tp_getattr */
     0,                                      /* tp_setattr */
+#if defined(PY3) && PY_VERSION_HEX >= 0x03050000
+    &PendingCall_tp_as_async,               /* tp_as_async */
+#else
     0,                                      /* tp_compare */
+#endif
     0,                                      /* tp_repr */
     0,                                      /* tp_as_number */
     0,                                      /* tp_as_sequence */
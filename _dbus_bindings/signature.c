@@ -227,6 +227,15 @@ PyTypeObject DBusPySignature_Type = {
     0,                                      /* tp_free */
 };
 
+/* Internal constructor for signatures which libdbus has already validated,
+ * skipping Signature_tp_new's argument parsing and validation */
+PyObject *
+DBusPySignature_FromDBus(const char *signature, long variant_level)
+{
+    return DBusPyStrBase_FromString(&DBusPySignature_Type, signature,
+                                    variant_level);
+}
+
 dbus_bool_t
 dbus_py_init_signature(void)
 {
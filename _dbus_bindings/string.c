@@ -330,6 +330,75 @@ PyTypeObject DBusPyString_Type = {
     String_tp_new,                          /* tp_new */
 };
 
+/* Internal constructors ============================================ */
+
+/* These take strings which libdbus has already validated, so they skip
+ * tp_new's argument parsing and validation. */
+
+PyObject *
+DBusPyString_FromDBus(const char *utf8, long variant_level)
+{
+    PyObject *self;
+    PyObject *unicode = PyUnicode_DecodeUTF8(utf8, strlen(utf8), NULL);
+#ifdef PY3
+    /* see DBusPyStrBase_FromString() for why this still uses tp_new */
+    PyObject *args;
+
+    if (!unicode)
+        return NULL;
+    args = PyTuple_Pack(1, unicode);
+    Py_CLEAR(unicode);
+    if (!args)
+        return NULL;
+    self = (PyUnicode_Type.tp_new)(&DBusPyString_Type, args, NULL);
+    Py_CLEAR(args);
+#else
+    Py_ssize_t len;
+
+    if (!unicode)
+        return NULL;
+    /* as unicode_subtype_new() does; Python 2's unicode layout is the same
+     * in every version this supports */
+    len = PyUnicode_GET_SIZE(unicode);
+    self = DBusPyString_Type.tp_alloc(&DBusPyString_Type, 0);
+    if (self) {
+        PyUnicodeObject *u = (PyUnicodeObject *)self;
+
+        u->str = PyObject_MALLOC(sizeof(Py_UNICODE) * (len + 1));
+        if (!u->str) {
+            Py_CLEAR(self);
+            PyErr_NoMemory();
+        }
+        else {
+            Py_UNICODE_COPY(u->str, PyUnicode_AS_UNICODE(unicode), len + 1);
+            u->length = len;
+            u->hash = -1;
+        }
+    }
+    Py_CLEAR(unicode);
+#endif
+    if (self) {
+        ((DBusPyString *)self)->variant_level = variant_level;
+    }
+    return self;
+}
+
+#ifndef PY3
+PyObject *
+DBusPyUTF8String_FromDBus(const char *utf8, long variant_level)
+{
+    return DBusPyStrBase_FromString(&DBusPyUTF8String_Type, utf8,
+                                    variant_level);
+}
+#endif
+
+PyObject *
+DBusPyObjectPath_FromDBus(const char *path, long variant_level)
+{
+    return DBusPyStrBase_FromString(&DBusPyObjectPath_Type, path,
+                                    variant_level);
+}
+
 dbus_bool_t
 dbus_py_init_string_types(void)
 {
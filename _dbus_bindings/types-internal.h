@@ -108,5 +108,21 @@ PyObject *dbus_py_variant_level_getattro(PyObject *obj, PyObject *name);
 dbus_bool_t dbus_py_variant_level_set(PyObject *obj, long variant_level);
 void dbus_py_variant_level_clear(PyObject *obj);
 long dbus_py_variant_level_get(PyObject *obj);
+/* Struct's signature, stored alongside its variant level; borrowed ref */
+PyObject *dbus_py_struct_signature_get(PyObject *obj);
+dbus_bool_t dbus_py_struct_signature_set(PyObject *obj, PyObject *signature);
+
+/* Construct instances of subclasses of the abstract base types without
+ * argument parsing or validation, for values already checked by libdbus */
+#ifndef PY3
+PyObject *DBusPyIntBase_FromLong(PyTypeObject *cls, long value,
+                                 long variant_level);
+#endif
+PyObject *DBusPyLongBase_FromPyLong(PyTypeObject *cls, PyObject *value,
+                                    long variant_level);
+PyObject *DBusPyFloatBase_FromDouble(PyTypeObject *cls, double value,
+                                     long variant_level);
+PyObject *DBusPyStrBase_FromString(PyTypeObject *cls, const char *str,
+                                   long variant_level);
 
 #endif
@@ -50,11 +50,12 @@ __all__ = [
 
            'BUS_DAEMON_NAME', 'BUS_DAEMON_PATH', 'BUS_DAEMON_IFACE',
            'LOCAL_PATH', 'LOCAL_IFACE', 'PEER_IFACE',
-           'INTROSPECTABLE_IFACE', 'PROPERTIES_IFACE',
+           'INTROSPECTABLE_IFACE', 'PROPERTIES_IFACE', 'OBJECT_MANAGER_IFACE',
 
            'ObjectPath', 'ByteArray', 'Signature', 'Byte', 'Boolean',
            'Int16', 'UInt16', 'Int32', 'UInt32', 'Int64', 'UInt64',
            'Double', 'String', 'Array', 'Struct', 'Dictionary',
+           'LazyVariant',
 
            # from exceptions
            'DBusException',
@@ -87,7 +88,8 @@ from _dbus_bindings import (
     validate_object_path)
 from _dbus_bindings import (
     BUS_DAEMON_IFACE, BUS_DAEMON_NAME, BUS_DAEMON_PATH, INTROSPECTABLE_IFACE,
-    LOCAL_IFACE, LOCAL_PATH, PEER_IFACE, PROPERTIES_IFACE)
+    LOCAL_IFACE, LOCAL_PATH, OBJECT_MANAGER_IFACE, PEER_IFACE,
+    PROPERTIES_IFACE)
 
 from dbus.exceptions import (
     DBusException, IntrospectionParserException, MissingErrorHandlerException,
@@ -95,7 +97,8 @@ from dbus.exceptions import (
     ValidationException)
 from _dbus_bindings import (
     Array, Boolean, Byte, ByteArray, Dictionary, Double, Int16, Int32, Int64,
-    ObjectPath, Signature, String, Struct, UInt16, UInt32, UInt64)
+    LazyVariant, ObjectPath, Signature, String, Struct, UInt16, UInt32,
+    UInt64)
 
 if is_py2:
     from _dbus_bindings import UTF8String
@@ -184,7 +184,8 @@ class BusConnection(Connection):
             return bus_name
 
     def get_object(self, bus_name, object_path, introspect=True,
-                   follow_name_owner_changes=False, **kwargs):
+                   follow_name_owner_changes=False, cache_properties=False,
+                   **kwargs):
         """Return a local proxy for the given remote object.
 
         Method calls on the proxy are translated into method calls on the
@@ -215,6 +216,12 @@ class BusConnection(Connection):
                 If the given object path is a unique name, this parameter
                 has no effect.
 
+            `cache_properties` : bool
+                If true (default is false), keep a local copy of the remote
+                object's properties; see `dbus.proxies.ProxyObject`.
+
+                :Since: 1.2.1
+
         :Returns: a `dbus.proxies.ProxyObject`
         :Raises `DBusException`: if resolving the well-known name to a
             unique name fails
@@ -236,9 +243,13 @@ class BusConnection(Connection):
             raise TypeError('get_object does not take these keyword '
                             'arguments: %s' % ', '.join(kwargs.keys()))
 
+        if cache_properties:
+            # only passed if used, for the sake of ProxyObject subclasses
+            kwargs['cache_properties'] = True
         return self.ProxyObjectClass(self, bus_name, object_path,
                                      introspect=introspect,
-                                     follow_name_owner_changes=follow_name_owner_changes)
+                                     follow_name_owner_changes=follow_name_owner_changes,
+                                     **kwargs)
 
     def get_unix_user(self, bus_name):
         """Get the numeric uid of the process owning the given bus name.
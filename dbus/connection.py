@@ -23,9 +23,11 @@
 __all__ = ('Connection', 'SignalMatch')
 __docformat__ = 'reStructuredText'
 
+import itertools
 import logging
 import threading
 import weakref
+from operator import attrgetter, itemgetter
 
 from _dbus_bindings import (
     Connection as _Connection, LOCAL_IFACE, LOCAL_PATH, validate_bus_name,
@@ -35,12 +37,7 @@ from dbus.lowlevel import (
     ErrorMessage, HANDLER_RESULT_NOT_YET_HANDLED, MethodCallMessage,
     MethodReturnMessage, SignalMessage)
 from dbus.proxies import ProxyObject
-from dbus._compat import is_py2, is_py3
-
-if is_py3:
-    from _dbus_bindings import String
-else:
-    from _dbus_bindings import UTF8String
+from dbus._compat import is_py2
 
 
 _logger = logging.getLogger('dbus.connection')
@@ -50,13 +47,446 @@ def _noop(*args, **kwargs):
     pass
 
 
+def _get_args_opts(byte_arrays, native, kwargs):
+    get_args_opts = dict(byte_arrays=byte_arrays)
+    if native:
+        get_args_opts['native'] = True
+    if is_py2:
+        get_args_opts['utf8_strings'] = kwargs.get('utf8_strings', False)
+    elif 'utf8_strings' in kwargs:
+        raise TypeError("unexpected keyword argument 'utf8_strings'")
+    return get_args_opts
+
+
+def _method_call_message(bus_name, object_path, dbus_interface, method,
+                         signature, args):
+    if object_path == LOCAL_PATH:
+        raise DBusException('Methods may not be called on the reserved '
+                            'path %s' % LOCAL_PATH)
+    if dbus_interface == LOCAL_IFACE:
+        raise DBusException('Methods may not be called on the reserved '
+                            'interface %s' % LOCAL_IFACE)
+    # no need to validate other args - MethodCallMessage ctor will do
+
+    message = MethodCallMessage(destination=bus_name,
+                                path=object_path,
+                                interface=dbus_interface,
+                                method=method)
+    # Add the arguments to the function
+    try:
+        message.append(signature=signature, *args)
+    except Exception as e:
+        logging.basicConfig()
+        _logger.error('Unable to set arguments %r according to '
+                      'signature %r: %s: %s',
+                      args, signature, e.__class__, e)
+        raise
+    return message
+
+
+# The default reply and error handlers for call_async(), so that leaving
+# both out can be told apart from passing None for both
+_AWAIT_REPLY = object()
+
+
+def _method_result(args_list):
+    if len(args_list) == 0:
+        return None
+    elif len(args_list) == 1:
+        return args_list[0]
+    else:
+        return tuple(args_list)
+
+
+class _MethodReply(object):
+    """The reply handler used by `Connection.call_async`.
+
+    It calls the caller's reply or error handler, and makes the returned
+    PendingCall awaitable: awaiting it gives what `call_blocking` would
+    have returned, or raises the error. The reply might come in before
+    the PendingCall is awaited, or in another thread, so the asyncio
+    future is only created when it is first awaited.
+    """
+
+    __slots__ = ('_reply_handler', '_error_handler', '_get_args_opts',
+                 '_done', '_result', '_error', '_loop', '_thread',
+                 '_future')
+
+    def __init__(self, reply_handler, error_handler, get_args_opts):
+        self._reply_handler = reply_handler
+        self._error_handler = error_handler
+        self._get_args_opts = get_args_opts
+        self._done = False
+        self._result = None
+        self._error = None
+        self._loop = None
+        self._thread = None
+        self._future = None
+
+    def __call__(self, message):
+        if isinstance(message, MethodReturnMessage):
+            args_list = message.get_args_list(**self._get_args_opts)
+            self._finish(_method_result(args_list), None)
+            self._reply_handler(*args_list)
+        else:
+            if isinstance(message, ErrorMessage):
+                error = DBusException(name=message.get_error_name(),
+                                      *message.get_args_list())
+            else:
+                error = TypeError('Unexpected type for reply message: %r'
+                                  % message)
+            self._finish(None, error)
+            self._error_handler(error)
+
+    def _finish(self, result, error):
+        self._result = result
+        self._error = error
+        self._done = True
+        future = self._future
+        if future is not None:
+            if threading.current_thread() is self._thread:
+                self._resolve()
+            else:
+                self._loop.call_soon_threadsafe(self._resolve)
+
+    def _resolve(self):
+        # Only ever called in the event loop's thread, but possibly twice
+        if self._future.done():
+            return
+        if self._error is not None:
+            self._future.set_exception(self._error)
+        else:
+            self._future.set_result(self._result)
+
+    def __await__(self):
+        if self._future is None:
+            import asyncio
+
+            self._loop = asyncio.get_event_loop()
+            self._thread = threading.current_thread()
+            try:
+                self._future = self._loop.create_future()
+            except AttributeError:
+                # AbstractEventLoop.create_future() is new in Python 3.5.2
+                self._future = asyncio.Future(loop=self._loop)
+            if self._done:
+                self._resolve()
+        return self._future.__await__()
+
+
+class _MessageArgs(object):
+    """The arguments of a signal being dispatched, extracted when first
+    needed and shared between all the matches it is offered to."""
+
+    __slots__ = ('_message', '_n_strings', '_strings', '_paths')
+
+    def __init__(self, message, n_strings):
+        self._message = message
+        self._n_strings = n_strings
+        # (number asked for, tuple from get_arg_strings) or None
+        self._strings = None
+        self._paths = None
+
+    def _fetch(self, index, object_paths):
+        n = max(self._n_strings, index + 1)
+        return (n, self._message.get_arg_strings(n,
+                                                 object_paths=object_paths))
+
+    def string(self, index):
+        """Return argument `index` if it is a string, or None."""
+        strings = self._strings
+        if strings is None or (index >= len(strings[1])
+                               and len(strings[1]) == strings[0]):
+            strings = self._strings = self._fetch(index, False)
+        if index < len(strings[1]):
+            return strings[1][index]
+        return None
+
+    def path(self, index):
+        """Return argument `index` if it is a string or object path, or
+        None."""
+        paths = self._paths
+        if paths is None or (index >= len(paths[1])
+                             and len(paths[1]) == paths[0]):
+            paths = self._paths = self._fetch(index, True)
+        if index < len(paths[1]):
+            return paths[1][index]
+        return None
+
+    def get_args_list(self, byte_arrays, utf8_strings, native):
+        """Return the arguments unpacked with the given options. The
+        message keeps the list, so each combination is only unpacked once,
+        and every caller gets the same list and argument objects.
+        """
+        if is_py2:
+            return self._message.get_args_list(byte_arrays=byte_arrays,
+                                               utf8_strings=utf8_strings,
+                                               native=native, cache=True)
+        return self._message.get_args_list(byte_arrays=byte_arrays,
+                                           native=native, cache=True)
+
+
+# Kinds of keyword a match can be indexed by, in order of preference
+_ARG = 0
+_ARG_PATH = 1
+_ARG0_NAMESPACE = 2
+
+
+def _index_key(match):
+    # Return (kind, index, value) for the keyword by which match is
+    # indexed: its lowest-numbered argN, or failing that argNpath, or
+    # arg0namespace; or None if it has none of them.
+    if match._int_args_match:
+        index = min(match._int_args_match)
+        return (_ARG, index, match._int_args_match[index])
+    if match._int_args_path:
+        index = min(match._int_args_path)
+        return (_ARG_PATH, index, match._int_args_path[index])
+    if match._arg0_namespace is not None:
+        return (_ARG0_NAMESPACE, 0, match._arg0_namespace)
+    return None
+
+
+def _path_matches(arg, value):
+    # The argNpath rule from the D-Bus specification
+    return (arg == value or (value.endswith('/') and arg.startswith(value))
+            or (arg.endswith('/') and value.startswith(arg)))
+
+
+def _path_namespace_matches(path, value):
+    # The path_namespace rule from the D-Bus specification
+    return (path == value or value == '/' or
+            (path is not None and path.startswith(value + '/')))
+
+
+def _namespace_matches(arg, value):
+    # The arg0namespace rule from the D-Bus specification
+    return arg == value or arg.startswith(value + '.')
+
+
+class _MatchBucket(object):
+    """The matches for one path, interface, member and sender, split by
+    the value of the ``arg``\ *n*, ``arg``\ *n*\ ``path`` or
+    ``arg0namespace`` keyword chosen by `_index_key`."""
+
+    __slots__ = ('unindexed', 'by_arg')
+
+    def __init__(self):
+        self.unindexed = []
+        # tuple of (kind, index, {value: [SignalMatch]}); replaced rather
+        # than modified, so that dispatch can iterate over it without the
+        # lock
+        self.by_arg = ()
+
+    def __bool__(self):
+        return bool(self.unindexed or self.by_arg)
+
+    __nonzero__ = __bool__
+
+    def extend_matches(self, found, args):
+        """Append to `found` the matches whose indexed keyword accepts
+        the `_MessageArgs`, and the unindexed ones."""
+        found.extend(self.unindexed)
+        for kind, index, by_value in self.by_arg:
+            if kind == _ARG:
+                value = args.string(index)
+                if value is not None:
+                    matches = by_value.get(value)
+                    if matches:
+                        found.extend(matches)
+            elif kind == _ARG_PATH:
+                value = args.path(index)
+                if value is None:
+                    continue
+                # the value itself and its prefixes ending with '/'...
+                i = value.find('/')
+                while i >= 0:
+                    matches = by_value.get(value[:i + 1])
+                    if matches:
+                        found.extend(matches)
+                    i = value.find('/', i + 1)
+                if not value.endswith('/'):
+                    matches = by_value.get(value)
+                    if matches:
+                        found.extend(matches)
+                else:
+                    # ...and, for a value ending with '/', the keys it is
+                    # a prefix of
+                    for key, matches in list(by_value.items()):
+                        if len(key) > len(value) and key.startswith(value):
+                            found.extend(matches)
+            else:
+                value = args.string(0)
+                if value is None:
+                    continue
+                # the value itself and the namespaces containing it
+                i = value.find('.')
+                while i >= 0:
+                    matches = by_value.get(value[:i])
+                    if matches:
+                        found.extend(matches)
+                    i = value.find('.', i + 1)
+                matches = by_value.get(value)
+                if matches:
+                    found.extend(matches)
+
+
+class _SignalMatchTree(object):
+    """SignalMatch objects indexed by path, interface, member, sender and
+    the value of one ``arg``\ *n*, ``arg``\ *n*\ ``path`` or
+    ``arg0namespace`` keyword, so that a signal is only offered to
+    matches which could accept it.
+
+    Modifications must be made with the connection's signals lock held;
+    lookups need not be.
+    """
+
+    def __init__(self):
+        self._by_rule = {}
+        """Map from (path, interface, member) to dict mapping sender's
+        unique name to _MatchBucket."""
+
+        self._serials = itertools.count()
+
+        self.n_arg_strings = 0
+        """How many arguments the matches added so far might check."""
+
+    def add(self, match):
+        match._serial = next(self._serials)
+        for indexed in (match._int_args_match, match._int_args_path):
+            if indexed:
+                self.n_arg_strings = max(self.n_arg_strings,
+                                         max(indexed) + 1)
+        if match._arg0_namespace is not None:
+            self.n_arg_strings = max(self.n_arg_strings, 1)
+        self._insert(match)
+
+    def _insert(self, match):
+        by_sender = self._by_rule.setdefault(
+                (match._path, match._interface, match._member), {})
+        bucket = by_sender.get(match._sender_name_owner)
+        if bucket is None:
+            bucket = by_sender[match._sender_name_owner] = _MatchBucket()
+
+        key = _index_key(match)
+        if key is None:
+            bucket.unindexed.append(match)
+            return
+
+        (kind, index, value) = key
+        for k, i, by_value in bucket.by_arg:
+            if (k, i) == (kind, index):
+                by_value.setdefault(value, []).append(match)
+                return
+        bucket.by_arg = tuple(sorted(bucket.by_arg + ((kind, index,
+                                                       {value: [match]}),),
+                                     key=_bucket_entry_key))
+
+    def remove(self, match):
+        rule = (match._path, match._interface, match._member)
+        by_sender = self._by_rule.get(rule)
+        if by_sender is None:
+            return
+        bucket = by_sender.get(match._sender_name_owner)
+        if bucket is None:
+            return
+
+        key = _index_key(match)
+        if key is None:
+            if match in bucket.unindexed:
+                bucket.unindexed.remove(match)
+        else:
+            (kind, index, value) = key
+            for k, i, by_value in bucket.by_arg:
+                if (k, i) != (kind, index):
+                    continue
+                matches = by_value.get(value, ())
+                if match in matches:
+                    matches.remove(match)
+                    if not matches:
+                        del by_value[value]
+                    if not by_value:
+                        bucket.by_arg = tuple([entry
+                                               for entry in bucket.by_arg
+                                               if entry[:2] != (kind,
+                                                                index)])
+                break
+
+        if not bucket:
+            del by_sender[match._sender_name_owner]
+            if not by_sender:
+                del self._by_rule[rule]
+
+    def set_sender_name_owner(self, match, new_name):
+        """Change the unique name by which `match` is indexed."""
+        present = match in self.get_rule_matches(match._path,
+                                                 match._interface,
+                                                 match._member)
+        if present:
+            self.remove(match)
+        match._sender_name_owner = new_name
+        if present:
+            self._insert(match)
+
+    def get_rule_matches(self, path, dbus_interface, member):
+        """Return the matches added for exactly this path, interface and
+        member, in the order they were added."""
+        found = []
+        by_sender = self._by_rule.get((path, dbus_interface, member))
+        if by_sender is not None:
+            for bucket in by_sender.values():
+                found.extend(bucket.unindexed)
+                for kind, index, by_value in bucket.by_arg:
+                    for matches in by_value.values():
+                        found.extend(matches)
+        found.sort(key=_match_serial)
+        return found
+
+    def get_matches(self, path, dbus_interface, member, sender, args):
+        """Return the matches which might accept a signal with the given
+        header fields and `_MessageArgs`, in the order they were added.
+        Only the sender and one argument keyword have been checked.
+        """
+        found = []
+        by_rule = self._by_rule
+        if not by_rule:
+            return found
+
+        paths = (None,) if path is None else (None, path)
+        interfaces = (None,) if dbus_interface is None else (None,
+                                                            dbus_interface)
+        members = (None,) if member is None else (None, member)
+        senders = (None,) if sender is None else (None, sender)
+
+        for p in paths:
+            for i in interfaces:
+                for m in members:
+                    by_sender = by_rule.get((p, i, m))
+                    if by_sender is None:
+                        continue
+                    for s in senders:
+                        bucket = by_sender.get(s)
+                        if bucket is not None:
+                            bucket.extend_matches(found, args)
+
+        if len(found) > 1:
+            found.sort(key=_match_serial)
+        return found
+
+
+_match_serial = attrgetter('_serial')
+_bucket_entry_key = itemgetter(0, 1)
+
+
 class SignalMatch(object):
     _slots = ['_sender_name_owner', '_member', '_interface', '_sender',
               '_path', '_handler', '_args_match', '_rule',
-              '_byte_arrays', '_conn_weakref',
+              '_byte_arrays', '_native', '_conn_weakref',
               '_destination_keyword', '_interface_keyword',
               '_message_keyword', '_member_keyword',
-              '_sender_keyword', '_path_keyword', '_int_args_match']
+              '_sender_keyword', '_path_keyword', '_int_args_match',
+              '_int_args_path', '_arg0_namespace', '_path_namespace',
+              '_serial']
     if is_py2:
         _slots.append('_utf8_strings')
 
@@ -67,7 +497,7 @@ class SignalMatch(object):
                  sender_keyword=None, path_keyword=None,
                  interface_keyword=None, member_keyword=None,
                  message_keyword=None, destination_keyword=None,
-                 **kwargs):
+                 native=None, **kwargs):
         if member is not None:
             validate_member_name(member)
         if dbus_interface is not None:
@@ -78,6 +508,7 @@ class SignalMatch(object):
             validate_object_path(object_path)
 
         self._rule = None
+        self._serial = 0
         self._conn_weakref = weakref.ref(conn)
         self._sender = sender
         self._interface = dbus_interface
@@ -95,6 +526,8 @@ class SignalMatch(object):
             raise TypeError("unexpected keyword argument 'utf8_strings'")
 
         self._byte_arrays = byte_arrays
+        # None means the connection's native_args, looked up each time
+        self._native = native
         self._sender_keyword = sender_keyword
         self._path_keyword = path_keyword
         self._member_keyword = member_keyword
@@ -103,22 +536,40 @@ class SignalMatch(object):
         self._destination_keyword = destination_keyword
 
         self._args_match = kwargs
-        if not kwargs:
-            self._int_args_match = None
-        else:
-            self._int_args_match = {}
-            for kwarg in kwargs:
-                if not kwarg.startswith('arg'):
-                    raise TypeError('SignalMatch: unknown keyword argument %s'
-                                    % kwarg)
-                try:
-                    index = int(kwarg[3:])
-                except ValueError:
-                    raise TypeError('SignalMatch: unknown keyword argument %s'
-                                    % kwarg)
-                if index < 0 or index > 63:
-                    raise TypeError('SignalMatch: arg match index must be in '
-                                    'range(64), not %d' % index)
+        self._int_args_match = None
+        self._int_args_path = None
+        self._arg0_namespace = kwargs.get('arg0namespace')
+        self._path_namespace = kwargs.get('path_namespace')
+        if self._path_namespace is not None:
+            if object_path is not None:
+                raise TypeError('SignalMatch: path and path_namespace cannot '
+                                'both be specified')
+            validate_object_path(self._path_namespace)
+        for kwarg in kwargs:
+            if kwarg in ('arg0namespace', 'path_namespace'):
+                continue
+            if not kwarg.startswith('arg'):
+                raise TypeError('SignalMatch: unknown keyword argument %s'
+                                % kwarg)
+            if kwarg.endswith('path'):
+                index = kwarg[3:-4]
+            else:
+                index = kwarg[3:]
+            try:
+                index = int(index)
+            except ValueError:
+                raise TypeError('SignalMatch: unknown keyword argument %s'
+                                % kwarg)
+            if index < 0 or index > 63:
+                raise TypeError('SignalMatch: arg match index must be in '
+                                'range(64), not %d' % index)
+            if kwarg.endswith('path'):
+                if self._int_args_path is None:
+                    self._int_args_path = {}
+                self._int_args_path[index] = kwargs[kwarg]
+            else:
+                if self._int_args_match is None:
+                    self._int_args_match = {}
                 self._int_args_match[index] = kwargs[kwarg]
 
     def __hash__(self):
@@ -142,6 +593,8 @@ class SignalMatch(object):
                 rule.append("sender='%s'" % self._sender)
             if self._path is not None:
                 rule.append("path='%s'" % self._path)
+            if self._path_namespace is not None:
+                rule.append("path_namespace='%s'" % self._path_namespace)
             if self._interface is not None:
                 rule.append("interface='%s'" % self._interface)
             if self._member is not None:
@@ -149,6 +602,11 @@ class SignalMatch(object):
             if self._int_args_match is not None:
                 for index, value in self._int_args_match.items():
                     rule.append("arg%d='%s'" % (index, value))
+            if self._int_args_path is not None:
+                for index, value in self._int_args_path.items():
+                    rule.append("arg%dpath='%s'" % (index, value))
+            if self._arg0_namespace is not None:
+                rule.append("arg0namespace='%s'" % self._arg0_namespace)
 
             self._rule = ','.join(rule)
 
@@ -159,7 +617,11 @@ class SignalMatch(object):
                 % (self.__class__, id(self), self._rule, self._conn_weakref()))
 
     def set_sender_name_owner(self, new_name):
-        self._sender_name_owner = new_name
+        conn = self._conn_weakref()
+        if conn is None:
+            self._sender_name_owner = new_name
+        else:
+            conn._set_signal_match_owner(self, new_name)
 
     def matches_removal_spec(self, sender, object_path,
                              dbus_interface, member, handler, **kwargs):
@@ -177,54 +639,62 @@ class SignalMatch(object):
             return False
         return True
 
-    def maybe_handle_message(self, message):
-        args = None
+    def maybe_handle_message(self, message, _args=None):
+        if _args is None:
+            _args = _MessageArgs(message, 0)
+        # the message keeps this, so it is only built once per dispatch
+        header = message.get_header()
 
-        # these haven't been checked yet by the match tree
-        if self._sender_name_owner not in (None, message.get_sender()):
+        # the match tree has checked these, and at most one of the args
+        if self._sender_name_owner not in (None, header.sender):
             return False
         if self._int_args_match is not None:
-            # extracting args with utf8_strings and byte_arrays is less work
-            kwargs = dict(byte_arrays=True)
-            arg_type = (String if is_py3 else UTF8String)
-            if is_py2:
-                kwargs['utf8_strings'] = True
-            args = message.get_args_list(**kwargs)
             for index, value in self._int_args_match.items():
-                if (index >= len(args)
-                    or not isinstance(args[index], arg_type)
-                    or args[index] != value):
+                arg = _args.string(index)
+                if arg is None or arg != value:
                     return False
+        if self._int_args_path is not None:
+            for index, value in self._int_args_path.items():
+                arg = _args.path(index)
+                if arg is None or not _path_matches(arg, value):
+                    return False
+        if self._arg0_namespace is not None:
+            arg = _args.string(0)
+            if arg is None or not _namespace_matches(arg,
+                                                     self._arg0_namespace):
+                return False
 
         # these have likely already been checked by the match tree
-        if self._member not in (None, message.get_member()):
+        if self._member not in (None, header.member):
+            return False
+        if self._interface not in (None, header.interface):
             return False
-        if self._interface not in (None, message.get_interface()):
+        if self._path not in (None, header.path):
             return False
-        if self._path not in (None, message.get_path()):
+        if (self._path_namespace is not None and
+            not _path_namespace_matches(header.path, self._path_namespace)):
             return False
 
         try:
-            # minor optimization: if we already extracted the args with the
-            # right calling convention to do the args match, don't bother
-            # doing so again
-            utf8_strings = (is_py2 and self._utf8_strings)
-            if args is None or not utf8_strings or not self._byte_arrays:
-                kwargs = dict(byte_arrays=self._byte_arrays)
-                if is_py2:
-                    kwargs['utf8_strings'] = self._utf8_strings
-                args = message.get_args_list(**kwargs)
+            # the args are shared with other matches for this message
+            native = self._native
+            if native is None:
+                conn = self._conn_weakref()
+                native = getattr(conn, 'native_args', False)
+            args = _args.get_args_list(self._byte_arrays,
+                                       is_py2 and self._utf8_strings,
+                                       bool(native))
             kwargs = {}
             if self._sender_keyword is not None:
-                kwargs[self._sender_keyword] = message.get_sender()
+                kwargs[self._sender_keyword] = header.sender
             if self._destination_keyword is not None:
-                kwargs[self._destination_keyword] = message.get_destination()
+                kwargs[self._destination_keyword] = header.destination
             if self._path_keyword is not None:
-                kwargs[self._path_keyword] = message.get_path()
+                kwargs[self._path_keyword] = header.path
             if self._member_keyword is not None:
-                kwargs[self._member_keyword] = message.get_member()
+                kwargs[self._member_keyword] = header.member
             if self._interface_keyword is not None:
-                kwargs[self._interface_keyword] = message.get_interface()
+                kwargs[self._interface_keyword] = header.interface
             if self._message_keyword is not None:
                 kwargs[self._message_keyword] = message
             self._handler(*args, **kwargs)
@@ -264,9 +734,8 @@ class Connection(_Connection):
 
             self.__call_on_disconnection = []
 
-            self._signal_recipients_by_object_path = {}
-            """Map from object path to dict mapping dbus_interface to dict
-            mapping member to list of SignalMatch objects."""
+            self._signal_match_tree = _SignalMatchTree()
+            """Index of SignalMatch objects."""
 
             self._signals_lock = threading.Lock()
             """Lock used to protect signal data structures"""
@@ -290,7 +759,7 @@ class Connection(_Connection):
         return bus_name
 
     def get_object(self, bus_name=None, object_path=None, introspect=True,
-                   **kwargs):
+                   cache_properties=False, **kwargs):
         """Return a local proxy for the given remote object.
 
         Method calls on the proxy are translated into method calls on the
@@ -306,6 +775,11 @@ class Connection(_Connection):
             `introspect` : bool
                 If true (default), attempt to introspect the remote
                 object to find out supported methods and their signatures
+            `cache_properties` : bool
+                If true (default is false), keep a local copy of the remote
+                object's properties; see `dbus.proxies.ProxyObject`.
+
+                :Since: 1.2.1
 
         :Returns: a `dbus.proxies.ProxyObject`
         """
@@ -323,8 +797,11 @@ class Connection(_Connection):
             raise TypeError('get_object does not take these keyword '
                             'arguments: %s' % ', '.join(kwargs.keys()))
 
+        if cache_properties:
+            # only passed if used, for the sake of ProxyObject subclasses
+            kwargs['cache_properties'] = True
         return self.ProxyObjectClass(self, bus_name, object_path,
-                                     introspect=introspect)
+                                     introspect=introspect, **kwargs)
 
     def add_signal_receiver(self, handler_function,
                                   signal_name=None,
@@ -335,6 +812,13 @@ class Connection(_Connection):
         """Arrange for the given function to be called when a signal matching
         the parameters is received.
 
+        Each signal is only unpacked once for all the receivers which use
+        the same `utf8_strings`, `byte_arrays` and `native` options, so
+        they are given the same argument objects. A handler must not
+        modify a `dbus.Array`, `dbus.Dictionary` or other mutable argument
+        in place, since receivers called after it would see the change;
+        it should modify a copy instead.
+
         :Parameters:
             `handler_function` : callable
                 The function to be called. Its positional arguments will
@@ -366,6 +850,13 @@ class Connection(_Connection):
                 If False (default) it will receive any byte-array
                 arguments as a dbus.Array of dbus.Byte (subclasses of:
                 a list of ints).
+            `native` : bool or None
+                If True, the handler function will receive builtin Python
+                types, as from ``get_args_list(native=True)``, rather than
+                dbus.types objects. If None (default), use the connection's
+                `native_args` at the time each signal arrives.
+
+                :Since: 1.2.1
             `sender_keyword` : str
                 If not None (the default), the handler function will receive
                 the unique name of the sending endpoint as a keyword
@@ -394,6 +885,22 @@ class Connection(_Connection):
                 is the value given for that keyword parameter. As of this
                 time only string arguments can be matched (in particular,
                 object paths and signatures can't).
+
+                With ``arg``\ *n*\ ``path``, the *n*\ th argument may also
+                be an object path, and matches if it is equal to the value,
+                or if one of them ends with '/' and is a prefix of the
+                other. With ``arg0namespace``, the first argument matches
+                if it is the value, or a name in the namespace it names
+                (``com.example.Foo`` is in the ``com.example`` namespace).
+
+                :Since: 1.2.1 (``arg``\ *n*\ ``path`` and ``arg0namespace``)
+            `path_namespace` : str
+                If not None, match only signals emitted by the object with
+                this path or by objects below it. It cannot be combined
+                with `path`; on a bus, the bus daemon must be D-Bus 1.5.0
+                or later.
+
+                :Since: 1.2.1
             `named_service` : str
                 A deprecated alias for `bus_name`.
         """
@@ -415,45 +922,18 @@ class Connection(_Connection):
 
         self._signals_lock.acquire()
         try:
-            by_interface = self._signal_recipients_by_object_path.setdefault(
-                    path, {})
-            by_member = by_interface.setdefault(dbus_interface, {})
-            matches = by_member.setdefault(signal_name, [])
-
-            matches.append(match)
+            self._signal_match_tree.add(match)
         finally:
             self._signals_lock.release()
 
         return match
 
-    def _iter_easy_matches(self, path, dbus_interface, member):
-        if path is not None:
-            path_keys = (None, path)
-        else:
-            path_keys = (None,)
-        if dbus_interface is not None:
-            interface_keys = (None, dbus_interface)
-        else:
-            interface_keys = (None,)
-        if member is not None:
-            member_keys = (None, member)
-        else:
-            member_keys = (None,)
-
-        for path in path_keys:
-            by_interface = self._signal_recipients_by_object_path.get(path)
-            if by_interface is None:
-                continue
-            for dbus_interface in interface_keys:
-                by_member = by_interface.get(dbus_interface, None)
-                if by_member is None:
-                    continue
-                for member in member_keys:
-                    matches = by_member.get(member, None)
-                    if matches is None:
-                        continue
-                    for m in matches:
-                        yield m
+    def _set_signal_match_owner(self, match, new_name):
+        self._signals_lock.acquire()
+        try:
+            self._signal_match_tree.set_sender_name_owner(match, new_name)
+        finally:
+            self._signals_lock.release()
 
     def remove_signal_receiver(self, handler_or_match,
                                signal_name=None,
@@ -473,22 +953,12 @@ class Connection(_Connection):
                  'positional parameters',
                  DeprecationWarning, stacklevel=2)
 
-        new = []
         deletions = []
         self._signals_lock.acquire()
         try:
-            by_interface = self._signal_recipients_by_object_path.get(path,
-                                                                      None)
-            if by_interface is None:
-                return
-            by_member = by_interface.get(dbus_interface, None)
-            if by_member is None:
-                return
-            matches = by_member.get(signal_name, None)
-            if matches is None:
-                return
-
-            for match in matches:
+            tree = self._signal_match_tree
+            for match in tree.get_rule_matches(path, dbus_interface,
+                                               signal_name):
                 if (handler_or_match is match
                     or match.matches_removal_spec(bus_name,
                                                   path,
@@ -497,17 +967,7 @@ class Connection(_Connection):
                                                   handler_or_match,
                                                   **keywords)):
                     deletions.append(match)
-                else:
-                    new.append(match)
-
-            if new:
-                by_member[signal_name] = new
-            else:
-                del by_member[signal_name]
-                if not by_member:
-                    del by_interface[dbus_interface]
-                    if not by_interface:
-                        del self._signal_recipients_by_object_path[path]
+                    tree.remove(match)
         finally:
             self._signals_lock.release()
 
@@ -526,13 +986,16 @@ class Connection(_Connection):
         if not isinstance(message, SignalMessage):
             return HANDLER_RESULT_NOT_YET_HANDLED
 
-        dbus_interface = message.get_interface()
-        path = message.get_path()
-        signal_name = message.get_member()
+        header = message.get_header()
+        dbus_interface = header.interface
+        path = header.path
+        signal_name = header.member
 
-        for match in self._iter_easy_matches(path, dbus_interface,
-                                             signal_name):
-            match.maybe_handle_message(message)
+        tree = self._signal_match_tree
+        args = _MessageArgs(message, tree.n_arg_strings)
+        for match in tree.get_matches(path, dbus_interface, signal_name,
+                                      header.sender, args):
+            match.maybe_handle_message(message, args)
 
         if (dbus_interface == LOCAL_IFACE and
             path == LOCAL_PATH and
@@ -549,113 +1012,108 @@ class Connection(_Connection):
         return HANDLER_RESULT_NOT_YET_HANDLED
 
     def call_async(self, bus_name, object_path, dbus_interface, method,
-                   signature, args, reply_handler, error_handler,
-                   timeout=-1.0, byte_arrays=False,
-                   require_main_loop=True, **kwargs):
+                   signature, args, reply_handler=_AWAIT_REPLY,
+                   error_handler=_AWAIT_REPLY, timeout=-1.0,
+                   byte_arrays=False, require_main_loop=True, native=None,
+                   **kwargs):
         """Call the given method, asynchronously.
 
         If the reply_handler is None, successful replies will be ignored.
         If the error_handler is None, failures will be ignored. If both
         are None, the implementation may request that no reply is sent.
 
-        :Returns: The dbus.lowlevel.PendingCall.
+        The returned PendingCall can be awaited in an asyncio coroutine,
+        giving the same result as `call_blocking`, or raising the error;
+        typically both handlers are then left out. The reply is delivered
+        to the coroutine's event loop from whichever thread the
+        connection's main loop runs in, although using a
+        `dbus.mainloop.asyncio.DBusAsyncioMainLoop` avoids that hop.
+        Cancelling the coroutine does not cancel the call.
+
+        If `native` is true, or None (the default) and this connection's
+        `native_args` is true, the reply's arguments are builtin Python
+        types rather than dbus.types objects; the same applies to
+        `call_blocking` and `call_many`.
+
+        :Returns: The dbus.lowlevel.PendingCall, or None if both handlers
+            are None.
         :Since: 0.81.0
         """
-        if object_path == LOCAL_PATH:
-            raise DBusException('Methods may not be called on the reserved '
-                                'path %s' % LOCAL_PATH)
-        if dbus_interface == LOCAL_IFACE:
-            raise DBusException('Methods may not be called on the reserved '
-                                'interface %s' % LOCAL_IFACE)
-        # no need to validate other args - MethodCallMessage ctor will do
-
-        get_args_opts = dict(byte_arrays=byte_arrays)
-        if is_py2:
-            get_args_opts['utf8_strings'] = kwargs.get('utf8_strings', False)
-        elif 'utf8_strings' in kwargs:
-            raise TypeError("unexpected keyword argument 'utf8_strings'")
-
-        message = MethodCallMessage(destination=bus_name,
-                                    path=object_path,
-                                    interface=dbus_interface,
-                                    method=method)
-        # Add the arguments to the function
-        try:
-            message.append(signature=signature, *args)
-        except Exception as e:
-            logging.basicConfig()
-            _logger.error('Unable to set arguments %r according to '
-                          'signature %r: %s: %s',
-                          args, signature, e.__class__, e)
-            raise
+        get_args_opts = _get_args_opts(
+            byte_arrays, self.native_args if native is None else native,
+            kwargs)
+        message = _method_call_message(bus_name, object_path, dbus_interface,
+                                       method, signature, args)
 
         if reply_handler is None and error_handler is None:
             # we don't care what happens, so just send it
             self.send_message(message)
             return
 
-        if reply_handler is None:
+        if reply_handler is None or reply_handler is _AWAIT_REPLY:
             reply_handler = _noop
-        if error_handler is None:
+        if error_handler is None or error_handler is _AWAIT_REPLY:
             error_handler = _noop
 
-        def msg_reply_handler(message):
-            if isinstance(message, MethodReturnMessage):
-                reply_handler(*message.get_args_list(**get_args_opts))
-            elif isinstance(message, ErrorMessage):
-                error_handler(DBusException(name=message.get_error_name(),
-                                            *message.get_args_list()))
-            else:
-                error_handler(TypeError('Unexpected type for reply '
-                                        'message: %r' % message))
-        return self.send_message_with_reply(message, msg_reply_handler,
-                                        timeout,
-                                        require_main_loop=require_main_loop)
+        return self.send_message_with_reply(message,
+                _MethodReply(reply_handler, error_handler, get_args_opts),
+                timeout, require_main_loop=require_main_loop)
 
     def call_blocking(self, bus_name, object_path, dbus_interface, method,
                       signature, args, timeout=-1.0,
-                      byte_arrays=False, **kwargs):
+                      byte_arrays=False, native=None, **kwargs):
         """Call the given method, synchronously.
         :Since: 0.81.0
         """
-        if object_path == LOCAL_PATH:
-            raise DBusException('Methods may not be called on the reserved '
-                                'path %s' % LOCAL_PATH)
-        if dbus_interface == LOCAL_IFACE:
-            raise DBusException('Methods may not be called on the reserved '
-                                'interface %s' % LOCAL_IFACE)
-        # no need to validate other args - MethodCallMessage ctor will do
-
-        get_args_opts = dict(byte_arrays=byte_arrays)
-        if is_py2:
-            get_args_opts['utf8_strings'] = kwargs.get('utf8_strings', False)
-        elif 'utf8_strings' in kwargs:
-            raise TypeError("unexpected keyword argument 'utf8_strings'")
-
-        message = MethodCallMessage(destination=bus_name,
-                                    path=object_path,
-                                    interface=dbus_interface,
-                                    method=method)
-        # Add the arguments to the function
-        try:
-            message.append(signature=signature, *args)
-        except Exception as e:
-            logging.basicConfig()
-            _logger.error('Unable to set arguments %r according to '
-                          'signature %r: %s: %s',
-                          args, signature, e.__class__, e)
-            raise
+        get_args_opts = _get_args_opts(
+            byte_arrays, self.native_args if native is None else native,
+            kwargs)
+        message = _method_call_message(bus_name, object_path, dbus_interface,
+                                       method, signature, args)
 
         # make a blocking call
         reply_message = self.send_message_with_reply_and_block(
             message, timeout)
-        args_list = reply_message.get_args_list(**get_args_opts)
-        if len(args_list) == 0:
-            return None
-        elif len(args_list) == 1:
-            return args_list[0]
-        else:
-            return tuple(args_list)
+        return _method_result(reply_message.get_args_list(**get_args_opts))
+
+    def call_many(self, calls, timeout=-1.0, byte_arrays=False, native=None,
+                  **kwargs):
+        """Call several methods synchronously, sending every call before
+        waiting for any reply, so that they take about one round trip
+        in total rather than one each.
+
+        Like `call_blocking`, this does not need or re-enter a main loop.
+
+        :Parameters:
+            `calls` : iterable
+                Tuples of (bus_name, object_path, dbus_interface, method,
+                signature, args), as passed to `call_blocking`
+            `timeout` : float
+                How long to wait for each reply, in seconds; since the
+                calls are made concurrently, this also bounds the total
+                time. If negative (default), libdbus' default is used.
+            `byte_arrays`, `native` : bool
+                As for `call_blocking`
+        :Returns: A list with one item per call, in order: what
+            `call_blocking` would have returned, or the
+            `dbus.exceptions.DBusException` it would have raised
+        :Since: 1.2.1
+        """
+        get_args_opts = _get_args_opts(
+            byte_arrays, self.native_args if native is None else native,
+            kwargs)
+        messages = [_method_call_message(*call) for call in calls]
+
+        results = []
+        for reply in self.send_messages_with_reply_and_block(messages,
+                                                             timeout):
+            if isinstance(reply, ErrorMessage):
+                results.append(DBusException(name=reply.get_error_name(),
+                                             *reply.get_args_list()))
+            else:
+                results.append(
+                        _method_result(reply.get_args_list(**get_args_opts)))
+        return results
 
     def call_on_disconnection(self, callable):
         """Arrange for `callable` to be called with one argument (this
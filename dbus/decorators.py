@@ -28,10 +28,16 @@
 __all__ = ('method', 'signal')
 __docformat__ = 'restructuredtext'
 
-import inspect
+try:
+    from inspect import getfullargspec as _getargspec
+except ImportError:
+    from inspect import getargspec as _getargspec
 
 from dbus import validate_interface_name, Signature, validate_member_name
 from dbus.lowlevel import SignalMessage
+from dbus.types import (
+    Array, Boolean, Byte, Dictionary, Double, Int16, Int32, Int64,
+    ObjectPath, String, Struct, UInt16, UInt32, UInt64, UnixFd)
 from dbus.exceptions import DBusException
 from dbus._compat import is_py2
 
@@ -41,7 +47,7 @@ def method(dbus_interface, in_signature=None, out_signature=None,
            sender_keyword=None, path_keyword=None, destination_keyword=None,
            message_keyword=None, connection_keyword=None,
            byte_arrays=False,
-           rel_path_keyword=None, **kwargs):
+           rel_path_keyword=None, native=None, **kwargs):
     """Factory for decorators used to mark methods of a `dbus.service.Object`
     to be exported on the D-Bus.
 
@@ -151,11 +157,21 @@ def method(dbus_interface, in_signature=None, out_signature=None,
             consistent.
 
             :Since: 0.80.0
+
+        `native` : bool or None
+            If True, the decorated method will receive builtin Python
+            types (int, str, list, dict and so on), as from
+            ``Message.get_args_list(native=True)``, rather than dbus.types
+            objects, which is much faster for large arguments. If None
+            (default), use the `native_args` of the connection the call
+            arrives on.
+
+            :Since: 1.2.1
     """
     validate_interface_name(dbus_interface)
 
     def decorator(func):
-        args = inspect.getargspec(func)[0]
+        args = _getargspec(func)[0]
         args.pop(0)
 
         if async_callbacks:
@@ -200,6 +216,8 @@ def method(dbus_interface, in_signature=None, out_signature=None,
         func._dbus_connection_keyword = connection_keyword
         func._dbus_args = args
         func._dbus_get_args_options = dict(byte_arrays=byte_arrays)
+        if native is not None:
+            func._dbus_get_args_options['native'] = bool(native)
         if is_py2:
             func._dbus_get_args_options['utf8_strings'] = kwargs.get(
                 'utf8_strings', False)
@@ -297,26 +315,48 @@ def signal(dbus_interface, signature=None, path_keyword=None,
 
             func(self, *args, **keywords)
 
+            # The arguments are marshalled once; every other location gets
+            # a copy of that message with its own path.
+            template = None
+            # [(connection, [message, ...])], in the order of locations
+            batches = []
+            by_connection = {}
             for location in self.locations:
                 if abs_path is None:
                     # non-deprecated case
                     if rel_path is None or rel_path in ('/', ''):
                         object_path = location[1]
                     else:
-                        # will be validated by SignalMessage ctor in a moment
+                        # will be validated by SignalMessage ctor or
+                        # copy_with_header in a moment
                         object_path = location[1] + rel_path
                 else:
                     object_path = abs_path
 
-                message = SignalMessage(object_path,
-                                                       dbus_interface,
-                                                       member_name)
-                message.append(signature=signature, *args)
+                if template is None:
+                    template = SignalMessage(object_path, dbus_interface,
+                                             member_name)
+                    template.append(signature=signature, *args)
+                    message = template
+                elif object_path == template.get_path():
+                    message = template.copy()
+                else:
+                    message = template.copy_with_header(path=object_path)
 
-                location[0].send_message(message)
+                messages = by_connection.get(location[0])
+                if messages is None:
+                    messages = by_connection[location[0]] = []
+                    batches.append((location[0], messages))
+                messages.append(message)
+
+            for connection, messages in batches:
+                if len(messages) == 1:
+                    connection.send_message(messages[0])
+                else:
+                    connection.send_messages(messages)
         # end emit_signal
 
-        args = inspect.getargspec(func)[0]
+        args = _getargspec(func)[0]
         args.pop(0)
 
         for keyword in rel_path_keyword, path_keyword:
@@ -343,3 +383,127 @@ def signal(dbus_interface, signature=None, path_keyword=None,
         return emit_signal
 
     return decorator
+
+
+#: The dbus.types class for each basic type, by signature
+_BASIC_TYPES = {'y': Byte, 'b': Boolean, 'n': Int16, 'q': UInt16,
+                'i': Int32, 'u': UInt32, 'x': Int64, 't': UInt64,
+                'd': Double, 's': String, 'o': ObjectPath,
+                'g': Signature, 'h': UnixFd}
+
+
+class _Property(object):
+    """A D-Bus property of a `dbus.service.Object`, as returned by
+    `dbus.decorators.property`."""
+
+    _dbus_is_property = True
+
+    def __init__(self, dbus_interface, signature, emits_change, writable,
+                 fget, fset=None):
+        self._dbus_interface = dbus_interface
+        self._dbus_signature = signature
+        self._dbus_emits_change = emits_change
+        self._dbus_writable = writable
+        self.fget = fget
+        self.fset = fset
+        self.__name__ = fget.__name__
+        self.__doc__ = fget.__doc__
+
+    def __get__(self, obj, objtype=None):
+        if obj is None:
+            return self
+        return self.fget(obj)
+
+    def __set__(self, obj, value):
+        if self.fset is None:
+            raise AttributeError("can't set D-Bus property %s" %
+                                 self.__name__)
+        self.fset(obj, value)
+        obj._dbus_property_changed(self)
+
+    def setter(self, fset):
+        """Return a copy of this property with the given setter, which is
+        called as ``fset(object, value)``, for use as a decorator."""
+        return _Property(self._dbus_interface, self._dbus_signature,
+                         self._dbus_emits_change, self._dbus_writable,
+                         self.fget, fset)
+
+    def changed(self, obj):
+        """Report that the value of the property on the given object has
+        changed other than by assigning to it, for example because the
+        getter computes it from something else."""
+        obj._dbus_property_changed(self)
+
+    def _dbus_wrap(self, value):
+        # Return value as a dbus.types object of the property's type, so
+        # that it is marshalled with the right signature inside a variant
+        signature = self._dbus_signature
+        first = signature[0]
+        if first == 'v':
+            return value
+        if first == '(':
+            return Struct(value, signature=signature[1:-1])
+        if first == 'a':
+            if signature[1] == '{':
+                return Dictionary(value, signature=signature[2:-1])
+            return Array(value, signature=signature[1:])
+        return _BASIC_TYPES[first](value)
+
+
+def property(dbus_interface, signature, emits_change=True, writable=False):
+    """Factory for decorators used to declare D-Bus properties of a
+    `dbus.service.Object`, which are exported through the standard
+    org.freedesktop.DBus.Properties interface. The object's class must
+    also inherit from `dbus.service.PropertiesInterface`, which
+    implements it.
+
+    The decorated method is the getter, as for the builtin ``property``,
+    and a setter can be added with ``@name.setter``. Assigning to the
+    property in Python calls the setter, then arranges for
+    ``PropertiesChanged`` to be emitted: changes made while the object is
+    handling a D-Bus method call are emitted together, in one signal per
+    interface, before its reply is sent; other changes are emitted after
+    the object's ``PROPERTIES_CHANGED_DELAY`` in seconds (by default, at
+    the end of the main loop iteration), merged with any others made in
+    the meantime.
+
+    Example::
+
+        class Example(dbus.service.Object, dbus.service.PropertiesInterface):
+            @dbus.service.property('com.example.Sample', 'u', writable=True)
+            def Volume(self):
+                return self._volume
+
+            @Volume.setter
+            def Volume(self, value):
+                self._volume = value
+
+    :Parameters:
+        `dbus_interface` : str
+            The D-Bus interface of the property.
+        `signature` : str
+            The signature of the property's single complete type.
+        `emits_change` : bool or str
+            True (default) to emit the new value in ``PropertiesChanged``;
+            ``'invalidates'`` to only emit its name; ``'const'`` or False
+            to emit nothing.
+        `writable` : bool
+            If True, the property can be set over D-Bus, through its
+            setter. By default, it can only be set in Python.
+
+    :Since: 1.2.1
+    """
+    validate_interface_name(dbus_interface)
+    if len(tuple(Signature(signature))) != 1:
+        raise ValueError('property signature must be a single complete '
+                         'type: %r' % signature)
+    if emits_change not in (True, False, 'invalidates', 'const'):
+        raise ValueError("emits_change must be True, False, 'invalidates' "
+                         "or 'const'")
+
+    def decorator(func):
+        validate_member_name(func.__name__)
+        return _Property(dbus_interface, signature, emits_change, writable,
+                         func)
+
+    return decorator
@@ -22,15 +22,16 @@
 
 """Low-level interface to D-Bus."""
 
-__all__ = ('PendingCall', 'Message', 'MethodCallMessage',
+__all__ = ('PendingCall', 'Message', 'MessageHeader', 'MethodCallMessage',
            'MethodReturnMessage', 'ErrorMessage', 'SignalMessage',
            'HANDLER_RESULT_HANDLED', 'HANDLER_RESULT_NOT_YET_HANDLED',
            'MESSAGE_TYPE_INVALID', 'MESSAGE_TYPE_METHOD_CALL',
            'MESSAGE_TYPE_METHOD_RETURN', 'MESSAGE_TYPE_ERROR',
-           'MESSAGE_TYPE_SIGNAL')
+           'MESSAGE_TYPE_SIGNAL', 'get_intern_stats')
 
 from _dbus_bindings import (
     ErrorMessage, HANDLER_RESULT_HANDLED, HANDLER_RESULT_NOT_YET_HANDLED,
     MESSAGE_TYPE_ERROR, MESSAGE_TYPE_INVALID, MESSAGE_TYPE_METHOD_CALL,
-    MESSAGE_TYPE_METHOD_RETURN, MESSAGE_TYPE_SIGNAL, Message,
-    MethodCallMessage, MethodReturnMessage, PendingCall, SignalMessage)
+    MESSAGE_TYPE_METHOD_RETURN, MESSAGE_TYPE_SIGNAL, Message, MessageHeader,
+    MethodCallMessage, MethodReturnMessage, PendingCall, SignalMessage,
+    get_intern_stats)
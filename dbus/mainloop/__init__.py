@@ -28,6 +28,8 @@ import _dbus_bindings
 
 NativeMainLoop = _dbus_bindings.NativeMainLoop
 
+PythonMainLoop = _dbus_bindings.PythonMainLoop
+
 NULL_MAIN_LOOP = _dbus_bindings.NULL_MAIN_LOOP
 """A null mainloop which doesn't actually do anything.
 
@@ -36,6 +38,10 @@ certainly a bad idea - if in doubt, use the GLib main loop found in
 `dbus.mainloop.glib`.
 """
 
+get_dispatch_batch_size = _dbus_bindings.get_dispatch_batch_size
+set_dispatch_batch_size = _dbus_bindings.set_dispatch_batch_size
+get_dispatch_stats = _dbus_bindings.get_dispatch_stats
+
 WATCH_READABLE = _dbus_bindings.WATCH_READABLE
 """Represents a file descriptor becoming readable.
 Used to implement file descriptor watches."""
@@ -54,8 +60,10 @@ Used to implement file descriptor watches."""
 
 __all__ = (
            # Imported into this module
-           'NativeMainLoop', 'WATCH_READABLE', 'WATCH_WRITABLE',
+           'NativeMainLoop', 'PythonMainLoop', 'WATCH_READABLE', 'WATCH_WRITABLE',
            'WATCH_HANGUP', 'WATCH_ERROR', 'NULL_MAIN_LOOP',
+           'get_dispatch_batch_size', 'set_dispatch_batch_size',
+           'get_dispatch_stats',
 
            # Submodules
            'glib'
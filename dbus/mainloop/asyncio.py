@@ -0,0 +1,173 @@
+# Copyright (C) 2026 agent <agent@local>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+"""Main loop integration with asyncio (Python 3 only).
+
+Connections and servers set up with a `DBusAsyncioMainLoop` are driven
+by an asyncio event loop, so that method calls can be awaited in
+coroutines::
+
+    loop = DBusAsyncioMainLoop(set_as_default=True)
+    bus = dbus.SessionBus()
+    reply = await bus.call_async(..., signature, args)
+
+:Since: 1.2.1
+"""
+
+__all__ = ('DBusAsyncioMainLoop',)
+__docformat__ = 'restructuredtext'
+
+import asyncio
+
+import _dbus_bindings
+from dbus.mainloop import PythonMainLoop, WATCH_READABLE, WATCH_WRITABLE
+
+try:
+    # returns None outside a running loop; asyncio.get_running_loop(),
+    # which raises instead, is only in Python 3.7 or later
+    _get_running_loop = asyncio._get_running_loop
+except AttributeError:
+    # Python 3.5.0 to 3.5.2: always go through call_soon_threadsafe
+    def _get_running_loop():
+        return None
+
+
+class DBusAsyncioMainLoop(PythonMainLoop):
+    """A `dbus.mainloop.NativeMainLoop` that registers the file
+    descriptors of D-Bus connections and servers with an asyncio event
+    loop, using `add_reader` and `add_writer`, and their timeouts with
+    `call_later`.
+
+    Connections attached to it may be used from other threads; libdbus'
+    requests from those are passed to the event loop with
+    `call_soon_threadsafe`.
+    """
+
+    def __init__(self, loop=None, set_as_default=False):
+        """Constructor.
+
+        :Parameters:
+            `loop` : asyncio.AbstractEventLoop
+                The event loop to use. The default is the current event
+                loop, as returned by `asyncio.get_event_loop`.
+            `set_as_default` : bool
+                If true, make this the default main loop for new
+                Connection or Bus instances.
+        """
+        if loop is None:
+            loop = asyncio.get_event_loop()
+        self._loop = loop
+        # {Watch: (fd, flags)} for watches libdbus has added
+        self._watches = {}
+        # {Timeout: TimerHandle or None} for timeouts libdbus has added
+        self._timeouts = {}
+        if set_as_default:
+            _dbus_bindings.set_default_main_loop(self)
+
+    @property
+    def loop(self):
+        """The asyncio event loop in use."""
+        return self._loop
+
+    def _in_loop(self, func, *args):
+        if _get_running_loop() is self._loop:
+            func(*args)
+        else:
+            self._loop.call_soon_threadsafe(func, *args)
+
+    # Watches
+
+    def _update_watch(self, watch, added):
+        # Bring the event loop up to date with the watch's current state,
+        # which might have changed again since libdbus asked for this.
+        old_fd, old_flags = self._watches.pop(watch, (-1, 0))
+        if added is None:
+            added = old_fd >= 0
+        fd = watch.fileno() if added else -1
+        flags = (watch.flags if fd >= 0 and watch.enabled else 0)
+        if fd >= 0:
+            self._watches[watch] = (fd, flags)
+
+        for flag, add, remove in (
+                (WATCH_READABLE, self._loop.add_reader,
+                 self._loop.remove_reader),
+                (WATCH_WRITABLE, self._loop.add_writer,
+                 self._loop.remove_writer)):
+            if old_fd == fd and (old_flags & flag) == (flags & flag):
+                continue
+            if old_flags & flag:
+                remove(old_fd)
+            if flags & flag:
+                add(fd, watch.handle, flag)
+
+    def add_watch(self, watch):
+        self._in_loop(self._update_watch, watch, True)
+
+    def remove_watch(self, watch):
+        self._in_loop(self._update_watch, watch, False)
+
+    def toggle_watch(self, watch):
+        self._in_loop(self._update_watch, watch, None)
+
+    # Timeouts
+
+    def _update_timeout(self, timeout, added):
+        if added is None:
+            added = timeout in self._timeouts
+        handle = self._timeouts.pop(timeout, None)
+        if handle is not None:
+            handle.cancel()
+        if not added:
+            return
+        if timeout.enabled:
+            handle = self._loop.call_later(timeout.interval / 1000.0,
+                                           self._fire_timeout, timeout)
+        self._timeouts[timeout] = handle
+
+    def _fire_timeout(self, timeout):
+        # libdbus' timeouts repeat until they are disabled or removed
+        self._timeouts[timeout] = None
+        timeout.handle()
+        if self._timeouts.get(timeout, False) is None:
+            self._update_timeout(timeout, True)
+
+    def add_timeout(self, timeout):
+        self._in_loop(self._update_timeout, timeout, True)
+
+    def remove_timeout(self, timeout):
+        self._in_loop(self._update_timeout, timeout, False)
+
+    def toggle_timeout(self, timeout):
+        self._in_loop(self._update_timeout, timeout, None)
+
+    # Dispatching
+
+    def queue_dispatch(self, dispatcher):
+        self._in_loop(self._loop.call_soon, dispatcher)
+
+    def call_later(self, delay, callable):
+        """Call ``callable()`` from the event loop once at least `delay`
+        seconds have passed. This may be called from any thread.
+
+        :Since: 1.2.1
+        """
+        self._in_loop(self._loop.call_later, delay, callable)
@@ -24,6 +24,7 @@
 # DEALINGS IN THE SOFTWARE.
 
 import logging
+import weakref
 
 try:
     from threading import RLock
@@ -43,7 +44,7 @@ _logger = logging.getLogger('dbus.proxies')
 
 from _dbus_bindings import (
     BUS_DAEMON_IFACE, BUS_DAEMON_NAME, BUS_DAEMON_PATH, INTROSPECTABLE_IFACE,
-    LOCAL_PATH)
+    LOCAL_PATH, OBJECT_MANAGER_IFACE, PROPERTIES_IFACE)
 from dbus._compat import is_py2
 
 
@@ -117,6 +118,20 @@ class _ProxyMethod:
 
         dbus_interface = keywords.pop('dbus_interface', self._dbus_interface)
 
+        cache = getattr(self._proxy, '_property_cache', None)
+        if cache is not None and dbus_interface == PROPERTIES_IFACE:
+            if self._method_name == 'Set' and len(args) == 3:
+                cache.invalidate(args[0], args[1])
+            elif (self._method_name in ('Get', 'GetAll') and
+                  not ignore_reply and not keywords):
+                # other keywords would change how the reply is unpacked
+                if reply_handler is None:
+                    return cache.lookup(self._method_name, args)
+                (found, value) = cache.peek(self._method_name, args)
+                if found:
+                    reply_handler(value)
+                    return
+
         if signature is None:
             if dbus_interface is None:
                 key = self._method_name
@@ -169,11 +184,277 @@ class _ProxyMethod:
                                     **keywords)
 
 
+#: Errors with which services that implement Get but not GetAll reply to
+#: GetAll
+_GET_ALL_UNSUPPORTED = ('org.freedesktop.DBus.Error.UnknownMethod',
+                        'org.freedesktop.DBus.Error.NotSupported')
+
+
+class _PropertyCache(object):
+    """The local copy of a remote object's properties kept by a
+    `ProxyObject` created with ``cache_properties=True``.
+
+    The values it returns are the cached objects themselves, not copies,
+    so they must not be modified.
+    """
+
+    def __init__(self, conn, bus_name, object_path, follow_name_owner):
+        self._conn = conn
+        self._bus_name = bus_name
+        self._object_path = object_path
+        self._follow_name_owner = follow_name_owner
+        self._lock = RLock()
+        # {interface: {name: value}}, for each interface fetched so far
+        self._interfaces = {}
+        # interfaces for which GetAll is not supported, whose entries in
+        # _interfaces only have the properties fetched so far with Get
+        self._no_get_all = set()
+        # {interface: [(changed, invalidated)]} for PropertiesChanged
+        # signals received while GetAll for that interface is in progress
+        self._loading = {}
+        # incremented by refresh(), so that a GetAll in progress at the
+        # time does not fill the cache with what it replies
+        self._generation = 0
+        # the unique name last seen owning bus_name, if following it
+        self._owner = None
+        # functions to remove the signal match and name owner watch, which
+        # are made when the cache is first used, or None after close()
+        self._subscriptions = []
+
+    def _subscribe(self):
+        # Start listening for changes, if not already done. Call with the
+        # lock held. Only the connection's matches hold a reference to the
+        # callbacks, and they only have a weak reference to the cache, so
+        # that the matches are removed when the proxy is discarded.
+        if self._subscriptions is None or self._subscriptions:
+            return
+
+        subscriptions = self._subscriptions
+
+        def collected(ref):
+            for remove in subscriptions:
+                remove()
+            del subscriptions[:]
+
+        ref = weakref.ref(self, collected)
+
+        def properties_changed(interface, changed, invalidated):
+            cache = ref()
+            if cache is not None:
+                cache._properties_changed(interface, changed, invalidated)
+
+        def owner_changed(owner):
+            cache = ref()
+            if cache is not None:
+                cache._owner_changed(owner)
+
+        subscriptions.append(self._conn.add_signal_receiver(
+            properties_changed, 'PropertiesChanged', PROPERTIES_IFACE,
+            self._bus_name, self._object_path).remove)
+        if self._follow_name_owner and self._bus_name is not None:
+            subscriptions.append(self._conn.watch_name_owner(
+                self._bus_name, owner_changed).cancel)
+
+    def _properties_changed(self, interface, changed, invalidated):
+        self._lock.acquire()
+        try:
+            if interface in self._loading:
+                self._loading[interface].append((changed, invalidated))
+            properties = self._interfaces.get(interface)
+            if properties is not None:
+                properties.update(changed)
+                for name in invalidated:
+                    properties.pop(name, None)
+        finally:
+            self._lock.release()
+
+    def _owner_changed(self, owner):
+        # The first call, with the owner when the watch was set up, might
+        # come after a change of owner that happened once values were
+        # fetched, so it can't be ignored: at worst it costs a GetAll.
+        self._lock.acquire()
+        try:
+            if owner != self._owner:
+                self.refresh()
+            self._owner = owner
+        finally:
+            self._lock.release()
+
+    def _get_all(self, interface, partial=False):
+        # Return the cached properties of interface, fetching them first if
+        # necessary. If partial is true and the object doesn't support
+        # GetAll, start with none, to be fetched one at a time. Call
+        # without the lock held.
+        self._lock.acquire()
+        try:
+            self._subscribe()
+            properties = self._interfaces.get(interface)
+            if properties is not None:
+                return properties
+            self._loading.setdefault(interface, [])
+            generation = self._generation
+        finally:
+            self._lock.release()
+
+        unsupported = False
+        try:
+            properties = dict(self._conn.call_blocking(self._bus_name,
+                self._object_path, PROPERTIES_IFACE, 'GetAll', 's',
+                (interface,)))
+        except DBusException as e:
+            if not partial or e.get_dbus_name() not in _GET_ALL_UNSUPPORTED:
+                raise
+            properties = {}
+            unsupported = True
+        finally:
+            self._lock.acquire()
+            try:
+                updates = self._loading.pop(interface, ())
+            finally:
+                self._lock.release()
+
+        self._lock.acquire()
+        try:
+            # a concurrent GetAll could have got here first
+            if interface in self._interfaces:
+                return self._interfaces[interface]
+            # only possible if signals are dispatched in another thread
+            for (changed, invalidated) in updates:
+                properties.update(changed)
+                for name in invalidated:
+                    properties.pop(name, None)
+            if (generation == self._generation and
+                self._subscriptions is not None):
+                self._interfaces[interface] = properties
+                if unsupported:
+                    self._no_get_all.add(interface)
+            return properties
+        finally:
+            self._lock.release()
+
+    def peek(self, method, args):
+        """Return (True, the reply to a Get or GetAll call with the given
+        arguments) if it is cached, or (False, None). The values are
+        shared with the cache."""
+        self._lock.acquire()
+        try:
+            properties = self._interfaces.get(args[0])
+            if properties is None:
+                return (False, None)
+            if method == 'GetAll':
+                if args[0] in self._no_get_all:
+                    return (False, None)
+                return (True, dict(properties))
+            if args[1] in properties:
+                return (True, properties[args[1]])
+            return (False, None)
+        finally:
+            self._lock.release()
+
+    def lookup(self, method, args):
+        """Return the reply to a Get or GetAll call with the given
+        arguments, from the cache if possible. The values are shared with
+        the cache.
+
+        If the remote object replies to GetAll with UnknownMethod or
+        NotSupported, Get fetches and caches properties one at a time
+        instead."""
+        if not args or not args[0]:
+            # the interface is optional for Get, but the cache needs it
+            return self._conn.call_blocking(self._bus_name,
+                self._object_path, PROPERTIES_IFACE, method, None, args)
+        if method == 'GetAll':
+            self._lock.acquire()
+            try:
+                unsupported = args[0] in self._no_get_all
+            finally:
+                self._lock.release()
+            if unsupported:
+                # the cached properties are only those read with Get
+                return self._conn.call_blocking(self._bus_name,
+                    self._object_path, PROPERTIES_IFACE, method, 's', args)
+        properties = self._get_all(args[0], partial=(method == 'Get'))
+        if method == 'GetAll':
+            self._lock.acquire()
+            try:
+                return dict(properties)
+            finally:
+                self._lock.release()
+
+        name = args[1]
+        self._lock.acquire()
+        try:
+            if name in properties:
+                return properties[name]
+        finally:
+            self._lock.release()
+        # invalidated, not included in GetAll, or GetAll unsupported
+        value = self._conn.call_blocking(self._bus_name, self._object_path,
+                                         PROPERTIES_IFACE, 'Get', 'ss', args)
+        self._lock.acquire()
+        try:
+            properties[name] = value
+        finally:
+            self._lock.release()
+        return value
+
+    def invalidate(self, interface, name):
+        """Forget the value of a property, which is about to be set."""
+        self._lock.acquire()
+        try:
+            self._interfaces.get(interface, {}).pop(name, None)
+        finally:
+            self._lock.release()
+
+    def refresh(self, interface=None):
+        """Forget the properties of one interface, or all of them."""
+        self._lock.acquire()
+        try:
+            self._generation += 1
+            if interface is None:
+                self._interfaces.clear()
+                self._no_get_all.clear()
+            else:
+                self._interfaces.pop(interface, None)
+                self._no_get_all.discard(interface)
+        finally:
+            self._lock.release()
+
+    def close(self):
+        """Stop following changes, and forget all the properties."""
+        self._lock.acquire()
+        try:
+            subscriptions = self._subscriptions or ()
+            self._subscriptions = None
+            self.refresh()
+        finally:
+            self._lock.release()
+        for remove in subscriptions:
+            remove()
+
+
 class ProxyObject(object):
     """A proxy to the remote Object.
 
     A ProxyObject is provided by the Bus. ProxyObjects
     have member functions, and can be called like normal Python objects.
+
+    If created with ``cache_properties=True``, the proxy keeps a copy of
+    the remote object's properties. Calls to the
+    org.freedesktop.DBus.Properties methods ``Get`` and ``GetAll`` fetch
+    all the properties of an interface with a single ``GetAll`` call the
+    first time, and are then answered locally, kept up to date by the
+    ``PropertiesChanged`` signal. This needs a main loop, and a remote
+    object that emits ``PropertiesChanged`` for its properties; see
+    `refresh_properties` for those that don't. For objects whose ``GetAll``
+    fails with UnknownMethod or NotSupported, properties are fetched with
+    ``Get`` one at a time instead. The values returned are the cached
+    objects themselves, shared by every caller, so they must not be
+    modified. If the proxy follows name owner
+    changes, the copy is discarded whenever the name changes owner. The
+    match rule for the signal is added when properties are first read,
+    and removed by `close_property_cache` or when the proxy is
+    garbage-collected.
     """
     ProxyMethodClass = _ProxyMethod
     DeferredMethodClass = _DeferredMethod
@@ -183,7 +464,8 @@ class ProxyObject(object):
     INTROSPECT_STATE_INTROSPECT_DONE = 2
 
     def __init__(self, conn=None, bus_name=None, object_path=None,
-                 introspect=True, follow_name_owner_changes=False, **kwargs):
+                 introspect=True, follow_name_owner_changes=False,
+                 cache_properties=False, **kwargs):
         """Initialize the proxy object.
 
         :Parameters:
@@ -203,6 +485,11 @@ class ProxyObject(object):
             `follow_name_owner_changes` : bool
                 If true (default is false) and the `bus_name` is a
                 well-known name, follow ownership changes for that name
+            `cache_properties` : bool
+                If true (default is false), keep a local copy of the
+                object's properties, as described above.
+
+                :Since: 1.2.1
         """
         bus = kwargs.pop('bus', None)
         if bus is not None:
@@ -228,7 +515,7 @@ class ProxyObject(object):
                             'keyword arguments: %s'
                             % ', '.join(kwargs.keys()))
 
-        if follow_name_owner_changes:
+        if follow_name_owner_changes or cache_properties:
             # we don't get the signals unless the Bus has a main loop
             # XXX: using Bus internals
             conn._require_main_loop()
@@ -258,6 +545,13 @@ class ProxyObject(object):
         # and calls the callback which re-takes the lock
         self._introspect_lock = RLock()
 
+        if cache_properties:
+            self._property_cache = _PropertyCache(conn, self._named_service,
+                                                  object_path,
+                                                  follow_name_owner_changes)
+        else:
+            self._property_cache = None
+
         if not introspect or self.__dbus_object_path__ == LOCAL_PATH:
             self._introspect_state = self.INTROSPECT_STATE_DONT_INTROSPECT
         else:
@@ -331,6 +625,12 @@ class ProxyObject(object):
                 If False (default) it will receive any byte-array
                 arguments as a dbus.Array of dbus.Byte (subclasses of:
                 a list of ints).
+            `native` : bool or None
+                If True, the handler function will receive builtin Python
+                types rather than dbus.types objects. If None (default),
+                use the connection's `native_args`.
+
+                :Since: 1.2.1
             `sender_keyword` : str
                 If not None (the default), the handler function will receive
                 the unique name of the sending endpoint as a keyword
@@ -358,7 +658,10 @@ class ProxyObject(object):
                 ``arg``\ *n*, match only signals where the *n*\ th argument
                 is the value given for that keyword parameter. As of this time
                 only string arguments can be matched (in particular,
-                object paths and signatures can't).
+                object paths and signatures can't). The
+                ``arg``\ *n*\ ``path`` and ``arg0namespace`` keywords are
+                accepted too, as described for
+                `dbus.connection.Connection.add_signal_receiver`.
         """
         return \
         self._bus.add_signal_receiver(handler_function,
@@ -368,6 +671,31 @@ class ProxyObject(object):
                                       path=self.__dbus_object_path__,
                                       **keywords)
 
+    def refresh_properties(self, dbus_interface=None):
+        """Discard the cached properties of the given interface, or of all
+        interfaces if it is None, so that they are fetched again when they
+        are next read. This does nothing unless the proxy was created with
+        ``cache_properties=True``.
+
+        :Since: 1.2.1
+        """
+        if self._property_cache is not None:
+            self._property_cache.refresh(dbus_interface)
+
+    def close_property_cache(self):
+        """Stop keeping a copy of the object's properties, if the proxy
+        was created with ``cache_properties=True``, so that the match rule
+        used for that is removed straight away rather than when the proxy
+        is garbage-collected. Reading properties through the proxy then
+        makes D-Bus calls again.
+
+        :Since: 1.2.1
+        """
+        cache = self._property_cache
+        self._property_cache = None
+        if cache is not None:
+            cache.close()
+
     def _Introspect(self):
         kwargs = {}
         if is_py2:
@@ -565,3 +893,167 @@ class Interface(object):
         return '<Interface %r implementing %r at %#x>'%(
         self._obj, self._dbus_interface, id(self))
     __str__ = __repr__
+
+
+class ObjectManagerProxy(object):
+    """A local mirror of the objects below a remote object implementing
+    org.freedesktop.DBus.ObjectManager, with their interfaces and
+    properties.
+
+    The mirror is filled by a single ``GetManagedObjects`` call, then kept
+    up to date from the ``InterfacesAdded``, ``InterfacesRemoved`` and
+    ``PropertiesChanged`` signals, so the connection must have a main loop.
+    Those signals are handled in the thread running it, which is the only
+    thread that may read `objects` or the dicts it holds while they are
+    being updated.
+
+    :Since: 1.2.1
+    """
+
+    def __init__(self, conn, bus_name, object_path):
+        """Constructor.
+
+        :Parameters:
+            `conn` : `dbus.connection.Connection`
+                The bus or connection on which to find the object manager.
+            `bus_name` : str or None
+                A bus name for the application owning the object manager.
+            `object_path` : str
+                The object path of the object manager.
+        """
+        if bus_name is not None:
+            _dbus_bindings.validate_bus_name(bus_name)
+        _dbus_bindings.validate_object_path(object_path)
+
+        self._conn = conn
+        self._bus_name = bus_name
+        self._object_path = object_path
+        self._lock = RLock()
+        self._objects = {}
+        # state updates, as (method, args), from signals received while
+        # GetManagedObjects is in progress; None once it has replied
+        self._loading = []
+
+        #: A list of callables, each called as ``callback(object_path,
+        #: interfaces_and_properties)`` when interfaces are added to a
+        #: managed object
+        self.on_interfaces_added = []
+        #: A list of callables, each called as ``callback(object_path,
+        #: interfaces)`` when interfaces are removed from a managed object
+        self.on_interfaces_removed = []
+
+        # listen before asking, so that no change can be missed
+        self._matches = [
+            conn.add_signal_receiver(self._interfaces_added,
+                                     'InterfacesAdded', OBJECT_MANAGER_IFACE,
+                                     bus_name, object_path),
+            conn.add_signal_receiver(self._interfaces_removed,
+                                     'InterfacesRemoved',
+                                     OBJECT_MANAGER_IFACE, bus_name,
+                                     object_path),
+            conn.add_signal_receiver(self._properties_changed,
+                                     'PropertiesChanged', PROPERTIES_IFACE,
+                                     bus_name, path_keyword='path',
+                                     path_namespace=object_path),
+        ]
+        try:
+            managed = conn.call_blocking(bus_name, object_path,
+                                         OBJECT_MANAGER_IFACE,
+                                         'GetManagedObjects', '', ())
+        except:
+            self.close()
+            raise
+
+        # Signals handled in another thread while the call was in progress
+        # are replayed on top of the reply, in order. Those it already
+        # reflects are followed by every later change, so the mirror ends
+        # up as the object manager is.
+        self._lock.acquire()
+        try:
+            for (path, interfaces) in managed.items():
+                self._objects[path] = dict((interface, dict(properties))
+                    for (interface, properties) in interfaces.items())
+            for (method, args) in self._loading:
+                method(*args)
+            self._loading = None
+        finally:
+            self._lock.release()
+
+    bus_name = property(lambda self: self._bus_name, None, None,
+            """The bus name of the application owning the object manager.""")
+
+    object_path = property(lambda self: self._object_path, None, None,
+            """The object path of the object manager.""")
+
+    @property
+    def objects(self):
+        """A dict mapping the object path of each managed object to a dict
+        mapping its interfaces to dicts of their properties. Do not
+        modify it.
+        """
+        return self._objects
+
+    def get_interfaces(self, object_path):
+        """Return a dict mapping the interfaces of the given managed object
+        to dicts of their properties, or None if there is no such object.
+        """
+        return self._objects.get(object_path)
+
+    def close(self):
+        """Stop updating the mirror."""
+        for match in self._matches:
+            match.remove()
+        self._matches = []
+
+    def _update(self, method, *args):
+        # Apply a change to the mirror, or queue it if GetManagedObjects
+        # has not yet replied.
+        self._lock.acquire()
+        try:
+            if self._loading is not None:
+                self._loading.append((method, args))
+            else:
+                method(*args)
+        finally:
+            self._lock.release()
+
+    def _add_interfaces(self, path, interfaces_and_properties):
+        interfaces = self._objects.setdefault(path, {})
+        for (interface, properties) in interfaces_and_properties.items():
+            interfaces[interface] = dict(properties)
+
+    def _remove_interfaces(self, path, removed):
+        interfaces = self._objects.get(path)
+        if interfaces is not None:
+            for interface in removed:
+                interfaces.pop(interface, None)
+            if not interfaces:
+                del self._objects[path]
+
+    def _change_properties(self, path, interface, changed, invalidated):
+        properties = self._objects.get(path, {}).get(interface)
+        if properties is None:
+            return
+        properties.update(changed)
+        for name in invalidated:
+            properties.pop(name, None)
+
+    def _interfaces_added(self, path, interfaces_and_properties):
+        self._update(self._add_interfaces, path, interfaces_and_properties)
+        for callback in self.on_interfaces_added:
+            callback(path, interfaces_and_properties)
+
+    def _interfaces_removed(self, path, removed):
+        self._update(self._remove_interfaces, path, removed)
+        for callback in self.on_interfaces_removed:
+            callback(path, removed)
+
+    def _properties_changed(self, interface, changed, invalidated, path=None):
+        # the match's path_namespace limits this to the manager's subtree
+        self._update(self._change_properties, path, interface, changed,
+                     invalidated)
+
+    def __repr__(self):
+        return '<ObjectManagerProxy for %s:%s at %#x>' % (self._bus_name,
+                self._object_path, id(self))
+    __str__ = __repr__
@@ -23,23 +23,34 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 # DEALINGS IN THE SOFTWARE.
 
-__all__ = ('BusName', 'Object', 'method', 'signal')
+__all__ = ('BusName', 'Object', 'ObjectManager', 'ObjectSubtree',
+           'PropertiesInterface', 'method', 'property', 'signal')
 __docformat__ = 'restructuredtext'
 
 import sys
 import logging
 import threading
 import traceback
-from collections import Sequence
+import weakref
+try:
+    from collections.abc import Sequence
+except ImportError:
+    from collections import Sequence
+try:
+    import builtins
+except ImportError:
+    import __builtin__ as builtins
 
 import _dbus_bindings
 from dbus import (
-    INTROSPECTABLE_IFACE, ObjectPath, SessionBus, Signature, Struct,
-    validate_bus_name, validate_object_path)
-from dbus.decorators import method, signal
+    INTROSPECTABLE_IFACE, OBJECT_MANAGER_IFACE, PROPERTIES_IFACE, ObjectPath,
+    SessionBus, Signature, Struct, validate_bus_name, validate_object_path)
+# property hides the builtin, which is used as builtins.property below
+from dbus.decorators import method, property, signal
 from dbus.exceptions import (
     DBusException, NameExistsException, UnknownMethodException)
-from dbus.lowlevel import ErrorMessage, MethodReturnMessage, MethodCallMessage
+from dbus.lowlevel import (
+    ErrorMessage, MethodReturnMessage, MethodCallMessage, SignalMessage)
 from dbus.proxies import LOCAL_PATH
 from dbus._compat import is_py2
 
@@ -183,11 +194,17 @@ class BusName(object):
 
 
 def _method_lookup(self, method_name, dbus_interface):
-    """Walks the Python MRO of the given class to find the method to invoke.
+    """Walks the Python MRO of the given object's class to find the method
+    to invoke.
 
     Returns two methods, the one to call, and the one it inherits from which
     defines its D-Bus interface name, signature, and attributes.
     """
+    return _class_method_lookup(self.__class__, method_name, dbus_interface)
+
+
+def _class_method_lookup(klass, method_name, dbus_interface):
+    """As for `_method_lookup`, but for a class rather than an instance."""
     parent_method = None
     candidate_class = None
     successful = False
@@ -196,7 +213,7 @@ def _method_lookup(self, method_name, dbus_interface):
     # latter is much simpler
     if dbus_interface:
         # search through the class hierarchy in python MRO order
-        for cls in self.__class__.__mro__:
+        for cls in klass.__mro__:
             # if we haven't got a candidate class yet, and we find a class with a
             # suitably named member, save this as a candidate class
             if (not candidate_class and method_name in cls.__dict__):
@@ -229,7 +246,7 @@ def _method_lookup(self, method_name, dbus_interface):
 
     else:
         # simpler version of above
-        for cls in self.__class__.__mro__:
+        for cls in klass.__mro__:
             if (not candidate_class and method_name in cls.__dict__):
                 candidate_class = cls
 
@@ -248,6 +265,153 @@ def _method_lookup(self, method_name, dbus_interface):
             raise UnknownMethodException('%s is not a valid method' % method_name)
 
 
+class _MethodDispatch(object):
+    """Everything about calling a D-Bus method that `Object._message_cb`
+    can work out in advance, since it only depends on the class."""
+
+    __slots__ = ('method', 'get_args_options', 'out_signature', 'n_out',
+                 'async_callbacks', 'sender_keyword', 'path_keyword',
+                 'destination_keyword', 'message_keywords',
+                 'rel_path_keyword', 'message_keyword', 'connection_keyword')
+
+    def __init__(self, candidate_method, parent_method):
+        self.method = candidate_method
+        self.get_args_options = parent_method._dbus_get_args_options
+
+        if parent_method._dbus_out_signature is not None:
+            self.out_signature = Signature(parent_method._dbus_out_signature)
+            self.n_out = len(tuple(self.out_signature))
+        else:
+            self.out_signature = None
+            self.n_out = None
+
+        self.async_callbacks = parent_method._dbus_async_callbacks
+
+        self.sender_keyword = parent_method._dbus_sender_keyword or None
+        self.path_keyword = parent_method._dbus_path_keyword or None
+        self.destination_keyword = (parent_method._dbus_destination_keyword
+                                    or None)
+        # (keyword, MessageHeader field holding its value)
+        self.message_keywords = tuple([(keyword, field) for keyword, field
+            in ((self.sender_keyword, 'sender'),
+                (self.path_keyword, 'path'),
+                (self.destination_keyword, 'destination'))
+            if keyword])
+        self.rel_path_keyword = parent_method._dbus_rel_path_keyword
+        self.message_keyword = parent_method._dbus_message_keyword
+        self.connection_keyword = parent_method._dbus_connection_keyword
+
+    def fast_entry(self):
+        """Return this method's entry for a `_dbus_bindings._MethodDispatcher`
+        table, or None if it has to go through `Object._message_cb`."""
+        if self.async_callbacks or self.rel_path_keyword:
+            return None
+        return (self.method, self.get_args_options, self.out_signature,
+                self.n_out or 0, self.sender_keyword, self.path_keyword,
+                self.destination_keyword, self.message_keyword or None,
+                self.connection_keyword or None)
+
+
+#: Every class using InterfaceType
+_interface_types = weakref.WeakSet()
+
+
+def _add_fast_entry(cls, key, dispatch):
+    """If cls uses FAST_DISPATCH and dispatch can be done in C, add it to
+    the class's `_dbus_bindings._MethodDispatcher` table."""
+    if getattr(cls, 'FAST_DISPATCH', False):
+        entry = dispatch.fast_entry()
+        if entry is not None:
+            fast_table = cls.__dict__['_dbus_fast_dispatch_table']
+            fast_table.setdefault(key[1], {})[key[0]] = entry
+
+
+def _build_dispatch_table(cls):
+    """Map (interface, member) to a `_MethodDispatch` for each method
+    exported by cls, and (None, member) for calls which don't specify an
+    interface, and store it on the class. Also refill the class's table
+    for FAST_DISPATCH."""
+    table = {}
+    cls.__dict__['_dbus_fast_dispatch_table'].clear()
+    class_table = cls._dbus_class_table[cls.__module__ + '.' + cls.__name__]
+
+    for interface, method_table in class_table.items():
+        for name, func in method_table.items():
+            if not getattr(func, '_dbus_is_method', False):
+                continue
+            for key in ((interface, name), (None, name)):
+                if key in table:
+                    continue
+                try:
+                    table[key] = _MethodDispatch(
+                        *_class_method_lookup(cls, name, key[0]))
+                except UnknownMethodException:
+                    continue
+                _add_fast_entry(cls, key, table[key])
+
+    # bypass InterfaceType.__setattr__, this is not a modification
+    type.__setattr__(cls, '_dbus_dispatch_table', table)
+    return table
+
+
+def _dispatch_lookup(cls, method_name, dbus_interface):
+    """Return the `_MethodDispatch` for a call to the given method of an
+    instance of cls, or raise UnknownMethodException."""
+    table = cls.__dict__['_dbus_dispatch_table']
+    if table is None:
+        table = _build_dispatch_table(cls)
+
+    try:
+        return table[(dbus_interface, method_name)]
+    except KeyError:
+        # not exported when the table was built; the search below is what
+        # the table caches, and raises if there is no such method
+        dispatch = _MethodDispatch(
+            *_class_method_lookup(cls, method_name, dbus_interface))
+        table[(dbus_interface, method_name)] = dispatch
+        _add_fast_entry(cls, (dbus_interface, method_name), dispatch)
+        return dispatch
+
+
+def _is_dbus_member(value):
+    """Return True if value is a D-Bus method, signal or property."""
+    return (getattr(value, '_dbus_is_method', False)
+            or getattr(value, '_dbus_is_signal', False)
+            or getattr(value, '_dbus_is_property', False))
+
+
+def _modifies_dispatch(cls, name, *values):
+    """Return True if setting or deleting cls.name, whose new value (if
+    any) is given, can change how instances of cls dispatch method calls."""
+    if name == 'FAST_DISPATCH':
+        return True
+    # an undecorated override of an exported method is still exported
+    class_table = cls._dbus_class_table.get(
+        cls.__module__ + '.' + cls.__name__, {})
+    for method_table in class_table.values():
+        if name in method_table:
+            return True
+    for klass in cls.__mro__:
+        if name in klass.__dict__:
+            values += (klass.__dict__[name],)
+            break
+    for value in values:
+        if _is_dbus_member(value):
+            return True
+    return False
+
+
+def _invalidate_dispatch_tables(cls):
+    """Discard the dispatch tables of cls and its subclasses."""
+    for klass in list(_interface_types):
+        if issubclass(klass, cls):
+            # bypass InterfaceType.__setattr__, this is not a modification
+            type.__setattr__(klass, '_dbus_dispatch_table', None)
+            # the C dispatchers don't look at _dbus_dispatch_table, so empty
+            # theirs to make them go through _message_cb, which rebuilds it
+            klass.__dict__['_dbus_fast_dispatch_table'].clear()
+
+
 def _method_reply_return(connection, message, method_name, signature, *retval):
     reply = MethodReturnMessage(message)
     try:
@@ -302,7 +466,8 @@ class InterfaceType(type):
         # object, so this has to be a dictionary that maps class names to
         # the per-class introspection/interface data
         class_table = getattr(cls, '_dbus_class_table', {})
-        cls._dbus_class_table = class_table
+        # bypass our __setattr__: creating a class doesn't change others
+        type.__setattr__(cls, '_dbus_class_table', class_table)
         interface_table = class_table[cls.__module__ + '.' + name] = {}
 
         # merge all the name -> method tables for all the interfaces
@@ -322,6 +487,40 @@ class InterfaceType(type):
 
         super(InterfaceType, cls).__init__(name, bases, dct)
 
+        has_properties = False
+        for method_table in interface_table.values():
+            for func in method_table.values():
+                if getattr(func, '_dbus_is_property', False):
+                    has_properties = True
+        if has_properties and not issubclass(cls, PropertiesInterface):
+            # org.freedesktop.DBus.Properties is opt-in, so that it doesn't
+            # take over existing methods called Get, Set or GetAll
+            raise TypeError('%s has D-Bus properties, so it must inherit '
+                            'from dbus.service.PropertiesInterface' % name)
+        type.__setattr__(cls, '_dbus_has_properties', has_properties)
+        type.__setattr__(cls, '_dbus_fast_dispatch_table', {})
+        _interface_types.add(cls)
+        _build_dispatch_table(cls)
+
+    def __call__(cls, *args, **kwargs):
+        obj = type.__call__(cls, *args, **kwargs)
+        # only now is the subclass' constructor done, so its properties
+        # can be read for InterfacesAdded
+        _object_constructed(obj)
+        return obj
+
+    def __setattr__(cls, name, value):
+        modifies_dispatch = _modifies_dispatch(cls, name, value)
+        super(InterfaceType, cls).__setattr__(name, value)
+        if modifies_dispatch:
+            _invalidate_dispatch_tables(cls)
+
+    def __delattr__(cls, name):
+        modifies_dispatch = _modifies_dispatch(cls, name)
+        super(InterfaceType, cls).__delattr__(name)
+        if modifies_dispatch:
+            _invalidate_dispatch_tables(cls)
+
     # methods are different to signals, so we have two functions... :)
     def _reflect_on_method(cls, func):
         args = func._dbus_args
@@ -370,6 +569,26 @@ class InterfaceType(type):
 
         return reflection_data
 
+    def _reflect_on_property(cls, prop):
+        if prop._dbus_writable and prop.fset is not None:
+            access = 'readwrite'
+        else:
+            access = 'read'
+        emits_change = prop._dbus_emits_change
+        if emits_change is True:
+            return ('    <property name="%s" type="%s" access="%s" />\n'
+                    % (prop.__name__, prop._dbus_signature, access))
+
+        if emits_change is False:
+            emits_change = 'false'
+        reflection_data = ('    <property name="%s" type="%s" access="%s">\n'
+                           % (prop.__name__, prop._dbus_signature, access))
+        reflection_data += ('      <annotation name="org.freedesktop.DBus.'
+                            'Property.EmitsChangedSignal" value="%s" />\n'
+                            % emits_change)
+        reflection_data += '    </property>\n'
+        return reflection_data
+
 
 # Define Interface as an instance of the metaclass InterfaceType, in a way
 # that is compatible across both Python 2 and Python 3.
@@ -380,6 +599,187 @@ Interface = InterfaceType('Interface', (object,), {})
 #: Object._connection if it's actually in more than one place
 _MANY = object()
 
+#: Lock protecting `_managers` and the dicts in it
+_managers_lock = threading.Lock()
+#: Map from connection to {object path: (ObjectManager, {object path:
+#: Object})}, giving the objects each manager is responsible for. Only
+#: connections on which an ObjectManager is exported are included, so
+#: exports elsewhere need no bookkeeping.
+_managers = weakref.WeakKeyDictionary()
+
+
+def _find_manager(connection, path):
+    # Return the ObjectManager nearest above path, its path and the dict of
+    # objects it manages, or (None, None, None). Call with _managers_lock
+    # held.
+    managers = _managers.get(connection)
+    while managers and path != '/':
+        path = path[:path.rindex('/')] or '/'
+        entry = managers.get(path)
+        if entry is not None:
+            return (entry[0], path, entry[1])
+    return (None, None, None)
+
+
+def _exported_objects(connection):
+    # Yield (path, Object) for everything exported on connection, found
+    # from its object-path handlers.
+    for (path, on_unregister, on_message) in \
+            connection._list_object_path_handlers():
+        owner = getattr(on_unregister, '__self__', None)
+        if isinstance(owner, Object):
+            yield (path, owner)
+        elif isinstance(owner, ObjectSubtree):
+            for item in owner._tree.items():
+                yield item
+
+
+def _manager_exported(connection, path, manager):
+    # Start recording the objects that manager, exported at path, is
+    # responsible for, including those already exported below it. Call with
+    # _managers_lock held.
+    (parent, parent_path, parent_managed) = _find_manager(connection, path)
+    managed = {}
+    _managers.setdefault(connection, {})[path] = (manager, managed)
+    if parent is not None:
+        # take over the parent's objects that are below this one
+        candidates = list(parent_managed.items())
+    else:
+        candidates = _exported_objects(connection)
+    for (obj_path, obj) in candidates:
+        if _find_manager(connection, obj_path)[1] == path:
+            managed[obj_path] = obj
+            if parent_managed is not None:
+                del parent_managed[obj_path]
+
+
+def _manager_unexported(connection, path):
+    # Stop recording the objects managed by the ObjectManager at path,
+    # handing them back to the manager above it, if any. Call with
+    # _managers_lock held.
+    managers = _managers[connection]
+    managed = managers.pop(path)[1]
+    if not managers:
+        del _managers[connection]
+        return
+    parent_managed = _find_manager(connection, path)[2]
+    if parent_managed is not None:
+        parent_managed.update(managed)
+
+
+def _interfaces_and_properties(obj):
+    # Return {interface: {property: value}} for an Object, as in the
+    # ObjectManager signals. Properties are only known for objects that
+    # implement org.freedesktop.DBus.Properties.GetAll.
+    cls = obj.__class__
+    interfaces = obj._dbus_class_table[cls.__module__ + '.' + cls.__name__]
+    get_all = None
+    if 'GetAll' in interfaces.get(PROPERTIES_IFACE, ()):
+        get_all = obj.GetAll
+
+    ret = {}
+    for interface in interfaces:
+        properties = {}
+        if get_all is not None:
+            try:
+                properties = get_all(interface)
+            except DBusException as e:
+                # the usual way for GetAll to say there are none
+                _logger.debug('%r has no properties for %s: %s', obj,
+                              interface, e)
+            except Exception:
+                _logger.exception('Unable to get the properties of %r for '
+                                  '%s', obj, interface)
+        ret[interface] = properties
+    return ret
+
+
+def _object_exported(connection, path, obj):
+    if not _managers and not isinstance(obj, ObjectManager):
+        # nothing to announce it to
+        return
+
+    _managers_lock.acquire()
+    try:
+        if isinstance(obj, ObjectManager):
+            _manager_exported(connection, path, obj)
+        (manager, manager_path, managed) = _find_manager(connection, path)
+        if manager is None:
+            return
+        managed[path] = obj
+        constructing = getattr(obj, '_dbus_constructing_exports', None)
+        if constructing is not None:
+            # announced by _object_constructed
+            constructing.append((connection, path))
+            return
+    finally:
+        _managers_lock.release()
+
+    manager._emit_on(connection, manager_path, 'InterfacesAdded',
+                     'oa{sa{sv}}', path, _interfaces_and_properties(obj))
+
+
+def _object_constructed(obj):
+    # Emit InterfacesAdded for the places obj was exported while its
+    # constructor was running, if it is still there.
+    constructing = getattr(obj, '_dbus_constructing_exports', None)
+    if constructing is None:
+        # not an Object, or already done
+        return
+    if not constructing:
+        # only exports by the constructor itself, on this thread, are
+        # added to the list, so it can't be added to now
+        obj._dbus_constructing_exports = None
+        return
+
+    added = []
+    _managers_lock.acquire()
+    try:
+        obj._dbus_constructing_exports = None
+        for (connection, path) in constructing:
+            (manager, manager_path, managed) = _find_manager(connection,
+                                                             path)
+            if manager is not None and managed.get(path) is obj:
+                added.append((manager, connection, manager_path, path))
+    finally:
+        _managers_lock.release()
+
+    for (manager, connection, manager_path, path) in added:
+        manager._emit_on(connection, manager_path, 'InterfacesAdded',
+                         'oa{sa{sv}}', path, _interfaces_and_properties(obj))
+
+
+def _object_unexported(connection, path, obj):
+    if not _managers:
+        return
+
+    _managers_lock.acquire()
+    try:
+        managers = _managers.get(connection)
+        if not managers:
+            return
+        entry = managers.get(path)
+        if entry is not None and entry[0] is obj:
+            _manager_unexported(connection, path)
+        (manager, manager_path, managed) = _find_manager(connection, path)
+        if manager is None or managed.get(path) is not obj:
+            return
+        del managed[path]
+        constructing = getattr(obj, '_dbus_constructing_exports', None)
+        if constructing is not None:
+            # never announced, so there is nothing to take back
+            if (connection, path) in constructing:
+                constructing.remove((connection, path))
+            return
+    finally:
+        _managers_lock.release()
+
+    cls = obj.__class__
+    interfaces = obj._dbus_class_table[cls.__module__ + '.' + cls.__name__]
+    manager._emit_on(connection, manager_path, 'InterfacesRemoved', 'oas',
+                     path, list(interfaces))
+
+
 class Object(Interface):
     r"""A base class for exporting your own Objects across the Bus.
 
@@ -423,6 +823,14 @@ class Object(Interface):
     #: have the same object path on all its connections.
     SUPPORTS_MULTIPLE_CONNECTIONS = False
 
+    #: If True, method calls are unpacked, dispatched and replied to by
+    #: C code in _dbus_bindings, rather than by `_message_cb`, except for
+    #: methods with ``async_callbacks`` or ``rel_path_keyword``. Subclasses
+    #: which override `_message_cb` always use it.
+    #:
+    #: :Since: 1.2.1
+    FAST_DISPATCH = False
+
     def __init__(self, conn=None, object_path=None, bus_name=None):
         """Constructor. Either conn or bus_name is required; object_path
         is also required.
@@ -476,6 +884,10 @@ class Object(Interface):
         #: True if this is a fallback object handling a whole subtree.
         self._fallback = False
 
+        #: [(connection, path)] exported while the object is being
+        #: constructed, or None once it has been. Protected by _managers_lock
+        self._dbus_constructing_exports = []
+
         self._name = bus_name
 
         if conn is None and object_path is not None:
@@ -484,7 +896,7 @@ class Object(Interface):
         if conn is not None and object_path is not None:
             self.add_to_connection(conn, object_path)
 
-    @property
+    @builtins.property
     def __dbus_object_path__(self):
         """The object-path at which this object is available.
         Access raises AttributeError if there is no object path, or more than
@@ -500,7 +912,7 @@ class Object(Interface):
         else:
             return self._object_path
 
-    @property
+    @builtins.property
     def connection(self):
         """The Connection on which this object is available.
         Access raises AttributeError if there is no Connection, or more than
@@ -516,7 +928,7 @@ class Object(Interface):
         else:
             return self._connection
 
-    @property
+    @builtins.property
     def locations(self):
         """An iterable over tuples representing locations at which this
         object is available.
@@ -556,7 +968,12 @@ class Object(Interface):
         if path == LOCAL_PATH:
             raise ValueError('Objects may not be exported on the reserved '
                              'path %s' % LOCAL_PATH)
+        self._add_location(connection, path)
 
+    def _add_location(self, connection, path, subtree=None):
+        # If subtree is an _ObjectSubtree, the object is in a subtree
+        # registered by an ObjectSubtree, so is not registered with the
+        # connection itself.
         self._locations_lock.acquire()
         try:
             if (self._connection is not None and
@@ -571,9 +988,11 @@ class Object(Interface):
                 raise ValueError('%r is already exported at object '
                                  'path %s' % (self, self._object_path))
 
-            connection._register_object_path(path, self._message_cb,
-                                             self._unregister_cb,
-                                             self._fallback)
+            if subtree is None:
+                connection._register_object_path(path,
+                                                 self._get_message_cb(),
+                                                 self._unregister_cb,
+                                                 self._fallback)
 
             if self._connection is None:
                 self._connection = connection
@@ -585,10 +1004,15 @@ class Object(Interface):
             elif self._object_path != path:
                 self._object_path = _MANY
 
-            self._locations.append((connection, path, self._fallback))
+            if subtree is None:
+                self._locations.append((connection, path, self._fallback))
+            else:
+                self._locations.append((connection, path, False, subtree))
         finally:
             self._locations_lock.release()
 
+        _object_exported(connection, path, self)
+
     def remove_from_connection(self, connection=None, path=None):
         """Make this object inaccessible via the given D-Bus connection
         and object path. If no connection or path is specified,
@@ -627,7 +1051,10 @@ class Object(Interface):
 
             for location in dropped:
                 try:
-                    location[0]._unregister_object_path(location[1])
+                    if len(location) > 3:
+                        location[3].remove(location[1])
+                    else:
+                        location[0]._unregister_object_path(location[1])
                 except LookupError:
                     pass
                 if self._locations:
@@ -638,6 +1065,22 @@ class Object(Interface):
         finally:
             self._locations_lock.release()
 
+        for location in dropped:
+            _object_unexported(location[0], location[1], self)
+
+    def _get_message_cb(self):
+        cls = self.__class__
+        if cls.FAST_DISPATCH and cls._message_cb == Object._message_cb:
+            if cls._dbus_has_properties:
+                return _dbus_bindings._MethodDispatcher(
+                    self, cls.__dict__['_dbus_fast_dispatch_table'],
+                    self._message_cb, _method_reply_error,
+                    self._dbus_properties_enter, self._dbus_properties_exit)
+            return _dbus_bindings._MethodDispatcher(
+                self, cls.__dict__['_dbus_fast_dispatch_table'],
+                self._message_cb, _method_reply_error)
+        return self._message_cb
+
     def _unregister_cb(self, connection):
         # there's not really enough information to do anything useful here
         _logger.info('Unregistering exported object %r from some path '
@@ -649,32 +1092,32 @@ class Object(Interface):
 
         try:
             # lookup candidate method and parent method
-            method_name = message.get_member()
-            interface_name = message.get_interface()
-            (candidate_method, parent_method) = _method_lookup(self, method_name, interface_name)
+            header = message.get_header()
+            method_name = header.member
+            interface_name = header.interface
+            dispatch = _dispatch_lookup(self.__class__, method_name,
+                                        interface_name)
 
             # set up method call parameters
-            args = message.get_args_list(**parent_method._dbus_get_args_options)
+            get_args_options = dispatch.get_args_options
+            if ('native' not in get_args_options and
+                    getattr(connection, 'native_args', False)):
+                get_args_options = dict(get_args_options, native=True)
+            args = message.get_args_list(**get_args_options)
             keywords = {}
-
-            if parent_method._dbus_out_signature is not None:
-                signature = Signature(parent_method._dbus_out_signature)
-            else:
-                signature = None
+            signature = dispatch.out_signature
 
             # set up async callback functions
-            if parent_method._dbus_async_callbacks:
-                (return_callback, error_callback) = parent_method._dbus_async_callbacks
+            if dispatch.async_callbacks:
+                (return_callback, error_callback) = dispatch.async_callbacks
                 keywords[return_callback] = lambda *retval: _method_reply_return(connection, message, method_name, signature, *retval)
                 keywords[error_callback] = lambda exception: _method_reply_error(connection, message, exception)
 
             # include the sender etc. if desired
-            if parent_method._dbus_sender_keyword:
-                keywords[parent_method._dbus_sender_keyword] = message.get_sender()
-            if parent_method._dbus_path_keyword:
-                keywords[parent_method._dbus_path_keyword] = message.get_path()
-            if parent_method._dbus_rel_path_keyword:
-                path = message.get_path()
+            for keyword, field in dispatch.message_keywords:
+                keywords[keyword] = getattr(header, field)
+            if dispatch.rel_path_keyword:
+                path = header.path
                 rel_path = path
                 for exp in self._locations:
                     # pathological case: if we're exported in two places,
@@ -694,37 +1137,42 @@ class Object(Interface):
                             if len(suffix) < len(rel_path):
                                 rel_path = suffix
                 rel_path = ObjectPath(rel_path)
-                keywords[parent_method._dbus_rel_path_keyword] = rel_path
+                keywords[dispatch.rel_path_keyword] = rel_path
 
-            if parent_method._dbus_destination_keyword:
-                keywords[parent_method._dbus_destination_keyword] = message.get_destination()
-            if parent_method._dbus_message_keyword:
-                keywords[parent_method._dbus_message_keyword] = message
-            if parent_method._dbus_connection_keyword:
-                keywords[parent_method._dbus_connection_keyword] = connection
+            if dispatch.message_keyword:
+                keywords[dispatch.message_keyword] = message
+            if dispatch.connection_keyword:
+                keywords[dispatch.connection_keyword] = connection
 
-            # call method
-            retval = candidate_method(self, *args, **keywords)
+            # call method, emitting PropertiesChanged for any properties
+            # it changes before replying
+            if self._dbus_has_properties:
+                self._dbus_properties_enter()
+                try:
+                    retval = dispatch.method(self, *args, **keywords)
+                finally:
+                    self._dbus_properties_exit()
+            else:
+                retval = dispatch.method(self, *args, **keywords)
 
             # we're done - the method has got callback functions to reply with
-            if parent_method._dbus_async_callbacks:
+            if dispatch.async_callbacks:
                 return
 
             # otherwise we send the return values in a reply. if we have a
             # signature, use it to turn the return value into a tuple as
             # appropriate
             if signature is not None:
-                signature_tuple = tuple(signature)
                 # if we have zero or one return values we want make a tuple
                 # for the _method_reply_return function, otherwise we need
                 # to check we're passing it a sequence
-                if len(signature_tuple) == 0:
+                if dispatch.n_out == 0:
                     if retval == None:
                         retval = ()
                     else:
                         raise TypeError('%s has an empty output signature but did not return None' %
                             method_name)
-                elif len(signature_tuple) == 1:
+                elif dispatch.n_out == 1:
                     retval = (retval,)
                 else:
                     if isinstance(retval, Sequence):
@@ -771,6 +1219,8 @@ class Object(Interface):
                     reflection_data += self.__class__._reflect_on_method(func)
                 elif getattr(func, '_dbus_is_signal', False):
                     reflection_data += self.__class__._reflect_on_signal(func)
+                elif getattr(func, '_dbus_is_property', False):
+                    reflection_data += self.__class__._reflect_on_property(func)
 
             reflection_data += '  </interface>\n'
 
@@ -791,6 +1241,248 @@ class Object(Interface):
                                    id(self))
     __str__ = __repr__
 
+
+class _PropertiesState(object):
+    """The state kept by a `PropertiesInterface`, created when first needed
+    so that objects whose properties are never read or set don't pay for it.
+    """
+    __slots__ = ('lock', 'cache', 'generation', 'pending', 'batch',
+                 'scheduled')
+
+    def __init__(self):
+        #: Lock protecting the other attributes
+        self.lock = threading.Lock()
+        #: {interface: {name: LazyVariant}} for GetAll
+        self.cache = {}
+        #: Incremented whenever a property changes
+        self.generation = 0
+        #: {interface: {name: property}} not yet in PropertiesChanged
+        self.pending = {}
+        #: Number of method calls being handled, during which
+        #: PropertiesChanged is not emitted
+        self.batch = 0
+        #: True while the main loop is due to emit PropertiesChanged
+        self.scheduled = False
+
+
+#: Lock protecting the creation of each object's _PropertiesState
+_properties_state_lock = threading.Lock()
+
+
+class PropertiesInterface(Interface):
+    """A mixin implementing org.freedesktop.DBus.Properties for the
+    `dbus.service.property` attributes of an `Object`.
+
+    Objects with properties must inherit from it as well as from `Object`
+    (or one of its subclasses)::
+
+        class Example(dbus.service.Object, dbus.service.PropertiesInterface):
+            @dbus.service.property('com.example.Sample', 'u')
+            def Volume(self):
+                return self._volume
+
+    :Since: 1.2.1
+    """
+
+    #: How long in seconds to wait before emitting ``PropertiesChanged``
+    #: for a `dbus.service.property` set other than while handling a
+    #: method call, so that further changes can be merged into the same
+    #: signal. The signal is emitted from the main loop of the object's
+    #: connection, so if 0, changes made during the same main loop
+    #: iteration are merged. That needs a main loop with a ``call_later``
+    #: method, like those of `dbus.mainloop.epoll` and
+    #: `dbus.mainloop.asyncio`: with others, such as
+    #: `dbus.mainloop.glib`, or a connection's `start_dispatch_thread`,
+    #: the signal is emitted immediately.
+    PROPERTIES_CHANGED_DELAY = 0
+
+    #: The object's _PropertiesState, or None until it is first needed
+    _dbus_properties = None
+
+    def _dbus_properties_state(self):
+        state = self._dbus_properties
+        if state is None:
+            _properties_state_lock.acquire()
+            try:
+                state = self._dbus_properties
+                if state is None:
+                    state = self._dbus_properties = _PropertiesState()
+            finally:
+                _properties_state_lock.release()
+        return state
+
+    def _dbus_property_lookup(self, interface_name, property_name):
+        cls = self.__class__
+        interfaces = self._dbus_class_table[cls.__module__ + '.' + cls.__name__]
+        if interface_name:
+            candidates = [interfaces.get(interface_name, {})]
+        else:
+            candidates = interfaces.values()
+        for method_table in candidates:
+            prop = method_table.get(property_name)
+            if getattr(prop, '_dbus_is_property', False):
+                return prop
+        raise DBusException('No property %s on interface %s' %
+                            (property_name, interface_name),
+                            name='org.freedesktop.DBus.Error.UnknownProperty')
+
+    def _dbus_properties_snapshot(self, interface_name):
+        # Return {name: LazyVariant} for the properties of the interface,
+        # marshalled once and kept until one of them changes
+        state = self._dbus_properties_state()
+        state.lock.acquire()
+        try:
+            snapshot = state.cache.get(interface_name)
+            generation = state.generation
+        finally:
+            state.lock.release()
+        if snapshot is not None:
+            return snapshot
+
+        cls = self.__class__
+        interfaces = self._dbus_class_table[cls.__module__ + '.' + cls.__name__]
+        if interface_name not in interfaces:
+            raise DBusException('No interface %s' % interface_name,
+                                name='org.freedesktop.DBus.Error.'
+                                     'UnknownInterface')
+        values = {}
+        for (name, prop) in interfaces[interface_name].items():
+            if getattr(prop, '_dbus_is_property', False):
+                values[name] = prop._dbus_wrap(prop.fget(self))
+        if values:
+            # a scratch message, which is never sent
+            message = SignalMessage('/', PROPERTIES_IFACE, 'GetAll')
+            message.append(values, signature='a{sv}')
+            snapshot = message.get_args_list(lazy_variants=True)[0]
+        else:
+            snapshot = {}
+
+        state.lock.acquire()
+        try:
+            if generation == state.generation:
+                state.cache[interface_name] = snapshot
+        finally:
+            state.lock.release()
+        return snapshot
+
+    @method(PROPERTIES_IFACE, in_signature='ss', out_signature='v')
+    def Get(self, interface_name, property_name):
+        """Return the value of a `dbus.service.property`."""
+        prop = self._dbus_property_lookup(interface_name, property_name)
+        return self._dbus_properties_snapshot(prop._dbus_interface)[
+            property_name]
+
+    @method(PROPERTIES_IFACE, in_signature='s', out_signature='a{sv}')
+    def GetAll(self, interface_name):
+        """Return the values of all the `dbus.service.property` attributes
+        of an interface, as `dbus.LazyVariant` objects.
+        """
+        return self._dbus_properties_snapshot(interface_name)
+
+    @method(PROPERTIES_IFACE, in_signature='ssv', out_signature='')
+    def Set(self, interface_name, property_name, value):
+        """Set a `dbus.service.property` declared with ``writable=True``."""
+        prop = self._dbus_property_lookup(interface_name, property_name)
+        if not prop._dbus_writable or prop.fset is None:
+            raise DBusException('Property %s is read-only' % property_name,
+                                name='org.freedesktop.DBus.Error.'
+                                     'PropertyReadOnly')
+        try:
+            value = prop._dbus_wrap(value)
+            # a scratch message, which is never sent: reject here a value
+            # that Get and PropertiesChanged would fail to send later
+            message = SignalMessage('/', PROPERTIES_IFACE, 'Set')
+            message.append(value, signature=prop._dbus_signature)
+        except (TypeError, ValueError, OverflowError) as e:
+            raise DBusException('Invalid value for property %s of type '
+                                '%s: %s' % (property_name,
+                                            prop._dbus_signature, e),
+                                name='org.freedesktop.DBus.Error.'
+                                     'InvalidArgs')
+        prop.__set__(self, value)
+
+    @signal(PROPERTIES_IFACE, signature='sa{sv}as')
+    def PropertiesChanged(self, interface_name, changed_properties,
+                          invalidated_properties):
+        """Emitted when `dbus.service.property` attributes change."""
+        pass
+
+    def _dbus_properties_call_later(self):
+        # Return the call_later method of the main loop of the (first)
+        # connection the object is on, or None
+        locations = self._locations
+        if not locations:
+            return None
+        mainloop = locations[0][0]._get_main_loop()
+        return getattr(mainloop, 'call_later', None)
+
+    def _dbus_property_changed(self, prop):
+        interface_name = prop._dbus_interface
+        state = self._dbus_properties_state()
+        call_later = None
+        state.lock.acquire()
+        try:
+            state.cache.pop(interface_name, None)
+            state.generation += 1
+            if prop._dbus_emits_change in (False, 'const'):
+                return
+            state.pending.setdefault(interface_name, {})[prop.__name__] = prop
+            if state.batch or state.scheduled:
+                return
+            call_later = self._dbus_properties_call_later()
+            state.scheduled = call_later is not None
+        finally:
+            state.lock.release()
+        if call_later is not None:
+            try:
+                call_later(self.PROPERTIES_CHANGED_DELAY,
+                           self._dbus_properties_flush)
+                return
+            except Exception:
+                _logger.exception('Unable to schedule PropertiesChanged '
+                                  'for %r', self)
+        self._dbus_properties_flush()
+
+    def _dbus_properties_enter(self):
+        state = self._dbus_properties_state()
+        state.lock.acquire()
+        state.batch += 1
+        state.lock.release()
+
+    def _dbus_properties_exit(self):
+        state = self._dbus_properties_state()
+        state.lock.acquire()
+        state.batch -= 1
+        flush = not state.batch and state.pending
+        state.lock.release()
+        if flush:
+            self._dbus_properties_flush()
+
+    def _dbus_properties_flush(self):
+        state = self._dbus_properties_state()
+        state.lock.acquire()
+        try:
+            pending = state.pending
+            state.pending = {}
+            state.scheduled = False
+        finally:
+            state.lock.release()
+
+        for (interface_name, props) in pending.items():
+            try:
+                changed = {}
+                invalidated = []
+                for (name, prop) in props.items():
+                    if prop._dbus_emits_change == 'invalidates':
+                        invalidated.append(name)
+                    else:
+                        changed[name] = prop._dbus_wrap(prop.fget(self))
+                self.PropertiesChanged(interface_name, changed, invalidated)
+            except Exception:
+                _logger.exception('Unable to emit PropertiesChanged for %s '
+                                  'on %r', interface_name, self)
+
+
 class FallbackObject(Object):
     """An object that implements an entire subtree of the object-path
     tree.
@@ -833,3 +1525,209 @@ class FallbackObject(Object):
             raise TypeError('If conn is given, object_path is required')
         else:
             self.add_to_connection(conn, object_path)
+
+
+class ObjectManager(Object):
+    """An object implementing the org.freedesktop.DBus.ObjectManager
+    interface, for clients to find all the objects below it, with their
+    interfaces and properties, in a single call.
+
+    Every `Object` added to the same connection at a path below the
+    manager's is included, until it is removed, except for those below
+    another ObjectManager further down. ``InterfacesAdded`` and
+    ``InterfacesRemoved`` are emitted as objects are added and removed.
+    The properties of an object are those returned by its
+    ``org.freedesktop.DBus.Properties.GetAll`` method, if it implements
+    one; objects in an `ObjectSubtree` are only included once they have
+    been created.
+
+    An object exported by its constructor is only announced once the
+    outermost constructor has returned, so its properties may rely on
+    attributes set after calling `Object.__init__`. ``InterfacesAdded``
+    carries the property values at that time, and later changes must be
+    signalled with ``PropertiesChanged``.
+
+    Use it as a base class instead of `Object`, or alongside another
+    subclass of it.
+
+    :Since: 1.2.1
+    """
+
+    @method(OBJECT_MANAGER_IFACE, in_signature='',
+            out_signature='a{oa{sa{sv}}}', path_keyword='object_path',
+            connection_keyword='connection')
+    def GetManagedObjects(self, object_path, connection):
+        """Return the interfaces and properties of all the objects below
+        this one, keyed by object path.
+        """
+        _managers_lock.acquire()
+        try:
+            entry = _managers.get(connection, {}).get(object_path)
+            managed = entry and list(entry[1].items()) or []
+        finally:
+            _managers_lock.release()
+
+        ret = {}
+        for (path, obj) in managed:
+            ret[path] = _interfaces_and_properties(obj)
+        return ret
+
+    @signal(OBJECT_MANAGER_IFACE, signature='oa{sa{sv}}')
+    def InterfacesAdded(self, object_path, interfaces_and_properties):
+        """Emitted when an object is added below this one."""
+        pass
+
+    @signal(OBJECT_MANAGER_IFACE, signature='oas')
+    def InterfacesRemoved(self, object_path, interfaces):
+        """Emitted when an object below this one is removed."""
+        pass
+
+    def _emit_on(self, connection, path, member, signature, *args):
+        # Unlike calling the signal methods, only emit from one location
+        message = SignalMessage(path, OBJECT_MANAGER_IFACE, member)
+        message.append(signature=signature, *args)
+        connection.send_message(message)
+
+
+class ObjectSubtree(object):
+    """A subtree of the object-path tree whose objects are only created
+    when they are first addressed.
+
+    Exporting a large or unbounded set of objects with `Object` registers
+    each of them with the connection up front. An ObjectSubtree instead
+    registers a single handler for its whole subtree, and calls
+    ``resolver(object_path)`` the first time a message arrives for an
+    object path in it that has no object yet. The resolver returns an
+    `Object`, which has not been exported anywhere else, to be exported at
+    exactly that path (its subpaths are resolved separately); or None if
+    there is no object there, in which case method calls other than
+    ``Introspect`` get an ``org.freedesktop.DBus.Error.UnknownObject``
+    error.
+
+    Objects stay in the subtree until they are removed with `discard`,
+    their own `Object.remove_from_connection`, or by removing the whole
+    subtree.
+
+    :Since: 1.2.1
+    """
+
+    def __init__(self, conn, object_path, resolver, enumerator=None):
+        """Constructor.
+
+        :Parameters:
+            `conn` : dbus.connection.Connection
+                The connection on which to export the subtree.
+            `object_path` : str
+                The object path at the root of the subtree. The resolver is
+                called for the root itself as well as for paths below it.
+            `resolver` : callable
+                Called with a `dbus.ObjectPath` in the subtree, and
+                returns an `Object` to export there, or None.
+            `enumerator` : callable or None
+                If not None, called with a `dbus.ObjectPath` in the
+                subtree, and returns an iterable over the names of its
+                children, as for `Connection.list_exported_child_objects`.
+                Without it, only the objects created so far can be
+                found by introspection.
+        """
+        if object_path == LOCAL_PATH:
+            raise ValueError('Objects may not be exported on the reserved '
+                             'path %s' % LOCAL_PATH)
+        self._connection = conn
+        self._resolver = resolver
+        self._tree = _dbus_bindings._ObjectSubtree(object_path, self._resolve,
+                                                   enumerator, self._missing)
+        conn._register_object_path(object_path, self._tree, self._unregister_cb,
+                                   True)
+
+    @builtins.property
+    def connection(self):
+        """The Connection on which the subtree is exported."""
+        return self._connection
+
+    @builtins.property
+    def object_path(self):
+        """The object path at the root of the subtree."""
+        return self._tree.path
+
+    def __len__(self):
+        """Return the number of objects created so far."""
+        return len(self._tree)
+
+    def get(self, path):
+        """Return the object at the given path, or None if it has not been
+        created. The resolver is not called.
+        """
+        return self._tree.get(path)
+
+    def add(self, path, obj):
+        """Export an `Object` at the given path in the subtree before it
+        is addressed, in place of whatever the resolver would return.
+
+        :Raises KeyError: if there is already an object at that path
+        """
+        self._tree.add(path, obj, obj._get_message_cb())
+        try:
+            obj._add_location(self._connection, path, self._tree)
+        except:
+            self._tree.remove(path)
+            raise
+
+    def discard(self, path):
+        """Remove the object at the given path from the subtree, if there is
+        one. The resolver will be called again if the path is addressed.
+        """
+        obj = self._tree.get(path)
+        if obj is not None:
+            try:
+                obj.remove_from_connection(self._connection, path)
+            except LookupError:
+                pass
+
+    def remove_from_connection(self):
+        """Stop exporting the subtree, and remove all the objects in it from
+        the connection.
+        """
+        self._connection._unregister_object_path(self._tree.path)
+        self._unregister_cb(self._connection)
+
+    def _resolve(self, path):
+        obj = self._resolver(path)
+        if obj is None:
+            return None
+        obj._add_location(self._connection, path, self._tree)
+        return (obj, obj._get_message_cb())
+
+    def _missing(self, connection, message):
+        if not isinstance(message, MethodCallMessage):
+            return NotImplemented
+
+        header = message.get_header()
+        if (header.member == 'Introspect' and
+            header.interface in (INTROSPECTABLE_IFACE, None)):
+            try:
+                children = connection.list_exported_child_objects(header.path)
+            except Exception as exception:
+                # the enumerator failed: say so, rather than letting
+                # libdbus reply that there are no children
+                _method_reply_error(connection, message, exception)
+                return
+            xml = _dbus_bindings.DBUS_INTROSPECT_1_0_XML_DOCTYPE_DECL_NODE
+            xml += '<node name="%s">\n' % header.path
+            for name in children:
+                xml += '  <node name="%s"/>\n' % name
+            xml += '</node>\n'
+            reply = MethodReturnMessage(message)
+            reply.append(xml, signature='s')
+        else:
+            reply = ErrorMessage(message,
+                                 'org.freedesktop.DBus.Error.UnknownObject',
+                                 'No object at %s' % header.path)
+        connection.send_message(reply)
+
+    def _unregister_cb(self, connection):
+        for path, obj in self._tree.clear():
+            try:
+                obj.remove_from_connection(connection, path)
+            except LookupError:
+                pass
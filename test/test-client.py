@@ -25,6 +25,7 @@
 
 from __future__ import print_function
 import os
+import threading
 import unittest
 import time
 import logging
@@ -35,7 +36,9 @@ pydir = os.path.normpath(os.environ["DBUS_TOP_SRCDIR"])
 
 import dbus
 import _dbus_bindings
+import dbus.bus
 import dbus.glib
+import dbus.mainloop
 import dbus.service
 
 from dbus._compat import is_py2, is_py3
@@ -511,6 +514,67 @@ class TestDBusBindings(unittest.TestCase):
         # fd.o #12096
         dbus.Bus(private=True).close()
 
+    def testPropertyCacheNameOwner(self):
+        iface = 'com.example.Owned'
+        name = 'com.example.OwnedName'
+
+        class Owned(dbus.service.Object, dbus.service.PropertiesInterface):
+            def __init__(self, conn, value):
+                dbus.service.Object.__init__(self, conn, '/owned')
+                self.value = value
+
+            @dbus.service.property(iface, 's')
+            def Value(self):
+                return self.value
+
+        # the connections call each other, so each is dispatched by a
+        # thread of its own rather than by the GLib main loop
+        address = os.environ['DBUS_SESSION_BUS_ADDRESS']
+        conns = []
+        for i in range(3):
+            conn = dbus.bus.BusConnection(
+                address, mainloop=dbus.mainloop.NULL_MAIN_LOOP)
+            conn.start_dispatch_thread()
+            conns.append(conn)
+        (first, second, client) = conns
+        moved = threading.Event()
+
+        def owner_changed(owner):
+            if owner == second.get_unique_name():
+                moved.set()
+
+        def value(proxy):
+            return dbus.Interface(proxy, dbus.PROPERTIES_IFACE).Get(iface,
+                                                                    'Value')
+
+        try:
+            Owned(first, 'first')
+            Owned(second, 'second')
+            first.request_name(name)
+            bound = client.get_object(name, '/owned', introspect=False,
+                                      cache_properties=True)
+            following = client.get_object(name, '/owned', introspect=False,
+                                          follow_name_owner_changes=True,
+                                          cache_properties=True)
+            self.assertEqual(value(bound), 'first')
+            self.assertEqual(value(following), 'first')
+
+            # watched after the proxy's cache, so it is told later
+            watch = client.watch_name_owner(name, owner_changed)
+            second.request_name(name)
+            first.release_name(name)
+            self.assertTrue(moved.wait(5))
+            watch.cancel()
+            self.assertEqual(value(following), 'second')
+
+            # without following, the proxy and its cache stay with the
+            # owner at the time it was created
+            bound.refresh_properties()
+            self.assertEqual(value(bound), 'first')
+        finally:
+            for conn in conns:
+                conn.close()
+
     def testTimeoutAsyncClient(self):
         loop = gobject.MainLoop()
         passes = []
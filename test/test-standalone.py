@@ -30,6 +30,7 @@ from __future__ import unicode_literals
 
 import sys
 import os
+import struct
 import unittest
 
 builddir = os.path.normpath(os.environ["DBUS_TOP_BUILDDIR"])
@@ -44,9 +45,19 @@ from dbus._compat import is_py2, is_py3
 if is_py3:
     def make_long(n):
         return n
+    text_type = str
+    long_type = int
 else:
     def make_long(n):
         return long(n)
+    text_type = unicode
+    long_type = long
+
+def buffer_items(view):
+    # memoryview.tolist() only supports byte views on Python 2
+    data = view.tobytes()
+    return list(struct.unpack('%d%s' % (len(data) // view.itemsize,
+                                        view.format), data))
 
 
 # Check that we're using the right versions
@@ -89,6 +100,33 @@ class TestTypes(unittest.TestCase):
         self.assertEqual(x.variant_level, 42)
         self.assertEqual(x, ('a','b','c'))
 
+    def test_variant_level_storage(self):
+        # variant levels and struct signatures of variable-sized objects are
+        # kept out of line; make sure they survive the table growing,
+        # shrinking and having entries removed from the middle
+        objs = []
+        for i in range(5000):
+            objs.append(types.Int64(i, variant_level=i % 5))
+            objs.append(types.ObjectPath('/%d' % i, variant_level=i % 3))
+            objs.append(types.Struct((i,), signature=(i % 2 and 'x' or None),
+                                     variant_level=i % 4))
+        del objs[::2]
+        for x in objs:
+            if isinstance(x, types.Struct):
+                i = x[0]
+                self.assertEqual(x.variant_level, i % 4)
+                if i % 2:
+                    self.assertEqual(x.signature, 'x')
+                else:
+                    self.assertEqual(x.signature, None)
+            elif isinstance(x, types.ObjectPath):
+                self.assertEqual(x.variant_level, int(x[1:]) % 3)
+            else:
+                self.assertEqual(x.variant_level, x % 5)
+        del objs[:]
+        self.assertEqual(types.Int64(1).variant_level, 0)
+        self.assertEqual(types.Struct((1,)).signature, None)
+
     def test_Byte(self):
         self.assertEqual(types.Byte(b'x', variant_level=2),
                           types.Byte(ord('x')))
@@ -289,6 +327,325 @@ class TestMessageMarshalling(unittest.TestCase):
         aeq(s.get_args_list(), [[]])
         aeq(s.get_args_list(byte_arrays=True), [types.ByteArray(b'')])
 
+    def test_append_fixed_array(self):
+        import array
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+
+        for sig, values in (('ad', [1.5, -2.0, 3]),
+                            ('ai', (-1, 2, 0x7fffffff)),
+                            ('au', [0, 0xffffffff]),
+                            ('an', [-0x8000, 0x7fff]),
+                            ('aq', [0xffff]),
+                            ('ax', [-make_long(0x8000000000000000)]),
+                            ('at', [make_long(0xffffffffffffffff)]),
+                            ('ab', [True, 0, 'x']),
+                            ('ay', [0, 0xff]),
+                            ('ai', [])):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(values, signature=sig)
+            aeq(s.get_signature(), sig)
+            aeq(s.get_args_list(), [[(v if sig != 'ab' else bool(v))
+                                     for v in values]])
+
+        for code, sig in (('d', 'ad'), ('i', 'ai'), ('I', 'au'),
+                          ('h', 'an'), ('H', 'aq'), ('B', 'ay')):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(array.array(code, [1, 2, 3]), signature=sig)
+            aeq(s.get_args_list(), [[1, 2, 3]])
+
+        # buffers of the wrong item type are converted item by item
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append(array.array('B', [1, 2, 3]), signature='ai')
+        aeq(s.get_args_list(), [[1, 2, 3]])
+
+        # range checks still apply in bulk
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(OverflowError, s.append, [0, 0x10000],
+                          signature='aq')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(ValueError, s.append, [0, 0x100], signature='ay')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(TypeError, s.append, [1.0, 'x'], signature='ad')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(OverflowError, s.append, array.array('i', [-1]),
+                          signature='au')
+
+    def test_get_args_fixed_arrays_buffer(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append([1.5, -2.0], [-1, 2, 3], [], b'ab', [True], ['x'],
+                 signature='adaiauayabas')
+        args = s.get_args_list(fixed_arrays='buffer')
+        for view, fmt, items in zip(args[:4], 'diIB',
+                                    ([1.5, -2.0], [-1, 2, 3], [], [97, 98])):
+            self.assertTrue(isinstance(view, memoryview))
+            self.assertTrue(view.readonly)
+            aeq(view.format, fmt)
+            aeq(buffer_items(view), items)
+        # booleans and non-fixed types are unpacked as usual
+        aeq(args[4], [True])
+        aeq(args[4].__class__, types.Array)
+        aeq(args[5], ['x'])
+        # byte_arrays takes precedence
+        aeq(s.get_args_list(byte_arrays=True, fixed_arrays='buffer')[3],
+            types.ByteArray(b'ab'))
+
+        # the message can't be appended to while its body is exported
+        self.assertRaises(BufferError, s.append, 1, signature='i')
+        view = args[0]
+        del args
+        self.assertRaises(BufferError, s.append, 1, signature='i')
+        del view
+        s.append(1, signature='i')
+        aeq(s.get_signature(), 'adaiauayabasi')
+
+        # the views keep the message alive
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append([0x12345678, 1], signature='au')
+        view = s.get_args_list(fixed_arrays='buffer')[0]
+        del s
+        aeq(buffer_items(view), [0x12345678, 1])
+
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(ValueError, s.get_args_list, fixed_arrays='list')
+
+    def test_get_args_cache(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append(b'ab', {'x': 1}, signature='aya{si}')
+        args = s.get_args_list(cache=True)
+        self.assertTrue(s.get_args_list(cache=True) is args)
+        self.assertFalse(s.get_args_list() is args)
+        aeq(s.get_args_list(), args)
+        # each set of options is cached separately
+        byte_args = s.get_args_list(byte_arrays=True, cache=True)
+        self.assertFalse(byte_args is args)
+        aeq(byte_args[0].__class__, types.ByteArray)
+        self.assertTrue(s.get_args_list(byte_arrays=True, cache=True)
+                        is byte_args)
+        self.assertTrue(s.get_args_list(cache=True) is args)
+        # appending empties the cache
+        s.append('c', signature='s')
+        args = s.get_args_list(cache=True)
+        aeq(len(args), 3)
+        self.assertRaises(ValueError, s.get_args_list, cache=True,
+                          fixed_arrays='buffer')
+
+    def test_get_args_native(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append({'s': 'x', 'b': True, 'u': types.UInt32(0xffffffff),
+                  'o': types.ObjectPath('/a'),
+                  'vi': types.Int32(1, variant_level=2)},
+                 [types.Int16(-1), types.Int16(2)], [True, False],
+                 b'ab', ('s', 1.5, types.UInt64(2**64 - 1)), [['x']],
+                 signature='a{sv}anabay(sdt)aas')
+        args = s.get_args_list(native=True)
+        aeq(args, [{'s': 'x', 'b': True, 'u': 0xffffffff, 'o': '/a',
+                    'vi': 1},
+                   [-1, 2], [True, False], [97, 98], ('s', 1.5, 2**64 - 1),
+                   [['x']]])
+        for value, cls in zip(args, (dict, list, list, list, tuple, list)):
+            aeq(value.__class__, cls)
+        for key, cls in (('s', text_type), ('b', bool), ('u', int),
+                         ('o', str), ('vi', int)):
+            aeq(args[0][key].__class__, cls)
+        aeq([x.__class__ for x in args[1] + args[2] + list(args[4])],
+            [int, int, bool, bool, text_type, float, long_type])
+        aeq(args[5][0][0].__class__, text_type)
+        aeq(s.get_args_list(native=True, byte_arrays=True)[3], b'ab')
+        aeq(s.get_args_list(native=True, byte_arrays=True)[3].__class__,
+            bytes)
+        aeq(buffer_items(s.get_args_list(native=True,
+                                         fixed_arrays='buffer')[1]),
+            [-1, 2])
+        if is_py2:
+            args = s.get_args_list(native=True, utf8_strings=True)
+            aeq(args[0]['s'].__class__, str)
+            aeq(args[4][0].__class__, str)
+            aeq(args[5][0][0].__class__, str)
+        # cached separately from the usual types
+        wrapped = s.get_args_list(cache=True)
+        self.assertFalse(s.get_args_list(native=True, cache=True) is wrapped)
+        aeq(s.get_args_list(native=True, cache=True)[1][0].__class__, int)
+        aeq(s.get_args_list(cache=True)[1][0].__class__, types.Int16)
+
+    def test_get_args_lazy_variants(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append({'i': types.Int32(1), 's': types.String('x', variant_level=2),
+                  'e': types.Array([], signature='s')},
+                 signature='a{sv}')
+        props = s.get_args_list(lazy_variants=True)[0]
+        for value in props.values():
+            aeq(value.__class__, dbus.LazyVariant)
+        aeq(props['i'].signature, 'i')
+        aeq(props['s'].signature, 'v')
+        aeq(props['s'].variant_level, 2)
+        value = props['s'].value
+        aeq(value, 'x')
+        aeq(value.variant_level, 2)
+        self.assertTrue(props['s'].value is value)
+        aeq(props['e'].value, [])
+        # the message can't change under them
+        self.assertRaises(BufferError, s.append, 1)
+        self.assertRaises(ValueError, s.get_args_list, lazy_variants=True,
+                          cache=True)
+        # they are copied into other messages as they are
+        copy = SignalMessage('/', 'foo.bar', 'baz')
+        copy.append(props, props['i'], props['i'])
+        aeq(copy.get_signature(), 'a{sv}vv')
+        aeq(copy.get_args_list(), s.get_args_list() + [1, 1])
+        aeq(copy.get_args_list()[0]['s'].variant_level, 2)
+        # or unpacked, if the signature calls for something else
+        copy = SignalMessage('/', 'foo.bar', 'baz')
+        copy.append(props['i'], signature='i')
+        aeq(copy.get_args_list(), [1])
+        del props, value
+        s.append(1)
+
+    def test_get_arg_and_iter_args(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append('a', {'k': 1}, [b'x', b'y'], signature='sa{si}aay')
+        aeq(s.get_arg(0), 'a')
+        aeq(s.get_arg(0).__class__, types.String)
+        aeq(s.get_arg(2, byte_arrays=True), [b'x', b'y'])
+        aeq(s.get_arg(1, native=True).__class__, dict)
+        self.assertRaises(IndexError, s.get_arg, 3)
+        self.assertRaises(IndexError, s.get_arg, -1)
+        self.assertRaises(TypeError, s.get_arg, 0, cache=True)
+
+        aeq(list(s.iter_args()), s.get_args_list())
+        aeq(list(s.iter_args(native=True)), s.get_args_list(native=True))
+        aeq(list(s.iter_array(1)), [('k', 1)])
+        aeq(list(s.iter_array(2, byte_arrays=True)), [b'x', b'y'])
+        self.assertRaises(TypeError, s.iter_array, 0)
+        self.assertRaises(IndexError, s.iter_array, 3)
+        aeq(list(SignalMessage('/', 'foo.bar', 'baz').iter_args()), [])
+
+        # the message is only locked while an iterator is unfinished
+        it = s.iter_args()
+        aeq(next(it), 'a')
+        self.assertRaises(BufferError, s.append, 1)
+        aeq(len(list(it)), 2)
+        s.append(1)
+        aeq(s.get_arg(3), 1)
+
+    def test_iter_args_reinit(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append([1, 2, 3], 'x', signature='ais')
+        it = s.iter_args()
+        items = s.iter_array(0)
+        aeq(next(it), [1, 2, 3])
+        aeq(next(items), 1)
+        # the iterators point into the message, so it can't be replaced
+        self.assertRaises(BufferError, s.__init__, '/x', 'foo.bar', 'quux')
+        aeq(s.get_member(), 'baz')
+        aeq(list(it), ['x'])
+        aeq(list(items), [2, 3])
+        s.__init__('/x', 'foo.bar', 'quux')
+        aeq(s.get_member(), 'quux')
+        aeq(s.get_args_list(), [])
+
+    def test_interned_strings(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/foo', 'foo.bar', 'baz')
+        t = SignalMessage('/foo', 'foo.bar', 'baz')
+        s.append({'k': 1}, {types.ObjectPath('/p'): 2},
+                 signature='a{si}a{oi}')
+        t.append({'k': 1}, signature='a{si}')
+        before = lowlevel.get_intern_stats()
+        self.assertTrue(s.get_member() is t.get_member())
+        self.assertTrue(s.get_interface() is t.get_interface())
+        self.assertTrue(s.get_path() is t.get_path())
+        aeq(s.get_path().__class__, types.ObjectPath)
+        self.assertTrue(lowlevel.get_intern_stats()['hits']
+                        >= before['hits'] + 3)
+
+        k1, = s.get_args_list()[0]
+        k2, = t.get_args_list()[0]
+        self.assertTrue(k1 is k2)
+        aeq(k1.__class__, types.String)
+        aeq(k1.variant_level, 0)
+        k1, = s.get_args_list(native=True)[0]
+        k2, = t.get_args_list(native=True)[0]
+        self.assertTrue(k1 is k2)
+        aeq(k1.__class__, text_type)
+        if is_py2:
+            k1, = s.get_args_list(native=True, utf8_strings=True)[0]
+            aeq(k1.__class__, str)
+        p, = s.get_args_list()[1]
+        aeq(p.__class__, types.ObjectPath)
+        aeq(p, '/p')
+
+        # only keys are interned, not values
+        self.assertFalse(s.get_arg(0) is t.get_arg(0))
+
+    def test_get_header(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage, MESSAGE_TYPE_SIGNAL
+        s = SignalMessage('/foo', 'foo.bar', 'baz')
+        h = s.get_header()
+        self.assertTrue(isinstance(h, lowlevel.MessageHeader))
+        aeq(h.type, MESSAGE_TYPE_SIGNAL)
+        aeq(h.path, '/foo')
+        aeq(h.path.__class__, types.ObjectPath)
+        aeq(h.interface, 'foo.bar')
+        aeq(h.member, 'baz')
+        aeq((h.serial, h.reply_serial, h.sender, h.destination,
+             h.error_name), (0, 0, None, None, None))
+        aeq(h.signature, '')
+        aeq(h.signature.__class__, types.Signature)
+        aeq(h.no_reply, True)    # always set on signals
+        self.assertRaises(AttributeError, setattr, h, 'member', 'x')
+
+        # kept until the header or signature changes
+        self.assertTrue(s.get_header() is h)
+        s.set_sender(':1.23')
+        h2 = s.get_header()
+        aeq((h.sender, h2.sender), (None, ':1.23'))
+        s.append(1)
+        aeq(s.get_header().signature, 'i')
+        s._set_serial(42)
+        aeq(s.get_header().serial, 42)
+        aeq(s.get_header(), (MESSAGE_TYPE_SIGNAL, 42, 0, '/foo', 'foo.bar',
+                             'baz', None, None, ':1.23', 'i', True, True))
+
+    def test_copy_with_header(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        s = SignalMessage('/foo', 'foo.bar', 'baz')
+        s.set_destination(':1.2')
+        s.append('x', types.Array([1, 2], signature='u'), signature='sau')
+        s._set_serial(3)
+
+        c = s.copy_with_header(path='/foo/bar')
+        self.assertTrue(isinstance(c, SignalMessage))
+        aeq(c.get_path(), '/foo/bar')
+        aeq((c.get_interface(), c.get_member(), c.get_destination()),
+            ('foo.bar', 'baz', ':1.2'))
+        aeq(c.get_serial(), 0)
+        aeq(c.get_args_list(), ['x', [1, 2]])
+        aeq(s.get_path(), '/foo')
+
+        c = s.copy_with_header(destination=None)
+        aeq((c.get_path(), c.get_destination()), ('/foo', None))
+        c = s.copy_with_header(path='/', destination='com.example.X')
+        aeq((c.get_path(), c.get_destination()), ('/', 'com.example.X'))
+
+        self.assertRaises(ValueError, s.copy_with_header, path='foo')
+        self.assertRaises(ValueError, s.copy_with_header, destination='1')
+
     def test_append_Variant(self):
         aeq = self.assertEqual
         from _dbus_bindings import SignalMessage
@@ -309,6 +666,65 @@ class TestMessageMarshalling(unittest.TestCase):
         aeq(args[2].variant_level, 1)
         aeq(args[2].signature, 'v')
 
+    def test_append_signature_cache(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+
+        # more distinct signatures than the cache holds, so that earlier
+        # ones are evicted and recompiled
+        for n in range(1, 301):
+            sig = 'a(%sas)a{s%s}' % ('i' * (n % 7 + 1),
+                                     ('ai', 'i', 'v')[n % 3])
+            value = {'x': [n] if n % 3 == 0 else (n if n % 3 == 1 else 'v')}
+            for i in range(2):
+                s = SignalMessage('/', 'foo.bar', 'baz')
+                s.append([tuple([n] * (n % 7 + 1)) + (['a', 'b'],)], value,
+                         signature=sig)
+                aeq(s.get_signature(), sig)
+                args = s.get_args_list()
+                aeq(args[0], [tuple([n] * (n % 7 + 1)) + (['a', 'b'],)])
+                aeq(args[0].signature, '(%sas)' % ('i' * (n % 7 + 1)))
+                aeq(args[1], value)
+
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(ValueError, s.append, 1, signature='a')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(TypeError, s.append, (1, 2, 3), signature='(ii)')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(TypeError, s.append, (1,), signature='(ii)')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(TypeError, s.append, 1, signature='ii')
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(TypeError, s.append, 1, 2, signature='i')
+
+    def test_get_args_basic_types(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        values = [types.Boolean(True), types.Byte(255),
+                  types.Int16(-0x8000), types.UInt16(0xffff),
+                  types.Int32(-0x80000000), types.UInt32(0xffffffff),
+                  types.Int64(-0x8000000000000000),
+                  types.UInt64(0xffffffffffffffff), types.Double(0.5),
+                  types.String('\xe9'), types.ObjectPath('/a/b'),
+                  types.Signature('a{sv}')]
+        for variant_level in (0, 1, 3):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            if variant_level:
+                s.append(signature='v' * len(values),
+                         *[v.__class__(v, variant_level=variant_level)
+                           for v in values])
+            else:
+                s.append(*values)
+            args = s.get_args_list()
+            aeq(len(args), len(values))
+            for arg, value in zip(args, values):
+                aeq(arg.__class__, value.__class__)
+                aeq(arg, value)
+                aeq(arg.variant_level, variant_level)
+                aeq(repr(arg),
+                    repr(value.__class__(value,
+                                         variant_level=variant_level)))
+
     def test_guess_signature(self):
         aeq = self.assertEqual
         from _dbus_bindings import Message
@@ -341,6 +757,47 @@ class TestMessageMarshalling(unittest.TestCase):
         aeq(gs(types.Dictionary({}, signature='iu')), 'a{iu}')
         aeq(gs(types.Array([types.Int32(1)])), 'ai')
         aeq(gs(types.Array([types.Int32(1)], signature='u')), 'au')
+        aeq(gs(types.Struct((1, 2))), '(ii)')
+        aeq(gs(types.Struct((1, 2), signature='xx')), '(xx)')
+
+    def test_guess_signature_cache(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import Message
+        gs = Message.guess_signature
+
+        class MyInt(types.Int64):
+            __slots__ = ()
+
+        # the same type is guessed correctly, whatever the variant level
+        for i in range(3):
+            aeq(gs(MyInt(1)), 'x')
+            aeq(gs(MyInt(1, variant_level=1)), 'v')
+            aeq(gs([MyInt(1, variant_level=2)]), 'av')
+            aeq(gs({'a': MyInt(1)}, MyInt(2)), 'a{sx}x')
+
+        # changing the class is noticed, even after it has been guessed
+        MyInt.__dbus_object_path__ = '/foo'
+        aeq(gs(MyInt(1)), 'o')
+        del MyInt.__dbus_object_path__
+        aeq(gs(MyInt(1)), 'x')
+
+        # so are instance attributes, for types that can have them
+        class MyStr(str):
+            pass
+        aeq(gs(MyStr('a')), 's')
+        obj = MyStr('a')
+        obj.__dbus_object_path__ = '/foo'
+        aeq(gs(obj), 'o')
+        aeq(gs(MyStr('a')), 's')
+
+        m = _dbus_bindings.SignalMessage('/', 'foo.bar', 'baz')
+        m.append(MyInt(1, variant_level=2), types.Struct((1,), signature='x'))
+        aeq(m.get_signature(), 'v(x)')
+        aeq(m.get_args_list(), [1, (1,)])
+
+        self.assertRaises(ValueError, gs, *(['s'] * 256))
+        self.assertRaises(ValueError, gs, [[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[
+            1]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]])
 
     def test_get_args_options(self):
         aeq = self.assertEqual
@@ -509,6 +966,1265 @@ class TestMatching(unittest.TestCase):
         self._message.append('/', signature='o')
         self.assertFalse(self._match.maybe_handle_message(self._message))
 
+    def test_variant_string_match(self):
+        self._message.append(types.String('/', variant_level=2),
+                             signature='v')
+        self.assertTrue(self._match.maybe_handle_message(self._message))
+
+    def test_get_arg_strings(self):
+        self._message.append('a', types.ObjectPath('/b'), 42,
+                             types.String('c', variant_level=1), 'd',
+                             signature='soivs')
+        self.assertEqual(self._message.get_arg_strings(0), ())
+        self.assertEqual(self._message.get_arg_strings(4),
+                         ('a', None, None, 'c'))
+        self.assertEqual(self._message.get_arg_strings(64),
+                         ('a', None, None, 'c', 'd'))
+        self.assertEqual(self._message.get_arg_strings(3, object_paths=True),
+                         ('a', '/b', None))
+        self.assertRaises(ValueError, self._message.get_arg_strings, -1)
+
+    def test_match_tree(self):
+        from dbus.connection import SignalMatch, _SignalMatchTree, \
+                _MessageArgs
+        class FakeConn(object): pass
+        conn = FakeConn()
+        calls = []
+        def make(sender, path, member, **kwargs):
+            def cb(*args):
+                calls.append((name, args))
+            name = kwargs.pop('name')
+            return SignalMatch(conn, sender, path, 'a.b', member, cb,
+                               **kwargs)
+        tree = _SignalMatchTree()
+        matches = [make(None, None, 'c', name='any'),
+                   make(':1.1', '/', 'c', name='sender'),
+                   make(None, '/', None, arg0='x', name='x'),
+                   make(None, '/', None, arg0='y', name='y'),
+                   make(None, None, 'c', arg0='x', arg1='z', name='xz'),
+                   make(None, '/', 'c', arg1='z', name='z')]
+        for m in matches:
+            tree.add(m)
+        self.assertEqual(tree.n_arg_strings, 2)
+
+        def dispatch(sender, *args):
+            from _dbus_bindings import SignalMessage
+            message = SignalMessage('/', 'a.b', 'c')
+            if sender is not None:
+                message.set_sender(sender)
+            message.append(signature='s' * len(args), *args)
+            del calls[:]
+            margs = _MessageArgs(message, tree.n_arg_strings)
+            for m in tree.get_matches('/', 'a.b', 'c', sender, margs):
+                m.maybe_handle_message(message, margs)
+            return [c[0] for c in calls]
+
+        self.assertEqual(dispatch(None, 'x'), ['any', 'x'])
+        self.assertEqual(dispatch(':1.1', 'y', 'z'),
+                         ['any', 'sender', 'y', 'z'])
+        self.assertEqual(dispatch(':1.2', 'x', 'z'), ['any', 'x', 'xz', 'z'])
+
+        tree.set_sender_name_owner(matches[1], ':1.2')
+        self.assertEqual(dispatch(':1.2', 'w'), ['any', 'sender'])
+        self.assertEqual(dispatch(':1.1', 'w'), ['any'])
+
+        self.assertEqual(tree.get_rule_matches('/', 'a.b', None),
+                         matches[2:4])
+        for m in matches:
+            tree.remove(m)
+        self.assertEqual(tree._by_rule, {})
+        self.assertEqual(dispatch(None, 'x', 'z'), [])
+
+        # argNpath and arg0namespace matches are indexed too
+        matches = [make(None, '/', 'c', arg0namespace='com.example',
+                        name='ns'),
+                   make(None, '/', 'c', arg0namespace='com.example.Foo',
+                        name='ns-foo'),
+                   make(None, '/', 'c', arg1path='/aa/', name='path-aa/'),
+                   make(None, '/', 'c', arg1path='/aa/bb', name='path-bb'),
+                   make(None, '/', 'c', arg1path='/', name='path-root'),
+                   make(None, '/', 'c', arg0namespace='com.example',
+                        arg1path='/aa/bb/', name='both')]
+        for m in matches:
+            tree.add(m)
+        self.assertEqual(str(matches[5]),
+                         "type='signal',path='/',interface='a.b',"
+                         "member='c',arg1path='/aa/bb/',"
+                         "arg0namespace='com.example'")
+        self.assertEqual(dispatch(None, 'com.example'), ['ns'])
+        self.assertEqual(dispatch(None, 'com.example.Foo'), ['ns', 'ns-foo'])
+        self.assertEqual(dispatch(None, 'com.examples'), [])
+        self.assertEqual(dispatch(None, 'x', '/aa/bb'),
+                         ['path-aa/', 'path-bb', 'path-root'])
+        self.assertEqual(dispatch(None, 'com.example.Bar', '/aa/'),
+                         ['ns', 'path-aa/', 'path-bb', 'path-root', 'both'])
+        self.assertEqual(dispatch(None, 'x', '/aa'), ['path-root'])
+        for m in matches:
+            tree.remove(m)
+        self.assertEqual(tree._by_rule, {})
+
+        # path_namespace is checked by the match itself
+        match = make(None, None, 'c', path_namespace='/aa', name='subtree')
+        self.assertEqual(str(match),
+                         "type='signal',path_namespace='/aa',"
+                         "interface='a.b',member='c'")
+        for (path, handled) in (('/aa', True), ('/aa/bb', True),
+                                ('/aab', False), ('/', False)):
+            from _dbus_bindings import SignalMessage
+            message = SignalMessage(path, 'a.b', 'c')
+            self.assertEqual(match.maybe_handle_message(message), handled)
+        self.assertRaises(TypeError, make, None, '/', 'c',
+                          path_namespace='/aa', name='both-paths')
+
+    def test_receivers_share_arguments(self):
+        from _dbus_bindings import SignalMessage
+        from dbus.connection import SignalMatch, _MessageArgs
+        class FakeConn(object): pass
+        conn = FakeConn()
+        seen = []
+        def mutate(items):
+            seen.append(list(items))
+            items.append(types.Int32(4))
+        def record(items):
+            seen.append(list(items))
+        message = SignalMessage('/', 'a.b', 'c')
+        message.append([1, 2, 3], signature='ai')
+        margs = _MessageArgs(message, 0)
+        for cb in (mutate, record):
+            SignalMatch(conn, None, '/', 'a.b', 'c',
+                        cb).maybe_handle_message(message, margs)
+        # receivers with the same options are given the same objects, so a
+        # change made by one is seen by those called after it
+        self.assertEqual(seen, [[1, 2, 3], [1, 2, 3, 4]])
+
+class TestServiceDispatch(unittest.TestCase):
+    fast = False
+
+    def setUp(self):
+        import dbus.service
+
+        class FakeConn(object):
+            def __init__(self):
+                self.sent = []
+            def send_message(self, message):
+                self.sent.append(message)
+            def _register_object_path(self, *args):
+                pass
+            def list_exported_child_objects(self, path):
+                return []
+            def _get_main_loop(self):
+                return None
+
+        class Base(dbus.service.Object):
+            FAST_DISPATCH = self.fast
+
+            @dbus.service.method('com.example.Base', in_signature='s',
+                                 out_signature='s',
+                                 sender_keyword='sender')
+            def Echo(self, s, sender=None):
+                return '%s from %s' % (s, sender)
+
+            @dbus.service.method('com.example.Base', in_signature='',
+                                 out_signature='ii')
+            def Pair(self):
+                return 1, 2
+
+            @dbus.service.method('com.example.Base', in_signature='',
+                                 out_signature='', path_keyword='path',
+                                 message_keyword='message',
+                                 connection_keyword='connection')
+            def Keywords(self, path, message, connection):
+                self.keywords = (path, message, connection)
+
+            @dbus.service.method('com.example.Base', in_signature='',
+                                 out_signature='s',
+                                 async_callbacks=('reply', 'error'))
+            def Later(self, reply, error):
+                self.later = reply
+
+            @dbus.service.method('com.example.Base', in_signature='i')
+            def Fail(self, n):
+                if n == 2:
+                    raise ValueError('two')
+                if n:
+                    raise dbus.exceptions.DBusException(
+                        'failed', name='com.example.Failed')
+                return 'not None'
+
+            @dbus.service.method('com.example.Base', in_signature='a{si}',
+                                 out_signature='s')
+            def TypeOf(self, d):
+                return d['x'].__class__.__name__
+
+            @dbus.service.method('com.example.Base', in_signature='a{si}',
+                                 out_signature='s', native=True)
+            def NativeTypeOf(self, d):
+                return d['x'].__class__.__name__
+
+        class Derived(Base):
+            # overrides without re-decorating: still exported
+            def Echo(self, s, sender=None):
+                return 'derived'
+
+        self.conn = FakeConn()
+        self.Derived = Derived
+        self.obj = Derived()
+        self.handler = self.obj._get_message_cb()
+        self.serial = 0
+
+    def call(self, member, interface='com.example.Base', *args):
+        message = lowlevel.MethodCallMessage(None, '/', interface, member)
+        self.serial += 1
+        message._set_serial(self.serial)
+        message.set_sender(':1.23')
+        if args:
+            message.append(*args)
+        self.handler(self.conn, message)
+        reply = self.conn.sent.pop()
+        self.assertEqual(reply.get_reply_serial(), self.serial)
+        return reply
+
+    def test_dispatch(self):
+        aeq = self.assertEqual
+        for i in range(2):
+            aeq(self.call('Echo', 'com.example.Base', 'x').get_args_list(),
+                ['derived'])
+            aeq(self.call('Echo', None, 'x').get_args_list(), ['derived'])
+            reply = self.call('Pair')
+            aeq(reply.get_signature(), 'ii')
+            aeq(reply.get_args_list(), [1, 2])
+            aeq(self.call('Introspect',
+                          'org.freedesktop.DBus.Introspectable').get_signature(),
+                's')
+            aeq(self.call('Nope').get_error_name(),
+                'org.freedesktop.DBus.Error.UnknownMethod')
+            aeq(self.call('Pair', 'com.example.Other').get_error_name(),
+                'org.freedesktop.DBus.Error.UnknownMethod')
+
+    def test_dispatch_handler(self):
+        self.assertEqual(
+            isinstance(self.handler, _dbus_bindings._MethodDispatcher),
+            self.fast)
+
+    def test_dispatch_keywords(self):
+        aeq = self.assertEqual
+        reply = self.call('Keywords')
+        aeq(reply.get_signature(), '')
+        path, message, connection = self.obj.keywords
+        aeq(path, '/')
+        aeq(path.__class__, types.ObjectPath)
+        aeq(message.get_reply_serial(), 0)
+        aeq(message.get_serial(), self.serial)
+        self.assertTrue(connection is self.conn)
+
+        message = lowlevel.MethodCallMessage(None, '/', 'com.example.Base',
+                                             'Later')
+        message._set_serial(1000)
+        self.handler(self.conn, message)
+        aeq(self.conn.sent, [])
+        self.obj.later('later')
+        aeq(self.conn.sent.pop().get_args_list(), ['later'])
+
+    def test_dispatch_errors(self):
+        aeq = self.assertEqual
+        reply = self.call('Fail', 'com.example.Base', 1)
+        aeq(reply.get_error_name(), 'com.example.Failed')
+        aeq(reply.get_args_list(), ['failed'])
+        # the output signature is the default, which is "guess"
+        aeq(self.call('Fail', 'com.example.Base', 0).get_args_list(),
+            ['not None'])
+        # in_signature isn't checked, so this is too many arguments
+        reply = self.call('Pair', 'com.example.Base', 'surplus')
+        aeq(reply.get_error_name(),
+            'org.freedesktop.DBus.Python.TypeError')
+        reply = self.call('Fail', 'com.example.Base', 2)
+        aeq(reply.get_error_name(),
+            'org.freedesktop.DBus.Python.ValueError')
+        self.assertTrue('Traceback' in reply.get_args_list()[0])
+        self.assertTrue("raise ValueError('two')" in reply.get_args_list()[0])
+
+    def test_dispatch_native(self):
+        aeq = self.assertEqual
+        arg = {'x': types.Int32(1)}
+        aeq(self.call('TypeOf', 'com.example.Base', arg).get_args_list(),
+            ['Int32'])
+        aeq(self.call('NativeTypeOf', 'com.example.Base',
+                      arg).get_args_list(), ['int'])
+        self.conn.native_args = True
+        aeq(self.call('TypeOf', 'com.example.Base', arg).get_args_list(),
+            ['int'])
+
+    def test_dispatch_table_invalidation(self):
+        aeq = self.assertEqual
+        aeq(self.call('Echo', None, 'x').get_args_list(), ['derived'])
+        del self.Derived.Echo
+        aeq(self.call('Echo', None, 'x').get_args_list(),
+            ['x from :1.23'])
+
+    def test_dispatch_table_unrelated_attributes(self):
+        import dbus.service
+        aeq = self.assertEqual
+        Derived = self.Derived
+        Base = Derived.__bases__[0]
+        self.call('Echo', None, 'x')
+        table = Derived.__dict__['_dbus_dispatch_table']
+        # plain class state doesn't affect dispatch
+        Derived.counter = 1
+        Base.counter = 2
+        del Derived.counter
+        self.assertTrue(Derived.__dict__['_dbus_dispatch_table'] is table)
+
+        # a new method invalidates the class and its subclasses only
+        def Added(self):
+            return 'added'
+        Base.Added = dbus.service.method('com.example.Base',
+                                         out_signature='s')(Added)
+        self.assertTrue(Base.__dict__['_dbus_dispatch_table'] is None)
+        self.assertTrue(Derived.__dict__['_dbus_dispatch_table'] is None)
+        self.assertTrue(dbus.service.Object.__dict__['_dbus_dispatch_table']
+                        is not None)
+        aeq(self.call('Added').get_args_list(), ['added'])
+
+    def test_construction_bookkeeping(self):
+        import dbus.service
+
+        class Plain(dbus.service.Interface):
+            pass
+
+        # only Objects are tracked while they're being constructed
+        self.assertFalse('_dbus_constructing_exports' in vars(Plain()))
+        self.assertTrue(self.obj._dbus_constructing_exports is None)
+
+    def test_properties(self):
+        import dbus.service
+        aeq = self.assertEqual
+        iface = 'com.example.Props'
+
+        class Props(dbus.service.Object, dbus.service.PropertiesInterface):
+            FAST_DISPATCH = self.fast
+
+            def __init__(self):
+                dbus.service.Object.__init__(self)
+                self._volume = 1
+                self._name = 'a'
+                self.secret = 0
+
+            @dbus.service.property(iface, 'u', writable=True)
+            def Volume(self):
+                return self._volume
+
+            @Volume.setter
+            def Volume(self, value):
+                self._volume = value
+
+            @dbus.service.property(iface, 's')
+            def Name(self):
+                return self._name
+
+            @Name.setter
+            def Name(self, value):
+                self._name = value
+
+            @dbus.service.property(iface, 'i', emits_change='invalidates')
+            def Secret(self):
+                return self.secret
+
+            @dbus.service.property(iface, 'as', emits_change='const')
+            def Tags(self):
+                return ['x']
+
+            @dbus.service.method(iface, in_signature='us')
+            def SetBoth(self, volume, name):
+                self.Volume = volume
+                self.Name = name
+
+        obj = Props()
+        obj.add_to_connection(self.conn, '/')
+        self.handler = obj._get_message_cb()
+        signals = self.conn.sent
+        # the state behind the properties is only created once needed
+        self.assertTrue(obj._dbus_properties is None)
+
+        def changes():
+            ret = [s.get_args_list() for s in signals]
+            del signals[:]
+            return ret
+
+        reply = self.call('GetAll', dbus.PROPERTIES_IFACE, iface)
+        self.assertFalse(obj._dbus_properties is None)
+        aeq(reply.get_signature(), 'a{sv}')
+        aeq(reply.get_args_list(),
+            [{'Volume': 1, 'Name': 'a', 'Secret': 0, 'Tags': ['x']}])
+        aeq(reply.get_args_list()[0]['Volume'].__class__, types.UInt32)
+        self.assertTrue(obj.GetAll(iface) is obj.GetAll(iface))
+        aeq(self.call('Get', dbus.PROPERTIES_IFACE, iface,
+                      'Name').get_args_list(), ['a'])
+        aeq(self.call('GetAll', dbus.PROPERTIES_IFACE,
+                      'com.example.Nope').get_error_name(),
+            'org.freedesktop.DBus.Error.UnknownInterface')
+        aeq(self.call('Get', dbus.PROPERTIES_IFACE, iface,
+                      'Nope').get_error_name(),
+            'org.freedesktop.DBus.Error.UnknownProperty')
+
+        # changes made by a method call are merged, and emitted before the
+        # reply
+        self.call('SetBoth', iface, types.UInt32(5), 'b')
+        aeq(changes(), [[iface, {'Volume': 5, 'Name': 'b'}, []]])
+        aeq(self.call('Get', dbus.PROPERTIES_IFACE, iface,
+                      'Volume').get_args_list(), [5])
+
+        self.call('Set', dbus.PROPERTIES_IFACE, iface, 'Volume',
+                  types.UInt32(7))
+        aeq(changes(), [[iface, {'Volume': 7}, []]])
+        aeq(self.call('Set', dbus.PROPERTIES_IFACE, iface, 'Name',
+                      'c').get_error_name(),
+            'org.freedesktop.DBus.Error.PropertyReadOnly')
+        aeq(changes(), [])
+
+        # values that are not of the property's type are rejected
+        for bad in ('abc', types.Int32(-1), types.Array(['x'],
+                                                        signature='s')):
+            aeq(self.call('Set', dbus.PROPERTIES_IFACE, iface, 'Volume',
+                          bad).get_error_name(),
+                'org.freedesktop.DBus.Error.InvalidArgs')
+        aeq(changes(), [])
+        aeq(self.call('GetAll', dbus.PROPERTIES_IFACE,
+                      iface).get_args_list()[0]['Volume'], 7)
+
+        # other changes are emitted immediately, without a main loop to
+        # merge them (see TestEpollMainLoop.test_properties_changed)
+        obj.secret = 3
+        Props.Secret.changed(obj)
+        aeq(changes(), [[iface, {}, ['Secret']]])
+        aeq(obj.GetAll(iface)['Secret'].value, 3)
+        obj.PROPERTIES_CHANGED_DELAY = 0.05
+        obj.Volume = 8
+        obj.Name = 'd'
+        aeq(changes(), [[iface, {'Volume': 8}, []],
+                        [iface, {'Name': 'd'}, []]])
+
+        xml = self.call('Introspect', dbus.INTROSPECTABLE_IFACE
+                        ).get_args_list()[0]
+        self.assertTrue('<property name="Volume" type="u" '
+                        'access="readwrite" />' in xml)
+        self.assertTrue('<property name="Name" type="s" access="read" />'
+                        in xml)
+        self.assertTrue('value="const"' in xml)
+
+        # only objects with properties implement the interface, and so
+        # take over methods with its method names
+        class Legacy(dbus.service.Object):
+            FAST_DISPATCH = self.fast
+
+            @dbus.service.method(iface)
+            def Poke(self):
+                pass
+
+            def Set(self, interface_name, property_name, value):
+                raise AssertionError('should not be called')
+
+        legacy = Legacy()
+        legacy.add_to_connection(self.conn, '/')
+        self.handler = legacy._get_message_cb()
+        aeq(self.call('Set', dbus.PROPERTIES_IFACE, iface, 'Volume',
+                      types.UInt32(1)).get_error_name(),
+            'org.freedesktop.DBus.Error.UnknownMethod')
+        xml = self.call('Introspect', dbus.INTROSPECTABLE_IFACE
+                        ).get_args_list()[0]
+        self.assertFalse(dbus.PROPERTIES_IFACE in xml)
+
+        def declare_without_mixin():
+            class Bad(dbus.service.Object):
+                @dbus.service.property(iface, 'u')
+                def Volume(self):
+                    return 1
+        self.assertRaises(TypeError, declare_without_mixin)
+
+class TestServiceFastDispatch(TestServiceDispatch):
+    fast = True
+
+class TestEpollMainLoop(unittest.TestCase):
+    def setUp(self):
+        import dbus.connection
+        import dbus.server
+        import dbus.service
+        from dbus.mainloop.epoll import DBusEpollMainLoop
+
+        class Obj(dbus.service.Object):
+            SUPPORTS_MULTIPLE_CONNECTIONS = True
+
+            @dbus.service.method('com.example.Epoll', in_signature='s',
+                                 out_signature='s')
+            def Echo(self, s):
+                return s
+
+            @dbus.service.method('com.example.Epoll',
+                                 async_callbacks=('reply', 'error'))
+            def Never(self, reply, error):
+                pass
+
+        self.loop = DBusEpollMainLoop()
+        self.obj = Obj()
+        self.server = dbus.server.Server('unix:tmpdir=/tmp',
+                                         mainloop=self.loop)
+        self.server.on_connection_added.append(
+                lambda conn: self.obj.add_to_connection(conn, '/'))
+
+        # objects under /things are only created when they're addressed
+        self.resolved = []
+        self.subtrees = []
+
+        def resolve(path):
+            self.resolved.append(path)
+            if path.count('/') == 3:
+                return Obj()
+            return None
+
+        def enumerate_things(path):
+            if path == '/things':
+                return ['a', 'b']
+            if path == '/things/bad':
+                raise ValueError('no children here')
+            return []
+
+        self.server.on_connection_added.append(
+                lambda conn: self.subtrees.append(dbus.service.ObjectSubtree(
+                    conn, '/things', resolve, enumerate_things)))
+        self.conn = dbus.connection.Connection(self.server.address,
+                                               mainloop=self.loop)
+
+    def tearDown(self):
+        self.conn.close()
+        self.server.disconnect()
+
+    def run_with_server(self, func):
+        """Run the main loop in another thread, and call func with the
+        server side of self.conn, returning what it returns."""
+        import threading
+
+        thread = threading.Thread(target=self.loop.run)
+        thread.start()
+        try:
+            # make sure the server side has seen the connection
+            self.conn.call_blocking(None, '/', 'com.example.Epoll', 'Echo',
+                                    's', ('',))
+            return func(self.subtrees[-1].connection)
+        finally:
+            self.loop.quit()
+            thread.join()
+
+    def test_isinstance(self):
+        import dbus.mainloop
+        self.assertTrue(isinstance(self.loop, dbus.mainloop.NativeMainLoop))
+
+    def test_calls_and_timeouts(self):
+        results = []
+
+        def error(e):
+            results.append(e.get_dbus_name())
+            self.loop.quit()
+
+        def reply(s):
+            results.append(s)
+            self.conn.call_async(None, '/', 'com.example.Epoll', 'Never',
+                                 '', (), None, error, timeout=0.05)
+
+        self.conn.call_async(None, '/', 'com.example.Epoll', 'Echo', 's',
+                             ('hello',), reply, error)
+        self.loop.run()
+        self.assertEqual(results,
+                         ['hello', 'org.freedesktop.DBus.Error.NoReply'])
+
+    def test_quit_from_thread(self):
+        import threading
+        results = []
+
+        def worker():
+            results.append(self.conn.call_blocking(
+                None, '/', 'com.example.Epoll', 'Echo', 's', ('thread',)))
+            self.loop.quit()
+
+        thread = threading.Thread(target=worker)
+        thread.start()
+        self.loop.run()
+        thread.join()
+        self.assertEqual(results, ['thread'])
+
+    def test_call_many(self):
+        import threading
+        import dbus.connection
+        import dbus.mainloop
+
+        # the server side runs in another thread; the client has no main
+        # loop at all
+        thread = threading.Thread(target=self.loop.run)
+        thread.start()
+        conn = dbus.connection.Connection(
+                self.server.address, mainloop=dbus.mainloop.NULL_MAIN_LOOP)
+        try:
+            calls = [(None, '/', 'com.example.Epoll', 'Echo', 's', (str(i),))
+                     for i in range(100)]
+            calls.insert(10, (None, '/', 'com.example.Epoll', 'Never', '',
+                              ()))
+            calls.insert(20, (None, '/', 'com.example.Epoll', 'Nope', '',
+                              ()))
+            results = conn.call_many(calls, timeout=0.5)
+            self.assertEqual(conn.call_many([]), [])
+        finally:
+            conn.close()
+            self.loop.quit()
+            thread.join()
+
+        self.assertEqual(len(results), 102)
+        self.assertEqual(results[10].get_dbus_name(),
+                         'org.freedesktop.DBus.Error.NoReply')
+        self.assertEqual(results[20].get_dbus_name(),
+                         'org.freedesktop.DBus.Error.UnknownMethod')
+        del results[20], results[10]
+        self.assertEqual(results, [str(i) for i in range(100)])
+
+    def test_object_subtree(self):
+        import threading
+        import dbus.connection
+        import dbus.mainloop
+
+        thread = threading.Thread(target=self.loop.run)
+        thread.start()
+        conn = dbus.connection.Connection(
+                self.server.address, mainloop=dbus.mainloop.NULL_MAIN_LOOP)
+        echo = ('com.example.Epoll', 'Echo', 's', ('x',))
+        introspect = ('org.freedesktop.DBus.Introspectable', 'Introspect',
+                      '', ())
+        try:
+            # signals don't bring objects into existence
+            conn.send_message(lowlevel.SignalMessage('/things/s/1',
+                                                     'com.example.Epoll',
+                                                     'Ping'))
+            results = conn.call_many([
+                (None, '/things/a/1') + echo,
+                (None, '/things/a/1') + echo,
+                (None, '/things/c') + echo,
+                (None, '/things') + introspect,
+                (None, '/things/a') + introspect,
+                (None, '/things/bad') + introspect,
+                ], timeout=5)
+            subtree = self.subtrees[-1]
+            self.assertEqual(len(subtree), 1)
+            obj = subtree.get('/things/a/1')
+            self.assertEqual([loc[1] for loc in obj.locations],
+                             ['/things/a/1'])
+            subtree.discard('/things/a/1')
+            self.assertEqual(len(subtree), 0)
+            self.assertEqual(list(obj.locations), [])
+            self.assertEqual(conn.call_many([(None, '/things/a/1') + echo],
+                                            timeout=5), ['x'])
+            subtree.remove_from_connection()
+            self.assertEqual(len(subtree), 0)
+        finally:
+            conn.close()
+            self.loop.quit()
+            thread.join()
+
+        self.assertEqual(results[:2], ['x', 'x'])
+        self.assertEqual(results[2].get_dbus_name(),
+                         'org.freedesktop.DBus.Error.UnknownObject')
+        self.assertTrue('<node name="a"/>' in results[3])
+        self.assertTrue('<node name="b"/>' in results[3])
+        # /things/a/1 has been created but isn't in the enumeration
+        self.assertTrue('<node name="1"/>' in results[4])
+        # an enumerator error is passed on, not treated as no children
+        self.assertTrue(results[5].get_dbus_name().endswith('.ValueError'))
+        self.assertEqual(self.resolved, ['/things/a/1', '/things/c',
+                                         '/things', '/things/a',
+                                         '/things/bad', '/things/a/1'])
+
+    def test_object_manager(self):
+        import threading
+        import dbus
+        import dbus.proxies
+        import dbus.service
+
+        class Thing(dbus.service.Object):
+            def __init__(self, conn, path):
+                dbus.service.Object.__init__(self, conn, path)
+                # only set once the object has been exported
+                self.size = len(path)
+
+            @dbus.service.method(dbus.PROPERTIES_IFACE, in_signature='s',
+                                 out_signature='a{sv}')
+            def GetAll(self, interface):
+                if interface == 'com.example.Thing':
+                    return {'Size': dbus.UInt32(self.size)}
+                raise dbus.DBusException('no properties')
+
+            @dbus.service.method('com.example.Thing')
+            def Poke(self):
+                pass
+
+        events = []
+        changed = threading.Event()
+
+        def added(path, interfaces):
+            events.append(('added', path, sorted(interfaces)))
+            changed.set()
+
+        def removed(path, interfaces):
+            events.append(('removed', path, sorted(interfaces)))
+            changed.set()
+
+        def check(server_conn):
+            # so that the proxy is only made once the signal announcing
+            # the inner manager has been dispatched
+            inner_added = threading.Event()
+            self.conn.add_signal_receiver(
+                lambda path, interfaces: inner_added.set(),
+                'InterfacesAdded', dbus.OBJECT_MANAGER_IFACE, None, '/om')
+
+            # objects exported before their manager are included too
+            early = Thing(server_conn, '/om/early')
+            manager = dbus.service.ObjectManager(server_conn, '/om')
+            inner = dbus.service.ObjectManager(server_conn, '/om/inner')
+            Thing(server_conn, '/om/inner/hidden')
+            Thing(server_conn, '/other')
+            self.assertTrue(inner_added.wait(5))
+
+            proxy = dbus.proxies.ObjectManagerProxy(self.conn, None, '/om')
+            proxy.on_interfaces_added.append(added)
+            proxy.on_interfaces_removed.append(removed)
+            self.assertEqual(sorted(proxy.objects), ['/om/early', '/om/inner'])
+            self.assertEqual(
+                proxy.get_interfaces('/om/early')['com.example.Thing'],
+                {'Size': 9})
+            self.assertEqual(
+                proxy.get_interfaces('/om/inner')[dbus.OBJECT_MANAGER_IFACE],
+                {})
+
+            late = Thing(server_conn, '/om/late')
+            self.assertTrue(changed.wait(5))
+            changed.clear()
+            self.assertEqual(
+                proxy.get_interfaces('/om/late')['com.example.Thing'],
+                {'Size': 8})
+
+            early.remove_from_connection()
+            self.assertTrue(changed.wait(5))
+            self.assertEqual(sorted(proxy.objects), ['/om/inner', '/om/late'])
+            proxy.close()
+
+        self.run_with_server(check)
+
+        ifaces = sorted([dbus.INTROSPECTABLE_IFACE, dbus.PROPERTIES_IFACE,
+                         'com.example.Thing'])
+        self.assertEqual(events, [('added', '/om/late', ifaces),
+                                  ('removed', '/om/early', ifaces)])
+
+    def test_object_manager_bookkeeping(self):
+        import dbus
+        import dbus.service
+
+        conn = self.conn
+        managers = dbus.service._managers
+
+        def managed(manager, path):
+            return sorted(manager.GetManagedObjects(path, conn))
+
+        # nothing is recorded for connections without a manager
+        before = dbus.service.Object(conn, '/bk/before')
+        self.assertFalse(conn in managers)
+
+        # objects already exported, including in subtrees, are found
+        subtree = dbus.service.ObjectSubtree(
+                conn, '/bk/sub/tree', lambda path: dbus.service.Object())
+        subtree.add('/bk/sub/tree/x', dbus.service.Object())
+        outer = dbus.service.ObjectManager(conn, '/bk')
+        self.assertEqual(managed(outer, '/bk'),
+                         ['/bk/before', '/bk/sub/tree/x'])
+
+        # an inner manager takes over the objects below it, and hands them
+        # back when it is removed
+        inner = dbus.service.ObjectManager(conn, '/bk/sub')
+        self.assertEqual(managed(outer, '/bk'), ['/bk/before', '/bk/sub'])
+        self.assertEqual(managed(inner, '/bk/sub'), ['/bk/sub/tree/x'])
+        inner.remove_from_connection()
+        self.assertEqual(managed(outer, '/bk'),
+                         ['/bk/before', '/bk/sub/tree/x'])
+
+        outer.remove_from_connection()
+        self.assertFalse(conn in managers)
+        subtree.remove_from_connection()
+        before.remove_from_connection()
+
+    def test_object_manager_proxy_loading(self):
+        import dbus
+        import dbus.proxies
+
+        class Match(object):
+            def remove(self):
+                pass
+
+        class LoadingConn(object):
+            # stands in for a connection whose signals are dispatched in
+            # another thread while GetManagedObjects is in progress
+            def __init__(self):
+                self.handlers = {}
+
+            def add_signal_receiver(self, handler, member, *args, **kwargs):
+                self.handlers[member] = handler
+                return Match()
+
+            def call_blocking(self, *args):
+                added = self.handlers['InterfacesAdded']
+                removed = self.handlers['InterfacesRemoved']
+                changed = self.handlers['PropertiesChanged']
+                added('/om/a', {'com.example.A': {'X': 1}})
+                changed('com.example.A', {'X': 2}, [], path='/om/a')
+                added('/om/b', {'com.example.B': {}})
+                removed('/om/c', ['com.example.C'])
+                # the reply already reflects some of the changes
+                return {'/om/a': {'com.example.A': {'X': 2}},
+                        '/om/c': {'com.example.C': {}}}
+
+        proxy = dbus.proxies.ObjectManagerProxy(LoadingConn(), None, '/om')
+        self.assertEqual(proxy.objects,
+                         {'/om/a': {'com.example.A': {'X': 2}},
+                          '/om/b': {'com.example.B': {}}})
+
+    def test_property_cache(self):
+        import gc
+        import threading
+        import dbus
+        import dbus.service
+        iface = 'com.example.Cached'
+
+        class Cached(dbus.service.Object, dbus.service.PropertiesInterface):
+            gets = 0
+            level = 1
+            token = 'x'
+            count = 0
+
+            @dbus.service.method(dbus.PROPERTIES_IFACE, in_signature='s',
+                                 out_signature='a{sv}')
+            def GetAll(self, interface):
+                self.gets += 1
+                return dbus.service.PropertiesInterface.GetAll(self,
+                                                               interface)
+
+            @dbus.service.property(iface, 'u', writable=True)
+            def Level(self):
+                return self.level
+
+            @Level.setter
+            def Level(self, value):
+                self.level = value
+
+            @dbus.service.property(iface, 's', emits_change='invalidates')
+            def Token(self):
+                return self.token
+
+            @dbus.service.property(iface, 'i', emits_change=False)
+            def Count(self):
+                return self.count
+
+            @Count.setter
+            def Count(self, value):
+                self.count = value
+
+        class GetOnly(dbus.service.Object):
+            gets = 0
+
+            @dbus.service.method(dbus.PROPERTIES_IFACE, in_signature='ss',
+                                 out_signature='v')
+            def Get(self, interface, name):
+                self.gets += 1
+                return name.lower()
+
+        changes = []
+        changed = threading.Event()
+
+        def on_changed(*args):
+            changes.append(args)
+            changed.set()
+
+        def matches():
+            return len(list(self.conn._signal_match_tree.get_rule_matches(
+                '/cached', dbus.PROPERTIES_IFACE, 'PropertiesChanged')))
+
+        def check(server_conn):
+            obj = Cached(server_conn, '/cached')
+            proxy = self.conn.get_object(None, '/cached', introspect=False,
+                                         cache_properties=True)
+            props = dbus.Interface(proxy, dbus.PROPERTIES_IFACE)
+            # the match is only added once properties are read
+            self.assertEqual(matches(), 0)
+            self.assertEqual(props.Get(iface, 'Level'), 1)
+            self.assertEqual(matches(), 1)
+            # registered after the cache's own receiver, so it runs later
+            self.conn.add_signal_receiver(on_changed, 'PropertiesChanged',
+                                          dbus.PROPERTIES_IFACE, None,
+                                          '/cached')
+
+            self.assertEqual(props.Get(iface, 'Token'), 'x')
+            self.assertEqual(props.GetAll(iface),
+                             {'Level': 1, 'Token': 'x', 'Count': 0})
+            self.assertEqual(obj.gets, 1)
+
+            Cached.Level.__set__(obj, 5)
+            self.assertTrue(changed.wait(5))
+            changed.clear()
+            self.assertEqual(props.Get(iface, 'Level'), 5)
+            self.assertEqual(obj.gets, 1)
+
+            # invalidated properties are fetched again individually
+            obj.token = 'y'
+            Cached.Token.changed(obj)
+            self.assertTrue(changed.wait(5))
+            changed.clear()
+            self.assertEqual(props.Get(iface, 'Token'), 'y')
+            self.assertEqual(obj.gets, 1)
+
+            # Set goes to the remote object, and the new value is not served
+            # from the cache before it has been read back
+            props.Set(iface, 'Level', dbus.UInt32(7))
+            self.assertEqual(props.Get(iface, 'Level'), 7)
+
+            replies = []
+            props.Get(iface, 'Level', reply_handler=replies.append,
+                      error_handler=replies.append)
+            self.assertEqual(replies, [7])
+
+            # changes the object does not announce need refresh_properties()
+            Cached.Count.__set__(obj, 9)
+            self.assertEqual(props.Get(iface, 'Count'), 0)
+            proxy.refresh_properties(iface)
+            self.assertEqual(props.Get(iface, 'Count'), 9)
+            self.assertEqual(obj.gets, 2)
+
+            # objects without GetAll have their properties read with Get
+            get_only = GetOnly(server_conn, '/get_only')
+            partial = self.conn.get_object(None, '/get_only',
+                                           introspect=False,
+                                           cache_properties=True)
+            partial_props = dbus.Interface(partial, dbus.PROPERTIES_IFACE)
+            self.assertEqual(partial_props.Get(iface, 'Level'), 'level')
+            self.assertEqual(partial_props.Get(iface, 'Level'), 'level')
+            self.assertEqual(partial_props.Get(iface, 'Token'), 'token')
+            self.assertEqual(get_only.gets, 2)
+            try:
+                partial_props.GetAll(iface)
+            except dbus.DBusException as e:
+                self.assertEqual(e.get_dbus_name(),
+                                 'org.freedesktop.DBus.Error.UnknownMethod')
+            else:
+                self.fail('GetAll should have failed')
+            partial.close_property_cache()
+
+            # once closed, the proxy stops caching
+            proxy.close_property_cache()
+            self.assertEqual(matches(), 1)
+            Cached.Count.__set__(obj, 10)
+            self.assertEqual(props.Get(iface, 'Count'), 10)
+
+            # a proxy that is just dropped removes its match too
+            other = self.conn.get_object(None, '/cached', introspect=False,
+                                         cache_properties=True)
+            self.assertEqual(dbus.Interface(other, dbus.PROPERTIES_IFACE)
+                             .Get(iface, 'Count'), 10)
+            self.assertEqual(matches(), 2)
+            del other
+            gc.collect()
+            self.assertEqual(matches(), 1)
+
+        self.run_with_server(check)
+
+        # proxy.refresh and proxy.close are still remote methods
+        proxy = self.conn.get_object(None, '/cached', introspect=False,
+                                     cache_properties=True)
+        self.assertTrue(isinstance(proxy.refresh, dbus.proxies._ProxyMethod))
+        self.assertTrue(isinstance(proxy.close, dbus.proxies._ProxyMethod))
+
+    def test_signal_fan_out(self):
+        import threading
+        import dbus
+        import dbus.service
+
+        class Emitter(dbus.service.Object):
+            SUPPORTS_MULTIPLE_OBJECT_PATHS = True
+
+            @dbus.service.signal('com.example.Emitter', signature='sai')
+            def Fired(self, name, values):
+                pass
+
+        received = []
+        done = threading.Event()
+
+        def fired(name, values, path=None):
+            received.append((path, name, list(values)))
+            if len(received) == 3:
+                done.set()
+
+        def check(server_conn):
+            self.conn.add_signal_receiver(fired, 'Fired',
+                                          'com.example.Emitter',
+                                          path_keyword='path')
+            emitter = Emitter()
+            for path in ('/e/1', '/e/2', '/e/3'):
+                emitter.add_to_connection(server_conn, path)
+
+            serials = server_conn.send_messages([])
+            self.assertEqual(serials, [])
+
+            emitter.Fired('bang', [1, 2, 3])
+            self.assertTrue(done.wait(5))
+
+        self.run_with_server(check)
+
+        self.assertEqual(sorted(received),
+                         [('/e/1', 'bang', [1, 2, 3]),
+                          ('/e/2', 'bang', [1, 2, 3]),
+                          ('/e/3', 'bang', [1, 2, 3])])
+
+    def test_properties_changed(self):
+        import threading
+        import dbus
+        import dbus.service
+
+        iface = 'com.example.Props'
+
+        class Props(dbus.service.Object, dbus.service.PropertiesInterface):
+            @dbus.service.property(iface, 'u')
+            def Volume(self):
+                return self._volume
+
+            @Volume.setter
+            def Volume(self, value):
+                self._volume = value
+
+            @dbus.service.property(iface, 's')
+            def Name(self):
+                return self._name
+
+            @Name.setter
+            def Name(self, value):
+                self._name = value
+
+        received = []
+        signalled = threading.Event()
+        echoed = threading.Event()
+
+        def changed(interface_name, changed, invalidated):
+            received.append((interface_name, dict(changed),
+                             list(invalidated)))
+            signalled.set()
+
+        def round_trip():
+            # the reply is dispatched after any signals sent before it
+            echoed.clear()
+            self.conn.call_async(None, '/', 'com.example.Epoll', 'Echo',
+                                 's', ('',), lambda s: echoed.set(), None)
+            self.assertTrue(echoed.wait(5))
+
+        def check(server_conn):
+            self.conn.add_signal_receiver(changed, 'PropertiesChanged',
+                                          dbus.PROPERTIES_IFACE)
+            obj = Props()
+            obj.add_to_connection(server_conn, '/props')
+
+            def assign():
+                obj.Volume = 5
+                obj.Name = 'b'
+
+            # changes made in one main loop iteration, other than by a
+            # method call, are merged
+            self.loop.call_later(0, assign)
+            self.assertTrue(signalled.wait(5))
+            round_trip()
+            self.assertEqual(received, [(iface, {'Volume': 5, 'Name': 'b'},
+                                         [])])
+
+            # as are those made during the delay, from any thread
+            del received[:]
+            signalled.clear()
+            obj.PROPERTIES_CHANGED_DELAY = 0.2
+            obj.Volume = 6
+            obj.Name = 'c'
+            self.assertTrue(signalled.wait(5))
+            round_trip()
+            self.assertEqual(received, [(iface, {'Volume': 6, 'Name': 'c'},
+                                         [])])
+
+        self.run_with_server(check)
+
+    def test_dispatch_thread(self):
+        import threading
+        import dbus.connection
+        import dbus.mainloop
+
+        thread = threading.Thread(target=self.loop.run)
+        thread.start()
+        conn = dbus.connection.Connection(
+                self.server.address, mainloop=dbus.mainloop.NULL_MAIN_LOOP)
+        results = []
+        done = threading.Event()
+
+        def reply(s):
+            results.append((s, threading.current_thread() is thread))
+            done.set()
+
+        attached = dbus.connection.Connection(self.server.address,
+                                              mainloop=self.loop)
+        try:
+            self.assertRaises(RuntimeError, attached.start_dispatch_thread)
+            conn.start_dispatch_thread()
+            self.assertRaises(RuntimeError, conn.start_dispatch_thread)
+            conn.call_async(None, '/', 'com.example.Epoll', 'Echo', 's',
+                            ('dispatched',), reply, None)
+            done.wait(5)
+        finally:
+            conn.close()
+            attached.close()
+            self.loop.quit()
+            thread.join()
+
+        self.assertEqual(results, [('dispatched', False)])
+
+    def test_dispatch_batch_size(self):
+        import threading
+        import dbus.connection
+        import dbus.mainloop
+
+        old = dbus.mainloop.get_dispatch_batch_size()
+        thread = threading.Thread(target=self.loop.run)
+        thread.start()
+        conn = dbus.connection.Connection(self.server.address,
+                                          mainloop=self.loop)
+        try:
+            for size in (0, 1, 16):
+                dbus.mainloop.set_dispatch_batch_size(size)
+                self.assertEqual(dbus.mainloop.get_dispatch_batch_size(),
+                                 size)
+                before = dbus.mainloop.get_dispatch_stats()
+                self.assertEqual(conn.call_many(
+                    [(None, '/', 'com.example.Epoll', 'Echo', 's', (str(i),))
+                     for i in range(10)]), [str(i) for i in range(10)])
+                after = dbus.mainloop.get_dispatch_stats()
+                if size:
+                    self.assertTrue(after['messages'] > before['messages'])
+                    self.assertTrue(after['batches'] > before['batches'])
+                else:
+                    self.assertEqual(after['batches'], before['batches'])
+        finally:
+            dbus.mainloop.set_dispatch_batch_size(old)
+            conn.close()
+            self.loop.quit()
+            thread.join()
+
+if not hasattr(_dbus_bindings, 'DBusEpollMainLoop'):
+    del TestEpollMainLoop
+
+class TestAsyncioMainLoop(unittest.TestCase):
+    def run_with_connection(self, coroutine_function):
+        import asyncio
+        import dbus.connection
+        import dbus.server
+        import dbus.service
+        from dbus.mainloop.asyncio import DBusAsyncioMainLoop
+
+        class Obj(dbus.service.Object):
+            SUPPORTS_MULTIPLE_CONNECTIONS = True
+
+            @dbus.service.method('com.example.Asyncio', in_signature='s',
+                                 out_signature='s')
+            def Echo(self, s):
+                return s
+
+            @dbus.service.method('com.example.Asyncio',
+                                 async_callbacks=('reply', 'error'))
+            def Never(self, reply, error):
+                pass
+
+        loop = asyncio.new_event_loop()
+        asyncio.set_event_loop(loop)
+        mainloop = DBusAsyncioMainLoop(loop)
+        obj = Obj()
+        server = dbus.server.Server('unix:tmpdir=/tmp', mainloop=mainloop)
+        server.on_connection_added.append(
+                lambda conn: obj.add_to_connection(conn, '/'))
+        conn = dbus.connection.Connection(server.address, mainloop=mainloop)
+        self.address = server.address
+        try:
+            return loop.run_until_complete(coroutine_function(conn))
+        finally:
+            conn.close()
+            server.disconnect()
+            asyncio.set_event_loop(None)
+            loop.close()
+
+    def test_await_calls(self):
+        import asyncio
+
+        def echo(conn, s):
+            return conn.call_async(None, '/', 'com.example.Asyncio', 'Echo',
+                                   's', (s,))
+
+        def main(conn):
+            return asyncio.gather(*[echo(conn, str(i)) for i in range(50)])
+
+        self.assertEqual(self.run_with_connection(main),
+                         [str(i) for i in range(50)])
+
+    def test_await_error(self):
+        errors = []
+
+        def main(conn):
+            return conn.call_async(None, '/', 'com.example.Asyncio', 'Never',
+                                   '', (), None, errors.append, timeout=0.05)
+
+        try:
+            self.run_with_connection(main)
+        except dbus.DBusException as e:
+            self.assertEqual(e.get_dbus_name(),
+                             'org.freedesktop.DBus.Error.NoReply')
+        else:
+            self.fail('awaiting the call should have raised')
+        self.assertEqual(len(errors), 1)
+
+    def test_dispatch_thread(self):
+        # unlike TestEpollMainLoop, this also runs on builds without the
+        # epoll main loop, which are the only ones where start_dispatch_thread
+        # uses dbus_connection_read_write() instead of an epoll loop
+        import asyncio
+        import threading
+        import dbus.connection
+        import dbus.mainloop
+
+        def main(conn):
+            # conn already has a main loop to dispatch it
+            self.assertRaises(RuntimeError, conn.start_dispatch_thread)
+
+            loop = asyncio.get_event_loop()
+            future = asyncio.Future(loop=loop)
+            client = dbus.connection.Connection(
+                    self.address, mainloop=dbus.mainloop.NULL_MAIN_LOOP)
+            future.add_done_callback(lambda f: client.close())
+
+            def reply(s):
+                loop.call_soon_threadsafe(future.set_result,
+                    (s, threading.current_thread() is main_thread))
+
+            def error(e):
+                loop.call_soon_threadsafe(future.set_exception, e)
+
+            client.start_dispatch_thread()
+            client.call_async(None, '/', 'com.example.Asyncio', 'Echo', 's',
+                              ('threaded',), reply, error)
+            return asyncio.wait_for(future, 5)
+
+        main_thread = threading.current_thread()
+        self.assertEqual(self.run_with_connection(main), ('threaded', False))
+
+if sys.version_info[:2] < (3, 5):
+    del TestAsyncioMainLoop
+
 if __name__ == '__main__':
     # Python 2.6 doesn't accept a `verbosity` keyword.
     kwargs = {}
@@ -0,0 +1,129 @@
+#!/usr/bin/env python
+
+"""Microbenchmark for dispatching method calls to dbus.service.Object.
+
+Run with the freshly-built _dbus_bindings on sys.path, e.g.:
+
+    PYTHONPATH=_dbus_bindings/.libs:. python tools/bench-dispatch.py
+
+Calls the exported object's message handler directly with
+locally-constructed messages and a fake connection which discards the
+replies, so no bus is needed, and prints the latency of each kind of call,
+with and without FAST_DISPATCH.
+"""
+
+# Copyright (C) 2026 agent <agent@local>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+from __future__ import print_function
+
+import sys
+import timeit
+from optparse import OptionParser
+
+import dbus.service
+from dbus.lowlevel import MethodCallMessage
+
+IFACE = 'com.example.Bench'
+
+
+class FakeConnection(object):
+
+    def send_message(self, message):
+        pass
+
+
+class Base(dbus.service.Object):
+
+    @dbus.service.method(IFACE, in_signature='', out_signature='')
+    def Ping(self):
+        pass
+
+    @dbus.service.method(IFACE, in_signature='s', out_signature='s',
+                         sender_keyword='sender')
+    def Echo(self, s, sender=None):
+        return s
+
+    @dbus.service.method(IFACE, in_signature='ii', out_signature='ii')
+    def Swap(self, a, b):
+        return b, a
+
+
+class Derived(Base):
+    """Overrides a method, to make the MRO walk a bit longer."""
+
+    def Ping(self):
+        pass
+
+
+class FastDerived(Derived):
+    FAST_DISPATCH = True
+
+
+CALLS = [
+    ('Ping', IFACE, '', ()),
+    ('Ping (no iface)', None, '', ()),
+    ('Echo', IFACE, 's', ('hello',)),
+    ('Swap', IFACE, 'ii', (1, 2)),
+]
+
+
+def make_message(member, interface, signature, args):
+    message = MethodCallMessage(None, '/', interface, member)
+    message._set_serial(1)
+    message.set_sender(':1.42')
+    if signature:
+        message.append(signature=signature, *args)
+    return message
+
+
+def main():
+    parser = OptionParser(usage='%prog [options]')
+    parser.add_option('-n', '--number', type='int', default=0,
+                      help='calls per timing run (default: auto)')
+    parser.add_option('-r', '--repeat', type='int', default=5,
+                      help='timing runs; the best is reported (default: 5)')
+    options, args = parser.parse_args()
+
+    connection = FakeConnection()
+
+    for cls in Derived, FastDerived:
+        print('FAST_DISPATCH = %s' % cls.FAST_DISPATCH)
+        handler = cls()._get_message_cb()
+        for name, interface, signature, call_args in CALLS:
+            member = name.split()[0]
+            message = make_message(member, interface, signature, call_args)
+            timer = timeit.Timer(lambda: handler(connection, message))
+            number = options.number
+            if not number:
+                number = 1
+                while timer.timeit(number) < 0.2:
+                    number *= 2
+            best = min(timer.repeat(options.repeat, number)) / number
+            print('  %-16s %12.1f us/call %12.1f calls/s'
+                  % (name, best * 1e6, 1.0 / best))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
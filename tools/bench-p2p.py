@@ -0,0 +1,163 @@
+#!/usr/bin/env python
+
+"""Benchmark method calls to exported objects over a peer-to-peer
+connection.
+
+Run with the freshly-built _dbus_bindings on sys.path, e.g.:
+
+    PYTHONPATH=_dbus_bindings/.libs:. python tools/bench-p2p.py
+
+A child process runs a dbus.server.Server with the epoll main loop (or
+the GLib one, with --glib) and exports the same object twice, with and
+without FAST_DISPATCH; the parent connects to it and makes blocking calls.
+No bus is needed.
+"""
+
+# Copyright (C) 2026 agent <agent@local>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+from __future__ import print_function
+
+import os
+import signal
+import sys
+import time
+from optparse import OptionParser
+
+import dbus
+import dbus.connection
+import dbus.server
+import dbus.service
+
+IFACE = 'com.example.Bench'
+
+
+class Bench(dbus.service.Object):
+    SUPPORTS_MULTIPLE_CONNECTIONS = True
+
+    @dbus.service.method(IFACE, in_signature='', out_signature='')
+    def Ping(self):
+        pass
+
+    @dbus.service.method(IFACE, in_signature='s', out_signature='s',
+                         sender_keyword='sender')
+    def Echo(self, s, sender=None):
+        return s
+
+    @dbus.service.method(IFACE, in_signature='a{sv}', out_signature='u')
+    def Count(self, d):
+        return len(d)
+
+
+class FastBench(Bench):
+    FAST_DISPATCH = True
+
+
+CALLS = [
+    ('Ping', '', ()),
+    ('Echo', 's', ('hello',)),
+    ('Count', 'a{sv}', (dict(('key%d' % i, i) for i in range(10)),)),
+]
+
+
+def serve(write_fd, use_glib):
+    if use_glib:
+        from dbus.mainloop.glib import DBusGMainLoop
+        from gi.repository import GLib
+
+        DBusGMainLoop(set_as_default=True)
+        loop = GLib.MainLoop()
+    else:
+        from dbus.mainloop.epoll import DBusEpollMainLoop
+
+        loop = DBusEpollMainLoop(set_as_default=True)
+
+    server = dbus.server.Server('unix:tmpdir=/tmp')
+    slow = Bench()
+    fast = FastBench()
+
+    def connection_added(conn):
+        slow.add_to_connection(conn, '/Slow')
+        fast.add_to_connection(conn, '/Fast')
+
+    server.on_connection_added.append(connection_added)
+    os.write(write_fd, (server.address + '\n').encode('ascii'))
+    os.close(write_fd)
+    loop.run()
+
+
+def main():
+    parser = OptionParser(usage='%prog [options]')
+    parser.add_option('-s', '--seconds', type='float', default=1.0,
+                      help='time to spend on each method (default: 1)')
+    parser.add_option('--glib', action='store_true', default=False,
+                      help='use the GLib main loop in the server')
+    options, args = parser.parse_args()
+
+    try:
+        if options.glib:
+            import gi
+        else:
+            import dbus.mainloop.epoll
+    except ImportError as e:
+        print('Cannot run the server: %s' % e, file=sys.stderr)
+        return 77
+
+    read_fd, write_fd = os.pipe()
+    pid = os.fork()
+    if pid == 0:
+        os.close(read_fd)
+        try:
+            serve(write_fd, options.glib)
+        finally:
+            os._exit(0)
+
+    os.close(write_fd)
+    with os.fdopen(read_fd) as reader:
+        address = reader.readline().strip()
+
+    try:
+        conn = dbus.connection.Connection(address)
+        for path in '/Slow', '/Fast':
+            print('%s:' % path)
+            for member, signature, call_args in CALLS:
+                n = 0
+                start = time.time()
+                deadline = start + options.seconds
+                while True:
+                    conn.call_blocking(None, path, IFACE, member, signature,
+                                       call_args)
+                    n += 1
+                    if n % 100 == 0 and time.time() >= deadline:
+                        break
+                elapsed = time.time() - start
+                print('  %-8s %10.1f calls/s %8.1f us/call'
+                      % (member, n / elapsed, elapsed / n * 1e6))
+    finally:
+        os.kill(pid, signal.SIGTERM)
+        os.waitpid(pid, 0)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+
+"""Microbenchmark for Message.get_args_list().
+
+Run with the freshly-built _dbus_bindings on sys.path, e.g.:
+
+    PYTHONPATH=_dbus_bindings/.libs:. python tools/bench-unmarshal.py
+
+Prints the throughput of unpacking a few typical payloads. No bus is
+needed.
+"""
+
+# Copyright (C) 2026 agent <agent@local>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+from __future__ import print_function
+
+import sys
+import timeit
+from optparse import OptionParser
+
+from _dbus_bindings import SignalMessage
+import dbus
+
+
+def make_properties(n):
+    props = {}
+    for i in range(n):
+        props['Property%d' % i] = [
+            dbus.String('value %d' % i),
+            dbus.UInt32(i),
+            dbus.Boolean(i % 2),
+            dbus.ObjectPath('/org/example/Object%d' % i),
+            dbus.Array([dbus.Int32(i), dbus.Int32(-i)], signature='i'),
+            dbus.Struct((dbus.Int64(i), dbus.String('x')), signature='xs'),
+            ][i % 6]
+    return props
+
+
+PAYLOADS = [
+    ('a{sv} x 1000', 'a{sv}', lambda: (make_properties(1000),)),
+    ('ai x 100000', 'ai', lambda: (list(range(100000)),)),
+    ('a(xs) x 10000', 'a(xs)',
+     lambda: ([(i, 'item %d' % i) for i in range(10000)],)),
+    ('10 small args', 'isubdosuqy',
+     lambda: (1, 'foo', 2, True, 1.5, '/', 'bar', 3, 4, 5)),
+]
+
+
+def main():
+    parser = OptionParser(usage='%prog [options]')
+    parser.add_option('-n', '--number', type='int', default=0,
+                      help='calls per timing run (default: auto)')
+    parser.add_option('-r', '--repeat', type='int', default=5,
+                      help='timing runs; the best is reported (default: 5)')
+    options, args = parser.parse_args()
+
+    for name, signature, make_args in PAYLOADS:
+        message = SignalMessage('/', 'com.example.Bench', 'Bench')
+        message.append(signature=signature, *make_args())
+        timer = timeit.Timer(message.get_args_list)
+        number = options.number
+        if not number:
+            number = 1
+            while timer.timeit(number) < 0.2:
+                number *= 2
+        best = min(timer.repeat(options.repeat, number)) / number
+        print('%-16s %12.1f us/call %12.1f calls/s'
+              % (name, best * 1e6, 1.0 / best))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())